@@ -0,0 +1,386 @@
+// Import benchmark: generates synthetic obj datasets and times every stage of the loader.
+// The CPU stages run without a GPU, --gpu adds the upload and the whole Scene::loadModel.
+// Results are written as JSON so two runs can be compared.
+
+#include "SyntheticObj.h"
+#include <ObjParser.h>
+#include <MeshProcessing.h>
+#include <MeshCache.h>
+#include <Mesh.h>
+#include <Scene.h>
+#include <Texture.h>
+#include <TextureCache.h>
+#include <MaterialCache.h>
+#include <ThreadPool.h>
+#include <Device.h>
+#include <Utils.h>
+#include <nvvk/commands_vk.hpp>
+#include <filesystem>
+#include <functional>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+namespace
+{
+	struct BenchmarkOptions
+	{
+		std::string directory{ "astra_benchmark" };
+		std::string output{ "loader_benchmark.json" };
+		size_t maxTriangles{ 1000000 };
+		uint32_t runs{ 1 };
+		bool gpu{ false };
+		// only the datasets whose name contains it
+		std::string filter;
+	};
+
+	struct DatasetResult
+	{
+		Astra::SyntheticObjDesc desc;
+		Astra::SyntheticObjInfo info;
+		size_t vertices{ 0 };
+		size_t weldedVertices{ 0 };
+		// triangles tinyobj read, to check both parsers agree
+		size_t tinyobjTriangles{ 0 };
+		// best time of every stage in milliseconds, in the order they run
+		std::vector<std::pair<std::string, double>> stages;
+
+		void record(const std::string& stage, double ms)
+		{
+			auto it = std::find_if(stages.begin(), stages.end(), [&](const auto& s) { return s.first == stage; });
+			if (it == stages.end())
+				stages.emplace_back(stage, ms);
+			else
+				it->second = std::min(it->second, ms);
+		}
+	};
+
+	std::vector<Astra::SyntheticObjDesc> getDatasets()
+	{
+		// name, triangles, normals, texCoords, materials, shapes, textures, textureSize
+		return {
+			{ "tri1k", 1000, true, true, 1, 1, 0, 512 },
+			{ "tri100k", 100000, true, true, 4, 1, 1, 512 },
+			{ "tri1m", 1000000, true, true, 4, 1, 2, 1024 },
+			{ "tri1m_nonormals", 1000000, false, true, 4, 1, 2, 1024 },
+			{ "tri1m_positions", 1000000, false, false, 1, 1, 0, 512 },
+			{ "tri1m_materials", 1000000, true, true, 256, 16, 16, 512 },
+			{ "tri1m_shapes", 1000000, true, true, 16, 4096, 0, 512 },
+			{ "tri10m", 10000000, true, true, 8, 8, 4, 2048 },
+			{ "tri10m_nonormals", 10000000, false, true, 8, 8, 4, 2048 },
+			{ "tri50m", 50000000, true, true, 16, 32, 8, 2048 },
+		};
+	}
+
+	double timeMs(const std::function<void()>& work)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		work();
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	std::vector<std::string> resolveTextures(const std::string& objPath, const std::vector<std::string>& paths)
+	{
+		// same as Mesh::loadFromFile, relative to the obj
+		std::vector<std::string> resolved;
+		const std::filesystem::path base = std::filesystem::path(objPath).parent_path();
+		for (const std::string& path : paths)
+		{
+			const std::filesystem::path texture(path);
+			resolved.push_back(texture.is_relative() ? (base / texture).string() : path);
+		}
+		return resolved;
+	}
+
+	void runCpuStages(DatasetResult& result, const BenchmarkOptions& options)
+	{
+		const std::string& path = result.info.objPath;
+		const Astra::MeshLoadOptions defaults;
+
+		// the reference parser first, MeshLoadOptions::parallelParser = false, on its own mesh so both read the file the same way
+		{
+			Astra::Mesh mesh;
+			std::vector<uint32_t> positionIds;
+			result.record("parseTinyobj", timeMs([&]() { mesh.loadObjTinyobj(path, positionIds); }));
+			result.tinyobjTriangles = mesh.indices.size() / 3;
+		}
+		{
+			Astra::Mesh mesh;
+			std::vector<uint32_t> positionIds;
+			result.record("parseParallel", timeMs([&]() { mesh.loadObjParallel(path, positionIds); }));
+		}
+
+		// the steps of Mesh::loadFromFile one by one, on the same data
+		Astra::ObjData data;
+		result.record("parse", timeMs([&]() { Astra::parseObj(path, data); }));
+		for (auto& mi : data.materialIndices)
+		{
+			if (mi < 0 || mi >= static_cast<int32_t>(data.materials.size()))
+				mi = 0;
+		}
+		result.vertices = data.vertices.size();
+		if (!data.hasNormals)
+		{
+			const uint32_t* positionIds = data.positionIds.size() == data.vertices.size() ? data.positionIds.data() : nullptr;
+			result.record("normals", timeMs([&]() { Astra::computeSmoothNormals(data.vertices, data.indices, defaults.creaseAngle, positionIds); }));
+		}
+		result.record("weld", timeMs([&]() { Astra::weldVertices(data.vertices, data.indices, defaults.weldEpsilon); }));
+		result.weldedVertices = data.vertices.size();
+		result.record("optimize", timeMs([&]() { Astra::optimizeMesh(data.vertices, data.indices, data.materialIndices); }));
+		result.record("lod", timeMs([&]()
+			{
+				std::vector<uint32_t> lodIndices, lodTriangles;
+				Astra::buildLodChain(data.vertices.data(), data.vertices.size(), data.indices.data(), data.indices.size(), defaults.lodCount, defaults.lodReduction,
+					lodIndices, lodTriangles);
+			}));
+		// done by Mesh::computeCullingData at the end of the import
+		result.record("meshlets", timeMs([&]() { Astra::buildMeshlets(data.vertices.data(), data.vertices.size(), data.indices.data(), data.indices.size()); }));
+		result.record("bounds", timeMs([&]()
+			{
+				Astra::computeBounds(data.vertices.data(), data.vertices.size());
+				Astra::computeSubmeshBounds(data.vertices.data(), data.indices.data(), data.indices.size(), data.materialIndices.data(), data.materialIndices.size(),
+					data.materials.size());
+			}));
+
+		// without the .ktx2 cache, so the images are really decoded and their mipmaps generated
+		const std::vector<std::string> textures = resolveTextures(path, data.texturePaths);
+		if (!textures.empty())
+		{
+			Astra::TextureLoadOptions textureOptions;
+			textureOptions.useCache = false;
+			result.record("textureDecode", timeMs([&]()
+				{
+					std::vector<Astra::TextureData> decoded(textures.size());
+					AstraThreads.parallelFor(textures.size(), [&](size_t begin, size_t end)
+						{
+							for (size_t t = begin; t < end; t++)
+								decoded[t] = Astra::loadTextureData(textures[t], textureOptions);
+						}, 1);
+				}));
+		}
+		data = Astra::ObjData();
+
+		// and the whole import, as the engine does it
+		Astra::MeshLoadOptions noCache;
+		noCache.useCache = false;
+		result.record("loadFromFile", timeMs([&]() { Astra::Mesh mesh; mesh.loadFromFile(path, noCache); }));
+		Astra::MeshLoadOptions tinyobj = noCache;
+		tinyobj.parallelParser = false;
+		result.record("loadFromFileTinyobj", timeMs([&]() { Astra::Mesh mesh; mesh.loadFromFile(path, tinyobj); }));
+
+		Astra::MeshLoadOptions cached;
+		cached.cacheDirectory = (std::filesystem::path(options.directory) / "cache").string();
+		std::error_code ec;
+		std::filesystem::remove(Astra::getMeshCachePath(path, cached.cacheDirectory), ec);
+		result.record("loadFromFileCacheWrite", timeMs([&]() { Astra::Mesh mesh; mesh.loadFromFile(path, cached); }));
+		result.record("loadFromFileCacheRead", timeMs([&]() { Astra::Mesh mesh; mesh.loadFromFile(path, cached); }));
+	}
+
+	void runGpuStages(DatasetResult& result, const BenchmarkOptions& options, nvvk::ResourceAllocatorDma& alloc)
+	{
+		const std::string& path = result.info.objPath;
+		Astra::MeshLoadOptions cached;
+		cached.cacheDirectory = (std::filesystem::path(options.directory) / "cache").string();
+
+		// Mesh::create with the textures already decoded, so only the upload is timed
+		Astra::Mesh mesh;
+		mesh.loadFromFile(path, cached);
+		mesh.meshId = 0;
+		mesh.decodeTextures();
+		Astra::TextureCache textureCache;
+		Astra::MaterialCache materialCache;
+		textureCache.init(&alloc);
+		materialCache.init(&alloc);
+		result.record("upload", timeMs([&]()
+			{
+				nvvk::CommandPool cmdPool(AstraDevice.getVkDevice(), AstraDevice.getGraphicsQueueIndex());
+				VkCommandBuffer cmdBuf = cmdPool.createCommandBuffer();
+				mesh.create(Astra::CommandList(cmdBuf), &alloc, textureCache, materialCache);
+				cmdPool.submitAndWait(cmdBuf);
+				alloc.finalizeAndReleaseStaging();
+			}));
+		alloc.destroy(mesh.vertexBuffer);
+		alloc.destroy(mesh.indexBuffer);
+		alloc.destroy(mesh.matIndexBuffer);
+		alloc.destroy(mesh.dequantBuffer);
+		alloc.destroy(mesh.meshletBuffer);
+		alloc.destroy(mesh.lodIndexBuffer);
+		alloc.destroy(mesh.lodTriangleBuffer);
+		textureCache.destroy();
+		materialCache.destroy();
+
+		// a scene loads its lazy models on init, with its default options and no mesh cache
+		std::error_code ec;
+		std::filesystem::remove(Astra::getMeshCachePath(path), ec);
+		Astra::Scene scene;
+		scene.loadModel(path);
+		result.record("sceneLoadModel", timeMs([&]() { scene.init(&alloc); }));
+		scene.destroy();
+		std::filesystem::remove(Astra::getMeshCachePath(path), ec);
+	}
+
+	double getStage(const DatasetResult& result, const std::string& stage)
+	{
+		auto it = std::find_if(result.stages.begin(), result.stages.end(), [&](const auto& s) { return s.first == stage; });
+		return it == result.stages.end() ? 0.0 : it->second;
+	}
+
+	std::string jsonString(const std::string& s)
+	{
+		std::string out = "\"";
+		for (char c : s)
+		{
+			if (c == '"' || c == '\\')
+				out += '\\';
+			out += c;
+		}
+		return out + "\"";
+	}
+
+	bool writeJson(const std::string& path, const BenchmarkOptions& options, const std::vector<DatasetResult>& results)
+	{
+		FILE* file = std::fopen(path.c_str(), "w");
+		if (file == nullptr)
+			return false;
+
+		std::fprintf(file, "{\n");
+		std::fprintf(file, "  \"timestamp\": %lld,\n", static_cast<long long>(std::time(nullptr)));
+		std::fprintf(file, "  \"threads\": %u,\n", AstraThreads.getThreadCount());
+		std::fprintf(file, "  \"runs\": %u,\n", options.runs);
+		std::fprintf(file, "  \"gpu\": %s,\n", options.gpu ? "true" : "false");
+		std::fprintf(file, "  \"datasets\": [\n");
+		for (size_t d = 0; d < results.size(); d++)
+		{
+			const DatasetResult& r = results[d];
+			std::fprintf(file, "    {\n");
+			std::fprintf(file, "      \"name\": %s,\n", jsonString(r.desc.name).c_str());
+			std::fprintf(file, "      \"triangles\": %zu,\n", r.info.triangles);
+			std::fprintf(file, "      \"positions\": %zu,\n", r.info.positions);
+			std::fprintf(file, "      \"vertices\": %zu,\n", r.vertices);
+			std::fprintf(file, "      \"weldedVertices\": %zu,\n", r.weldedVertices);
+			std::fprintf(file, "      \"normals\": %s,\n", r.desc.normals ? "true" : "false");
+			std::fprintf(file, "      \"texCoords\": %s,\n", r.desc.texCoords ? "true" : "false");
+			std::fprintf(file, "      \"materials\": %u,\n", r.desc.materials);
+			std::fprintf(file, "      \"shapes\": %u,\n", r.desc.shapes);
+			std::fprintf(file, "      \"textures\": %u,\n", r.desc.textures);
+			std::fprintf(file, "      \"fileBytes\": %zu,\n", r.info.fileBytes);
+			std::fprintf(file, "      \"tinyobjTriangles\": %zu,\n", r.tinyobjTriangles);
+			// how many times faster the parallel parser is than tinyobj
+			const double parallelMs = getStage(r, "parseParallel");
+			std::fprintf(file, "      \"parserSpeedup\": %.3f,\n", parallelMs > 0.0 ? getStage(r, "parseTinyobj") / parallelMs : 0.0);
+			std::fprintf(file, "      \"stagesMs\": {");
+			for (size_t s = 0; s < r.stages.size(); s++)
+			{
+				std::fprintf(file, "%s\n        %s: %.3f", s == 0 ? "" : ",", jsonString(r.stages[s].first).c_str(), r.stages[s].second);
+			}
+			std::fprintf(file, "\n      }\n");
+			std::fprintf(file, "    }%s\n", d + 1 < results.size() ? "," : "");
+		}
+		std::fprintf(file, "  ]\n}\n");
+		std::fclose(file);
+		return true;
+	}
+
+	void printUsage()
+	{
+		std::printf("AstraLoaderBenchmark [options]\n"
+			"  --dir <path>            folder for the generated datasets and caches (astra_benchmark)\n"
+			"  --out <file>            JSON results (loader_benchmark.json)\n"
+			"  --max-triangles <n>     skip the datasets bigger than this (1000000, the biggest is 50000000)\n"
+			"  --runs <n>              repetitions, the best time of each stage is kept (1)\n"
+			"  --filter <text>         only the datasets whose name contains it\n"
+			"  --gpu                   also time Mesh::create and Scene::loadModel, needs a Vulkan device\n");
+	}
+
+	bool parseArguments(int argc, char** argv, BenchmarkOptions& options)
+	{
+		for (int i = 1; i < argc; i++)
+		{
+			const std::string arg = argv[i];
+			const bool hasValue = i + 1 < argc;
+			if (arg == "--dir" && hasValue)
+				options.directory = argv[++i];
+			else if (arg == "--out" && hasValue)
+				options.output = argv[++i];
+			else if (arg == "--max-triangles" && hasValue)
+				options.maxTriangles = std::strtoull(argv[++i], nullptr, 10);
+			else if (arg == "--runs" && hasValue)
+				options.runs = std::max(1u, static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10)));
+			else if (arg == "--filter" && hasValue)
+				options.filter = argv[++i];
+			else if (arg == "--gpu")
+				options.gpu = true;
+			else
+				return false;
+		}
+		return true;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	BenchmarkOptions options;
+	if (!parseArguments(argc, argv, options))
+	{
+		printUsage();
+		return 1;
+	}
+
+	std::vector<DatasetResult> results;
+	for (const Astra::SyntheticObjDesc& desc : getDatasets())
+	{
+		if (desc.triangles > options.maxTriangles || desc.name.find(options.filter) == std::string::npos)
+			continue;
+		DatasetResult result;
+		result.desc = desc;
+		const double generateMs = timeMs([&]() { Astra::writeSyntheticObj(options.directory, desc, result.info); });
+		if (result.info.objPath.empty() || !std::filesystem::exists(result.info.objPath))
+		{
+			Astra::Log("Could not generate dataset " + desc.name + " in " + options.directory, ERR);
+			return 1;
+		}
+		if (result.info.generated)
+			Astra::Log("Generated " + result.info.objPath + " in " + std::to_string(static_cast<int>(generateMs)) + " ms");
+		results.push_back(result);
+	}
+
+	for (uint32_t run = 0; run < options.runs; run++)
+	{
+		for (DatasetResult& result : results)
+		{
+			Astra::Log("CPU stages of " + result.desc.name + ", run " + std::to_string(run + 1));
+			runCpuStages(result, options);
+		}
+	}
+
+	if (options.gpu)
+	{
+		Astra::DeviceCreateInfo createInfo;
+		createInfo.useRT = false;
+		createInfo.cacheTextures = false;
+		AstraDevice.initDevice(createInfo);
+		nvvk::ResourceAllocatorDma alloc;
+		alloc.init(AstraDevice.getVkDevice(), AstraDevice.getPhysicalDevice());
+		for (uint32_t run = 0; run < options.runs; run++)
+		{
+			for (DatasetResult& result : results)
+			{
+				Astra::Log("GPU stages of " + result.desc.name + ", run " + std::to_string(run + 1));
+				runGpuStages(result, options, alloc);
+			}
+		}
+		alloc.deinit();
+		AstraDevice.destroy();
+	}
+
+	if (!writeJson(options.output, options, results))
+	{
+		Astra::Log("Could not write " + options.output, ERR);
+		return 1;
+	}
+	Astra::Log("Results written to " + options.output);
+	return 0;
+}
@@ -0,0 +1,248 @@
+#include "SyntheticObj.h"
+#include <stb_image_write.h>
+#include <filesystem>
+#include <algorithm>
+#include <vector>
+#include <cstdio>
+#include <cmath>
+
+namespace
+{
+	// flushed to the file once it holds this many bytes
+	constexpr size_t WriteBufferSize = 4 * 1024 * 1024;
+
+	// the same inputs always give the same numbers, on every platform
+	uint32_t hash32(uint32_t x)
+	{
+		x ^= x >> 16;
+		x *= 0x7FEB352Du;
+		x ^= x >> 15;
+		x *= 0x846CA68Bu;
+		x ^= x >> 16;
+		return x;
+	}
+
+	float unitNoise(uint32_t x)
+	{
+		return static_cast<float>(hash32(x) & 0xFFFFFF) / static_cast<float>(0xFFFFFF);
+	}
+
+	class BufferedFile
+	{
+	private:
+		FILE* _file{ nullptr };
+		std::vector<char> _buffer;
+		size_t _written{ 0 };
+
+	public:
+		explicit BufferedFile(const std::string& path) : _file(std::fopen(path.c_str(), "wb"))
+		{
+			_buffer.reserve(WriteBufferSize + 256);
+		}
+		~BufferedFile()
+		{
+			close();
+		}
+		bool valid() const
+		{
+			return _file != nullptr;
+		}
+		template <typename... Args>
+		void print(const char* format, Args... args)
+		{
+			char line[256];
+			const int n = std::snprintf(line, sizeof(line), format, args...);
+			_buffer.insert(_buffer.end(), line, line + std::min<int>(n, sizeof(line) - 1));
+			if (_buffer.size() >= WriteBufferSize)
+				flush();
+		}
+		void flush()
+		{
+			if (_file != nullptr && !_buffer.empty())
+				_written += std::fwrite(_buffer.data(), 1, _buffer.size(), _file);
+			_buffer.clear();
+		}
+		size_t close()
+		{
+			flush();
+			if (_file != nullptr)
+				std::fclose(_file);
+			_file = nullptr;
+			return _written;
+		}
+	};
+
+	bool writeTexture(const std::string& path, uint32_t index, uint32_t size)
+	{
+		// checkerboard with a different tint and cell size per texture, plus some noise so it does not compress to nothing
+		std::vector<uint8_t> pixels(static_cast<size_t>(size) * size * 4);
+		const uint32_t cell = 8u << (index % 4);
+		const uint8_t tint[3] = { static_cast<uint8_t>(hash32(index * 3 + 0)), static_cast<uint8_t>(hash32(index * 3 + 1)), static_cast<uint8_t>(hash32(index * 3 + 2)) };
+		for (uint32_t y = 0; y < size; y++)
+		{
+			for (uint32_t x = 0; x < size; x++)
+			{
+				uint8_t* p = pixels.data() + (static_cast<size_t>(y) * size + x) * 4;
+				const bool on = ((x / cell) + (y / cell)) % 2 == 0;
+				const uint8_t noise = static_cast<uint8_t>(hash32(index * 0x9E3779B9u + y * size + x) & 0x1F);
+				for (int c = 0; c < 3; c++)
+				{
+					p[c] = static_cast<uint8_t>(on ? std::min(255, tint[c] / 2 + 128 - noise) : tint[c] / 4 + noise);
+				}
+				p[3] = 255;
+			}
+		}
+		return stbi_write_png(path.c_str(), static_cast<int>(size), static_cast<int>(size), 4, pixels.data(), static_cast<int>(size * 4)) != 0;
+	}
+
+	bool writeMtl(const std::string& path, const std::string& baseName, const Astra::SyntheticObjDesc& desc)
+	{
+		BufferedFile mtl(path);
+		if (!mtl.valid())
+			return false;
+		for (uint32_t m = 0; m < desc.materials; m++)
+		{
+			mtl.print("newmtl m%u\n", m);
+			mtl.print("Ka 0.1 0.1 0.1\n");
+			mtl.print("Kd %.4f %.4f %.4f\n", unitNoise(m * 3 + 0), unitNoise(m * 3 + 1), unitNoise(m * 3 + 2));
+			mtl.print("Ks 0.5 0.5 0.5\n");
+			mtl.print("Ns %.1f\n", 8.0f + 120.0f * unitNoise(m * 7 + 5));
+			mtl.print("illum 2\n");
+			if (m < desc.textures)
+				mtl.print("map_Kd %s_tex%u.png\n", baseName.c_str(), m);
+			mtl.print("\n");
+		}
+		mtl.close();
+		return true;
+	}
+}
+
+bool Astra::writeSyntheticObj(const std::string& directory, const SyntheticObjDesc& desc, SyntheticObjInfo& info)
+{
+	std::error_code ec;
+	std::filesystem::create_directories(directory, ec);
+
+	// every shape is a grid of quads over a wavy surface, placed next to the previous one
+	const uint32_t shapes = std::max(desc.shapes, 1u);
+	const size_t quadsPerShape = std::max<size_t>((desc.triangles / shapes + 1) / 2, 1);
+	const size_t columns = std::max<size_t>(static_cast<size_t>(std::sqrt(static_cast<double>(quadsPerShape))), 1);
+	const size_t rows = (quadsPerShape + columns - 1) / columns;
+
+	const std::filesystem::path objPath = std::filesystem::path(directory) / (desc.name + ".obj");
+	info.objPath = objPath.string();
+	info.triangles = shapes * columns * rows * 2;
+	info.positions = shapes * (columns + 1) * (rows + 1);
+	info.generated = false;
+
+	// the name says everything about the contents, so existing files are reused
+	if (std::filesystem::exists(objPath, ec))
+	{
+		info.fileBytes = static_cast<size_t>(std::filesystem::file_size(objPath, ec));
+		return true;
+	}
+
+	const uint32_t materials = std::max(desc.materials, 1u);
+	SyntheticObjDesc mtlDesc = desc;
+	mtlDesc.materials = materials;
+	if (!writeMtl((std::filesystem::path(directory) / (desc.name + ".mtl")).string(), desc.name, mtlDesc))
+		return false;
+	for (uint32_t t = 0; t < std::min(desc.textures, materials); t++)
+	{
+		const std::string texturePath = (std::filesystem::path(directory) / (desc.name + "_tex" + std::to_string(t) + ".png")).string();
+		if (!writeTexture(texturePath, t, desc.textureSize))
+			return false;
+	}
+
+	// written to a temporary name, an interrupted run does not leave a truncated dataset behind
+	const std::string tempPath = info.objPath + ".tmp";
+	BufferedFile obj(tempPath);
+	if (!obj.valid())
+		return false;
+	obj.print("# synthetic obj: %zu triangles, %u shapes, %u materials\n", info.triangles, shapes, materials);
+	obj.print("mtllib %s.mtl\n", desc.name.c_str());
+
+	// materials change in runs of faces, spread over the whole file
+	const size_t facesPerMaterial = std::max<size_t>(info.triangles / materials, 1);
+	size_t face = 0;
+	size_t firstPosition = 1;
+	for (uint32_t s = 0; s < shapes; s++)
+	{
+		obj.print("o shape%u\n", s);
+		const float offset = static_cast<float>(s) * 1.1f;
+		for (size_t r = 0; r <= rows; r++)
+		{
+			for (size_t c = 0; c <= columns; c++)
+			{
+				const float u = static_cast<float>(c) / static_cast<float>(columns);
+				const float v = static_cast<float>(r) / static_cast<float>(rows);
+				const float height = 0.05f * std::sin(u * 12.0f + offset) * std::cos(v * 9.0f) + 0.002f * unitNoise(static_cast<uint32_t>(firstPosition + r * (columns + 1) + c));
+				obj.print("v %.6f %.6f %.6f\n", offset + u, height, v);
+			}
+		}
+		if (desc.texCoords)
+		{
+			for (size_t r = 0; r <= rows; r++)
+			{
+				for (size_t c = 0; c <= columns; c++)
+				{
+					obj.print("vt %.6f %.6f\n", static_cast<float>(c) / static_cast<float>(columns), static_cast<float>(r) / static_cast<float>(rows));
+				}
+			}
+		}
+		if (desc.normals)
+		{
+			// close enough to the surface, the loader does not check them
+			for (size_t r = 0; r <= rows; r++)
+			{
+				for (size_t c = 0; c <= columns; c++)
+				{
+					const float u = static_cast<float>(c) / static_cast<float>(columns);
+					const float v = static_cast<float>(r) / static_cast<float>(rows);
+					const float dx = 0.6f * std::cos(u * 12.0f + offset) * std::cos(v * 9.0f);
+					const float dz = -0.45f * std::sin(u * 12.0f + offset) * std::sin(v * 9.0f);
+					const float length = std::sqrt(dx * dx + 1.0f + dz * dz);
+					obj.print("vn %.5f %.5f %.5f\n", -dx / length, 1.0f / length, -dz / length);
+				}
+			}
+		}
+
+		uint32_t material = UINT32_MAX;
+		for (size_t r = 0; r < rows; r++)
+		{
+			for (size_t c = 0; c < columns; c++)
+			{
+				const uint32_t faceMaterial = static_cast<uint32_t>(std::min<size_t>(face / facesPerMaterial, materials - 1));
+				if (faceMaterial != material)
+				{
+					material = faceMaterial;
+					obj.print("usemtl m%u\n", material);
+				}
+				const size_t a = firstPosition + r * (columns + 1) + c;
+				const size_t b = a + 1;
+				const size_t d = a + columns + 1;
+				const size_t e = d + 1;
+				const size_t quad[2][3] = { { a, d, b }, { b, d, e } };
+				for (const auto& tri : quad)
+				{
+					if (desc.normals && desc.texCoords)
+						obj.print("f %zu/%zu/%zu %zu/%zu/%zu %zu/%zu/%zu\n", tri[0], tri[0], tri[0], tri[1], tri[1], tri[1], tri[2], tri[2], tri[2]);
+					else if (desc.normals)
+						obj.print("f %zu//%zu %zu//%zu %zu//%zu\n", tri[0], tri[0], tri[1], tri[1], tri[2], tri[2]);
+					else if (desc.texCoords)
+						obj.print("f %zu/%zu %zu/%zu %zu/%zu\n", tri[0], tri[0], tri[1], tri[1], tri[2], tri[2]);
+					else
+						obj.print("f %zu %zu %zu\n", tri[0], tri[1], tri[2]);
+				}
+				face += 2;
+			}
+		}
+		firstPosition += (rows + 1) * (columns + 1);
+	}
+	info.fileBytes = obj.close();
+
+	std::filesystem::rename(tempPath, objPath, ec);
+	if (ec)
+		return false;
+	info.generated = true;
+	return true;
+}
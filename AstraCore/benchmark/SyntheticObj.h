@@ -0,0 +1,56 @@
+#pragma once
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+namespace Astra
+{
+	/**
+	 * @struct SyntheticObjDesc
+	 * \~spanish @brief Parámetros de un obj sintético. El mismo descriptor genera siempre los mismos ficheros
+	 * \~english @brief Parameters of a synthetic obj. The same descriptor always generates the same files
+	 */
+	struct SyntheticObjDesc
+	{
+		std::string name;
+		/**
+		 * \~spanish @brief Triángulos aproximados, se reparten entre las formas como rejillas de quads
+		 * \~english @brief Approximate triangle count, split between the shapes as quad grids
+		 */
+		size_t triangles{ 1000 };
+		bool normals{ true };
+		bool texCoords{ true };
+		uint32_t materials{ 1 };
+		uint32_t shapes{ 1 };
+		/**
+		 * \~spanish @brief Cuántos de los materiales tienen una textura difusa. Cada una es una imagen png distinta
+		 * \~english @brief How many of the materials have a diffuse texture. Every one is a different png image
+		 */
+		uint32_t textures{ 0 };
+		uint32_t textureSize{ 512 };
+	};
+
+	/**
+	 * @struct SyntheticObjInfo
+	 * \~spanish @brief Lo que se ha generado realmente
+	 * \~english @brief What was actually generated
+	 */
+	struct SyntheticObjInfo
+	{
+		std::string objPath;
+		size_t triangles{ 0 };
+		size_t positions{ 0 };
+		size_t fileBytes{ 0 };
+		/**
+		 * \~spanish @brief False si los ficheros ya existían y no se han vuelto a escribir
+		 * \~english @brief False if the files already existed and were not written again
+		 */
+		bool generated{ false };
+	};
+
+	/**
+	 * \~spanish @brief Escribe en @p directory el obj, su mtl y sus texturas. Si ya están se reutilizan. Devuelve false si no se pueden escribir
+	 * \~english @brief Writes the obj, its mtl and its textures to @p directory. They are reused if already there. Returns false if they cannot be written
+	 */
+	bool writeSyntheticObj(const std::string& directory, const SyntheticObjDesc& desc, SyntheticObjInfo& info);
+}
@@ -54,9 +54,13 @@ namespace Astra
 		int _selectedPipeline{ 0 };
 
 		nvvk::DescriptorSetBindings _descSetLayoutBind;
-		VkDescriptorPool _descPool;
-		VkDescriptorSetLayout _descSetLayout;
-		VkDescriptorSet _descSet;
+		VkDescriptorPool _descPool{ VK_NULL_HANDLE };
+		VkDescriptorSetLayout _descSetLayout{ VK_NULL_HANDLE };
+		VkDescriptorSet _descSet{ VK_NULL_HANDLE }; // set of the frame being recorded
+		std::vector<VkDescriptorSet> _frameDescSets; // one per frame in flight, so a frame never writes a set the GPU is reading
+		std::vector<uint64_t> _frameDescVersions; // version of the descriptors every set was written with
+		uint64_t _descVersion{ 0 };
+		uint32_t _textureCapacity{ 0 }; // size of the texture binding, the scene may use fewer
 
 		/**
 		 *  \~spanish @brief Método abstracto que cada clase derivada debe implementar. Debe crear las pipelines que se vayan a usar e introducir en el vector @a _pipelines
@@ -74,21 +78,45 @@ namespace Astra
 		 *  					Binding 0: Parámetros de Cámara \n
 		 *  					Binding 1: Datos de las luces \n
 		 *  					Binding 2: Datos de los objetos, direcciones de memoria para acceder a los buffers \n
-		 *  					Binding 3: Texturas
+		 *  					Binding 3: Texturas, con sitio para más de las que tiene la escena para no rehacer el layout al cargar modelos \n
+		 *  					Hay un descriptor set por cada frame en vuelo. Si ya había un layout, lo destruye junto con su pool
 		 *
 		 *  \~english @brief Creates the descriptor set layouts needed for rasterization
 		 *  					The bindings are the following: \n
 		 * 						Binding 0: Camera parameters \n
 		 * 						Binding 1: Data for the different lights in the scene \n
 		 * 						Binding 2: Object descriptors, GPU addresses for the buffers \n
-		 * 						Binding 3: Textures
+		 * 						Binding 3: Textures, with room for more than the scene has so loading models does not recreate the layout \n
+		 * 						There is a descriptor set for every frame in flight. If there was a layout already, it is destroyed along with its pool
 		 */
 		virtual void createDescriptorSetLayout();
 		/**
-		 *  \~spanish @brief Escribe y actualiza los datos del descriptor set
-		 *  \~english @brief Writes and updates the descriptor set data
+		 *  \~spanish @brief Escribe los datos de la escena en el descriptor set @p set
+		 *  \~english @brief Writes the scene data into the descriptor set @p set
+		 */
+		virtual void writeDescriptorSet(VkDescriptorSet set);
+		/**
+		 *  \~spanish @brief Escribe y actualiza los descriptor sets de todos los frames. Solo cuando la GPU no los está usando
+		 *  \~english @brief Writes and updates the descriptor sets of every frame. Only when the GPU is not using them
 		 */
 		virtual void updateDescriptorSet();
+		/**
+		 *  \~spanish @brief Marca los descriptores como desactualizados después de añadir modelos, cada frame reescribe los suyos cuando la GPU termina con ellos.
+		 *  El layout y las pipelines solo se rehacen, esperando a la GPU, si las texturas ya no caben en él
+		 *  \~english @brief Marks the descriptors as outdated after models were added, every frame writes its own once the GPU is done with them.
+		 *  The layout and the pipelines are only recreated, waiting for the GPU, if the textures no longer fit in it
+		 */
+		virtual void updateSceneDescriptors();
+		/**
+		 *  \~spanish @brief Elige los descriptor sets del frame @p frame y los reescribe si están desactualizados. Lo llama el Renderer después de esperar al fence del frame
+		 *  \~english @brief Picks the descriptor sets of the frame @p frame and writes them again if they are outdated. Called by the Renderer after waiting for the fence of the frame
+		 */
+		virtual void updateFrameDescriptors(uint32_t frame);
+		/**
+		 *  \~spanish @brief Reescribe los descriptor sets del frame @p frame
+		 *  \~english @brief Writes the descriptor sets of the frame @p frame again
+		 */
+		virtual void writeFrameDescriptors(uint32_t frame);
 		/**
 		 *  \~spanish @brief Resetea la escena, se debe llamar cuando se cambie de escena o si se agregan modelos durante la ejecución.
 		 *  \~spanish @warning No se puede llamar durante el renderizado ya que los descriptor sets estarán desactualizados al mismo tiempo que se ejecutan los shaders. Asegurarse de hacerlo antes o después!.
@@ -96,6 +124,15 @@ namespace Astra
 		 *  \~english @warning Calling the method while rendering will probably crash the scene as Descriptor Sets will be outdated as the shaders are running! Make sure to reset it before or after a render action.
 		 */
 		virtual void resetScene(bool recreatePipelines = false);
+		/**
+		 *  \~spanish @brief Avanza las cargas asíncronas de la escena actual. Si alguna ha terminado, añade los modelos y marca los descriptores como desactualizados.
+		 *  Los buffers sustituidos se destruyen cuando terminan los frames que los usan, sin esperar a la GPU.
+		 *  Lo llama el Renderer al principio de cada frame, cuando no se está grabando ningún comando.
+		 *  \~english @brief Advances the asynchronous loads of the current scene. If any of them finished, adds the models and marks the descriptors as outdated.
+		 *  The replaced buffers are destroyed once the frames using them finish, without waiting for the GPU.
+		 *  Called by the Renderer at the start of every frame, when no commands are being recorded.
+		 */
+		virtual void updateAsyncLoads();
 		/**
 		 *  \~spanish @brief Callback para el cambio de tamaño de ventana. Actualiza ImGui, renderer, cámara y descriptor sets
 		 *  \~english @brief Window resize callback. Updates ImGui, renderer, camera and descriptor sets
@@ -13,15 +13,31 @@ namespace Astra
 	{
 	protected:
 		nvvk::DescriptorSetBindings _rtDescSetLayoutBind;
-		VkDescriptorPool _rtDescPool;
-		VkDescriptorSetLayout _rtDescSetLayout;
-		VkDescriptorSet _rtDescSet;
+		VkDescriptorPool _rtDescPool{ VK_NULL_HANDLE };
+		VkDescriptorSetLayout _rtDescSetLayout{ VK_NULL_HANDLE };
+		VkDescriptorSet _rtDescSet{ VK_NULL_HANDLE }; // set of the frame being recorded
+		std::vector<VkDescriptorSet> _rtFrameDescSets; // one per frame in flight, like the App ones
 		std::vector<nvvk::AccelKHR> _blas;
 		std::vector<VkAccelerationStructureInstanceKHR> m_tlas;
 
 		virtual void createRtDescriptorSetLayout();
+		/**
+		 * \~spanish @brief Escribe el TLAS y la imagen de salida en el descriptor set @p set
+		 * \~english @brief Writes the TLAS and the output image into the descriptor set @p set
+		 */
+		virtual void writeRtDescriptorSet(VkDescriptorSet set);
+		/**
+		 * \~spanish @brief Escribe los descriptor sets de trazado de rayos de todos los frames. Solo cuando la GPU no los está usando
+		 * \~english @brief Writes the ray tracing descriptor sets of every frame. Only when the GPU is not using them
+		 */
 		virtual void updateRtDescriptorSet();
 		void onResize(int w, int h) override;
+		void updateFrameDescriptors(uint32_t frame) override;
+		/**
+		 * \~spanish @brief Además de los de App, vuelve a escribir el TLAS del frame, que se rehace al añadir modelos
+		 * \~english @brief Besides the App ones, writes the TLAS of the frame again, which is rebuilt when models are added
+		 */
+		void writeFrameDescriptors(uint32_t frame) override;
 		void resetScene(bool recreatePipelines) override;
 
 	public:
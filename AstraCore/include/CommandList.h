@@ -24,14 +24,24 @@ namespace Astra
 
 		void pipelineBarrier(VkPipelineStageFlags srcFlags, VkPipelineStageFlags dstFlags, VkDependencyFlags depsFlags, const std::vector<VkMemoryBarrier> &memoryBarrier, const std::vector<VkBufferMemoryBarrier> &bufferMemoryBarrier, const std::vector<VkImageMemoryBarrier> &imageMemoryBarrier) const;
 		void updateBuffer(const nvvk::Buffer &buffer, uint32_t offset, VkDeviceSize size, const void *data) const;
+		void fillBuffer(const nvvk::Buffer &buffer, uint32_t data, VkDeviceSize offset = 0, VkDeviceSize size = VK_WHOLE_SIZE) const;
+		void copyBuffer(const nvvk::Buffer &src, const nvvk::Buffer &dst, VkDeviceSize srcOffset, VkDeviceSize dstOffset, VkDeviceSize size) const;
 
 		void begin(const VkCommandBufferBeginInfo &beginInfo) const;
 		void end() const;
 		void beginRenderPass(const VkRenderPassBeginInfo &beginInfo, VkSubpassContents subpassContents = VK_SUBPASS_CONTENTS_INLINE) const;
 		void endRenderPass() const;
 
-		void drawIndexed(const VkBuffer &vertexBuffer, const VkBuffer &indexBuffer, uint32_t nbIndices) const;
+		void drawIndexed(const VkBuffer &vertexBuffer, const VkBuffer &indexBuffer, uint32_t nbIndices, uint32_t firstIndex = 0) const;
 		void draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex = 0, uint32_t firstInstance = 0) const;
+		void drawIndexedIndirect(const VkBuffer &indexBuffer, const VkBuffer &drawBuffer, VkDeviceSize offset, uint32_t drawCount = 1, uint32_t stride = sizeof(VkDrawIndexedIndirectCommand)) const;
+		/**
+		 * \~spanish @brief Como drawIndexedIndirect(), pero el número de draws lo lee la GPU de @p countBuffer, hasta @p maxDrawCount
+		 * \~english @brief Like drawIndexedIndirect(), but the GPU reads the number of draws from @p countBuffer, up to @p maxDrawCount
+		 */
+		void drawIndexedIndirectCount(const VkBuffer &indexBuffer, const VkBuffer &drawBuffer, VkDeviceSize offset, const VkBuffer &countBuffer, VkDeviceSize countOffset, uint32_t maxDrawCount,
+			uint32_t stride = sizeof(VkDrawIndexedIndirectCommand)) const;
+		void dispatch(uint32_t groupCountX, uint32_t groupCountY = 1, uint32_t groupCountZ = 1) const;
 		void raytrace(const std::array<VkStridedDeviceAddressRegionKHR, 4> &regions, uint32_t width, uint32_t height, uint32_t depth = 1) const;
 		void bindPipeline(PipelineBindPoints bindPoint, const VkPipeline &pipeline) const;
 		void bindDescriptorSets(PipelineBindPoints bindPoint, const VkPipelineLayout &layout, const std::vector<VkDescriptorSet> &descSets) const;
@@ -3,12 +3,15 @@
 #include <GLFW/glfw3.h>
 #include <vector>
 #include <string>
+#include <functional>
+#include <utility>
 #include <nvvk/resourceallocator_vk.hpp>
 #include <nvvk/debug_util_vk.hpp>
 #include <nvvk/raytraceKHR_vk.hpp>
 #include <Mesh.h>
 #include <nvvk/context_vk.hpp>
 #include <CommandList.h>
+#include <Texture.h>
 
 namespace Astra
 {
@@ -29,6 +32,21 @@ namespace Astra
 	struct DeviceCreateInfo
 	{
 		bool useRT{ true };
+		/**
+		 * \~spanish @brief Comprime las texturas a BC. Si el dispositivo no admite BC se usan sin comprimir
+		 * \~english @brief Compresses the textures to BC. If the device does not support BC they are used uncompressed
+		 */
+		bool compressTextures{ false };
+		/**
+		 * \~spanish @brief Guarda las texturas procesadas (con sus mipmaps y comprimidas si se pide) en .ktx2 para no repetir el trabajo en cada ejecución
+		 * \~english @brief Stores the processed textures (with their mipmaps, and compressed if requested) as .ktx2 so the work is not repeated on every run
+		 */
+		bool cacheTextures{ true };
+		/**
+		 * \~spanish @brief Carpeta para los .ktx2 generados, vacía para guardarlos junto a las imágenes
+		 * \~english @brief Folder for the generated .ktx2 files, empty to store them next to the images
+		 */
+		std::string textureCacheDirectory;
 
 		std::vector<std::string> instanceLayers;
 		std::vector<std::string> instanceExtensions;
@@ -53,6 +71,21 @@ namespace Astra
 		uint32_t _graphicsQueueIndex;
 		VkCommandPool _cmdPool;
 		bool _raytracingEnabled;
+		bool _gpuDrivenSupported{ false };
+		TextureLoadOptions _textureLoadOptions;
+
+		// resources replaced while frames were in flight, with the submits they have to outlive
+		struct RetiredResource
+		{
+			std::function<void()> destroy;
+			std::vector<std::pair<uint32_t, uint64_t>> frames; // frame and serial of its submit
+		};
+		std::vector<RetiredResource> _retired;
+		std::vector<uint64_t> _frameSubmitted; // serial of the last submit of every frame
+		std::vector<uint64_t> _frameCompleted; // serial of the last submit of every frame known to be finished
+		uint64_t _submitSerial{ 0 };
+		uint32_t _frameIndex{ 0 }; // frame being recorded
+		bool _recording{ false };  // between frameCompleted() and frameSubmitted() of _frameIndex
 
 		nvvk::DebugUtil _debug;
 		nvvk::Context _vkcontext{};
@@ -91,6 +124,16 @@ namespace Astra
 		GLFWwindow* getWindow();
 		bool getRtEnabled() const;
 		VkPhysicalDeviceRayTracingPipelinePropertiesKHR getRtProperties() const;
+		/**
+		 * \~spanish @brief Opciones con las que se cargan las texturas, según el DeviceCreateInfo y el soporte de BC del dispositivo
+		 * \~english @brief Options the textures are loaded with, from the DeviceCreateInfo and the BC support of the device
+		 */
+		const TextureLoadOptions& getTextureLoadOptions() const;
+		/**
+		 * \~spanish @brief Indica si el dispositivo admite drawIndirectCount, multiDrawIndirect y firstInstance en los draws indirectos, necesarios para el raster GPU-driven
+		 * \~english @brief Tells whether the device supports drawIndirectCount, multiDrawIndirect and firstInstance in indirect draws, needed by the GPU-driven raster
+		 */
+		bool getGpuDrivenSupported() const;
 
 		/**
 		 * \~spanish @brief Crear un shader module con el archivo binario recibido como parámetro
@@ -103,12 +146,26 @@ namespace Astra
 		 * \~english @brief Creates a texture of the file. If @p dummy is true it creates a dummy texture to keep the descriptor set layout
 		 */
 		nvvk::Texture createTextureImage(const Astra::CommandList& cmdList, const std::string& path, nvvk::ResourceAllocatorDma& alloc, bool dummy = false);
+		/**
+		 * \~spanish @brief Crea una textura a partir de una imagen ya decodificada. Si trae sus mipmaps se suben todos directamente, si no se generan en la GPU
+		 * \~english @brief Creates a texture from an already decoded image. If it has its mipmaps they are all uploaded directly, otherwise they are generated on the GPU
+		 */
+		nvvk::Texture createTextureImage(const Astra::CommandList& cmdList, const TextureData& data, nvvk::ResourceAllocatorDma& alloc);
 
+	private:
 		/**
-		 * \~spanish @brief Convierte un Mesh a un objeto apropiado para la construcción de estructuras de aceleración.
-		 * \~english @brief Transforms the Mesh object into an appropiate format for building the acceleration structure
+		 * \~spanish @brief Sube una textura con todos sus niveles ya calculados, comprimida o no
+		 * \~english @brief Uploads a texture with all its levels already computed, compressed or not
 		 */
-		nvvk::RaytracingBuilderKHR::BlasInput objectToVkGeometry(const Astra::Mesh& model);
+		nvvk::Texture createTextureImageLevels(const Astra::CommandList& cmdList, const TextureData& data, nvvk::ResourceAllocatorDma& alloc, const VkSamplerCreateInfo& samplerCreateInfo);
+
+	public:
+
+		/**
+		 * \~spanish @brief Convierte un Mesh a un objeto apropiado para la construcción de estructuras de aceleración. @p lod elige el nivel de detalle
+		 * \~english @brief Transforms the Mesh object into an appropiate format for building the acceleration structure. @p lod picks the level of detail
+		 */
+		nvvk::RaytracingBuilderKHR::BlasInput objectToVkGeometry(const Astra::Mesh& model, uint32_t lod = 0);
 
 		/**
 		 * \~spanish @brief Crea un UBO del tipo @p T
@@ -138,6 +195,44 @@ namespace Astra
 		 * \~english @brief Waits for the GPU queue to be idle.
 		 */
 		void queueWaitIdle();
+
+		/**
+		 * \~spanish @brief Indica cuántos frames puede haber en vuelo, cada uno con su fence. Lo llama el Renderer, con 0 deja de haberlos
+		 * \~english @brief Sets how many frames can be in flight, each one with its fence. Called by the Renderer, 0 means there are none
+		 */
+		void initFrames(uint32_t count);
+		/**
+		 * \~spanish @brief Destruye un recurso con @p destroy cuando terminen los frames que están en vuelo ahora y el que se está grabando, en lugar de esperar a la GPU.
+		 * Si no hay ninguno lo destruye ya. Solo desde el hilo principal
+		 * \~english @brief Destroys a resource with @p destroy once the frames in flight right now and the one being recorded finish, instead of waiting for the GPU.
+		 * If there are none it destroys it right away. Main thread only
+		 */
+		void retire(std::function<void()> destroy);
+		/**
+		 * \~spanish @brief El Renderer avisa de que ha enviado el frame @p frame con su fence
+		 * \~english @brief The Renderer tells that it submitted the frame @p frame with its fence
+		 */
+		void frameSubmitted(uint32_t frame);
+		/**
+		 * \~spanish @brief El Renderer avisa de que ha esperado al fence del frame @p frame. Destruye lo que ya no usa ningún frame
+		 * \~english @brief The Renderer tells that it waited for the fence of the frame @p frame. Destroys what no frame uses anymore
+		 */
+		void frameCompleted(uint32_t frame);
+		/**
+		 * \~spanish @brief Número de frames que puede haber en vuelo, 0 si no hay Renderer
+		 * \~english @brief Number of frames that can be in flight, 0 if there is no Renderer
+		 */
+		uint32_t getFrameCount() const;
+		/**
+		 * \~spanish @brief Frame que se está grabando. La GPU ya ha terminado con lo que usó la última vez, así que sus recursos por frame se pueden reescribir
+		 * \~english @brief Frame being recorded. The GPU is already done with what it used last time, so its per-frame resources can be written again
+		 */
+		uint32_t getFrameIndex() const;
+		/**
+		 * \~spanish @brief Destruye todo lo retirado. Solo con la GPU libre
+		 * \~english @brief Destroys everything retired. Only with the GPU idle
+		 */
+		void flushRetired();
 	};
 
 #define AstraDevice Astra::Device::getInstance()
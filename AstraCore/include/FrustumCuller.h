@@ -0,0 +1,60 @@
+#pragma once
+#include <InstanceStorage.h>
+#include <glm/glm.hpp>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace Astra
+{
+	class Mesh;
+
+	/**
+	 * @class FrustumCuller
+	 * \~spanish @brief Descarte en CPU de las instancias que quedan fuera del frustum de la cámara. Guarda por columnas la caja de mundo de cada instancia,
+	 * que solo recalcula para las que se han movido, y las prueba de ocho en ocho con AVX2 si la CPU lo tiene, repartidas entre los hilos del ThreadPool
+	 * \~english @brief CPU culling of the instances outside the camera frustum. It stores by columns the world box of every instance,
+	 * which is only recomputed for the ones that moved, and tests them eight at a time with AVX2 if the CPU has it, split between the threads of the ThreadPool
+	 */
+	class FrustumCuller
+	{
+	private:
+		// world boxes, padded to a multiple of 8 so the last group can be loaded whole
+		std::vector<float> _minX;
+		std::vector<float> _minY;
+		std::vector<float> _minZ;
+		std::vector<float> _maxX;
+		std::vector<float> _maxY;
+		std::vector<float> _maxZ;
+		std::vector<uint8_t> _inside;
+		size_t _count{ 0 };
+		size_t _culledCount{ 0 };
+		bool _avx2;
+
+	public:
+		FrustumCuller();
+
+		/**
+		 * \~spanish @brief Transforma los límites de su malla a una caja de mundo para cada instancia con eInstanceBoundsDirty. Las mallas sin límites nunca se descartan
+		 * \~english @brief Transforms the bounds of its mesh into a world box for every instance with eInstanceBoundsDirty. Meshes without bounds are never culled
+		 */
+		void updateBounds(InstanceStorage& instances, const std::vector<Mesh>& meshes);
+		/**
+		 * \~spanish @brief Prueba cada caja contra los planos del frustum de @p viewProj (profundidad de 0 a 1, como la de la cámara)
+		 * \~english @brief Tests every box against the frustum planes of @p viewProj (depth from 0 to 1, as the camera one)
+		 */
+		void cull(const glm::mat4& viewProj);
+		/**
+		 * \~spanish @brief Indica si la caja de la instancia @p index toca el frustum en el último cull()
+		 * \~english @brief Tells whether the box of the @p index instance touched the frustum in the last cull()
+		 */
+		bool isInside(size_t index) const;
+		/**
+		 * \~spanish @brief Instancias fuera del frustum en el último cull(), sin contar si son visibles o no
+		 * \~english @brief Instances outside the frustum in the last cull(), whether they are visible or not
+		 */
+		size_t getCulledCount() const;
+		size_t size() const;
+		void clear();
+	};
+}
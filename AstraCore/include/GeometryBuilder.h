@@ -0,0 +1,107 @@
+#pragma once
+#include <Mesh.h>
+#include <MaterialCache.h>
+#include <MeshProcessing.h>
+#include <nvvk/resourceallocator_vk.hpp>
+#include <nvvk/commands_vk.hpp>
+#include <mutex>
+#include <cfloat>
+#include <cstdint>
+#include <cstddef>
+
+namespace Astra
+{
+	/**
+	 * @class GeometryBuilder
+	 * \~spanish @brief Construye una malla procedural escribiendo directamente en un buffer de staging propio, sin vectores intermedios en CPU.
+	 * Los vértices y los índices se escriben una sola vez en getVertices() y getIndices() y finish() los copia a los buffers de la malla.
+	 * El buffer de staging es del builder, así que las cargas de la escena que liberan la memoria de staging del allocator no le afectan.
+	 * La malla resultante solo tiene sus datos en GPU: usa vértices Vertex sin empaquetar, un solo material y no tiene meshlets ni niveles de detalle.
+	 * Se obtiene con Scene::beginShape() y se termina con Scene::addShape()
+	 * \~english @brief Builds a procedural mesh writing straight into a staging buffer of its own, without intermediate CPU vectors.
+	 * Vertices and indices are written once into getVertices() and getIndices() and finish() copies them to the buffers of the mesh.
+	 * The staging buffer belongs to the builder, so the scene loads that release the staging memory of the allocator do not touch it.
+	 * The resulting mesh only has its data on the device: it uses plain Vertex vertices, a single material and has no meshlets nor levels of detail.
+	 * Obtained with Scene::beginShape() and finished with Scene::addShape()
+	 */
+	class GeometryBuilder
+	{
+	private:
+		nvvk::ResourceAllocatorDma* _alloc{ nullptr };
+
+		nvvk::Buffer _vertexBuffer;
+		nvvk::Buffer _indexBuffer;
+		nvvk::Buffer _matIndexBuffer;
+		// host visible, vertices first and indices after them, mapped until finish()
+		nvvk::Buffer _stagingBuffer;
+		VkDeviceSize _vertexSize{ 0 };
+		VkDeviceSize _indexSize{ 0 };
+		Vertex* _vertices{ nullptr };
+		uint32_t* _indices{ nullptr };
+		size_t _vertexCount{ 0 };
+		size_t _triangleCount{ 0 };
+
+		MeshBounds _bounds;
+		// box of everything given to writeVertices() and extendBounds()
+		glm::vec3 _boundsMin{ FLT_MAX };
+		glm::vec3 _boundsMax{ -FLT_MAX };
+		std::mutex _boundsMutex;
+		bool _finished{ false };
+
+		void releaseStaging();
+
+	public:
+		/**
+		 * \~spanish @brief Crea los buffers de GPU y reserva la memoria de staging para @p vertexCount vértices y @p triangleCount triángulos
+		 * \~english @brief Creates the device buffers and reserves the staging memory for @p vertexCount vertices and @p triangleCount triangles
+		 */
+		GeometryBuilder(nvvk::ResourceAllocatorDma* alloc, size_t vertexCount, size_t triangleCount);
+		GeometryBuilder(const GeometryBuilder&) = delete;
+		GeometryBuilder& operator=(const GeometryBuilder&) = delete;
+		/**
+		 * \~spanish @brief Si no se ha llamado a finish() libera los buffers
+		 * \~english @brief Frees the buffers if finish() was not called
+		 */
+		~GeometryBuilder();
+
+		/**
+		 * \~spanish @brief Vértices de la malla en memoria de staging. Es memoria de solo escritura: leerla es muy lento. Se pueden escribir desde varios hilos
+		 * \~english @brief Vertices of the mesh in staging memory. It is write-only memory: reading it is very slow. They can be written from several threads
+		 */
+		Vertex* getVertices();
+		/**
+		 * \~spanish @brief Tres índices por triángulo en memoria de staging, con las mismas condiciones que getVertices()
+		 * \~english @brief Three indices per triangle in staging memory, with the same conditions as getVertices()
+		 */
+		uint32_t* getIndices();
+		size_t getVertexCount() const;
+		size_t getTriangleCount() const;
+		/**
+		 * \~spanish @brief Copia @p count vértices a partir de la posición @p first y amplía los límites con ellos mientras siguen en la caché.
+		 * Se puede llamar desde varios hilos para rangos distintos
+		 * \~english @brief Copies @p count vertices starting at slot @p first and extends the bounds with them while they are still in the cache.
+		 * It can be called from several threads for different ranges
+		 */
+		void writeVertices(size_t first, const Vertex* vertices, size_t count);
+		/**
+		 * \~spanish @brief Amplía los límites con una caja, para los generadores que escriben directamente en getVertices(). Se puede llamar desde varios hilos
+		 * \~english @brief Extends the bounds with a box, for the generators that write straight into getVertices(). It can be called from several threads
+		 */
+		void extendBounds(const glm::vec3& min, const glm::vec3& max);
+		/**
+		 * \~spanish @brief Límites de la malla si el generador ya los conoce, tienen preferencia sobre los acumulados. Si no hay ninguno, la malla no tiene límites
+		 * y no se descarta nunca: la memoria de staging no se vuelve a leer
+		 * \~english @brief Bounds of the mesh if the generator already knows them, they take precedence over the accumulated ones. If there are none, the mesh has no bounds
+		 * and is never culled: the staging memory is not read back
+		 */
+		void setBounds(const MeshBounds& bounds);
+
+		/**
+		 * \~spanish @brief Sube los datos escritos y pasa los buffers a @p mesh con @p material, que se pide a @p materialCache. Espera a que termine la copia
+		 * y después los punteros de getVertices() y getIndices() dejan de ser válidos
+		 * \~english @brief Uploads the written data and hands the buffers to @p mesh with @p material, which is acquired from @p materialCache. Waits for the copy
+		 * to finish and afterwards the getVertices() and getIndices() pointers are no longer valid
+		 */
+		void finish(Mesh& mesh, const WaveFrontMaterial& material, MaterialCache& materialCache);
+	};
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <Mesh.h>
+#include <TextureCache.h>
+#include <glm/glm.hpp>
+#include <vector>
+#include <string>
+#include <memory>
+#include <unordered_map>
+#include <cstdint>
+
+namespace Astra
+{
+	/**
+	 * @struct GltfNode
+	 * \~spanish @brief Nodo de un glTF que tiene malla. Su transformación es relativa a @p parent e incluye la de los nodos sin malla que haya entre ambos
+	 * \~english @brief Node of a glTF file that has a mesh. Its transform is relative to @p parent and includes the one of the nodes without a mesh in between
+	 */
+	struct GltfNode
+	{
+		/**
+		 * \~spanish @brief Posición de la malla en GltfData::meshes. Varios nodos pueden compartirla
+		 * \~english @brief Index of the mesh in GltfData::meshes. Several nodes may share it
+		 */
+		int mesh{ -1 };
+		/**
+		 * \~spanish @brief Posición en GltfData::nodes del antecesor más cercano con malla, -1 si no tiene. Siempre está antes que el nodo
+		 * \~english @brief Index in GltfData::nodes of the closest ancestor with a mesh, -1 if there is none. It always comes before the node
+		 */
+		int parent{ -1 };
+		glm::mat4 transform{ 1.0f };
+		std::string name;
+	};
+
+	/**
+	 * @struct GltfData
+	 * \~spanish @brief Resultado de leer un glTF. Cada malla del fichero es una Mesh con todas sus primitivas juntas, y las texturas apuntan al fichero de la imagen
+	 * o, si va dentro del glTF, a un nombre "fichero#imageN" que se busca en @p embeddedImages
+	 * \~english @brief Result of parsing a glTF file. Every mesh in the file becomes a Mesh with all its primitives together, and the textures point to the image file
+	 * or, if it is inside the glTF, to a "file#imageN" name that is looked up in @p embeddedImages
+	 */
+	struct GltfData
+	{
+		std::vector<Mesh> meshes;
+		std::vector<GltfNode> nodes;
+		/**
+		 * \~spanish @brief Imágenes dentro del glTF, sin decodificar, por su nombre en texturePaths. Apuntan a @p source
+		 * \~english @brief Images inside the glTF, still encoded, by their name in texturePaths. They point into @p source
+		 */
+		std::unordered_map<std::string, std::pair<const uint8_t*, size_t>> embeddedImages;
+		/**
+		 * \~spanish @brief Modelo leído. Las mallas que usan sus buffers directamente también lo mantienen vivo
+		 * \~english @brief Parsed model. Meshes that use its buffers directly keep it alive too
+		 */
+		std::shared_ptr<const void> source;
+		std::string warning;
+		std::string error;
+	};
+
+	/**
+	 * \~spanish @brief Devuelve si el fichero es un .gltf o un .glb
+	 * \~english @brief Returns whether the file is a .gltf or a .glb file
+	 */
+	bool isGltfFile(const std::string& path);
+
+	/**
+	 * \~spanish @brief Lee un .gltf o un .glb. Los .glb se proyectan en memoria. Los índices de 32 bits y los vértices que ya tienen el formato de Vertex
+	 * se usan sin copiarlos; el resto se convierte en paralelo en el ThreadPool. Devuelve false si ha habido algún error, que se describe en @p data.error
+	 * \~english @brief Parses a .gltf or a .glb file. .glb files are memory mapped. 32 bit indices and vertices already in the Vertex layout are used
+	 * without copying them; the rest is converted in parallel on the ThreadPool. Returns false on error, which is described in @p data.error
+	 */
+	bool parseGltf(const std::string& path, GltfData& data);
+
+	/**
+	 * \~spanish @brief Decodifica en paralelo las texturas de todas las mallas, tanto las de fichero como las que van dentro del glTF.
+	 * Cada imagen se decodifica una sola vez, y las que ya estén en @p cached se saltan
+	 * \~english @brief Decodes in parallel the textures of every mesh, both the external files and the ones inside the glTF.
+	 * Every image is decoded only once, and the ones already in @p cached are skipped
+	 */
+	void decodeGltfTextures(GltfData& data, const TextureCache* cached = nullptr);
+}
@@ -0,0 +1,146 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace Astra
+{
+	/**
+	 * @struct Handle
+	 * \~spanish @brief Referencia estable a un elemento de un HandleTable. Sigue siendo válida aunque se borren otros elementos,
+	 * y deja de serlo cuando se borra el suyo aunque su hueco se reutilice. @p T solo sirve para no mezclar handles de tablas distintas
+	 * \~english @brief Stable reference to an element of a HandleTable. It stays valid when other elements are removed,
+	 * and stops being valid once its own element is removed even if its slot is reused. @p T only keeps handles of different tables apart
+	 */
+	template <typename T>
+	struct Handle
+	{
+		uint32_t slot{ UINT32_MAX };
+		uint32_t generation{ 0 };
+
+		bool isNull() const
+		{
+			return slot == UINT32_MAX;
+		}
+		bool operator==(const Handle& other) const
+		{
+			return slot == other.slot && generation == other.generation;
+		}
+		bool operator!=(const Handle& other) const
+		{
+			return !(*this == other);
+		}
+	};
+
+	/**
+	 * @class HandleTable
+	 * \~spanish @brief Traduce handles a posiciones de un array denso, que el dueño compacta moviendo el último elemento al hueco del borrado.
+	 * Añadir, borrar y buscar son O(1). La tabla solo guarda la traducción, los datos siguen en los arrays del dueño
+	 * \~english @brief Translates handles to positions of a dense array, which the owner compacts by moving the last element into the removed one.
+	 * Adding, removing and looking up are O(1). The table only holds the translation, the data stays in the arrays of the owner
+	 */
+	template <typename T>
+	class HandleTable
+	{
+	private:
+		struct Slot
+		{
+			uint32_t dense;
+			uint32_t generation;
+		};
+		std::vector<Slot> _slots;
+		std::vector<uint32_t> _denseToSlot;
+		std::vector<uint32_t> _freeSlots;
+
+	public:
+		static constexpr uint32_t InvalidIndex = UINT32_MAX;
+
+		/**
+		 * \~spanish @brief Handle para un elemento nuevo al final del array denso
+		 * \~english @brief Handle for a new element at the end of the dense array
+		 */
+		Handle<T> push()
+		{
+			uint32_t slot;
+			if (!_freeSlots.empty())
+			{
+				slot = _freeSlots.back();
+				_freeSlots.pop_back();
+			}
+			else
+			{
+				slot = static_cast<uint32_t>(_slots.size());
+				_slots.push_back({ InvalidIndex, 0 });
+			}
+			_slots[slot].dense = static_cast<uint32_t>(_denseToSlot.size());
+			_denseToSlot.push_back(slot);
+			return { slot, _slots[slot].generation };
+		}
+
+		/**
+		 * \~spanish @brief Borra el elemento de la posición @p dense, igual que hace el dueño: el último pasa a su lugar
+		 * \~english @brief Removes the element at @p dense, the same way the owner does: the last one takes its place
+		 */
+		void removeAt(uint32_t dense)
+		{
+			const uint32_t slot = _denseToSlot[dense];
+			const uint32_t lastSlot = _denseToSlot.back();
+			_denseToSlot[dense] = lastSlot;
+			_slots[lastSlot].dense = dense;
+			_denseToSlot.pop_back();
+
+			// old handles to this slot stop matching
+			_slots[slot].dense = InvalidIndex;
+			_slots[slot].generation++;
+			_freeSlots.push_back(slot);
+		}
+
+		/**
+		 * \~spanish @brief Posición de @p handle en el array denso, InvalidIndex si ya no existe
+		 * \~english @brief Position of @p handle in the dense array, InvalidIndex if it no longer exists
+		 */
+		uint32_t find(Handle<T> handle) const
+		{
+			if (handle.slot >= _slots.size() || _slots[handle.slot].generation != handle.generation)
+				return InvalidIndex;
+			return _slots[handle.slot].dense;
+		}
+
+		bool contains(Handle<T> handle) const
+		{
+			return find(handle) != InvalidIndex;
+		}
+
+		Handle<T> getHandle(uint32_t dense) const
+		{
+			const uint32_t slot = _denseToSlot[dense];
+			return { slot, _slots[slot].generation };
+		}
+
+		size_t size() const
+		{
+			return _denseToSlot.size();
+		}
+
+		void reserve(size_t count)
+		{
+			_slots.reserve(count);
+			_denseToSlot.reserve(count);
+		}
+
+		/**
+		 * \~spanish @brief Borra todo. Los handles anteriores no vuelven a ser válidos
+		 * \~english @brief Removes everything. Previous handles never become valid again
+		 */
+		void clear()
+		{
+			for (uint32_t slot : _denseToSlot)
+			{
+				_slots[slot].dense = InvalidIndex;
+				_slots[slot].generation++;
+				_freeSlots.push_back(slot);
+			}
+			_denseToSlot.clear();
+		}
+	};
+}
@@ -0,0 +1,188 @@
+#pragma once
+#include <HandleTable.h>
+#include <glm/glm.hpp>
+#include <unordered_map>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+namespace Astra
+{
+	class MeshInstance;
+	using InstanceHandle = Handle<MeshInstance>;
+
+	/**
+	 * \~spanish @brief Bits de estado de cada instancia
+	 * \~english @brief State bits of every instance
+	 */
+	enum InstanceFlags : uint8_t
+	{
+		eInstanceVisible = 1,
+		// the world transform or the visibility changed since clearDirty()
+		eInstanceDirty = 2,
+		// the local transform or the parent changed, the world transform is stale until updateTransforms()
+		eInstanceLocalDirty = 4,
+		// the world transform was recomputed in the last updateTransforms(), only meaningful inside it
+		eInstanceMoved = 8,
+		// the world transform or the mesh changed since consumeBoundsDirty(), for the world boxes of the FrustumCuller
+		eInstanceBoundsDirty = 16,
+		// the world transform, the mesh or the visibility changed since consumeGpuDirty(), for the instance buffer of the GPU-driven raster
+		eInstanceGpuDirty = 32
+	};
+
+	/**
+	 * @class InstanceStorage
+	 * \~spanish @brief Instancias de una escena guardadas por columnas: transformaciones, padre, malla, nivel de detalle y bits de estado, cada uno en su array contiguo.
+	 * Los nombres son opcionales y se guardan una sola vez aunque los repitan muchas instancias. Las instancias se identifican por su posición,
+	 * que cambia al borrar otras (la última pasa al hueco), o por un InstanceHandle, que no cambia.
+	 * Cada instancia tiene una transformación local, relativa a su padre, y una de mundo que calcula updateTransforms() solo para los subárboles que han cambiado
+	 * \~english @brief Instances of a scene stored by columns: transforms, parent, mesh, level of detail and state bits, each one in its own contiguous array.
+	 * Names are optional and stored only once even if many instances repeat them. Instances are identified by their position,
+	 * which changes when others are removed (the last one fills the gap), or by an InstanceHandle, which does not.
+	 * Every instance has a local transform, relative to its parent, and a world one that updateTransforms() computes only for the subtrees that changed
+	 */
+	class InstanceStorage
+	{
+	private:
+		std::vector<glm::mat4> _locals;
+		std::vector<glm::mat4> _transforms; // world
+		std::vector<InstanceHandle> _parents;
+		std::vector<uint32_t> _meshes;
+		std::vector<uint32_t> _lods;
+		std::vector<uint8_t> _flags;
+		std::vector<uint32_t> _nameIds; // 0 is no name
+
+		std::vector<std::string> _names;
+		std::unordered_map<std::string, uint32_t> _nameLookup;
+		HandleTable<MeshInstance> _handles;
+
+		// instances sorted by depth in the hierarchy, every level starts at its offset
+		std::vector<uint32_t> _parentIndices; // _parents resolved, valid while the order is
+		std::vector<uint32_t> _order;
+		std::vector<size_t> _levelOffsets;
+		bool _orderDirty{ false };
+		size_t _parentCount{ 0 }; // instances with a parent handle, without any the order is not needed
+		bool _pendingTransforms{ false };
+		bool _pendingGpu{ false }; // some instance may have eInstanceGpuDirty
+		uint64_t _meshVersion{ 0 };
+
+		uint32_t internName(const std::string& name);
+		void rebuildOrder();
+
+	public:
+		static constexpr uint32_t InvalidIndex = HandleTable<MeshInstance>::InvalidIndex;
+		static constexpr uint32_t NoParent = InvalidIndex;
+
+		InstanceStorage();
+
+		/**
+		 * \~spanish @brief Añade una instancia de la malla @p mesh y devuelve su posición. @p transform es relativa a @p parent
+		 * \~english @brief Adds an instance of the @p mesh mesh and returns its position. @p transform is relative to @p parent
+		 */
+		size_t add(uint32_t mesh, const glm::mat4& transform, const std::string& name = "", uint32_t parent = NoParent);
+		/**
+		 * \~spanish @brief Añade @p count instancias sin nombre de la malla @p mesh, una por transformación. Devuelve la posición de la primera
+		 * \~english @brief Adds @p count unnamed instances of the @p mesh mesh, one per transform. Returns the position of the first one
+		 */
+		size_t add(uint32_t mesh, const glm::mat4* transforms, size_t count);
+		/**
+		 * \~spanish @brief Borra la instancia de la posición @p index en O(1), la última pasa a ocupar su lugar. Sus hijos se quedan sin padre donde estaban
+		 * \~english @brief Removes the instance at @p index in O(1), the last one takes its place. Its children are left without a parent where they were
+		 */
+		void remove(size_t index);
+		/**
+		 * \~spanish @brief Borra la instancia de @p handle. Devuelve false si ya no existía
+		 * \~english @brief Removes the instance of @p handle. Returns false if it no longer existed
+		 */
+		bool remove(InstanceHandle handle);
+		void clear();
+		void reserve(size_t count);
+
+		size_t size() const;
+		bool empty() const;
+		InstanceHandle getHandle(size_t index) const;
+		/**
+		 * \~spanish @brief Posición actual de la instancia de @p handle, InvalidIndex si se ha borrado
+		 * \~english @brief Current position of the instance of @p handle, InvalidIndex if it was removed
+		 */
+		uint32_t find(InstanceHandle handle) const;
+		/**
+		 * \~spanish @brief Cambia la malla @p from por @p to en todas las instancias que la usan
+		 * \~english @brief Replaces the @p from mesh with @p to in every instance using it
+		 */
+		void replaceMesh(uint32_t from, uint32_t to);
+
+		/**
+		 * \~spanish @brief Transformación de mundo, al día tras updateTransforms()
+		 * \~english @brief World transform, up to date after updateTransforms()
+		 */
+		const glm::mat4& getTransform(size_t index) const;
+		const glm::mat4& getLocalTransform(size_t index) const;
+		void setLocalTransform(size_t index, const glm::mat4& transform);
+		uint32_t getParent(size_t index) const;
+		/**
+		 * \~spanish @brief Cuelga la instancia @p index de @p parent (NoParent la deja suelta). Con @p keepWorld la local se cambia para que no se mueva.
+		 * Devuelve false, sin cambiar nada, si crearía un ciclo
+		 * \~english @brief Attaches the @p index instance to @p parent (NoParent detaches it). With @p keepWorld the local transform is changed so it does not move.
+		 * Returns false, changing nothing, if it would create a cycle
+		 */
+		bool setParent(size_t index, uint32_t parent, bool keepWorld = false);
+		/**
+		 * \~spanish @brief Recalcula las transformaciones de mundo de las instancias cuya local o la de algún antecesor ha cambiado, nivel a nivel de la jerarquía.
+		 * Las que cambian quedan marcadas con eInstanceDirty
+		 * \~english @brief Recomputes the world transforms of the instances whose local transform, or the one of any ancestor, changed, level by level of the hierarchy.
+		 * The ones that change are marked with eInstanceDirty
+		 */
+		void updateTransforms();
+		uint32_t getMeshIndex(size_t index) const;
+		uint32_t getLod(size_t index) const;
+		void setLod(size_t index, uint32_t lod);
+		bool getVisible(size_t index) const;
+		void setVisible(size_t index, bool visible);
+		/**
+		 * \~spanish @brief Nombre de la instancia, vacío si no tiene
+		 * \~english @brief Name of the instance, empty if it has none
+		 */
+		const std::string& getName(size_t index) const;
+		void setName(size_t index, const std::string& name);
+
+		/**
+		 * \~spanish @brief Indica si ha cambiado la transformación de mundo o la visibilidad desde el último clearDirty()
+		 * \~english @brief Tells whether the world transform or the visibility changed since the last clearDirty()
+		 */
+		bool isDirty(size_t index) const;
+		void clearDirty();
+		/**
+		 * \~spanish @brief Indica si la transformación de mundo o la malla han cambiado desde la última llamada para esta instancia, y quita la marca.
+		 * Se puede llamar a la vez desde varios hilos para instancias distintas
+		 * \~english @brief Tells whether the world transform or the mesh changed since the last call for this instance, and clears the mark.
+		 * It can be called at the same time from several threads for different instances
+		 */
+		bool consumeBoundsDirty(size_t index);
+		/**
+		 * \~spanish @brief Como consumeBoundsDirty(), pero con eInstanceGpuDirty, que también cambia con la visibilidad
+		 * \~english @brief Like consumeBoundsDirty(), but with eInstanceGpuDirty, which also changes with the visibility
+		 */
+		bool consumeGpuDirty(size_t index);
+		/**
+		 * \~spanish @brief Indica si alguna instancia puede tener eInstanceGpuDirty desde la última llamada, para no recorrerlas en los frames sin cambios
+		 * \~english @brief Tells whether any instance may have eInstanceGpuDirty since the last call, so frames without changes do not walk them
+		 */
+		bool consumeGpuPending();
+		/**
+		 * \~spanish @brief Cambia cada vez que se añaden o borran instancias o alguna cambia de malla, para rehacer solo entonces lo que depende de sus mallas
+		 * \~english @brief Changes every time instances are added or removed or any of them changes its mesh, so what depends on their meshes is only rebuilt then
+		 */
+		uint64_t getMeshVersion() const;
+
+		/**
+		 * \~spanish @brief Columnas completas, para recorrerlas en bloque
+		 * \~english @brief Whole columns, to walk them in bulk
+		 */
+		const std::vector<glm::mat4>& getTransforms() const;
+		const std::vector<uint32_t>& getMeshIndices() const;
+		const std::vector<uint32_t>& getLods() const;
+		const std::vector<uint8_t>& getFlags() const;
+	};
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <string>
+#include <cstddef>
+
+namespace Astra
+{
+	/**
+	 * @class MappedFile
+	 * \~spanish @brief Fichero proyectado en memoria de solo lectura. El contenido se lee directamente de la caché de páginas del sistema sin copiarlo.
+	 * \~english @brief Read-only memory mapped file. Its contents are read straight from the OS page cache without copying them.
+	 */
+	class MappedFile
+	{
+	private:
+		const char* _data{ nullptr };
+		size_t _size{ 0 };
+		bool _open{ false };
+#ifdef _WIN32
+		void* _file{ nullptr };
+		void* _mapping{ nullptr };
+#else
+		int _fd{ -1 };
+#endif
+
+	public:
+		MappedFile() = default;
+		explicit MappedFile(const std::string& path);
+		~MappedFile();
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+		MappedFile(MappedFile&& other) noexcept;
+		MappedFile& operator=(MappedFile&& other) noexcept;
+
+		/**
+		 * \~spanish @brief Abre y proyecta el fichero. Devuelve false si no se ha podido abrir
+		 * \~english @brief Opens and maps the file. Returns false if it could not be opened
+		 */
+		bool open(const std::string& path);
+		void close();
+
+		bool isOpen() const { return _open; }
+		const char* data() const { return _data; }
+		size_t size() const { return _size; }
+	};
+}
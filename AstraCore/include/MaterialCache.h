@@ -0,0 +1,87 @@
+#pragma once
+#include <nvvk/resourceallocator_vk.hpp>
+#include <CommandList.h>
+#include <host_device.h>
+#include <unordered_map>
+#include <vector>
+#include <mutex>
+#include <cstdint>
+
+namespace Astra
+{
+	/**
+	 * @class MaterialCache
+	 * \~spanish @brief Tabla de materiales de una escena sin duplicados. Cada material se identifica por el hash de su WaveFrontMaterial, con la textura ya
+	 * traducida a la tabla de texturas, así que los materiales repetidos en varios modelos se guardan una sola vez. Las entradas llevan un contador de referencias.
+	 * Los shaders la leen entera desde el binding eMaterials y los índices de material de cada triángulo ya apuntan a ella.
+	 * La posición 0 es siempre el material por defecto
+	 * \~english @brief Material table of a scene without duplicates. Every material is identified by the hash of its WaveFrontMaterial, with the texture already
+	 * translated to the texture table, so materials repeated across several models are stored only once. Entries are reference counted.
+	 * Shaders read the whole table from the eMaterials binding and the material index of every triangle already points to it.
+	 * Slot 0 is always the default material
+	 */
+	class MaterialCache
+	{
+	private:
+		nvvk::ResourceAllocatorDma* _alloc{ nullptr };
+
+		// freed slots keep a copy of the default until they are reused
+		std::vector<WaveFrontMaterial> _materials;
+		std::vector<uint32_t> _refCounts;
+		std::vector<uint64_t> _slotHashes;
+		std::vector<uint32_t> _freeSlots;
+
+		std::unordered_map<uint64_t, uint32_t> _hashSlots;
+		nvvk::Buffer _buffer;
+		size_t _capacity{ 0 };
+		// slots changed since the last upload, from _dirtyBegin to _dirtyEnd
+		size_t _dirtyBegin{ 0 };
+		size_t _dirtyEnd{ 0 };
+		// models can be created from the loader threads
+		mutable std::mutex _mutex;
+
+		void createDefault();
+		void markDirty(size_t slot);
+		uint32_t addSlot(const WaveFrontMaterial& material, uint64_t hash);
+
+	public:
+		void init(nvvk::ResourceAllocatorDma* alloc);
+		/**
+		 * \~spanish @brief Destruye el buffer y vacía la tabla, tenga referencias o no
+		 * \~english @brief Destroys the buffer and empties the table, whether it is referenced or not
+		 */
+		void destroy();
+
+		/**
+		 * \~spanish @brief Devuelve la posición en la tabla de cada material de @p materials, añadiendo una referencia. Los que no están se añaden
+		 * y se suben con el siguiente consumeUpload()
+		 * \~english @brief Returns the table slot of every material in @p materials, adding a reference. Missing ones are added
+		 * and uploaded with the next consumeUpload()
+		 */
+		std::vector<uint32_t> acquire(const std::vector<WaveFrontMaterial>& materials);
+		/**
+		 * \~spanish @brief Quita una referencia a cada material de @p slots. Los que se quedan sin referencias dejan su posición libre
+		 * \~english @brief Removes a reference from every material in @p slots. The ones left without references free their slot
+		 */
+		void release(const std::vector<uint32_t>& slots);
+		/**
+		 * \~spanish @brief Crea el buffer de GPU, con el doble de capacidad, si la tabla ya no cabe. Devuelve si lo ha hecho, y entonces la tabla entera queda pendiente de subir
+		 * @warning Espera a que la GPU deje de usar el anterior, y hay que volver a escribir el descriptor
+		 * \~english @brief Creates the device buffer, with twice the capacity, if the table no longer fits. Returns whether it did, and then the whole table is pending upload
+		 * @warning Waits until the GPU stops using the previous one, and the descriptor has to be written again
+		 */
+		bool reserveBuffer();
+		/**
+		 * \~spanish @brief Devuelve los materiales cambiados desde la última llamada que caben en el buffer, a partir de la posición @p first, y los da por subidos
+		 * \~english @brief Returns the materials changed since the last call that fit in the buffer, starting at slot @p first, and takes them as uploaded
+		 */
+		std::vector<WaveFrontMaterial> consumeUpload(size_t& first);
+
+		/**
+		 * \~spanish @brief Buffer con la tabla completa, en el orden de las posiciones
+		 * \~english @brief Buffer with the whole table, in slot order
+		 */
+		const nvvk::Buffer& getBuffer() const;
+		size_t getUniqueCount() const;
+	};
+}
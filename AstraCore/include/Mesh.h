@@ -6,6 +6,12 @@
 #include <vector>
 #include <vulkan/vulkan.h>
 #include <CommandList.h>
+#include <MappedFile.h>
+#include <Texture.h>
+#include <TextureCache.h>
+#include <MaterialCache.h>
+#include <MeshProcessing.h>
+#include <memory>
 namespace Astra
 {
 	/**
@@ -20,6 +26,70 @@ namespace Astra
 	};
 
 
+	/**
+	 * @struct MeshLoadOptions
+	 * \~spanish @brief Opciones para la carga de modelos desde fichero
+	 * \~english @brief Options for loading models from files
+	 */
+	struct MeshLoadOptions
+	{
+		/**
+		 * \~spanish @brief Usa el lector de obj paralelo. Si es false se usa tinyobj, que es más lento pero sirve de referencia
+		 * \~english @brief Uses the parallel obj parser. If false tinyobj is used instead, which is slower but serves as a reference
+		 */
+		bool parallelParser{ true };
+		/**
+		 * \~spanish @brief Une los vértices repetidos para generar una malla indexada de verdad
+		 * \~english @brief Welds repeated vertices to generate a truly indexed mesh
+		 */
+		bool weldVertices{ true };
+		/**
+		 * \~spanish @brief Si el fichero no tiene normales se calculan suaves, salvo entre triángulos que formen más de este ángulo en grados. Con 0 quedan facetadas
+		 * \~english @brief If the file has no normals smooth ones are computed, except between triangles at more than this angle in degrees. With 0 they are faceted
+		 */
+		float creaseAngle{ 60.0f };
+		/**
+		 * \~spanish @brief Distancia por debajo de la cual dos atributos se consideran iguales al unir vértices. Con 0 solo se unen los idénticos
+		 * \~english @brief Distance under which two attributes are considered equal when welding. With 0 only identical vertices are welded
+		 */
+		float weldEpsilon{ 0.0f };
+		/**
+		 * \~spanish @brief Reordena triángulos y vértices para aprovechar la caché de vértices, reducir el overdraw y leer los vértices en orden
+		 * \~english @brief Reorders triangles and vertices to make good use of the vertex cache, reduce overdraw and fetch the vertices in order
+		 */
+		bool optimizeMesh{ true };
+		/**
+		 * \~spanish @brief Pasa los colores de los materiales a espacio lineal
+		 * \~english @brief Converts the material colors to linear space
+		 */
+		bool linearizeColors{ false };
+		/**
+		 * \~spanish @brief Guarda el resultado en una caché .astramesh y la usa en las siguientes cargas en lugar de leer el obj
+		 * \~english @brief Stores the result in an .astramesh cache and uses it on later loads instead of parsing the obj
+		 */
+		bool useCache{ true };
+		/**
+		 * \~spanish @brief Carpeta de las cachés. Si está vacía se guardan junto a cada modelo
+		 * \~english @brief Cache folder. If empty they are stored next to each model
+		 */
+		std::string cacheDirectory;
+		/**
+		 * \~spanish @brief Formato de los vértices en la GPU, combinación de VertexFormatFlags. Con 0 se usa Vertex tal cual
+		 * \~english @brief Vertex format on the GPU, a combination of VertexFormatFlags. With 0 Vertex is used as it is
+		 */
+		uint32_t vertexFormat{ 0 };
+		/**
+		 * \~spanish @brief Número de niveles de detalle simplificados que se generan además de la malla completa. Con 0 no se generan
+		 * \~english @brief Number of simplified levels of detail generated besides the full mesh. With 0 none are generated
+		 */
+		uint32_t lodCount{ 3 };
+		/**
+		 * \~spanish @brief Fracción de los triángulos del nivel anterior que se intenta conservar en cada nivel de detalle
+		 * \~english @brief Fraction of the triangles of the previous level that every level of detail tries to keep
+		 */
+		float lodReduction{ 0.5f };
+	};
+
 	/**
 	 * @struct Mesh
 	 * \~spanish @brief Representa un modelo 3D como una malla de vértices y triángulos
@@ -65,15 +135,60 @@ namespace Astra
 		 */
 		std::vector<int32_t> materialIndices;
 		/**
-		 * \~spanish @brief Vector de texturas en CPU
-		 * \~english @brief Texture vector on CPU
+		 * \~spanish @brief Posición de cada textura de texturePaths en la tabla de texturas de la escena
+		 * \~english @brief Slot of every texturePaths texture in the scene texture table
+		 */
+		std::vector<uint32_t> textureIds;
+		/**
+		 * \~spanish @brief Posición de cada material de materials en la tabla de materiales de la escena
+		 * \~english @brief Slot of every materials material in the scene material table
 		 */
-		std::vector<nvvk::Texture> textures;
+		std::vector<uint32_t> materialIds;
 		/**
 		 * \~spanish @brief Vector de texturas (paths) en CPU
 		 * \~english @brief Texture path vector on CPU
 		 */
 		std::vector<std::string> texturePaths;
+		/**
+		 * \~spanish @brief Texturas ya decodificadas, pendientes de subir en create(). Vacío si no se ha llamado a decodeTextures()
+		 * \~english @brief Already decoded textures, pending upload in create(). Empty if decodeTextures() was not called
+		 */
+		std::vector<TextureData> decodedTextures;
+		/**
+		 * \~spanish @brief Formato del buffer de vértices, combinación de VertexFormatFlags. Los vértices se empaquetan al crear los buffers, en CPU siguen siendo Vertex
+		 * \~english @brief Vertex buffer format, a combination of VertexFormatFlags. Vertices are packed when the buffers are created, on the CPU they are still Vertex
+		 */
+		uint32_t vertexFormat{ 0 };
+		/**
+		 * \~spanish @brief Índices de los niveles de detalle, uno detrás de otro. Usan los mismos vértices que la malla completa
+		 * \~english @brief Indices of the levels of detail, one after another. They use the same vertices as the full mesh
+		 */
+		std::vector<uint32_t> lodIndices;
+		/**
+		 * \~spanish @brief Triángulo original de cada triángulo de lodIndices, para su material
+		 * \~english @brief Original triangle of every lodIndices triangle, for its material
+		 */
+		std::vector<uint32_t> lodTriangles;
+		/**
+		 * \~spanish @brief Niveles de detalle del 1 en adelante, el 0 es la malla completa
+		 * \~english @brief Levels of detail from 1 onwards, 0 is the full mesh
+		 */
+		std::vector<MeshLod> lods;
+		/**
+		 * \~spanish @brief Caja y esfera que contienen la malla en espacio de objeto, calculadas con computeCullingData()
+		 * \~english @brief Box and sphere containing the mesh in object space, computed by computeCullingData()
+		 */
+		MeshBounds bounds;
+		/**
+		 * \~spanish @brief Límites de los triángulos de cada material, en el orden de materials
+		 * \~english @brief Bounds of the triangles of every material, in materials order
+		 */
+		std::vector<MeshBounds> submeshBounds;
+		/**
+		 * \~spanish @brief Meshlets del modelo en CPU, calculados con computeCullingData()
+		 * \~english @brief Meshlets of the model on CPU, computed by computeCullingData()
+		 */
+		std::vector<Meshlet> meshlets;
 
 		// CPU - GPU side
 		/**
@@ -87,15 +202,27 @@ namespace Astra
 		 */
 		nvvk::Buffer indexBuffer;
 		/**
-		 * \~spanish @brief Buffer de materiales en GPU
-		 * \~english @brief Materials buffer on Device
+		 * \~spanish @brief Buffer de índice de materiales en GPU, ya traducidos a posiciones de la tabla de materiales de la escena
+		 * \~english @brief Material index buffer on Device, already translated to slots of the scene material table
+		 */
+		nvvk::Buffer matIndexBuffer;
+		/**
+		 * \~spanish @brief Transformación que recupera las posiciones cuantizadas al construir el BLAS. Solo existe con eVertexQuantized
+		 * \~english @brief Transform that recovers the quantized positions when building the BLAS. Only exists with eVertexQuantized
 		 */
-		nvvk::Buffer matColorBuffer;
+		nvvk::Buffer dequantBuffer;
 		/**
-		 * \~spanish @brief Buffer de índice de materiales en GPU
-		 * \~english @brief Material index buffer on Device
+		 * \~spanish @brief Meshlets del modelo en GPU, para descartarlos con Scene::cull()
+		 * \~english @brief Meshlets of the model on Device, to cull them with Scene::cull()
 		 */
-		nvvk::Buffer matIndexBuffer;
+		nvvk::Buffer meshletBuffer;
+		uint32_t meshletCount{ 0 };
+		/**
+		 * \~spanish @brief Índices y triángulos originales de los niveles de detalle en GPU
+		 * \~english @brief Indices and original triangles of the levels of detail on Device
+		 */
+		nvvk::Buffer lodIndexBuffer;
+		nvvk::Buffer lodTriangleBuffer;
 
 		// GPU side
 		/**
@@ -103,23 +230,75 @@ namespace Astra
 		 * \~english @brief Contains the GPU memory addresses for the buffers.
 		 */
 		ObjDesc descriptor{}; // gpu buffer addresses
+		/**
+		 * \~spanish @brief Descripción de cada nivel de detalle. La escena las pone justo detrás de la de la malla, a partir de lodDescIndex
+		 * \~english @brief Description of every level of detail. The scene puts them right after the one of the mesh, starting at lodDescIndex
+		 */
+		std::vector<ObjDesc> lodDescriptors;
+		/**
+		 * \~spanish @brief Posición de descriptor en el buffer de descripciones de la escena
+		 * \~english @brief Slot of descriptor in the description buffer of the scene
+		 */
+		uint32_t descIndex{ 0 };
+		uint32_t lodDescIndex{ 0 };
+
+		/**
+		 * \~spanish @brief Datos de los vértices. Si el modelo viene de la caché o de un glTF pueden apuntar a la memoria del fichero y entonces los vectores de CPU están vacíos
+		 * \~english @brief Vertex data. If the model comes from the cache or from a glTF they may point to the file memory and then the CPU vectors are empty
+		 */
+		const Vertex* getVertexData() const;
+		size_t getVertexCount() const;
+		const uint32_t* getIndexData() const;
+		size_t getIndexCount() const;
+		const int32_t* getMaterialIndexData() const;
+		size_t getMaterialIndexCount() const;
+		const uint32_t* getLodIndexData() const;
+		const uint32_t* getLodTriangleData() const;
+		size_t getLodIndexCount() const;
+
+		/**
+		 * \~spanish @brief Dibuja el modelo con el nivel de detalle @p lod
+		 * \~english @brief Draws the model with the @p lod level of detail
+		 */
+		void draw(const CommandList &cmdList, uint32_t lod = 0) const;
+		/**
+		 * \~spanish @brief Crea los buffers y almacena las direcciones de memoria de estos. Las texturas se piden a @p textureCache
+		 * y los materiales pasan a apuntar directamente a su posición en la tabla de la escena. Después los materiales se piden a @p materialCache
+		 * y el índice de material de cada triángulo se sube ya traducido a su posición
+		 * \~english @brief Creates the buffers and stores the device buffer addresses. Textures are acquired from @p textureCache
+		 * and the materials are rewritten to point straight to their slot in the scene table. Then the materials are acquired from @p materialCache
+		 * and the material index of every triangle is uploaded already translated to its slot
+		 */
+		void create(const Astra::CommandList &cmdList, nvvk::ResourceAllocatorDma *alloc, TextureCache &textureCache, MaterialCache &materialCache);
 
 		/**
-		 * \~spanish @brief Dibuja el modelo
-		 * \~english @brief Draws the model
+		 * \~spanish @brief Decodifica en paralelo las texturas de texturePaths en CPU para que create() solo tenga que subirlas. Se puede llamar desde cualquier hilo.
+		 * Las que ya estén en @p cached se saltan y se quedan vacías
+		 * \~english @brief Decodes the texturePaths textures in parallel on the CPU so create() only has to upload them. Can be called from any thread.
+		 * The ones already in @p cached are skipped and left empty
 		 */
-		void draw(const CommandList &cmdList) const;
+		void decodeTextures(const TextureCache* cached = nullptr);
 		/**
-		 * \~spanish @brief Crea los buffers y almacena las direcciones de memoria de estos
-		 * \~english @brief Creates the buffers and stores the device buffer addresses
+		 * \~spanish @brief Decodifica en paralelo las texturas de todas las mallas de @p meshes. Una textura compartida solo se decodifica para la primera malla que la usa,
+		 * así que se tienen que crear en ese orden para que las demás la encuentren en la TextureCache
+		 * \~english @brief Decodes in parallel the textures of every mesh in @p meshes. A shared texture is only decoded for the first mesh using it,
+		 * so they have to be created in that order for the rest to find it in the TextureCache
 		 */
-		void create(const Astra::CommandList &cmdList, nvvk::ResourceAllocatorDma *alloc, uint32_t txtOffset);
+		static void decodeTextures(const std::vector<Mesh*>& meshes, const TextureCache* cached = nullptr);
 		
 		/**
-		 * \~spanish @brief Carga un modelo obj y almacena la información en los vectores de la CPU
-		 * \~english @brief Loads an obj file and stores the data in the CPU vectors
+		 * \~spanish @brief Carga un modelo obj y almacena la información en los vectores de la CPU. Devuelve false, sin vértices ni caché, si no se puede leer
+		 * \~english @brief Loads an obj file and stores the data in the CPU vectors. Returns false, with no vertices nor cache, if it can not be read
+		 */
+		bool loadFromFile(const std::string &path, const MeshLoadOptions &options = {});
+
+		/**
+		 * \~spanish @brief Calcula los meshlets y los límites de la malla y de cada material. Se puede llamar desde cualquier hilo; loadFromFile() ya lo hace
+		 * y los guarda en la caché. Si no se ha llamado, create() lo hace al crear los buffers
+		 * \~english @brief Computes the meshlets and the bounds of the mesh and of every material. Can be called from any thread; loadFromFile() already does it
+		 * and stores them in the cache. If it was not called, create() does it when the buffers are created
 		 */
-		void loadFromFile(const std::string &path);
+		void computeCullingData();
 
 		/**
 		* \~spanish @brief Inicializa un mesh a partir de una geometria y un material, para figuras simples
@@ -127,17 +306,69 @@ namespace Astra
 		*/
 		void fromGeoMat(const Astra::Geometry& geom, const WaveFrontMaterial &material);
 
+		/**
+		 * \~spanish @brief Usa datos que pertenecen a @p owner en lugar de los vectores de CPU, sin copiarlos. @p owner se mantiene vivo mientras viva la malla.
+		 * Los punteros nulos siguen usando su vector
+		 * \~english @brief Uses data owned by @p owner instead of the CPU vectors, without copying it. @p owner is kept alive as long as the mesh.
+		 * Null pointers keep using their vector
+		 */
+		void setExternalData(std::shared_ptr<const void> owner, const Vertex* vertexData, size_t vertexCount, const uint32_t* indexData, size_t indexCount,
+			const int32_t* materialIndexData = nullptr, size_t materialIndexCount = 0);
+		/**
+		 * \~spanish @brief Para mallas cuyos datos solo están en GPU, como las de GeometryBuilder: no hay datos en CPU pero los tamaños siguen siendo válidos
+		 * \~english @brief For meshes whose data is only on the device, like the GeometryBuilder ones: there is no CPU data but the sizes are still valid
+		 */
+		void setDeviceOnlyData(size_t vertexCount, size_t indexCount);
+		/**
+		 * \~spanish @brief Igual que setExternalData() para los niveles de detalle, con el mismo dueño
+		 * \~english @brief Same as setExternalData() for the levels of detail, with the same owner
+		 */
+		void setExternalLodData(const uint32_t* indexData, const uint32_t* triangleData, size_t indexCount);
+
+		/**
+		 * \~spanish @brief Lee el obj con tinyobj, sin el resto del procesado de loadFromFile(). Devuelve si el fichero tenía normales, si no @p positionIds tiene la posición
+		 * de cada vértice. Si no lo puede leer no deja vértices
+		 * \~english @brief Reads the obj with tinyobj, without the rest of the loadFromFile() processing. Returns whether the file had normals, if not @p positionIds holds the position
+		 * of every vertex. If it can not be read it leaves no vertices
+		 */
+		bool loadObjTinyobj(const std::string& path, std::vector<uint32_t>& positionIds);
+		/**
+		 * \~spanish @brief Lee el obj con el lector paralelo, sin el resto del procesado de loadFromFile(). Devuelve si el fichero tenía normales, si no @p positionIds tiene la posición
+		 * de cada vértice. Si no lo puede leer no deja vértices
+		 * \~english @brief Reads the obj with the parallel parser, without the rest of the loadFromFile() processing. Returns whether the file had normals, if not @p positionIds holds the position
+		 * of every vertex. If it can not be read it leaves no vertices
+		 */
+		bool loadObjParallel(const std::string& path, std::vector<uint32_t>& positionIds);
+
 	private:
 		/**
 		 * \~spanish @brief Crea los buffers
 		 * \~english @brief Creates the buffers
 		 */
 		void createBuffers(const Astra::CommandList& cmdList, nvvk::ResourceAllocatorDma* alloc);
+
+		/**
+		 * \~spanish @brief Dueño de los datos externos (el fichero de caché proyectado o el glTF leído), compartido entre las copias de la malla
+		 * \~english @brief Owner of the external data (the mapped cache file or the parsed glTF), shared between copies of the mesh
+		 */
+		std::shared_ptr<const void> _externalOwner;
+		const Vertex* _externalVertices{ nullptr };
+		size_t _externalVertexCount{ 0 };
+		const uint32_t* _externalIndices{ nullptr };
+		size_t _externalIndexCount{ 0 };
+		const int32_t* _externalMaterialIndices{ nullptr };
+		size_t _externalMaterialIndexCount{ 0 };
+		const uint32_t* _externalLodIndices{ nullptr };
+		const uint32_t* _externalLodTriangles{ nullptr };
+		size_t _externalLodIndexCount{ 0 };
+		bool _deviceOnly{ false };
 	};
 
 	/**
-	 * \~spanish @brief Clase que representa una instancia de una malla en una escena
-	 * \~english @brief Represents an instance of a mesh in a scene.
+	 * \~spanish @brief Clase que representa una instancia de una malla en una escena. Describe la instancia para Scene::addInstance(),
+	 * la escena la guarda en su InstanceStorage. Si se añade por puntero, la escena llama a update() en cada frame
+	 * \~english @brief Represents an instance of a mesh in a scene. It describes the instance for Scene::addInstance(),
+	 * the scene stores it in its InstanceStorage. If it is added by pointer, the scene calls update() every frame
 	 */
 	class MeshInstance : public Node3D
 	{
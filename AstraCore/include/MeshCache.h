@@ -0,0 +1,64 @@
+#pragma once
+#include <host_device.h>
+#include <MappedFile.h>
+#include <MeshProcessing.h>
+#include <vector>
+#include <string>
+#include <memory>
+#include <cstdint>
+
+namespace Astra
+{
+	/**
+	 * \~spanish @brief Versión del formato .astramesh. Hay que incrementarla con cualquier cambio en el formato o en el procesado de las mallas
+	 * \~english @brief .astramesh format version. Must be bumped on any change to the format or to the mesh processing
+	 */
+	constexpr uint32_t MeshCacheVersion = 5;
+
+	/**
+	 * @struct MeshCacheData
+	 * \~spanish @brief Contenido de un fichero .astramesh. Los arrays grandes apuntan directamente al fichero proyectado en memoria, que se mantiene abierto mientras exista @p file
+	 * \~english @brief Contents of an .astramesh file. The big arrays point straight into the memory mapped file, which stays open as long as @p file is alive
+	 */
+	struct MeshCacheData
+	{
+		const Vertex* vertices{ nullptr };
+		size_t vertexCount{ 0 };
+		const uint32_t* indices{ nullptr };
+		size_t indexCount{ 0 };
+		const int32_t* materialIndices{ nullptr };
+		size_t materialIndexCount{ 0 };
+		const uint32_t* lodIndices{ nullptr };
+		const uint32_t* lodTriangles{ nullptr };
+		size_t lodIndexCount{ 0 };
+		std::vector<MeshLod> lods;
+		std::vector<WaveFrontMaterial> materials;
+		std::vector<std::string> texturePaths;
+		std::vector<Meshlet> meshlets;
+		MeshBounds bounds;
+		std::vector<MeshBounds> submeshBounds;
+		std::shared_ptr<MappedFile> file;
+	};
+
+	/**
+	 * \~spanish @brief Ruta del fichero de caché de @p sourcePath. Si @p cacheDirectory está vacío se guarda junto al fichero original
+	 * \~english @brief Cache file path for @p sourcePath. If @p cacheDirectory is empty it is stored next to the source file
+	 */
+	std::string getMeshCachePath(const std::string& sourcePath, const std::string& cacheDirectory = "");
+
+	/**
+	 * \~spanish @brief Proyecta en memoria una caché. Devuelve false si no existe, es de otra versión o ya no corresponde a @p sourcePath o a los mtl que nombra
+	 * (tamaño, fecha y hash del contenido), o a las opciones de carga @p optionsKey
+	 * \~english @brief Memory maps a cache file. Returns false if it does not exist, has another version or no longer matches @p sourcePath or the mtl files it names
+	 * (size, modification time and content hash), or the load options @p optionsKey
+	 */
+	bool readMeshCache(const std::string& cachePath, const std::string& sourcePath, uint64_t optionsKey, MeshCacheData& data);
+
+	/**
+	 * \~spanish @brief Escribe una caché para @p sourcePath con el contenido de @p data. Se escribe aparte con un nombre único y se renombra, así que varios hilos o procesos
+	 * pueden escribir la misma a la vez
+	 * \~english @brief Writes a cache for @p sourcePath with the contents of @p data. It is written aside with a unique name and renamed, so several threads or processes
+	 * can write the same one at once
+	 */
+	bool writeMeshCache(const std::string& cachePath, const std::string& sourcePath, uint64_t optionsKey, const MeshCacheData& data);
+}
@@ -0,0 +1,154 @@
+#pragma once
+#include <host_device.h>
+#include <vector>
+#include <cstdint>
+
+namespace Astra
+{
+	/**
+	 * \~spanish @brief Une los vértices iguales (posición, normal, coordenadas de textura y color) y reescribe los índices para que apunten a los vértices únicos.
+	 * Los atributos se cuantizan con una rejilla de tamaño @p epsilon, con 0 solo se unen los vértices idénticos. Los vértices únicos mantienen el orden de su primera aparición,
+	 * así que el resultado no depende del número de hilos. Devuelve el número de vértices que quedan
+	 * \~english @brief Welds equal vertices (position, normal, texture coordinates and color) and rewrites the indices so they point to the unique ones.
+	 * Attributes are quantized on a grid of size @p epsilon, with 0 only identical vertices are welded. Unique vertices keep the order of their first appearance,
+	 * so the result does not depend on the number of threads. Returns the number of remaining vertices
+	 */
+	size_t weldVertices(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, float epsilon = 0.0f);
+
+	/**
+	 * \~spanish @brief Calcula normales suaves en paralelo en el ThreadPool: los triángulos que comparten una posición se agrupan una vez, cada uno con el primer grupo cuyo primer
+	 * triángulo está a menos de @p creaseAngle grados, y cada esquina toma la suma de las normales de su grupo, pesadas por su ángulo en esa esquina; entre grupos queda una arista viva.
+	 * Deja un vértice por esquina con índices 0, 1, 2...
+	 * para que weldVertices() una los que hayan quedado iguales. @p positionIds es opcional, un id por vértice igual para los que comparten posición
+	 * (como el índice de la línea v de un obj); sin él las posiciones se agrupan con un hash
+	 * \~english @brief Computes smooth normals in parallel on the ThreadPool: the triangles sharing a position are clustered once, each one into the first cluster whose first
+	 * triangle is within @p creaseAngle degrees, and every corner takes the sum of the normals of its cluster, weighted by their angle at that corner; clusters meet at a hard edge.
+	 * Leaves one vertex per corner with indices 0, 1, 2...
+	 * so weldVertices() can merge the ones that ended up equal. @p positionIds is optional, one id per vertex that is the same for the ones sharing a position
+	 * (like the index of the v line of an obj); without it positions are grouped with a hash
+	 */
+	void computeSmoothNormals(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, float creaseAngle = 60.0f, const uint32_t* positionIds = nullptr);
+
+	/**
+	 * @struct MeshBounds
+	 * \~spanish @brief Caja alineada con los ejes y esfera que contienen una malla o parte de ella, en espacio de objeto. La esfera está centrada en la caja
+	 * \~english @brief Axis aligned box and sphere containing a mesh or part of it, in object space. The sphere is centered on the box
+	 */
+	struct MeshBounds
+	{
+		glm::vec3 min{ 0.0f };
+		glm::vec3 max{ 0.0f };
+		glm::vec3 center{ 0.0f };
+		float radius{ 0.0f };
+		/**
+		 * \~spanish @brief False si no contiene ningún vértice
+		 * \~english @brief False if it contains no vertex
+		 */
+		bool valid{ false };
+	};
+
+	/**
+	 * \~spanish @brief Límites de todos los vértices, calculados en paralelo en el ThreadPool
+	 * \~english @brief Bounds of every vertex, computed in parallel on the ThreadPool
+	 */
+	MeshBounds computeBounds(const Vertex* vertices, size_t vertexCount);
+
+	/**
+	 * \~spanish @brief Límites de los triángulos de cada material, calculados en paralelo en el ThreadPool. Devuelve @p materialCount elementos.
+	 * Los triángulos sin índice de material cuentan como del material 0
+	 * \~english @brief Bounds of the triangles of every material, computed in parallel on the ThreadPool. Returns @p materialCount elements.
+	 * Triangles without a material index count as material 0
+	 */
+	std::vector<MeshBounds> computeSubmeshBounds(const Vertex* vertices, const uint32_t* indices, size_t indexCount, const int32_t* materialIndices, size_t materialIndexCount,
+		size_t materialCount);
+
+	/**
+	 * \~spanish @brief ACMR (vértices transformados por triángulo) de un buffer de índices con una caché FIFO de @p cacheSize vértices. 3 es el peor caso, y 0.5 el límite en mallas grandes
+	 * \~english @brief ACMR (transformed vertices per triangle) of an index buffer with a FIFO cache of @p cacheSize vertices. 3 is the worst case, and 0.5 the limit on large meshes
+	 */
+	float computeAcmr(const uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize = 16);
+
+	/**
+	 * \~spanish @brief Reordena los triángulos para aprovechar la caché de vértices transformados con el algoritmo de Forsyth (caché LRU de 32 vértices)
+	 * \~english @brief Reorders the triangles to make good use of the post-transform vertex cache with Forsyth's algorithm (32 vertex LRU cache)
+	 */
+	void optimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount);
+
+	/**
+	 * \~spanish @brief Parte los triángulos, ya ordenados para la caché, en grupos y los ordena de fuera a dentro para reducir el overdraw.
+	 * Un grupo se cierra cuando su ACMR baja de @p threshold veces el de toda la malla, así que la caché empeora como mucho en ese factor
+	 * \~english @brief Splits the triangles, already ordered for the cache, in clusters and sorts them from the outside in to reduce overdraw.
+	 * A cluster ends when its ACMR drops under @p threshold times the one of the whole mesh, so the cache gets worse by that factor at most
+	 */
+	void optimizeOverdraw(uint32_t* indices, size_t indexCount, const Vertex* vertices, size_t vertexCount, float threshold = 1.05f);
+
+	/**
+	 * \~spanish @brief Ordena los vértices según el primer triángulo que los usa, para que se lean de memoria en orden. Quita los que no se usan. Devuelve el número de vértices que quedan
+	 * \~english @brief Sorts the vertices by the first triangle using them, so they are fetched from memory in order. Unused ones are removed. Returns the number of remaining vertices
+	 */
+	size_t optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+
+	/**
+	 * @struct MeshOptimizationStats
+	 * \~spanish @brief ACMR con una caché FIFO de 16 vértices antes y después de optimizeMesh()
+	 * \~english @brief ACMR with a 16 vertex FIFO cache before and after optimizeMesh()
+	 */
+	struct MeshOptimizationStats
+	{
+		float acmrBefore{ 0.0f };
+		float acmrAfter{ 0.0f };
+	};
+
+	/**
+	 * \~spanish @brief Agrupa los triángulos por material y optimiza cada grupo en paralelo en el ThreadPool: caché de vértices y overdraw.
+	 * Después ordena los vértices para su lectura. @p materialIndices (uno por triángulo) se reordena con los triángulos
+	 * \~english @brief Groups the triangles by material and optimizes every group in parallel on the ThreadPool: vertex cache and overdraw.
+	 * Then the vertices are sorted for fetching. @p materialIndices (one per triangle) is reordered along with the triangles
+	 */
+	MeshOptimizationStats optimizeMesh(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, std::vector<int32_t>& materialIndices);
+
+	/**
+	 * \~spanish @brief Parte los triángulos en meshlets de como mucho MESHLET_MAX_VERTICES vértices y MESHLET_MAX_TRIANGLES triángulos, tomándolos en orden,
+	 * así que cada meshlet es un tramo del buffer de índices. Las esferas y conos de normales se calculan en paralelo en el ThreadPool
+	 * \~english @brief Splits the triangles in meshlets of at most MESHLET_MAX_VERTICES vertices and MESHLET_MAX_TRIANGLES triangles, taking them in order,
+	 * so every meshlet is a range of the index buffer. The spheres and normal cones are computed in parallel on the ThreadPool
+	 */
+	std::vector<Meshlet> buildMeshlets(const Vertex* vertices, size_t vertexCount, const uint32_t* indices, size_t indexCount);
+
+	/**
+	 * @struct MeshLod
+	 * \~spanish @brief Nivel de detalle de una malla. Usa los mismos vértices que la malla completa, solo cambian los índices
+	 * \~english @brief Level of detail of a mesh. It uses the same vertices as the full mesh, only the indices change
+	 */
+	struct MeshLod
+	{
+		uint32_t firstIndex{ 0 };
+		uint32_t indexCount{ 0 };
+		/**
+		 * \~spanish @brief Distancia máxima, en espacio de objeto, entre esta superficie y la original
+		 * \~english @brief Maximum distance, in object space, between this surface and the original one
+		 */
+		float error{ 0.0f };
+		uint32_t padding{ 0 };
+	};
+
+	/**
+	 * \~spanish @brief Simplifica la malla colapsando aristas por orden de error cuádrico hasta tener como mucho @p targetIndexCount índices o no poder seguir.
+	 * Los vértices no se mueven ni se crean, así que el resultado usa el mismo buffer de vértices. Los que comparten posición (costuras de normales o coordenadas
+	 * de textura) se colapsan juntos. @p outTriangles devuelve de qué triángulo original viene cada triángulo, para sus materiales. Devuelve el error cometido
+	 * \~english @brief Simplifies the mesh collapsing edges in quadric error order until it has at most @p targetIndexCount indices or it cannot go on.
+	 * Vertices are never moved or created, so the result uses the same vertex buffer. The ones sharing a position (normal or texture coordinate seams)
+	 * are collapsed together. @p outTriangles returns which original triangle every triangle comes from, for its material. Returns the error made
+	 */
+	float simplifyMesh(const Vertex* vertices, size_t vertexCount, const uint32_t* indices, size_t indexCount, size_t targetIndexCount,
+		std::vector<uint32_t>& outIndices, std::vector<uint32_t>& outTriangles);
+
+	/**
+	 * \~spanish @brief Genera hasta @p lodCount niveles de detalle, cada uno con @p reduction veces los triángulos del anterior y simplificado a partir de él.
+	 * Los índices de todos van seguidos en @p lodIndices y @p lodTriangles guarda el triángulo original de cada uno. Termina antes si un nivel ya casi no reduce
+	 * \~english @brief Generates up to @p lodCount levels of detail, each one with @p reduction times the triangles of the previous one and simplified from it.
+	 * The indices of all of them go one after another in @p lodIndices and @p lodTriangles stores the original triangle of each one. It stops early if a level barely reduces
+	 */
+	std::vector<MeshLod> buildLodChain(const Vertex* vertices, size_t vertexCount, const uint32_t* indices, size_t indexCount, uint32_t lodCount, float reduction,
+		std::vector<uint32_t>& lodIndices, std::vector<uint32_t>& lodTriangles);
+}
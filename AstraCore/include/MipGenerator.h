@@ -0,0 +1,13 @@
+#pragma once
+#include <Texture.h>
+
+namespace Astra
+{
+	/**
+	 * \~spanish @brief Genera todos los mipmaps de una imagen RGBA en CPU con un filtro de caja 2x2 en espacio lineal (el color se trata como sRGB y el alfa como lineal).
+	 * Los niveles se calculan a partir del anterior sin cuantizar, en paralelo y con AVX2 si la CPU lo admite. El resultado es el mismo en cualquier máquina
+	 * \~english @brief Generates every mipmap of an RGBA image on the CPU with a 2x2 box filter in linear space (color is treated as sRGB and alpha as linear).
+	 * Levels are computed from the unquantized previous one, in parallel and with AVX2 when the CPU supports it. The result is the same on any machine
+	 */
+	void generateMipChain(TextureData& data);
+}
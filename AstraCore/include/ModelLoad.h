@@ -0,0 +1,67 @@
+#pragma once
+#include <Mesh.h>
+#include <string>
+#include <functional>
+#include <future>
+#include <atomic>
+
+namespace Astra
+{
+	class Scene;
+
+	/**
+	 * \~spanish @brief Estado de una carga asíncrona
+	 * \~english @brief State of an asynchronous load
+	 */
+	enum class ModelLoadStatus
+	{
+		Loading,   // parsing and decoding on a worker thread
+		Uploading, // transfer submitted, waiting for its fence
+		Done,	   // added to the scene
+		Failed
+	};
+
+	/**
+	 * @class ModelLoad
+	 * \~spanish @brief Carga asíncrona de un modelo iniciada con Scene::loadModelAsync. Permite consultar el progreso y esperar al id del modelo con un future
+	 * \~english @brief Asynchronous model load started with Scene::loadModelAsync. Allows querying the progress and waiting for the model id with a future
+	 */
+	class ModelLoad
+	{
+		friend class Scene;
+
+	private:
+		std::string _path;
+		glm::mat4 _transform;
+		std::function<void(int)> _onLoaded;
+
+		std::atomic<float> _progress{ 0.0f };
+		std::atomic<ModelLoadStatus> _status{ ModelLoadStatus::Loading };
+		std::promise<int> _promise;
+		std::shared_future<int> _future;
+
+		// only touched by the worker until _cpuWork is ready, then only by the main thread
+		Mesh _mesh;
+		std::future<void> _cpuWork;
+		std::exception_ptr _error; // what the worker threw, if it failed that way
+		VkCommandBuffer _cmdBuf{ VK_NULL_HANDLE };
+		VkFence _fence{ VK_NULL_HANDLE };
+
+	public:
+		ModelLoad(const std::string& path, const glm::mat4& transform, const std::function<void(int)>& onLoaded);
+
+		const std::string& getPath() const;
+		/**
+		 * \~spanish @brief Progreso de la carga entre 0 y 1
+		 * \~english @brief Load progress between 0 and 1
+		 */
+		float getProgress() const;
+		ModelLoadStatus getStatus() const;
+		/**
+		 * \~spanish @brief Future con el id del modelo en la escena. Contiene una excepción si la carga falla
+		 * \~english @brief Future with the id of the model in the scene. Holds an exception if the load fails
+		 */
+		std::shared_future<int> getFuture() const;
+		bool isFinished() const;
+	};
+}
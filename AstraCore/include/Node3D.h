@@ -1,7 +1,9 @@
 #pragma once
 #include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
 #include <vector>
 #include <string>
+#include <atomic>
 #include <vulkan/vulkan.h>
 #include <host_device.h>
 
@@ -10,13 +12,26 @@ namespace Astra
 
 	/**
 	 * \~spanish @brief Clase abstracta que representa cualquier objeto 3D en una escena. Todos los métodos son simples y hacen lo que dice el nombre de este.
+	 * La posición, rotación y escala son el estado principal, la matriz se compone solo cuando se pide tras un cambio
 	 * \~english @brief Abstract class that represents any 3D object in the scene. These are very simple methods and they do as their name says.
+	 * Position, rotation and scale are the main state, the matrix is only composed when asked for after a change
 	 */
 	class Node3D
 	{
+	private:
+		// only one of the two representations may be stale at a time
+		mutable glm::vec3 _position{ 0.0f };
+		mutable glm::quat _rotation{ 1.0f, 0.0f, 0.0f, 0.0f };
+		mutable glm::vec3 _scale{ 1.0f };
+		mutable glm::mat4 _transform{ 1.0f };
+		mutable bool _matrixDirty{ false }; // the TRS changed, the matrix has to be composed
+		mutable bool _trsDirty{ false };	// the matrix was set or handed out, it has to be decomposed
+
+		void composeMatrix() const;
+		void decomposeMatrix() const;
+
 	protected:
-		static uint32_t NodeCount;
-		glm::mat4 _transform;
+		static std::atomic<uint32_t> NodeCount; // nodes can be created from the loading threads
 		std::vector<Node3D*> _children;
 		std::string _name;
 		uint32_t _id;
@@ -40,15 +55,21 @@ namespace Astra
 
 		// GETTERS
 		virtual glm::vec3 getPosition() const;
+		/**
+		 * \~spanish @brief Rotación en ángulos de Euler, en radianes
+		 * \~english @brief Rotation as Euler angles, in radians
+		 */
 		virtual glm::vec3 getRotation() const;
 		virtual glm::vec3 getScale() const;
-		virtual glm::vec3 getPosition();
-		virtual glm::vec3 getRotation();
-		virtual glm::vec3 getScale();
+		const glm::quat& getOrientation() const;
 
-		glm::mat4& getTransformRef() { return _transform; }
+		/**
+		 * \~spanish @brief Matriz editable. Como se puede haber cambiado, la siguiente lectura de posición, rotación o escala la descompone
+		 * \~english @brief Editable matrix. As it may have been changed, the next read of the position, rotation or scale decomposes it
+		 */
+		glm::mat4& getTransformRef();
 
-		const glm::mat4& getTransform() const { return _transform; }
+		const glm::mat4& getTransform() const;
 
 		std::vector<Node3D*>& getChildren() { return _children; }
 
@@ -59,6 +80,14 @@ namespace Astra
 
 		// SETTERS
 		void setName(const std::string& n) { _name = n; }
+		void setPosition(const glm::vec3& position);
+		void setOrientation(const glm::quat& rotation);
+		void setScale(const glm::vec3& scale);
+		/**
+		 * \~spanish @brief Cambia la matriz completa. Es lo único que descompone una matriz arbitraria
+		 * \~english @brief Sets the whole matrix. It is the only thing that decomposes an arbitrary matrix
+		 */
+		void setTransform(const glm::mat4& transform);
 
 		/**
 		 * \~spanish @brief Método que se llama en cada iteración del bucle de la aplicación
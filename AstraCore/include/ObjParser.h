@@ -0,0 +1,46 @@
+#pragma once
+#include <host_device.h>
+#include <vector>
+#include <string>
+#include <cstdint>
+
+namespace Astra
+{
+	/**
+	 * @struct ObjData
+	 * \~spanish @brief Resultado de leer un fichero obj. Ya tiene el formato de Mesh: un vértice por cada esquina de cada triángulo, en el orden del fichero
+	 * \~english @brief Result of parsing an obj file. Already in the Mesh layout: one vertex per triangle corner, in file order
+	 */
+	struct ObjData
+	{
+		std::vector<Vertex> vertices;
+		std::vector<uint32_t> indices;
+		/**
+		 * \~spanish @brief Un material por triángulo, -1 si no tiene
+		 * \~english @brief One material per triangle, -1 if it has none
+		 */
+		std::vector<int32_t> materialIndices;
+		std::vector<WaveFrontMaterial> materials;
+		/**
+		 * \~spanish @brief Texturas de los materiales tal y como aparecen en el mtl (sin resolver las rutas relativas)
+		 * \~english @brief Material textures as they appear in the mtl file (relative paths are not resolved)
+		 */
+		std::vector<std::string> texturePaths;
+		bool hasNormals{ false };
+		/**
+		 * \~spanish @brief Posición (línea v) de cada vértice, para agrupar las esquinas al calcular las normales. Solo si el fichero no tiene normales
+		 * \~english @brief Position (v line) of every vertex, to group the corners when computing the normals. Only if the file has no normals
+		 */
+		std::vector<uint32_t> positionIds;
+		std::string warning;
+		std::string error;
+	};
+
+	/**
+	 * \~spanish @brief Lee un fichero obj y sus mtl. El fichero se proyecta en memoria, se divide en trozos alineados a líneas y estos se procesan en paralelo en el ThreadPool.
+	 * Devuelve false si ha habido algún error, que se describe en @p data.error
+	 * \~english @brief Parses an obj file and its mtl files. The file is memory mapped, split in line aligned chunks and those are parsed in parallel on the ThreadPool.
+	 * Returns false on error, which is described in @p data.error
+	 */
+	bool parseObj(const std::string& path, ObjData& data);
+}
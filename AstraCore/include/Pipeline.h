@@ -77,6 +77,42 @@ namespace Astra
 		std::array<VkStridedDeviceAddressRegionKHR, 4> getSBTRegions();
 		void destroy(nvvk::ResourceAllocator* alloc) override;
 	};
+	/**
+	 * \~spanish @brief Clase abstracta para pipelines de cómputo. Declara el método de crear para ser sobreescrito por sus hijas.
+	 * \~english @brief Abstract class for compute pipelines. Declares the create method for its derived class to override
+	 */
+	class ComputePipeline : public Pipeline
+	{
+	public:
+		void bind(const CommandList& cmdList, const std::vector<VkDescriptorSet>& descsets) override;
+		virtual void create(VkDevice vkdev, const std::vector<VkDescriptorSetLayout>& descsetsLayouts) = 0;
+		inline bool doesRayTracing() override
+		{
+			return false;
+		};
+	};
+	/**
+	 * \~spanish @brief Pipeline que descarta los meshlets de todas las instancias y escribe un draw indirecto por cada uno visible para el raster. No usa descriptor sets,
+	 * todo llega en PushConstantCull. La usa el Renderer a través de Scene::cull()
+	 * \~english @brief Pipeline that culls the meshlets of every instance and writes an indirect draw for every visible one for the raster. It uses no descriptor sets,
+	 * everything comes in PushConstantCull. The Renderer uses it through Scene::cull()
+	 */
+	class MeshletCullPipeline : public ComputePipeline
+	{
+	public:
+		void create(VkDevice vkdev, const std::vector<VkDescriptorSetLayout>& descsetsLayouts = {}) override;
+	};
+	/**
+	 * \~spanish @brief Pipeline que descarta las instancias del raster GPU-driven, elige su nivel de detalle y escribe sus draws indirectos. Tampoco usa descriptor sets,
+	 * todo llega en PushConstantGpuCull. La usa el Renderer a través de Scene::cullGpuDriven()
+	 * \~english @brief Pipeline that culls the instances of the GPU-driven raster, picks their level of detail and writes their indirect draws. It uses no descriptor sets either,
+	 * everything comes in PushConstantGpuCull. The Renderer uses it through Scene::cullGpuDriven()
+	 */
+	class GpuCullPipeline : public ComputePipeline
+	{
+	public:
+		void create(VkDevice vkdev, const std::vector<VkDescriptorSetLayout>& descsetsLayouts = {}) override;
+	};
 	/**
 	 * \~spanish @brief Pipeline de rasterización de ejemplo para dibujar escenas en el offscreen framebuffer. Lista para usarse
 	 * \~english @brief Offscreen raster pipeline. Ready to use.
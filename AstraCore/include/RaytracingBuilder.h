@@ -0,0 +1,34 @@
+#pragma once
+#include <nvvk/raytraceKHR_vk.hpp>
+#include <cstddef>
+
+namespace Astra
+{
+	/**
+	 * @class RaytracingBuilder
+	 * \~spanish @brief nvvk::RaytracingBuilderKHR que permite rehacer solo una parte de las estructuras de aceleración. buildBlas() añade los BLAS
+	 * a continuación de los que ya hay, así que al cargar un modelo solo se construyen los suyos y después el TLAS
+	 * \~english @brief nvvk::RaytracingBuilderKHR that allows rebuilding only part of the acceleration structures. buildBlas() appends the BLAS
+	 * after the existing ones, so loading a model only builds its own and then the TLAS
+	 */
+	class RaytracingBuilder : public nvvk::RaytracingBuilderKHR
+	{
+	public:
+		size_t getBlasCount() const;
+		/**
+		 * \~spanish @brief Destruye los BLAS desde @p first hasta el final. Los anteriores no cambian de posición
+		 * \~english @brief Destroys the BLAS from @p first to the end. The previous ones keep their positions
+		 */
+		void destroyBlasFrom(size_t first);
+		/**
+		 * \~spanish @brief Destruye solo el TLAS, para volver a construirlo con otro número de instancias
+		 * \~english @brief Destroys only the TLAS, to build it again with a different number of instances
+		 */
+		void destroyTlas();
+		/**
+		 * \~spanish @brief Como destroyTlas(), pero el TLAS se destruye cuando terminan los frames en vuelo que lo usan
+		 * \~english @brief Like destroyTlas(), but the TLAS is destroyed once the frames in flight using it finish
+		 */
+		void retireTlas();
+	};
+}
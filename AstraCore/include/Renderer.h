@@ -39,6 +39,11 @@ namespace Astra
 		VkFormat _offscreenColorFormat{ VK_FORMAT_R32G32B32A32_SFLOAT };
 		VkFormat _offscreenDepthFormat{ VK_FORMAT_X8_D24_UNORM_PACK32 };
 
+		// meshlet culling, before the offscreen render pass
+		MeshletCullPipeline _cullPipeline;
+		// instance culling and indirect draws of the GPU-driven raster
+		GpuCullPipeline _gpuCullPipeline;
+
 		// post
 		PostPipeline _postPipeline;
 		VkRenderPass _postRenderPass;
@@ -121,6 +126,11 @@ namespace Astra
 
 		const nvvk::Texture& getOffscreenColor() const;
 		VkRenderPass getOffscreenRenderPass() const;
+		/**
+		 * \~spanish @brief Número de frames que puede haber en vuelo, uno por imagen de la swapchain
+		 * \~english @brief Number of frames that can be in flight, one per swapchain image
+		 */
+		uint32_t getFrameCount() const;
 
 
 		/**
@@ -4,11 +4,35 @@
 #include <Camera.h>
 #include <vulkan/vulkan.h>
 #include <nvvk/resourceallocator_vk.hpp>
-#include <nvvk/raytraceKHR_vk.hpp>
+#include <RaytracingBuilder.h>
 #include <RenderContext.h>
+#include <ModelLoad.h>
+#include <TextureCache.h>
+#include <MaterialCache.h>
+#include <GeometryBuilder.h>
+#include <InstanceStorage.h>
+#include <FrustumCuller.h>
+#include <nvvk/commands_vk.hpp>
+#include <memory>
 
 namespace Astra
 {
+	using MeshHandle = Handle<Mesh>;
+	using LightHandle = Handle<Light>;
+	struct GltfData;
+
+	/**
+	 * @struct ModelFile
+	 * \~spanish @brief Modelo a cargar con Scene::loadModels(): el fichero, la transformación de su instancia y el formato de sus vértices
+	 * \~english @brief Model to load with Scene::loadModels(): the file, the transform of its instance and the format of its vertices
+	 */
+	struct ModelFile
+	{
+		std::string path;
+		glm::mat4 transform{ 1.0f };
+		uint32_t vertexFormat{ 0 };
+	};
+
 	/**
 	 * \~spanish @brief Clase Escena. Contiene las mallas, instancias, luces y cámara. Esta es para rasterización.
 	 * \~english @brief Scene class. Contains the meshes, instances, lights and camera. This is raster-only.
@@ -17,51 +41,335 @@ namespace Astra
 	{
 	protected:
 		// Models in scene
-		std::vector<Mesh> _objModels;		  // the actual models (vertices, indices, etc)
-		std::vector<MeshInstance> _instances; // instances of the models
+		std::vector<Mesh> _objModels; // the actual models (vertices, indices, etc)
+		HandleTable<Mesh> _meshHandles;
+		InstanceStorage _instances;	  // instances of the models
+		std::vector<std::pair<MeshInstance*, InstanceHandle>> _instanceNodes; // instances whose update() runs every frame, not owned
 
-		std::vector<nvvk::Texture> _textures;
+		TextureCache _textureCache; // deduplicated texture table shared by every model
+		MaterialCache _materialCache; // deduplicated material table shared by every model
 		nvvk::Buffer _objDescBuffer; // Device buffer of the OBJ descriptions
+		std::vector<ObjDesc> _objDescs; // what the buffer holds, it has room for _objDescCapacity
+		size_t _objDescCapacity{ 0 };
+		size_t _objDescMeshCount{ 0 };	// models already laid out in _objDescs
+		size_t _objDescUploaded{ 0 };	// descriptions up to here are on the GPU
+		bool _descriptorsChanged{ false };
 
 		nvvk::Buffer _cameraUBO; // UBO for camera
 		nvvk::Buffer _lightsUBO;
-		nvvk::ResourceAllocatorDma* _alloc;
+		nvvk::ResourceAllocatorDma* _alloc{ nullptr };
 
 		LightsUniform _lightsUniform;
 		std::vector<Light*> _lights; // multiple lights in the future
+		HandleTable<Light> _lightHandles;
 		CameraController* _camera;
 		// lazy loading
-		std::vector<std::pair<std::string, glm::mat4>> _lazymodels;
+		std::vector<ModelFile> _lazymodels;
+		// async loading
+		std::vector<std::shared_ptr<ModelLoad>> _pendingLoads;
+		nvvk::CommandPool _loadCmdPool;
+		// meshlet culling
+		uint32_t _meshletCulling{ 0 };
+		nvvk::Buffer _cullChunkBuffer;		  // a CullChunk per workgroup of the culling
+		nvvk::Buffer _cullDrawBuffer;		  // a VkDrawIndexedIndirectCommand per meshlet of the culled instances
+		nvvk::Buffer _cullCountBuffer;		  // visible meshlets of every instance
+		size_t _cullChunkCapacity{ 0 };
+		size_t _cullDrawCapacity{ 0 };
+		size_t _cullCountCapacity{ 0 };
+		uint32_t _cullChunkCount{ 0 };
+		std::vector<uint32_t> _cullFirstDraw; // first draw command of every instance, NotCulled if it is drawn whole
+		uint64_t _cullMeshVersion{ 0 };		  // InstanceStorage::getMeshVersion() the chunks were laid out for
+		// levels of detail
+		float _lodThreshold{ 1.0f }; // error in pixels allowed on screen
+		// frustum culling
+		bool _frustumCulling{ true };
+		FrustumCuller _frustumCuller;
+		// GPU-driven raster
+		bool _gpuDriven{ false };
+		bool _gpuGeometryDirty{ true }; // models were added or laid out again since the tables below were built
+		struct IndexBlock
+		{
+			VkDeviceSize first{ 0 };
+			VkDeviceSize count{ 0 };
+		};
+		nvvk::Buffer _gpuIndexBuffer;	// indices of every model followed by its levels of detail, a block per model, room for _gpuIndexCapacity
+		size_t _gpuIndexCapacity{ 0 };
+		VkDeviceSize _gpuIndexEnd{ 0 };	// past the last block handed out
+		std::vector<IndexBlock> _gpuMeshBlocks; // block of every model, in model order
+		// blocks of removed models, they come back once the frames that drew them finish. Replaced on destroy so late ones are dropped
+		std::shared_ptr<std::vector<IndexBlock>> _gpuFreeBlocks{ std::make_shared<std::vector<IndexBlock>>() };
+		nvvk::Buffer _gpuMeshBuffer;	// a GpuMesh per model
+		size_t _gpuMeshCapacity{ 0 };
+		nvvk::Buffer _gpuRangeBuffer;	// a GpuDrawRange per description
+		size_t _gpuRangeCapacity{ 0 };
+		nvvk::Buffer _gpuInstanceBuffer; // a GpuInstance per instance, it has room for _gpuInstanceCapacity
+		nvvk::Buffer _gpuStateBuffer;	// a GpuInstanceState per instance
+		nvvk::Buffer _gpuDrawBuffer;	// draw count and a VkDrawIndexedIndirectCommand per instance
+		std::vector<GpuInstance> _gpuInstances; // what the instance buffer holds
+		size_t _gpuInstanceCapacity{ 0 };
+		struct FrameStaging
+		{
+			nvvk::Buffer buffer;
+			void* data{ nullptr }; // mapped while it lives
+			VkDeviceSize size{ 0 };
+		};
+		std::vector<FrameStaging> _gpuStaging; // per frame, for the instance uploads too big for vkCmdUpdateBuffer
 
+		/**
+		 * \~spanish @brief Añade las descripciones de los modelos nuevos. El buffer, igual que el de materiales, solo se vuelve a crear, con el doble de capacidad,
+		 * cuando no caben; en cualquier caso se suben en el siguiente updateObjDescBuffer()
+		 * \~english @brief Appends the descriptions of the new models. The buffer, like the material one, is only created again, with twice the capacity,
+		 * when they do not fit; either way they are uploaded in the next updateObjDescBuffer()
+		 */
 		virtual void createObjDescBuffer();
+		/**
+		 * \~spanish @brief Vuelve a colocar las descripciones de todos los modelos, después de borrar alguno
+		 * \~english @brief Lays out the descriptions of every model again, after removing any
+		 */
+		void rebuildObjDescs();
+		void destroyModelBuffers(Mesh& mesh);
 		virtual void createCameraUBO();
 		virtual void updateCameraUBO(const CommandList& cmdList);
 		virtual void createLightsUBO();
 		virtual void updateLightsUBO(const CommandList& cmdList);
+		/**
+		 * \~spanish @brief Mueve a la escena un modelo cuyos buffers ya están creados, junto con una instancia suya
+		 * \~english @brief Moves into the scene a model whose buffers are already created, along with an instance of it
+		 */
+		void addLoadedModel(Mesh&& mesh, const std::string& filename, const glm::mat4& transform);
+		/**
+		 * \~spanish @brief Añade una instancia por cada nodo de @p data, cuyas mallas empiezan en @p firstMesh. Las raíces se multiplican por @p transform
+		 * \~english @brief Adds an instance for every node of @p data, whose meshes start at @p firstMesh. The roots are multiplied by @p transform
+		 */
+		void addGltfNodes(const GltfData& data, int firstMesh, const glm::mat4& transform);
+		/**
+		 * \~spanish @brief Reparte los meshlets de las instancias actuales en grupos de trabajo y les da sitio para sus draws, hasta un máximo; el resto se dibujan enteras.
+		 * Los buffers solo se vuelven a crear, con el doble de capacidad, cuando no caben, y los anteriores se destruyen cuando terminan los frames que los usan
+		 * \~english @brief Splits the meshlets of the current instances into workgroups and makes room for their draws, up to a limit; the rest are drawn whole.
+		 * The buffers are only created again, with twice the capacity, when they do not fit, and the previous ones are destroyed once the frames using them finish
+		 */
+		virtual void updateCullingBuffers(const CommandList& cmdList);
+		virtual void destroyCullingBuffers();
+		bool isCulled(size_t instance) const;
+		/**
+		 * \~spanish @brief Elige el nivel de detalle de cada instancia según el error que se vería en pantalla, con histéresis para que no cambie en cada frame
+		 * \~english @brief Picks the level of detail of every instance from the error that would be seen on screen, with hysteresis so it does not switch every frame
+		 */
+		virtual void updateLods();
+		/**
+		 * \~spanish @brief Posición en el buffer de descripciones del objeto con el que se dibuja la instancia @p instance, según su nivel de detalle
+		 * \~english @brief Slot in the description buffer of the object the @p instance instance is drawn with, given its level of detail
+		 */
+		uint32_t getObjDescIndex(size_t instance) const;
+		/**
+		 * \~spanish @brief Copia los índices de los modelos nuevos a un bloque libre del buffer común y sube sus esferas y los rangos de cada descripción para el raster GPU-driven.
+		 * Los bloques de los demás modelos no se mueven; el buffer solo se vuelve a crear, con el doble de capacidad, cuando no caben
+		 * \~english @brief Copies the indices of the new models into a free block of the merged buffer and uploads their spheres and the ranges of every description for the GPU-driven raster.
+		 * The blocks of the other models do not move; the buffer is only created again, with twice the capacity, when they do not fit
+		 */
+		virtual void updateGpuGeometry(const CommandList& cmdList);
+		/**
+		 * \~spanish @brief Reserva @p count índices en el buffer común, en el primer bloque libre que sirva o al final
+		 * \~english @brief Reserves @p count indices in the merged buffer, in the first free block that fits or at the end
+		 */
+		VkDeviceSize allocateGpuIndices(const CommandList& cmdList, VkDeviceSize count);
+		/**
+		 * \~spanish @brief Devuelve el bloque del modelo @p index, que se puede reutilizar cuando terminen los frames que lo dibujan, y pone en su lugar el del último modelo
+		 * \~english @brief Gives back the block of the model @p index, reusable once the frames drawing it finish, and puts the block of the last model in its place
+		 */
+		void releaseGpuGeometry(uint32_t index);
+		/**
+		 * \~spanish @brief Sube las instancias que han cambiado desde el último frame: pocas con vkCmdUpdateBuffer, el resto desde el buffer de staging del frame.
+		 * Los buffers solo se vuelven a crear, con el doble de capacidad, cuando no caben
+		 * \~english @brief Uploads the instances that changed since the last frame: a few with vkCmdUpdateBuffer, the rest from the staging buffer of the frame.
+		 * The buffers are only created again, with twice the capacity, when they do not fit
+		 */
+		virtual void updateGpuInstances(const CommandList& cmdList);
+		virtual void destroyGpuDrivenBuffers();
 
 	public:
 		Scene() = default;
 
-		virtual void loadModel(const std::string& filepath, const glm::mat4& transform = glm::mat4(1.0f));
+		/**
+		 * \~spanish @brief Carga un modelo y añade una instancia suya. Los .gltf y .glb se cargan con loadGltf().
+		 * @p vertexFormat es el formato de sus vértices en la GPU, una combinación de VertexFormatFlags
+		 * \~english @brief Loads a model and adds an instance of it. .gltf and .glb files are loaded with loadGltf().
+		 * @p vertexFormat is the format of its vertices on the GPU, a combination of VertexFormatFlags
+		 */
+		virtual void loadModel(const std::string& filepath, const glm::mat4& transform = glm::mat4(1.0f), uint32_t vertexFormat = 0);
+		/**
+		 * \~spanish @brief Carga un .gltf o .glb. Cada malla del fichero se añade una vez y cada nodo con malla es una instancia que la comparte,
+		 * con su transformación de mundo multiplicada por @p transform. Todas las mallas se suben en un solo envío
+		 * \~english @brief Loads a .gltf or .glb file. Every mesh in the file is added once and every node with a mesh is an instance sharing it,
+		 * with its world transform multiplied by @p transform. All the meshes are uploaded in a single submission
+		 */
+		virtual void loadGltf(const std::string& filepath, const glm::mat4& transform = glm::mat4(1.0f), uint32_t vertexFormat = 0);
+		/**
+		 * \~spanish @brief Carga varios modelos a la vez. Los ficheros y sus texturas se leen en paralelo y todas las subidas se graban en unos pocos envíos,
+		 * cada uno limitado en memoria de staging, con una sola espera al final. Las descripciones se crean una vez para todos. Antes de init() se dejan para entonces
+		 * \~english @brief Loads several models at once. The files and their textures are read in parallel and every upload is recorded in a few submissions,
+		 * each one bounded in staging memory, with a single wait at the end. The descriptions are created once for all of them. Before init() they are left for it
+		 */
+		virtual void loadModels(const std::vector<ModelFile>& models);
+		/**
+		 * \~spanish @brief Carga un modelo sin bloquear. El fichero y las texturas se leen en el ThreadPool, la subida se hace con un envío con fence
+		 * y el modelo se añade a la escena al inicio de un frame. @p onLoaded se llama en el hilo principal con el id del modelo (-1 si falla)
+		 * \~english @brief Loads a model without blocking. The file and its textures are read on the ThreadPool, the upload is done in a fenced submission
+		 * and the model is added to the scene at the start of a frame. @p onLoaded is called on the main thread with the model id (-1 if it fails)
+		 */
+		virtual std::shared_ptr<ModelLoad> loadModelAsync(const std::string& filepath, const glm::mat4& transform = glm::mat4(1.0f), const std::function<void(int)>& onLoaded = nullptr,
+			uint32_t vertexFormat = 0);
+		/**
+		 * \~spanish @brief Envía las subidas de las cargas asíncronas que ya se han leído. Devuelve true si alguna ha terminado y está lista para publishAsyncLoads()
+		 * \~english @brief Submits the uploads of the asynchronous loads that have been read. Returns true if any of them finished and is ready for publishAsyncLoads()
+		 */
+		virtual bool updateAsyncLoads();
+		/**
+		 * \~spanish @brief Añade a la escena los modelos subidos. Modifica los buffers de la escena, así que la GPU no puede estar usándolos
+		 * \~english @brief Adds the uploaded models to the scene. It modifies the scene buffers, so the GPU must not be using them
+		 */
+		virtual void publishAsyncLoads();
+		bool hasPendingLoads() const;
 		virtual void init(nvvk::ResourceAllocator* alloc);
 		virtual void destroy();
 		virtual void addShape(Astra::Mesh& m);
+		/**
+		 * \~spanish @brief Empieza una malla procedural de @p vertexCount vértices y @p triangleCount triángulos que se escribe directamente en memoria de staging
+		 * \~english @brief Starts a procedural mesh of @p vertexCount vertices and @p triangleCount triangles that is written straight into staging memory
+		 */
+		std::unique_ptr<GeometryBuilder> beginShape(size_t vertexCount, size_t triangleCount);
+		/**
+		 * \~spanish @brief Termina la malla de @p builder con @p material y la añade a la escena sin copiar sus datos. Devuelve el id del modelo
+		 * \~english @brief Finishes the mesh of @p builder with @p material and adds it to the scene without copying its data. Returns the model id
+		 */
+		virtual int addShape(GeometryBuilder& builder, const WaveFrontMaterial& material);
 		virtual void addModel(Mesh& model);
-		virtual void addInstance(const MeshInstance& instance);
-		virtual void removeInstance(const MeshInstance& n);
-		virtual void addLight(Light* l);
+		/**
+		 * \~spanish @brief Como addModel(Mesh&), pero mueve los datos de @p model en lugar de copiarlos
+		 * \~english @brief Like addModel(Mesh&), but moves the data of @p model instead of copying it
+		 */
+		virtual void addModel(Mesh&& model);
+		/**
+		 * \~spanish @brief Borra el modelo de @p handle junto con sus instancias. El último modelo pasa a su posición.
+		 * Espera a la GPU. Las escenas de ray tracing rehacen los BLAS que se mueven y el TLAS
+		 * \~english @brief Removes the model of @p handle along with its instances. The last model takes its position.
+		 * It waits for the GPU. Ray tracing scenes rebuild the BLAS that move and the TLAS
+		 */
+		virtual void removeModel(MeshHandle handle);
+		MeshHandle getModelHandle(size_t index) const;
+		/**
+		 * \~spanish @brief Posición actual en getModels() del modelo de @p handle, -1 si se ha borrado
+		 * \~english @brief Current position in getModels() of the model of @p handle, -1 if it was removed
+		 */
+		int findModel(MeshHandle handle) const;
+		/**
+		 * \~spanish @brief Añade una instancia con la malla, transformación, nombre y visibilidad de @p instance. Solo se copian, su update() no se llama
+		 * \~english @brief Adds an instance with the mesh, transform, name and visibility of @p instance. They are only copied, its update() is not called
+		 */
+		virtual InstanceHandle addInstance(const MeshInstance& instance);
+		/**
+		 * \~spanish @brief Igual que addInstance(const MeshInstance&), pero la escena llama a update() de @p instance en cada frame y, si devuelve true,
+		 * copia su transformación y su visibilidad. La escena no es su dueña: tiene que vivir hasta que se borre la instancia o la escena
+		 * \~english @brief Same as addInstance(const MeshInstance&), but the scene calls update() of @p instance every frame and, if it returns true,
+		 * copies its transform and visibility. The scene does not own it: it has to live until the instance or the scene is removed
+		 */
+		virtual InstanceHandle addInstance(MeshInstance* instance);
+		/**
+		 * \~spanish @brief Añade @p count instancias sin nombre de la malla @p meshIndex, una por transformación. Devuelve la posición de la primera.
+		 * Si @p handles no es nulo, recibe el handle de cada una
+		 * \~english @brief Adds @p count unnamed instances of the @p meshIndex mesh, one per transform. Returns the position of the first one.
+		 * If @p handles is not null, it receives the handle of every one
+		 */
+		virtual size_t addInstances(uint32_t meshIndex, const glm::mat4* transforms, size_t count, InstanceHandle* handles = nullptr);
+		size_t addInstances(uint32_t meshIndex, const std::vector<glm::mat4>& transforms, std::vector<InstanceHandle>* handles = nullptr);
+		/**
+		 * \~spanish @brief Borra la instancia de @p handle en O(1). La última instancia pasa a su posición
+		 * \~english @brief Removes the instance of @p handle in O(1). The last instance takes its position
+		 */
+		virtual void removeInstance(InstanceHandle handle);
+		/**
+		 * \~spanish @brief Añade una luz. Devuelve un handle nulo si ya hay MAX_LIGHTS
+		 * \~english @brief Adds a light. Returns a null handle if there are already MAX_LIGHTS
+		 */
+		virtual LightHandle addLight(Light* l);
+		virtual void removeLight(LightHandle handle);
 		virtual void removeLight(Light* l);
 		virtual void setCamera(CameraController* c);
 		virtual void update(const CommandList& cmdList, float delta);
 		virtual void draw(RenderContext<PushConstantRaster>& renderContext);
+		/**
+		 * \~spanish @brief Descarta en GPU, en un solo dispatch, los meshlets de todas las instancias según getMeshletCulling() y deja un draw indirecto por cada meshlet visible para draw().
+		 * Lo llama el Renderer antes de empezar el render pass. Los grupos solo se reparten de nuevo cuando cambian las mallas de las instancias
+		 * \~english @brief Culls on the GPU, in a single dispatch, the meshlets of every instance as set by getMeshletCulling() and leaves an indirect draw per visible meshlet for draw().
+		 * The Renderer calls it before beginning the render pass. The workgroups are only split again when the meshes of the instances change
+		 */
+		virtual void cull(const CommandList& cmdList, ComputePipeline* pipeline);
+		/**
+		 * \~spanish @brief Descarta en GPU las instancias fuera del frustum, elige su nivel de detalle y escribe un draw indirecto por cada una visible.
+		 * Lo llama el Renderer antes del render pass en lugar de cull() cuando getGpuDriven() está activo
+		 * \~english @brief Culls on the GPU the instances outside the frustum, picks their level of detail and writes an indirect draw for every visible one.
+		 * The Renderer calls it before the render pass instead of cull() when getGpuDriven() is enabled
+		 */
+		virtual void cullGpuDriven(const CommandList& cmdList, ComputePipeline* pipeline);
+		/**
+		 * \~spanish @brief Sube las descripciones y los materiales añadidos desde la última vez, sin esperar. Lo llama el Renderer antes de dibujar, fuera del render pass
+		 * \~english @brief Uploads the descriptions and materials added since the last time, without waiting. The Renderer calls it before drawing, outside the render pass
+		 */
+		virtual void updateObjDescBuffer(const CommandList& cmdList);
+		/**
+		 * \~spanish @brief Indica si el buffer de descripciones o el de materiales se han vuelto a crear desde la última llamada, y hay que volver a escribir sus descriptores
+		 * \~english @brief Tells whether the description or the material buffer were created again since the last call, and their descriptors have to be written again
+		 */
+		bool consumeDescriptorsChanged();
+		/**
+		 * \~spanish @brief Activa el descarte de meshlets con una combinación de MeshletCullingFlags. Con 0, el valor por defecto, se dibujan todos los triángulos.
+		 * eCullBackface solo sirve para mallas cerradas, el raster dibuja las dos caras. Necesita draws indirectos con contador, como el raster GPU-driven
+		 * \~english @brief Enables the meshlet culling with a combination of MeshletCullingFlags. With 0, the default, every triangle is drawn.
+		 * eCullBackface is only for closed meshes, the raster draws both faces. It needs indirect count draws, like the GPU-driven raster
+		 */
+		void setMeshletCulling(uint32_t flags);
+		uint32_t getMeshletCulling() const;
+		/**
+		 * \~spanish @brief Error en pixels que puede tener en pantalla un nivel de detalle para usarse. Con 0 siempre se dibuja la malla completa
+		 * \~english @brief Error in pixels a level of detail may have on screen to be used. With 0 the full mesh is always drawn
+		 */
+		void setLodThreshold(float pixels);
+		float getLodThreshold() const;
+		/**
+		 * \~spanish @brief Activa el descarte en CPU de las instancias fuera del frustum de la cámara antes de dibujar. Activado por defecto
+		 * \~english @brief Enables the CPU culling of the instances outside the camera frustum before drawing. Enabled by default
+		 */
+		void setFrustumCulling(bool enabled);
+		bool getFrustumCulling() const;
+		/**
+		 * \~spanish @brief Instancias que quedaron fuera del frustum en el último draw(), 0 si el descarte está desactivado
+		 * \~english @brief Instances left outside the frustum in the last draw(), 0 if the culling is disabled
+		 */
+		size_t getFrustumCulledCount() const;
+		/**
+		 * \~spanish @brief Activa el raster GPU-driven: el descarte por frustum y la elección del nivel de detalle pasan a un compute shader y toda la escena
+		 * se dibuja con un solo draw indirecto. Solo se suben las instancias que cambian. No se combina con el descarte de meshlets.
+		 * Si el dispositivo no lo admite se queda desactivado
+		 * \~english @brief Enables the GPU-driven raster: the frustum culling and the choice of the level of detail move to a compute shader and the whole scene
+		 * is drawn with a single indirect draw. Only the instances that change are uploaded. It is not combined with the meshlet culling.
+		 * If the device does not support it, it stays disabled
+		 */
+		void setGpuDriven(bool enabled);
+		bool getGpuDriven() const;
 
 		const std::vector<Light*>& getLights() const;
 		CameraController* getCamera() const;
 
-		std::vector<MeshInstance>& getInstances();
+		InstanceStorage& getInstances();
 		std::vector<Mesh>& getModels();
-		std::vector<nvvk::Texture>& getTextures();
+		const std::vector<nvvk::Texture>& getTextures() const;
+		TextureCache& getTextureCache();
 		nvvk::Buffer& getObjDescBuff();
+		/**
+		 * \~spanish @brief Tabla de materiales de toda la escena, para el binding eMaterials
+		 * \~english @brief Material table of the whole scene, for the eMaterials binding
+		 */
+		const nvvk::Buffer& getMaterialBuff() const;
 		nvvk::Buffer& getCameraUBO();
 		nvvk::Buffer& getLightsUBO();
 
@@ -89,8 +397,21 @@ namespace Astra
 	class SceneRT : public Astra::Scene
 	{
 	protected:
-		nvvk::RaytracingBuilderKHR _rtBuilder;
+		RaytracingBuilder _rtBuilder;
 		std::vector<VkAccelerationStructureInstanceKHR> _asInstances;
+		size_t _blasModelCount{ 0 }; // models when the BLAS were built
+
+		/**
+		 * \~spanish @brief Indica si la malla de la instancia @p instance tiene BLAS. Las añadidas después de construirlos no se trazan hasta rebuildAS()
+		 * \~english @brief Tells whether the mesh of the @p instance instance has a BLAS. The ones added after they were built are not traced until rebuildAS()
+		 */
+		bool hasBlas(size_t instance) const;
+		VkAccelerationStructureInstanceKHR toRayInstance(size_t instance);
+		/**
+		 * \~spanish @brief Construye los BLAS de los modelos añadidos desde la última vez y los pone detrás de los que ya hay, en sus posiciones de descripción
+		 * \~english @brief Builds the BLAS of the models added since the last time and puts them after the existing ones, at their description slots
+		 */
+		void appendBottomLevelAS();
 
 	public:
 		void init(nvvk::ResourceAllocator* alloc) override;
@@ -105,6 +426,16 @@ namespace Astra
 		 * \~english @brief Creates the top level acceleration structure
 		 */
 		void createTopLevelAS();
+		/**
+		 * \~spanish @brief Además de añadir los modelos, construye solo sus BLAS y rehace el TLAS, sin tocar los BLAS que ya había
+		 * \~english @brief Besides adding the models, builds only their BLAS and rebuilds the TLAS, without touching the BLAS already there
+		 */
+		void publishAsyncLoads() override;
+		/**
+		 * \~spanish @brief Además de borrar el modelo, destruye los BLAS desde su posición, que se han movido, y construye otra vez los de los modelos que ahora van detrás
+		 * \~english @brief Besides removing the model, destroys the BLAS from its slot on, which moved, and builds again the ones of the models now behind it
+		 */
+		void removeModel(MeshHandle handle) override;
 		/**
 		 * \~spanish @brief Actualiza la estructura de aceleración de alto nivel
 		 * Necesario para permitir transformaciones en tiempo de ejecución.
@@ -0,0 +1,97 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <cstdint>
+
+namespace Astra
+{
+	/**
+	 * \~spanish @brief Formato de los píxeles de una textura. Los formatos BC se guardan en bloques de 4x4 píxeles
+	 * \~english @brief Pixel format of a texture. BC formats are stored in blocks of 4x4 pixels
+	 */
+	enum class TextureFormat
+	{
+		RGBA8, // 8 bit sRGB color with alpha
+		BC1,   // sRGB color without alpha, 8 bytes per block
+		BC3,   // sRGB color with alpha, 16 bytes per block
+		BC5	   // two linear channels, for normal maps, 16 bytes per block
+	};
+
+	/**
+	 * \~spanish @brief Bytes que ocupa un nivel de @p width x @p height en el formato @p format
+	 * \~english @brief Size in bytes of a @p width x @p height level in @p format
+	 */
+	size_t getTextureLevelSize(TextureFormat format, uint32_t width, uint32_t height);
+
+	/**
+	 * @struct TextureData
+	 * \~spanish @brief Imagen decodificada en CPU. Separa la decodificación (que se puede hacer en cualquier hilo) de la subida a la GPU.
+	 * Si @p levelOffsets está vacío los mipmaps se generan en la GPU
+	 * \~english @brief Image decoded on the CPU. Splits decoding (which can run on any thread) from the GPU upload.
+	 * If @p levelOffsets is empty the mipmaps are generated on the GPU
+	 */
+	struct TextureData
+	{
+		uint32_t width{ 0 };
+		uint32_t height{ 0 };
+		TextureFormat format{ TextureFormat::RGBA8 };
+		/**
+		 * \~spanish @brief Todos los niveles seguidos, empezando por el mayor
+		 * \~english @brief Every level one after another, starting by the largest
+		 */
+		std::vector<uint8_t> pixels;
+		/**
+		 * \~spanish @brief Posición de cada nivel en @p pixels. Vacío si solo está el nivel 0
+		 * \~english @brief Offset of every level in @p pixels. Empty if there is only level 0
+		 */
+		std::vector<size_t> levelOffsets;
+
+		uint32_t getLevelCount() const;
+		uint32_t getLevelWidth(uint32_t level) const;
+		uint32_t getLevelHeight(uint32_t level) const;
+		const uint8_t* getLevelData(uint32_t level) const;
+		size_t getLevelSize(uint32_t level) const;
+		bool isCompressed() const;
+	};
+
+	/**
+	 * @struct TextureLoadOptions
+	 * \~spanish @brief Opciones para la carga de texturas
+	 * \~english @brief Options for loading textures
+	 */
+	struct TextureLoadOptions
+	{
+		/**
+		 * \~spanish @brief Comprime las imágenes a BC
+		 * \~english @brief Compresses the images to BC
+		 */
+		bool compress{ false };
+		/**
+		 * \~spanish @brief Guarda la imagen procesada (comprimida o con sus mipmaps) en un .ktx2 y la usa en las siguientes cargas
+		 * \~english @brief Stores the processed image (compressed or with its mipmaps) in a .ktx2 and uses it on later loads
+		 */
+		bool useCache{ true };
+		/**
+		 * \~spanish @brief Si el dispositivo no admite BC es false, y los .ktx2 comprimidos se descomprimen en CPU
+		 * \~english @brief False if the device does not support BC, then compressed .ktx2 files are decompressed on the CPU
+		 */
+		bool compressedSupported{ true };
+		/**
+		 * \~spanish @brief Carpeta de los .ktx2 generados. Si está vacía se guardan junto a cada imagen
+		 * \~english @brief Folder for the generated .ktx2 files. If empty they are stored next to each image
+		 */
+		std::string cacheDirectory;
+	};
+
+	/**
+	 * \~spanish @brief Decodifica una imagen o un .ktx2 con todos sus mipmaps. Si no se puede leer devuelve una textura magenta de 1x1. Se puede llamar desde cualquier hilo
+	 * \~english @brief Decodes an image or a .ktx2 file with all its mipmaps. If it cannot be read a 1x1 magenta texture is returned. Can be called from any thread
+	 */
+	TextureData loadTextureData(const std::string& path, const TextureLoadOptions& options = {});
+
+	/**
+	 * \~spanish @brief Decodifica una imagen que ya está en memoria, como las que van dentro de un .glb. @p name solo se usa en los mensajes. No usa la caché de .ktx2
+	 * \~english @brief Decodes an image that is already in memory, like the ones inside a .glb file. @p name is only used in messages. The .ktx2 cache is not used
+	 */
+	TextureData loadTextureData(const uint8_t* bytes, size_t size, const std::string& name, const TextureLoadOptions& options = {});
+}
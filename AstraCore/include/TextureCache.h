@@ -0,0 +1,81 @@
+#pragma once
+#include <nvvk/resourceallocator_vk.hpp>
+#include <CommandList.h>
+#include <Texture.h>
+#include <unordered_map>
+#include <vector>
+#include <string>
+#include <mutex>
+#include <cstdint>
+
+namespace Astra
+{
+	/**
+	 * @class TextureCache
+	 * \~spanish @brief Tabla de texturas de una escena sin duplicados. Cada textura se identifica por su ruta canónica y por el hash de su contenido,
+	 * así que una imagen usada por varios modelos solo se decodifica y se sube una vez. Las entradas llevan un contador de referencias.
+	 * La posición 0 es siempre una textura blanca de 1x1 para los modelos sin texturas
+	 * \~english @brief Texture table of a scene without duplicates. Every texture is identified by its canonical path and by the hash of its contents,
+	 * so an image used by several models is only decoded and uploaded once. Entries are reference counted.
+	 * Slot 0 is always a 1x1 white texture for the models without textures
+	 */
+	class TextureCache
+	{
+	private:
+		nvvk::ResourceAllocatorDma* _alloc{ nullptr };
+
+		// descriptor table, freed slots keep a copy of the dummy until they are reused
+		std::vector<nvvk::Texture> _textures;
+		std::vector<uint32_t> _refCounts;
+		std::vector<uint64_t> _slotHashes;
+		std::vector<uint32_t> _freeSlots;
+
+		std::unordered_map<std::string, uint32_t> _pathSlots;
+		std::unordered_map<uint64_t, uint32_t> _hashSlots;
+		// lookups can come from loader threads
+		mutable std::mutex _mutex;
+
+		void createDummy(const CommandList& cmdList);
+		uint32_t addSlot(const nvvk::Texture& texture, uint64_t hash);
+
+	public:
+		void init(nvvk::ResourceAllocatorDma* alloc);
+		/**
+		 * \~spanish @brief Destruye todas las texturas, tengan referencias o no
+		 * \~english @brief Destroys every texture, whether it is referenced or not
+		 */
+		void destroy();
+
+		/**
+		 * \~spanish @brief Devuelve la posición en la tabla de cada textura de @p paths, añadiendo una referencia. Las que no están se suben con @p cmdList,
+		 * usando @p decoded si trae la imagen ya decodificada (ancho distinto de 0) o decodificándolas en paralelo si no
+		 * \~english @brief Returns the table slot of every texture in @p paths, adding a reference. Missing ones are uploaded with @p cmdList,
+		 * using @p decoded if it holds the already decoded image (non zero width) or decoding them in parallel otherwise
+		 */
+		std::vector<uint32_t> acquire(const CommandList& cmdList, const std::vector<std::string>& paths, const std::vector<TextureData>& decoded = {});
+		/**
+		 * \~spanish @brief Quita una referencia a cada textura de @p slots. Las que se quedan sin referencias se destruyen
+		 * @warning La GPU no puede estar usándolas
+		 * \~english @brief Removes a reference from every texture in @p slots. The ones left without references are destroyed
+		 * @warning The GPU must not be using them
+		 */
+		void release(const std::vector<uint32_t>& slots);
+		/**
+		 * \~spanish @brief Indica si la textura de @p path ya está en la tabla. Se puede llamar desde cualquier hilo
+		 * \~english @brief Tells whether the texture at @p path is already in the table. Can be called from any thread
+		 */
+		bool contains(const std::string& path) const;
+		/**
+		 * \~spanish @brief Ruta con la que la tabla identifica la textura de @p path, para agrupar las que se escriben de formas distintas
+		 * \~english @brief Path the table identifies the texture at @p path with, to group the ones written in different ways
+		 */
+		static std::string getCanonicalPath(const std::string& path);
+
+		/**
+		 * \~spanish @brief Tabla completa, en el orden en que se enlaza en el descriptor de texturas
+		 * \~english @brief Whole table, in the order it is bound to the textures descriptor
+		 */
+		const std::vector<nvvk::Texture>& getTextures() const;
+		size_t getUniqueCount() const;
+	};
+}
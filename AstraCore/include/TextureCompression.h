@@ -0,0 +1,42 @@
+#pragma once
+#include <Texture.h>
+#include <string>
+
+namespace Astra
+{
+	/**
+	 * \~spanish @brief Formato BC adecuado para una imagen RGBA: BC3 si tiene transparencias y BC1 si no
+	 * \~english @brief Suitable BC format for an RGBA image: BC3 if it has transparency and BC1 otherwise
+	 */
+	TextureFormat chooseCompressedFormat(const TextureData& rgba);
+
+	/**
+	 * \~spanish @brief Genera los mipmaps de una imagen RGBA de un nivel y los comprime a @p format. Los bloques se codifican en paralelo en el ThreadPool
+	 * \~english @brief Generates the mipmaps of a single level RGBA image and compresses them to @p format. Blocks are encoded in parallel on the ThreadPool
+	 */
+	TextureData compressTexture(const TextureData& rgba, TextureFormat format);
+
+	/**
+	 * \~spanish @brief Descomprime el nivel 0 de una textura BC a RGBA, para dispositivos sin soporte de BC
+	 * \~english @brief Decompresses level 0 of a BC texture to RGBA, for devices without BC support
+	 */
+	TextureData decompressTexture(const TextureData& compressed);
+
+	/**
+	 * \~spanish @brief Ruta del .ktx2 con la imagen @p sourcePath ya procesada (comprimida o con sus mipmaps). Si @p cacheDirectory está vacío se guarda junto a la imagen
+	 * \~english @brief Path of the .ktx2 with the image @p sourcePath already processed (compressed or with its mipmaps). If @p cacheDirectory is empty it is stored next to the image
+	 */
+	std::string getTextureCachePath(const std::string& sourcePath, const std::string& cacheDirectory = "");
+
+	/**
+	 * \~spanish @brief Escribe una textura en un fichero KTX2 sin supercompresión
+	 * \~english @brief Writes a texture to a KTX2 file without supercompression
+	 */
+	bool writeKtx2(const std::string& path, const TextureData& data);
+
+	/**
+	 * \~spanish @brief Lee un fichero KTX2 sin supercompresión en alguno de los formatos de TextureFormat
+	 * \~english @brief Reads a KTX2 file without supercompression in one of the TextureFormat formats
+	 */
+	bool readKtx2(const std::string& path, TextureData& data);
+}
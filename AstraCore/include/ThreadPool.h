@@ -0,0 +1,77 @@
+#pragma once
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <cstdint>
+
+namespace Astra
+{
+	/**
+	 * @class ThreadPool
+	 * \~spanish @brief Singleton. Conjunto de hilos de trabajo compartido por toda la biblioteca. Se usa para paralelizar la carga de modelos y otras tareas de CPU.
+	 * \~english @brief Singleton. Pool of worker threads shared by the whole library. Used for parallelizing model loading and other CPU tasks.
+	 */
+	class ThreadPool
+	{
+	private:
+		std::vector<std::thread> _workers;
+		std::deque<std::function<void()>> _tasks;
+		std::mutex _mutex;
+		std::condition_variable _cv;
+		bool _stop{ false };
+
+		ThreadPool();
+		~ThreadPool();
+
+		void workerLoop();
+		void enqueue(std::function<void()> task);
+
+	public:
+		static ThreadPool& getInstance()
+		{
+			static ThreadPool instance;
+			return instance;
+		}
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		/**
+		 * \~spanish @brief Número de hilos que participan en un parallelFor (los hilos de trabajo más el que llama)
+		 * \~english @brief Number of threads taking part in a parallelFor (the workers plus the calling one)
+		 */
+		uint32_t getThreadCount() const;
+
+		/**
+		 * \~spanish @brief Encola una tarea y devuelve un future con su resultado
+		 * \~english @brief Queues a task and returns a future with its result
+		 */
+		template <typename F>
+		auto submit(F&& f) -> std::future<decltype(f())>;
+
+		/**
+		 * \~spanish @brief Divide el rango [0, @p count) en lotes de al menos @p minBatch elementos y llama a @p fn(begin, end) con cada uno en paralelo.
+		 * Los lotes se reparten según los hilos quedan libres. El hilo que llama también procesa lotes, por lo que se puede llamar desde dentro de una tarea sin bloquear el pool. Vuelve cuando todos los lotes han terminado.
+		 * \~english @brief Splits the [0, @p count) range into batches of at least @p minBatch elements and calls @p fn(begin, end) for each of them in parallel.
+		 * Batches are handed out as threads become free. The calling thread also processes batches, so it is safe to call from inside a task. Returns once every batch is done.
+		 */
+		void parallelFor(size_t count, const std::function<void(size_t, size_t)>& fn, size_t minBatch = 1);
+	};
+
+#define AstraThreads Astra::ThreadPool::getInstance()
+
+	template <typename F>
+	inline auto ThreadPool::submit(F&& f) -> std::future<decltype(f())>
+	{
+		using R = decltype(f());
+		auto task = std::make_shared<std::packaged_task<R()>>(std::forward<F>(f));
+		std::future<R> result = task->get_future();
+		enqueue([task]() { (*task)(); });
+		return result;
+	}
+}
@@ -1,6 +1,7 @@
 #pragma once
 #include <vector>
 #include <string>
+#include <cstdint>
 #include <glm/glm.hpp>
 namespace Astra
 {
@@ -14,6 +15,18 @@ namespace Astra
 
 	std::vector<char> readShaderSource(const std::string &filename);
 
+	/**
+	 * \~spanish @brief Hash rápido de 64 bits de un bloque de memoria. No es criptográfico, sirve para identificar contenidos
+	 * \~english @brief Fast 64 bit hash of a memory block. Not cryptographic, meant for identifying contents
+	 */
+	uint64_t hashBytes(const void *data, size_t size);
+
+	/**
+	 * \~spanish @brief Indica si la CPU y el sistema operativo permiten usar AVX2. Siempre false fuera de x86
+	 * \~english @brief Tells whether the CPU and the operating system allow using AVX2. Always false outside x86
+	 */
+	bool hasAvx2();
+
 	void Log(const std::string &s, LOG_LEVELS level = INFO);
 
 	void Log(const std::string &name, const glm::vec3 &s, LOG_LEVELS level = INFO);
@@ -0,0 +1,30 @@
+#pragma once
+#include <host_device.h>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace Astra
+{
+	/**
+	 * \~spanish @brief Tamaño en bytes de un vértice con el formato @p vertexFormat (combinación de VertexFormatFlags). Siempre es múltiplo de 4
+	 * \~english @brief Size in bytes of a vertex in the @p vertexFormat format (a combination of VertexFormatFlags). Always a multiple of 4
+	 */
+	uint32_t getVertexStride(uint32_t vertexFormat);
+
+	/**
+	 * \~spanish @brief Empaqueta los vértices en el formato @p vertexFormat en paralelo en el ThreadPool: normales octaédricas en snorm16, coordenadas de textura en half,
+	 * color opcional en unorm8 y, con eVertexQuantized, posiciones en snorm16 relativas a la caja de la malla. @p posScale y @p posOffset devuelven cómo recuperarlas
+	 * (pos * posScale + posOffset). Los shaders las decodifican con loadVertex() de vertex.glsl
+	 * \~english @brief Packs the vertices in the @p vertexFormat format in parallel on the ThreadPool: octahedral normals in snorm16, texture coordinates in half floats,
+	 * optional color in unorm8 and, with eVertexQuantized, positions in snorm16 relative to the mesh bounds. @p posScale and @p posOffset return how to recover them
+	 * (pos * posScale + posOffset). Shaders decode them with loadVertex() from vertex.glsl
+	 */
+	std::vector<uint32_t> packVertices(const Vertex* vertices, size_t count, uint32_t vertexFormat, glm::vec3& posScale, glm::vec3& posOffset);
+
+	/**
+	 * \~spanish @brief Decodifica un vértice empaquetado igual que los shaders
+	 * \~english @brief Decodes a packed vertex the same way the shaders do
+	 */
+	Vertex unpackVertex(const uint32_t* packed, uint32_t vertexFormat, const glm::vec3& posScale, const glm::vec3& posOffset);
+}
@@ -40,16 +40,19 @@ layout(location = 1) in vec3 i_worldPos;
 layout(location = 2) in vec3 i_worldNrm;
 layout(location = 3) in vec3 i_viewDir;
 layout(location = 4) in vec2 i_texCoord;
+layout(location = 5) flat in uint i_objIndex;
+layout(location = 6) flat in uint i_firstTriangle;
 // Outgoing
 layout(location = 0) out vec4 o_color;
 
 layout(buffer_reference, scalar) buffer Vertices {Vertex v[]; }; // Positions of an object
 layout(buffer_reference, scalar) buffer Indices {uint i[]; }; // Triangle indices
-layout(buffer_reference, scalar) buffer Materials {WaveFrontMaterial m[]; }; // Array of all materials on an object
 layout(buffer_reference, scalar) buffer MatIndices {int i[]; }; // Material ID for each triangle
+layout(buffer_reference, scalar) buffer TriangleIds {uint i[]; }; // Original triangle of each simplified triangle
 
 layout(binding = eObjDescs, scalar) buffer ObjDesc_ { ObjDesc i[]; } objDesc;
 layout(binding = eTextures) uniform sampler2D[] textureSamplers;
+layout(binding = eMaterials, scalar) buffer Materials_ { WaveFrontMaterial m[]; } materials;
 layout(binding = eLights) uniform _LightsUniform { LightsUniform lightUni; };
 
 // clang-format on
@@ -58,11 +61,15 @@ layout(binding = eLights) uniform _LightsUniform { LightsUniform lightUni; };
 void main()
 {
   // Material of the object
-  ObjDesc    objResource = objDesc.i[pcRaster.objIndex];
+  ObjDesc    objResource = objDesc.i[i_objIndex];
   MatIndices matIndices  = MatIndices(objResource.materialIndexAddress);
-  Materials  materials   = Materials(objResource.materialAddress);
 
-  int               matIndex = matIndices.i[gl_PrimitiveID];
+  // culled instances draw every visible meshlet on its own, from its first triangle, and levels of detail have their own triangles
+  uint triangle = i_firstTriangle + uint(gl_PrimitiveID);
+  if(objResource.triangleIdAddress != 0)
+    triangle = TriangleIds(objResource.triangleIdAddress).i[gl_PrimitiveID];
+
+  int               matIndex = matIndices.i[triangle];
   WaveFrontMaterial mat      = materials.m[matIndex];
 
   vec3 diffuseColor = vec3(0);
@@ -90,7 +97,7 @@ void main()
       diffuseColor += computeDiffuse(mat, L, lightUni.lights[i].color, N) * lightIntensity;
       if(mat.textureId >= 0)
       {
-        int  txtOffset  = objDesc.i[pcRaster.objIndex].txtOffset;
+        int  txtOffset  = objResource.txtOffset;
         uint txtId      = txtOffset + mat.textureId;
         vec3 diffuseTxt = texture(textureSamplers[nonuniformEXT(txtId)], i_texCoord).xyz;
         diffuseColor *= diffuseTxt;
@@ -49,18 +49,35 @@ using uint = unsigned int;
 #endif
 
 #define MAX_LIGHTS 32
+#define MESHLET_MAX_VERTICES 64
+#define MESHLET_MAX_TRIANGLES 124
+#define MESHLET_CULL_GROUP_SIZE 64
+#define GPU_CULL_GROUP_SIZE 64
+#define LOD_HYSTERESIS 1.25 // a level of detail is left when its error grows this much over the threshold, and taken when it is this much under it
 
 START_BINDING(SceneBindings)
 eCamera = 0,  // Global uniform containing camera matrices
 eLights = 1,	// Lights in the scene
 eObjDescs = 2,  // Access to the object descriptions
-eTextures = 3   // Access to textures
+eTextures = 3,  // Access to textures
+eMaterials = 4  // Deduplicated materials of the whole scene
 END_BINDING();
 
 START_BINDING(RtxBindings)
 eTlas = 0,  // Top-level acceleration structure
 eOutImage = 1   // Ray tracer output image
 END_BINDING();
+
+START_BINDING(VertexFormatFlags)
+eVertexPacked = 1,    // Octahedral snorm16 normals and half float texture coordinates
+eVertexQuantized = 2, // Packed with snorm16 positions, dequantized with ObjDesc::posScale and posOffset
+eVertexColor = 4      // Packed keeping the color as unorm8
+END_BINDING();
+
+START_BINDING(MeshletCullingFlags)
+eCullFrustum = 1,  // Meshlets outside the view frustum
+eCullBackface = 2  // Meshlets facing away from the camera. The raster draws both faces, so only for closed meshes
+END_BINDING();
 // clang-format on
 
 // Information of a obj model when referenced in a shader
@@ -69,8 +86,12 @@ struct ObjDesc
 	int txtOffset;				   // Texture index offset in the array of textures
 	uint64_t vertexAddress;		   // Address of the Vertex buffer
 	uint64_t indexAddress;		   // Address of the index buffer
-	uint64_t materialAddress;	   // Address of the material buffer
-	uint64_t materialIndexAddress; // Address of the triangle material index buffer
+	uint64_t materialIndexAddress; // Address of the triangle material index buffer, already slots of the scene material table
+	int vertexFormat;			   // Combination of VertexFormatFlags, 0 is the plain Vertex
+	int vertexStride;			   // Size of a vertex in bytes
+	vec3 posScale;				   // Quantized positions are pos * posScale + posOffset
+	vec3 posOffset;
+	uint64_t triangleIdAddress;	   // Original triangle of each triangle of a level of detail, 0 if they are the same
 };
 
 // Uniform buffer set at each frame
@@ -108,6 +129,77 @@ struct PushConstantRaster
 	mat4 modelMatrix; // matrix of the instance
 	uint objIndex;
 	uint nLights;
+	uint64_t instanceAddress;	// GpuInstance array of the GPU-driven raster, the instance is gl_InstanceIndex. 0 uses modelMatrix and objIndex, and gl_InstanceIndex is the first triangle of the draw
+	uint64_t stateAddress;		// GpuInstanceState array written by the GPU culling
+};
+
+// Push constant structure for the meshlet culling
+struct PushConstantCull
+{
+	mat4 viewProj;			  // Camera view * projection
+	vec3 cameraPos;			  // Camera position in world space
+	uint flags;				  // Combination of MeshletCullingFlags
+	uint64_t chunkAddress;	  // CullChunk array, one per workgroup
+	uint64_t instanceAddress; // GpuInstance array, the same one the GPU-driven raster uses
+	uint64_t drawAddress;	  // A VkDrawIndexedIndirectCommand per meshlet of the culled instances
+	uint64_t countAddress;	  // Visible meshlets of every instance, the count of its indirect draws
+};
+
+// Meshlets of a culled instance handled by one workgroup of the meshlet culling
+struct CullChunk
+{
+	uint64_t meshletAddress; // Meshlets of the mesh of the instance
+	uint instance;
+	uint firstMeshlet; // The chunk takes up to MESHLET_CULL_GROUP_SIZE meshlets from here
+	uint meshletCount; // Meshlets of the whole mesh
+	uint firstDraw;	   // First draw command of the instance
+};
+
+// Instance of the GPU-driven raster
+struct GpuInstance
+{
+	mat4 transform;
+	uint mesh;	  // Position in the GpuMesh array
+	uint visible; // 0 if it is never drawn
+};
+
+// Mesh of the GPU-driven raster
+struct GpuMesh
+{
+	vec3 center; // Bounding sphere in object space
+	float radius;
+	uint descIndex; // Description of the full mesh, level l is at descIndex + l
+	uint lodCount;
+};
+
+// Indices of a description in the merged index buffer of the GPU-driven raster, one per ObjDesc
+struct GpuDrawRange
+{
+	uint firstIndex;
+	uint indexCount;
+	float error; // Error of the level of detail in object space, 0 for the full mesh
+};
+
+// What the GPU culling decided for an instance, kept between frames
+struct GpuInstanceState
+{
+	uint lod;
+	uint objIndex; // Description it is drawn with
+};
+
+// Push constant structure for the GPU-driven culling
+struct PushConstantGpuCull
+{
+	mat4 viewProj;
+	vec3 cameraPos;
+	uint instanceCount;
+	uint64_t instanceAddress; // GpuInstance array
+	uint64_t meshAddress;	  // GpuMesh array
+	uint64_t rangeAddress;	  // GpuDrawRange array
+	uint64_t stateAddress;	  // GpuInstanceState array
+	uint64_t drawAddress;	  // Draw count followed by a VkDrawIndexedIndirectCommand per visible instance
+	float pixelsPerUnit;	  // Pixels covered by one unit at distance 1
+	float lodThreshold;		  // Error in pixels allowed on screen, 0 always draws the full mesh
 };
 
 // Push constant structure for the ray tracer
@@ -128,6 +220,19 @@ struct Vertex
 	vec2 texCoord;
 };
 
+// Cluster of neighbouring triangles of a mesh, with the bounds to cull it
+struct Meshlet
+{
+	vec3 center; // Bounding sphere in object space
+	float radius;
+	vec3 coneApex; // Normal cone, the meshlet faces away if dot(normalize(coneApex - camera), coneAxis) >= coneCutoff
+	float coneCutoff;
+	vec3 coneAxis;
+	uint firstTriangle; // The triangles are consecutive in the index buffer of the mesh
+	uint triangleCount;
+	uint vertexCount;
+};
+
 struct WaveFrontMaterial
 {
 	vec3 ambient;
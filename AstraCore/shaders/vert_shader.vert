@@ -23,8 +23,10 @@
 #extension GL_GOOGLE_include_directive : enable
 
 #extension GL_EXT_shader_explicit_arithmetic_types_int64 : require
+#extension GL_EXT_buffer_reference2 : require
 
 #include "wavefront.glsl"
+#include "vertex.glsl"
 
 layout(binding = eCamera) uniform _CameraUniform
 {
@@ -36,16 +38,21 @@ layout(push_constant) uniform _PushConstantRaster
   PushConstantRaster pcRaster;
 };
 
-layout(location = 0) in vec3 i_position;
-layout(location = 1) in vec3 i_normal;
-layout(location = 2) in vec3 i_color;
-layout(location = 3) in vec2 i_texCoord;
+// vertices are read from the object buffer, every mesh can use its own format
+layout(binding = eObjDescs, scalar) buffer ObjDesc_ { ObjDesc i[]; } objDesc;
+
+// clang-format off
+layout(buffer_reference, scalar) buffer Instances {GpuInstance i[]; };
+layout(buffer_reference, scalar) buffer States {GpuInstanceState s[]; };
+// clang-format on
 
 
 layout(location = 1) out vec3 o_worldPos;
 layout(location = 2) out vec3 o_worldNrm;
 layout(location = 3) out vec3 o_viewDir;
 layout(location = 4) out vec2 o_texCoord;
+layout(location = 5) flat out uint o_objIndex;
+layout(location = 6) flat out uint o_firstTriangle;
 
 out gl_PerVertex
 {
@@ -55,12 +62,26 @@ out gl_PerVertex
 
 void main()
 {
-  vec3 origin = vec3(uni.viewInverse * vec4(0, 0, 0, 1));
+  mat4 modelMatrix   = pcRaster.modelMatrix;
+  uint objIndex      = pcRaster.objIndex;
+  uint firstTriangle = gl_InstanceIndex; // the meshlet culling leaves the first triangle of every draw in firstInstance, 0 otherwise
+  if(pcRaster.instanceAddress != 0)
+  {
+    // GPU-driven, the culling left the instance in firstInstance and the description it picked in its state
+    modelMatrix   = Instances(pcRaster.instanceAddress).i[gl_InstanceIndex].transform;
+    objIndex      = States(pcRaster.stateAddress).s[gl_InstanceIndex].objIndex;
+    firstTriangle = 0;
+  }
+
+  Vertex v      = loadVertex(objDesc.i[objIndex], gl_VertexIndex);
+  vec3   origin = vec3(uni.viewInverse * vec4(0, 0, 0, 1));
 
-  o_worldPos = vec3(pcRaster.modelMatrix * vec4(i_position, 1.0));
+  o_worldPos = vec3(modelMatrix * vec4(v.pos, 1.0));
   o_viewDir  = vec3(o_worldPos - origin);
-  o_texCoord = i_texCoord;
-  o_worldNrm = mat3(pcRaster.modelMatrix) * i_normal;
+  o_texCoord = v.texCoord;
+  o_worldNrm = mat3(modelMatrix) * v.nrm;
+  o_objIndex = objIndex;
+  o_firstTriangle = firstTriangle;
 
   gl_Position = uni.viewProj * vec4(o_worldPos, 1.0);
 }
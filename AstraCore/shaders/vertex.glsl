@@ -0,0 +1,46 @@
+// Vertex fetch for every vertex format of host_device.h (see VertexPacking.h)
+// Needs GL_EXT_buffer_reference2, GL_EXT_scalar_block_layout and GL_EXT_shader_explicit_arithmetic_types_int64
+
+#include "host_device.h"
+
+layout(buffer_reference, scalar) buffer VertexData {Vertex v[]; }; // Plain vertices of an object
+layout(buffer_reference, scalar) buffer VertexWords {uint w[]; }; // Packed vertices of an object
+
+vec3 octDecode(vec2 f)
+{
+	vec3  n = vec3(f.x, f.y, 1.0 - abs(f.x) - abs(f.y));
+	float t = max(-n.z, 0.0);
+	n.x += n.x >= 0.0 ? -t : t;
+	n.y += n.y >= 0.0 ? -t : t;
+	return normalize(n);
+}
+
+Vertex loadVertex(ObjDesc desc, uint index)
+{
+	uint format = uint(desc.vertexFormat);
+	if((format & eVertexPacked) == 0)
+	{
+		VertexData vertices = VertexData(desc.vertexAddress);
+		return vertices.v[index];
+	}
+
+	VertexWords words = VertexWords(desc.vertexAddress);
+	uint        w     = index * (uint(desc.vertexStride) / 4);
+	Vertex      v;
+	if((format & eVertexQuantized) != 0)
+	{
+		vec2 xy = unpackSnorm2x16(words.w[w]);
+		vec2 zw = unpackSnorm2x16(words.w[w + 1]);
+		v.pos   = vec3(xy, zw.x) * desc.posScale + desc.posOffset;
+		w += 2;
+	}
+	else
+	{
+		v.pos = uintBitsToFloat(uvec3(words.w[w], words.w[w + 1], words.w[w + 2]));
+		w += 3;
+	}
+	v.nrm      = octDecode(unpackSnorm2x16(words.w[w]));
+	v.texCoord = unpackHalf2x16(words.w[w + 1]);
+	v.color    = (format & eVertexColor) != 0 ? unpackUnorm4x8(words.w[w + 2]).rgb : vec3(0);
+	return v;
+}
@@ -4,8 +4,15 @@
 #include <nvvk/buffers_vk.hpp>
 #include <Utils.h>
 #include <glm/gtx/transform.hpp>
+#include <algorithm>
 #include "app.h"
 
+namespace
+{
+	// texture descriptors the layout has room for when it is first created, it doubles when the scene outgrows it
+	constexpr uint32_t MinTextureCapacity = 256;
+}
+
 void Astra::App::destroyPipelines()
 {
 	AstraDevice.waitIdle();
@@ -14,11 +21,21 @@ void Astra::App::destroyPipelines()
 		p->destroy(&_alloc);
 		delete p;
 	}
+	_pipelines.clear();
 }
 
 void Astra::App::createDescriptorSetLayout()
 {
-	int nbTxt = _scenes[_currentScene]->getTextures().size();
+	const VkDevice device = AstraDevice.getVkDevice();
+	if (_descSetLayout != VK_NULL_HANDLE)
+	{
+		// the set goes with its pool
+		vkDestroyDescriptorPool(device, _descPool, nullptr);
+		vkDestroyDescriptorSetLayout(device, _descSetLayout, nullptr);
+	}
+	const uint32_t nbTxt = static_cast<uint32_t>(_scenes[_currentScene]->getTextures().size());
+	if (nbTxt > _textureCapacity)
+		_textureCapacity = std::max(nbTxt, std::max(_textureCapacity * 2, MinTextureCapacity));
 
 	// Camera matrices
 	_descSetLayoutBind.addBinding(SceneBindings::eCamera, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1,
@@ -30,27 +47,41 @@ void Astra::App::createDescriptorSetLayout()
 	_descSetLayoutBind.addBinding(SceneBindings::eObjDescs, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1,
 		VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT | (AstraDevice.getRtEnabled() ? (VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR) : 0));
 	// Textures
-	_descSetLayoutBind.addBinding(SceneBindings::eTextures, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, nbTxt,
+	_descSetLayoutBind.addBinding(SceneBindings::eTextures, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, _textureCapacity,
+		VK_SHADER_STAGE_FRAGMENT_BIT | (AstraDevice.getRtEnabled() ? (VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR) : 0));
+	// only the slots the scene uses are written, the shaders never read the others
+	_descSetLayoutBind.setBindingFlags(SceneBindings::eTextures, VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT);
+	// Materials
+	_descSetLayoutBind.addBinding(SceneBindings::eMaterials, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1,
 		VK_SHADER_STAGE_FRAGMENT_BIT | (AstraDevice.getRtEnabled() ? (VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR) : 0));
 
-	_descSetLayout = _descSetLayoutBind.createLayout(AstraDevice.getVkDevice());
-	_descPool = _descSetLayoutBind.createPool(AstraDevice.getVkDevice(), 1);
-	_descSet = nvvk::allocateDescriptorSet(AstraDevice.getVkDevice(), _descPool, _descSetLayout);
+	_descSetLayout = _descSetLayoutBind.createLayout(device, 0, nvvk::DescriptorSupport::CORE_1_2);
+	// a set per frame in flight, a frame only writes its own once the GPU is done with it
+	const uint32_t frameCount = _renderer->getFrameCount();
+	_descPool = _descSetLayoutBind.createPool(device, frameCount);
+	nvvk::allocateDescriptorSets(device, _descPool, _descSetLayout, frameCount, _frameDescSets);
+	_descSet = _frameDescSets[0];
+	// the new sets are empty, none of them has the current descriptors
+	_descVersion++;
+	_frameDescVersions.assign(frameCount, 0);
 }
 
-void Astra::App::updateDescriptorSet()
+void Astra::App::writeDescriptorSet(VkDescriptorSet set)
 {
 	std::vector<VkWriteDescriptorSet> writes;
 
 	// Camera matrices and scene description
 	VkDescriptorBufferInfo dbiCamUnif{ _scenes[_currentScene]->getCameraUBO().buffer, 0, VK_WHOLE_SIZE };
-	writes.emplace_back(_descSetLayoutBind.makeWrite(_descSet, SceneBindings::eCamera, &dbiCamUnif));
+	writes.emplace_back(_descSetLayoutBind.makeWrite(set, SceneBindings::eCamera, &dbiCamUnif));
 
 	VkDescriptorBufferInfo dbiLightUnif{ _scenes[_currentScene]->getLightsUBO().buffer, 0, VK_WHOLE_SIZE };
-	writes.emplace_back(_descSetLayoutBind.makeWrite(_descSet, SceneBindings::eLights, &dbiLightUnif));
+	writes.emplace_back(_descSetLayoutBind.makeWrite(set, SceneBindings::eLights, &dbiLightUnif));
 
 	VkDescriptorBufferInfo dbiSceneDesc{ _scenes[_currentScene]->getObjDescBuff().buffer, 0, VK_WHOLE_SIZE };
-	writes.emplace_back(_descSetLayoutBind.makeWrite(_descSet, SceneBindings::eObjDescs, &dbiSceneDesc));
+	writes.emplace_back(_descSetLayoutBind.makeWrite(set, SceneBindings::eObjDescs, &dbiSceneDesc));
+
+	VkDescriptorBufferInfo dbiMaterials{ _scenes[_currentScene]->getMaterialBuff().buffer, 0, VK_WHOLE_SIZE };
+	writes.emplace_back(_descSetLayoutBind.makeWrite(set, SceneBindings::eMaterials, &dbiMaterials));
 
 	// All texture samplers
 	std::vector<VkDescriptorImageInfo> diit;
@@ -61,12 +92,26 @@ void Astra::App::updateDescriptorSet()
 		diit.emplace_back(texture.descriptor);
 	}
 	//}
-	writes.emplace_back(_descSetLayoutBind.makeWriteArray(_descSet, SceneBindings::eTextures, diit.data()));
+	if (!diit.empty())
+	{
+		VkWriteDescriptorSet textureWrite = _descSetLayoutBind.makeWriteArray(set, SceneBindings::eTextures, diit.data());
+		textureWrite.descriptorCount = static_cast<uint32_t>(diit.size());
+		writes.emplace_back(textureWrite);
+	}
 
 	// Writing the information
 	vkUpdateDescriptorSets(AstraDevice.getVkDevice(), static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
 }
 
+void Astra::App::updateDescriptorSet()
+{
+	for (size_t i = 0; i < _frameDescSets.size(); i++)
+	{
+		writeDescriptorSet(_frameDescSets[i]);
+		_frameDescVersions[i] = _descVersion;
+	}
+}
+
 void Astra::App::resetScene(bool recreatePipelines)
 {
 	_scenes[_currentScene]->reset();
@@ -82,6 +127,53 @@ void Astra::App::resetScene(bool recreatePipelines)
 
 }
 
+void Astra::App::updateSceneDescriptors()
+{
+	if (_scenes[_currentScene]->getTextures().size() > _textureCapacity)
+	{
+		// the pipelines were created with the old layout, the layout doubles so this is rare
+		AstraDevice.waitIdle();
+		_descSetLayoutBind.clear();
+		createDescriptorSetLayout();
+		destroyPipelines();
+		createPipelines();
+	}
+	// every frame writes its own sets once the GPU is done with them
+	_descVersion++;
+}
+
+void Astra::App::updateFrameDescriptors(uint32_t frame)
+{
+	_descSet = _frameDescSets[frame];
+	if (_frameDescVersions[frame] == _descVersion)
+		return;
+	writeFrameDescriptors(frame);
+	_frameDescVersions[frame] = _descVersion;
+}
+
+void Astra::App::writeFrameDescriptors(uint32_t frame)
+{
+	writeDescriptorSet(_frameDescSets[frame]);
+}
+
+void Astra::App::updateAsyncLoads()
+{
+	Scene* scene = _scenes[_currentScene];
+	if (scene->updateAsyncLoads())
+	{
+		// the replaced buffers are retired, the frames in flight keep reading them through their own sets
+		scene->publishAsyncLoads();
+		// new textures go into free slots of the binding, only the descriptors are written
+		scene->consumeDescriptorsChanged();
+		updateSceneDescriptors();
+	}
+	else if (scene->consumeDescriptorsChanged())
+	{
+		// models added directly reallocated the description or material buffers
+		updateSceneDescriptors();
+	}
+}
+
 void Astra::App::onResize(int w, int h)
 {
 	if (w == 0 || h == 0)
@@ -160,6 +252,7 @@ void Astra::App::destroy()
 		for (auto s : _scenes)
 			s->destroy();
 
+		vkDestroyDescriptorPool(AstraDevice.getVkDevice(), _descPool, nullptr);
 		vkDestroyDescriptorSetLayout(AstraDevice.getVkDevice(), _descSetLayout, nullptr);
 
 		destroyPipelines();
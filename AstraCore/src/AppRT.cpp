@@ -46,20 +46,29 @@ void Astra::AppRT::destroy()
 void Astra::AppRT::createRtDescriptorSetLayout()
 {
 	const auto& device = AstraDevice.getVkDevice();
+	if (_rtDescSetLayout != VK_NULL_HANDLE)
+	{
+		vkDestroyDescriptorPool(device, _rtDescPool, nullptr);
+		vkDestroyDescriptorSetLayout(device, _rtDescSetLayout, nullptr);
+	}
 	_rtDescSetLayoutBind.addBinding(RtxBindings::eTlas, VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR, 1, VK_SHADER_STAGE_RAYGEN_BIT_KHR | VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR);
 	_rtDescSetLayoutBind.addBinding(RtxBindings::eOutImage, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1, VK_SHADER_STAGE_RAYGEN_BIT_KHR);
 
-	_rtDescPool = _rtDescSetLayoutBind.createPool(device);
+	const uint32_t frameCount = _renderer->getFrameCount();
+	_rtDescPool = _rtDescSetLayoutBind.createPool(device, frameCount);
 	_rtDescSetLayout = _rtDescSetLayoutBind.createLayout(device);
 
+	std::vector<VkDescriptorSetLayout> layouts(frameCount, _rtDescSetLayout);
 	VkDescriptorSetAllocateInfo allocateInfo{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
 	allocateInfo.descriptorPool = _rtDescPool;
-	allocateInfo.descriptorSetCount = 1;
-	allocateInfo.pSetLayouts = &_rtDescSetLayout;
-	vkAllocateDescriptorSets(device, &allocateInfo, &_rtDescSet);
+	allocateInfo.descriptorSetCount = frameCount;
+	allocateInfo.pSetLayouts = layouts.data();
+	_rtFrameDescSets.resize(frameCount);
+	vkAllocateDescriptorSets(device, &allocateInfo, _rtFrameDescSets.data());
+	_rtDescSet = _rtFrameDescSets[0];
 }
 
-void Astra::AppRT::updateRtDescriptorSet()
+void Astra::AppRT::writeRtDescriptorSet(VkDescriptorSet set)
 {
 	VkAccelerationStructureKHR tlas = ((SceneRT*)_scenes[_currentScene])->getTLAS();
 	VkWriteDescriptorSetAccelerationStructureKHR descASInfo{ VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET_ACCELERATION_STRUCTURE_KHR };
@@ -68,17 +77,35 @@ void Astra::AppRT::updateRtDescriptorSet()
 	VkDescriptorImageInfo imageInfo{ {}, _renderer->getOffscreenColor().descriptor.imageView, VK_IMAGE_LAYOUT_GENERAL };
 
 	std::vector<VkWriteDescriptorSet> writes;
-	writes.emplace_back(_rtDescSetLayoutBind.makeWrite(_rtDescSet, RtxBindings::eTlas, &descASInfo));
-	writes.emplace_back(_rtDescSetLayoutBind.makeWrite(_rtDescSet, RtxBindings::eOutImage, &imageInfo));
+	writes.emplace_back(_rtDescSetLayoutBind.makeWrite(set, RtxBindings::eTlas, &descASInfo));
+	writes.emplace_back(_rtDescSetLayoutBind.makeWrite(set, RtxBindings::eOutImage, &imageInfo));
 	vkUpdateDescriptorSets(AstraDevice.getVkDevice(), static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
 }
 
+void Astra::AppRT::updateRtDescriptorSet()
+{
+	for (auto set : _rtFrameDescSets)
+		writeRtDescriptorSet(set);
+}
+
 void Astra::AppRT::onResize(int w, int h)
 {
 	Astra::App::onResize(w, h);
 	updateRtDescriptorSet();
 }
 
+void Astra::AppRT::updateFrameDescriptors(uint32_t frame)
+{
+	_rtDescSet = _rtFrameDescSets[frame];
+	App::updateFrameDescriptors(frame);
+}
+
+void Astra::AppRT::writeFrameDescriptors(uint32_t frame)
+{
+	App::writeFrameDescriptors(frame);
+	writeRtDescriptorSet(_rtFrameDescSets[frame]);
+}
+
 void Astra::AppRT::resetScene(bool recreatePipelines)
 {
 	_scenes[_currentScene]->reset();
@@ -18,6 +18,17 @@ void Astra::CommandList::updateBuffer(const nvvk::Buffer &buffer, uint32_t offse
 	vkCmdUpdateBuffer(_cmdBuf, buffer.buffer, offset, size, data);
 }
 
+void Astra::CommandList::fillBuffer(const nvvk::Buffer &buffer, uint32_t data, VkDeviceSize offset, VkDeviceSize size) const
+{
+	vkCmdFillBuffer(_cmdBuf, buffer.buffer, offset, size, data);
+}
+
+void Astra::CommandList::copyBuffer(const nvvk::Buffer &src, const nvvk::Buffer &dst, VkDeviceSize srcOffset, VkDeviceSize dstOffset, VkDeviceSize size) const
+{
+	VkBufferCopy region{srcOffset, dstOffset, size};
+	vkCmdCopyBuffer(_cmdBuf, src.buffer, dst.buffer, 1, &region);
+}
+
 void Astra::CommandList::begin(const VkCommandBufferBeginInfo &beginInfo) const
 {
 	vkBeginCommandBuffer(_cmdBuf, &beginInfo);
@@ -38,12 +49,12 @@ void Astra::CommandList::endRenderPass() const
 	vkCmdEndRenderPass(_cmdBuf);
 }
 
-void Astra::CommandList::drawIndexed(const VkBuffer &vertexBuffer, const VkBuffer &indexBuffer, uint32_t nbIndices) const
+void Astra::CommandList::drawIndexed(const VkBuffer &vertexBuffer, const VkBuffer &indexBuffer, uint32_t nbIndices, uint32_t firstIndex) const
 {
 	VkDeviceSize offset{0};
 	vkCmdBindVertexBuffers(_cmdBuf, 0, 1, &vertexBuffer, &offset);
 	vkCmdBindIndexBuffer(_cmdBuf, indexBuffer, 0, VK_INDEX_TYPE_UINT32);
-	vkCmdDrawIndexed(_cmdBuf, nbIndices, 1, 0, 0, 0);
+	vkCmdDrawIndexed(_cmdBuf, nbIndices, 1, firstIndex, 0, 0);
 }
 
 void Astra::CommandList::draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance) const
@@ -51,6 +62,24 @@ void Astra::CommandList::draw(uint32_t vertexCount, uint32_t instanceCount, uint
 	vkCmdDraw(_cmdBuf, vertexCount, instanceCount, firstVertex, firstInstance);
 }
 
+void Astra::CommandList::drawIndexedIndirect(const VkBuffer &indexBuffer, const VkBuffer &drawBuffer, VkDeviceSize offset, uint32_t drawCount, uint32_t stride) const
+{
+	vkCmdBindIndexBuffer(_cmdBuf, indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+	vkCmdDrawIndexedIndirect(_cmdBuf, drawBuffer, offset, drawCount, stride);
+}
+
+void Astra::CommandList::drawIndexedIndirectCount(const VkBuffer &indexBuffer, const VkBuffer &drawBuffer, VkDeviceSize offset, const VkBuffer &countBuffer, VkDeviceSize countOffset, uint32_t maxDrawCount,
+	uint32_t stride) const
+{
+	vkCmdBindIndexBuffer(_cmdBuf, indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+	vkCmdDrawIndexedIndirectCount(_cmdBuf, drawBuffer, offset, countBuffer, countOffset, maxDrawCount, stride);
+}
+
+void Astra::CommandList::dispatch(uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ) const
+{
+	vkCmdDispatch(_cmdBuf, groupCountX, groupCountY, groupCountZ);
+}
+
 void Astra::CommandList::raytrace(const std::array<VkStridedDeviceAddressRegionKHR, 4> &regions, uint32_t width, uint32_t height, uint32_t depth) const
 {
 	vkCmdTraceRaysKHR(_cmdBuf, &regions[0], &regions[1], &regions[2], &regions[3], width, height, depth);
@@ -2,9 +2,10 @@
 #include <nvvk/context_vk.hpp>
 #include <stdexcept>
 #include <nvvk/images_vk.hpp>
-#define STB_IMAGE_IMPLEMENTATION
-#include <stb_image.h>
 #include <icon.h>
+#include <Utils.h>
+#include <VertexPacking.h>
+#include <nvvk/buffers_vk.hpp>
 
 constexpr auto SAMPLE_WIDTH = 1280;
 constexpr auto SAMPLE_HEIGHT = 720;
@@ -150,6 +151,27 @@ namespace Astra
 		VkPhysicalDeviceProperties2 prop2{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2 };
 		prop2.pNext = &_rtProperties;
 		vkGetPhysicalDeviceProperties2(AstraDevice.getPhysicalDevice(), &prop2);
+
+		// nvvk enables every supported core feature, BC included
+		bool bcSupported = _vkcontext.m_physicalInfo.features10.textureCompressionBC == VK_TRUE;
+		for (VkFormat format : { VK_FORMAT_BC1_RGB_SRGB_BLOCK, VK_FORMAT_BC3_SRGB_BLOCK, VK_FORMAT_BC5_UNORM_BLOCK })
+		{
+			VkFormatProperties formatProperties;
+			vkGetPhysicalDeviceFormatProperties(_physicalDevice, format, &formatProperties);
+			bcSupported = bcSupported && (formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT);
+		}
+		_textureLoadOptions.compress = createInfo.compressTextures;
+		_textureLoadOptions.useCache = createInfo.cacheTextures;
+		_textureLoadOptions.compressedSupported = bcSupported;
+		_textureLoadOptions.cacheDirectory = createInfo.textureCacheDirectory;
+		if (createInfo.compressTextures && !bcSupported)
+		{
+			Astra::Log("The device does not support BC textures, they will be uncompressed", WARNING);
+		}
+
+		const nvvk::Context::PhysicalDeviceInfo& physicalInfo = _vkcontext.m_physicalInfo;
+		_gpuDrivenSupported = physicalInfo.features12.drawIndirectCount == VK_TRUE && physicalInfo.features10.multiDrawIndirect == VK_TRUE
+			&& physicalInfo.features10.drawIndirectFirstInstance == VK_TRUE;
 	}
 
 	VkInstance Device::getVkInstance() const
@@ -200,6 +222,16 @@ namespace Astra
 		return _rtProperties;
 	}
 
+	const TextureLoadOptions& Device::getTextureLoadOptions() const
+	{
+		return _textureLoadOptions;
+	}
+
+	bool Device::getGpuDrivenSupported() const
+	{
+		return _gpuDrivenSupported;
+	}
+
 	VkShaderModule Device::createShaderModule(const std::vector<char>& code)
 	{
 		VkShaderModuleCreateInfo createInfo = {};
@@ -270,21 +302,100 @@ namespace Astra
 		vkQueueWaitIdle(_queue);
 	}
 
-	nvvk::RaytracingBuilderKHR::BlasInput Device::objectToVkGeometry(const Astra::Mesh& model)
+	void Device::initFrames(uint32_t count)
 	{
-		size_t nbIndices = model.indices.size();
-		size_t nbVertices = model.vertices.size();
+		_frameSubmitted.assign(count, 0);
+		_frameCompleted.assign(count, 0);
+		_frameIndex = 0;
+		_recording = false;
+	}
+
+	void Device::retire(std::function<void()> destroy)
+	{
+		RetiredResource resource{ std::move(destroy), {} };
+		for (uint32_t i = 0; i < _frameSubmitted.size(); i++)
+		{
+			if (_frameSubmitted[i] > _frameCompleted[i])
+				resource.frames.emplace_back(i, _frameSubmitted[i]);
+		}
+		// the commands being recorded may use it too, their submit is the next one
+		if (_recording)
+			resource.frames.emplace_back(_frameIndex, _submitSerial + 1);
+		if (resource.frames.empty())
+		{
+			// nothing in flight can be using it
+			resource.destroy();
+			return;
+		}
+		_retired.push_back(std::move(resource));
+	}
+
+	void Device::frameSubmitted(uint32_t frame)
+	{
+		_frameSubmitted[frame] = ++_submitSerial;
+		_recording = false;
+	}
+
+	void Device::frameCompleted(uint32_t frame)
+	{
+		_frameIndex = frame;
+		_recording = true;
+		_frameCompleted[frame] = _frameSubmitted[frame];
+
+		size_t kept = 0;
+		for (size_t i = 0; i < _retired.size(); i++)
+		{
+			bool done = true;
+			for (const auto& [f, serial] : _retired[i].frames)
+				done = done && _frameCompleted[f] >= serial;
+			if (done)
+				_retired[i].destroy();
+			else
+				_retired[kept++] = std::move(_retired[i]);
+		}
+		_retired.resize(kept);
+	}
+
+	uint32_t Device::getFrameCount() const
+	{
+		return static_cast<uint32_t>(_frameSubmitted.size());
+	}
+
+	uint32_t Device::getFrameIndex() const
+	{
+		return _frameIndex;
+	}
+
+	void Device::flushRetired()
+	{
+		for (auto& resource : _retired)
+			resource.destroy();
+		_retired.clear();
+	}
+
+	nvvk::RaytracingBuilderKHR::BlasInput Device::objectToVkGeometry(const Astra::Mesh& model, uint32_t lod)
+	{
+		// the levels of detail share the vertices, only the indices change
+		const bool simplified = lod > 0 && lod <= model.lods.size();
+		size_t nbIndices = simplified ? model.lods[lod - 1].indexCount : model.getIndexCount();
+		size_t nbVertices = model.getVertexCount();
 		// BLAS builder requires raw device addresses.
 		uint32_t maxPrimitiveCount = nbIndices / 3;
 
 		// Describe buffer as array of VertexObj.
 		VkAccelerationStructureGeometryTrianglesDataKHR triangles{ VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_TRIANGLES_DATA_KHR };
-		triangles.vertexFormat = VK_FORMAT_R32G32B32_SFLOAT; // vec3 vertex position data.
+		// every format starts with the position, float or snorm16
+		const bool quantized = (model.vertexFormat & eVertexPacked) && (model.vertexFormat & eVertexQuantized);
+		triangles.vertexFormat = quantized ? VK_FORMAT_R16G16B16A16_SNORM : VK_FORMAT_R32G32B32_SFLOAT;
 		triangles.vertexData.deviceAddress = model.descriptor.vertexAddress;
-		triangles.vertexStride = sizeof(Vertex);
+		triangles.vertexStride = getVertexStride(model.vertexFormat);
+		if (quantized)
+		{
+			triangles.transformData.deviceAddress = nvvk::getBufferDeviceAddress(_vkdevice, model.dequantBuffer.buffer);
+		}
 		// Describe index data (32-bit unsigned int)
 		triangles.indexType = VK_INDEX_TYPE_UINT32;
-		triangles.indexData.deviceAddress = model.descriptor.indexAddress;
+		triangles.indexData.deviceAddress = simplified ? model.lodDescriptors[lod - 1].indexAddress : model.descriptor.indexAddress;
 		// Indicate identity transform by setting transformData to null device pointer.
 		// triangles.transformData = {};
 		triangles.maxVertex = nbVertices - 1;
@@ -342,35 +453,64 @@ namespace Astra
 		}
 		else
 		{
-			int texWidth, texHeight, texChannels;
-
-			stbi_uc* stbi_pixels = stbi_load(path.c_str(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
-
-			std::array<stbi_uc, 4> color{ 255u, 0u, 255u, 255u };
+			return createTextureImage(cmdList, loadTextureData(path, _textureLoadOptions), alloc);
+		}
+	}
 
-			stbi_uc* pixels = stbi_pixels;
-			// Handle failure
-			if (!stbi_pixels)
-			{
-				texWidth = texHeight = 1;
-				texChannels = 4;
-				pixels = reinterpret_cast<stbi_uc*>(color.data());
-			}
+	nvvk::Texture Device::createTextureImage(const Astra::CommandList& cmdList, const TextureData& data, nvvk::ResourceAllocatorDma& alloc)
+	{
+		VkSamplerCreateInfo samplerCreateInfo{ VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO };
+		samplerCreateInfo.minFilter = VK_FILTER_LINEAR;
+		samplerCreateInfo.magFilter = VK_FILTER_LINEAR;
+		samplerCreateInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+		samplerCreateInfo.maxLod = FLT_MAX;
 
-			VkDeviceSize bufferSize = static_cast<uint64_t>(texWidth) * texHeight * sizeof(uint8_t) * 4;
-			auto imgSize = VkExtent2D{ (uint32_t)texWidth, (uint32_t)texHeight };
-			auto imageCreateInfo = nvvk::makeImage2DCreateInfo(imgSize, format, VK_IMAGE_USAGE_SAMPLED_BIT, true);
+		const auto& cmdBuf = cmdList.getCommandBuffer();
+		if (!data.levelOffsets.empty() || data.isCompressed())
+		{
+			return createTextureImageLevels(cmdList, data, alloc, samplerCreateInfo);
+		}
 
+		VkFormat format = VK_FORMAT_R8G8B8A8_SRGB;
+		VkDeviceSize bufferSize = static_cast<uint64_t>(data.width) * data.height * sizeof(uint8_t) * 4;
+		auto imgSize = VkExtent2D{ data.width, data.height };
+		auto imageCreateInfo = nvvk::makeImage2DCreateInfo(imgSize, format, VK_IMAGE_USAGE_SAMPLED_BIT, true);
+
+		nvvk::Image image = alloc.createImage(cmdBuf, bufferSize, data.pixels.data(), imageCreateInfo);
+		nvvk::cmdGenerateMipmaps(cmdBuf, image.image, format, imgSize, imageCreateInfo.mipLevels);
+		VkImageViewCreateInfo ivInfo = nvvk::makeImageViewCreateInfo(image.image, imageCreateInfo);
+		return alloc.createTexture(image, ivInfo, samplerCreateInfo);
+	}
 
-			nvvk::Image image = alloc.createImage(cmdBuf, bufferSize, pixels, imageCreateInfo);
-			nvvk::cmdGenerateMipmaps(cmdBuf, image.image, format, imgSize, imageCreateInfo.mipLevels);
-			VkImageViewCreateInfo ivInfo = nvvk::makeImageViewCreateInfo(image.image, imageCreateInfo);
-			nvvk::Texture texture = alloc.createTexture(image, ivInfo, samplerCreateInfo);
+	nvvk::Texture Device::createTextureImageLevels(const Astra::CommandList& cmdList, const TextureData& data, nvvk::ResourceAllocatorDma& alloc, const VkSamplerCreateInfo& samplerCreateInfo)
+	{
+		VkFormat format = VK_FORMAT_R8G8B8A8_SRGB;
+		switch (data.format)
+		{
+		case TextureFormat::BC1: format = VK_FORMAT_BC1_RGB_SRGB_BLOCK; break;
+		case TextureFormat::BC3: format = VK_FORMAT_BC3_SRGB_BLOCK; break;
+		case TextureFormat::BC5: format = VK_FORMAT_BC5_UNORM_BLOCK; break;
+		default: break;
+		}
+		assert(!data.isCompressed() || _textureLoadOptions.compressedSupported);
+		const auto& cmdBuf = cmdList.getCommandBuffer();
 
-			stbi_image_free(stbi_pixels);
+		// the levels come from the file, nothing is generated on the GPU
+		auto imageCreateInfo = nvvk::makeImage2DCreateInfo(VkExtent2D{ data.width, data.height }, format, VK_IMAGE_USAGE_SAMPLED_BIT);
+		imageCreateInfo.mipLevels = data.getLevelCount();
+		nvvk::Image image = alloc.createImage(imageCreateInfo);
 
-			return texture;
+		VkImageSubresourceRange range{ VK_IMAGE_ASPECT_COLOR_BIT, 0, imageCreateInfo.mipLevels, 0, 1 };
+		nvvk::cmdBarrierImageLayout(cmdBuf, image.image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, range);
+		for (uint32_t level = 0; level < imageCreateInfo.mipLevels; level++)
+		{
+			VkImageSubresourceLayers subresource{ VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 1 };
+			VkExtent3D extent{ data.getLevelWidth(level), data.getLevelHeight(level), 1 };
+			alloc.getStaging()->cmdToImage(cmdBuf, image.image, VkOffset3D{}, extent, subresource, data.getLevelSize(level), data.getLevelData(level));
 		}
-	}
+		nvvk::cmdBarrierImageLayout(cmdBuf, image.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, range);
 
-}
\ No newline at end of file
+		VkImageViewCreateInfo ivInfo = nvvk::makeImageViewCreateInfo(image.image, imageCreateInfo);
+		return alloc.createTexture(image, ivInfo, samplerCreateInfo);
+	}
+}
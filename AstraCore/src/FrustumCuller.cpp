@@ -0,0 +1,205 @@
+#include <FrustumCuller.h>
+#include <Mesh.h>
+#include <ThreadPool.h>
+#include <Utils.h>
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define ASTRA_CULL_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#define ASTRA_TARGET_AVX2
+#else
+#define ASTRA_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace
+{
+	// below this many instances the boxes are updated and tested on a single thread
+	constexpr size_t MinBoundsBatch = 16 * 1024;
+	constexpr size_t MinCullBatch = 32 * 1024;
+	constexpr size_t CullGroup = 8;
+
+	// a, b, c, d of ax + by + cz + d >= 0 for the points inside
+	struct FrustumPlanes
+	{
+		glm::vec4 planes[6];
+	};
+
+	// columns of the boxes, with the corner each plane tests already picked
+	struct BoxColumns
+	{
+		const float* min[3];
+		const float* max[3];
+	};
+
+	FrustumPlanes extractPlanes(const glm::mat4& viewProj)
+	{
+		// rows of the matrix, glm stores columns
+		glm::vec4 rows[4];
+		for (int r = 0; r < 4; r++)
+		{
+			rows[r] = glm::vec4(viewProj[0][r], viewProj[1][r], viewProj[2][r], viewProj[3][r]);
+		}
+		// -w <= x, y <= w and 0 <= z <= w in clip space
+		FrustumPlanes frustum;
+		frustum.planes[0] = rows[3] + rows[0];
+		frustum.planes[1] = rows[3] - rows[0];
+		frustum.planes[2] = rows[3] + rows[1];
+		frustum.planes[3] = rows[3] - rows[1];
+		frustum.planes[4] = rows[2];
+		frustum.planes[5] = rows[3] - rows[2];
+		return frustum;
+	}
+
+	// a box is outside when its corner furthest along the normal of some plane is behind it
+	void cullScalar(const FrustumPlanes& frustum, const BoxColumns& boxes, size_t begin, size_t end, uint8_t* inside)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			bool outside = false;
+			for (const glm::vec4& p : frustum.planes)
+			{
+				const float x = p.x >= 0.0f ? boxes.max[0][i] : boxes.min[0][i];
+				const float y = p.y >= 0.0f ? boxes.max[1][i] : boxes.min[1][i];
+				const float z = p.z >= 0.0f ? boxes.max[2][i] : boxes.min[2][i];
+				outside |= (p.x * x + p.y * y) + (p.z * z + p.w) < 0.0f;
+			}
+			inside[i] = !outside;
+		}
+	}
+
+#ifdef ASTRA_CULL_X86
+	// eight boxes per iteration, [begin, end) is a multiple of 8 inside the padded columns
+	ASTRA_TARGET_AVX2 void cullAvx2(const FrustumPlanes& frustum, const BoxColumns& boxes, size_t begin, size_t end, uint8_t* inside)
+	{
+		const __m256 zero = _mm256_setzero_ps();
+		for (size_t i = begin; i < end; i += CullGroup)
+		{
+			__m256 outside = zero;
+			for (const glm::vec4& p : frustum.planes)
+			{
+				const __m256 x = _mm256_loadu_ps((p.x >= 0.0f ? boxes.max[0] : boxes.min[0]) + i);
+				const __m256 y = _mm256_loadu_ps((p.y >= 0.0f ? boxes.max[1] : boxes.min[1]) + i);
+				const __m256 z = _mm256_loadu_ps((p.z >= 0.0f ? boxes.max[2] : boxes.min[2]) + i);
+				const __m256 xy = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(p.x), x), _mm256_mul_ps(_mm256_set1_ps(p.y), y));
+				const __m256 zw = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(p.z), z), _mm256_set1_ps(p.w));
+				outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(xy, zw), zero, _CMP_LT_OQ));
+			}
+			const int mask = _mm256_movemask_ps(outside);
+			for (size_t k = 0; k < CullGroup; k++)
+			{
+				inside[i + k] = !((mask >> k) & 1);
+			}
+		}
+	}
+#endif
+}
+
+Astra::FrustumCuller::FrustumCuller() : _avx2(Astra::hasAvx2())
+{
+}
+
+void Astra::FrustumCuller::updateBounds(InstanceStorage& instances, const std::vector<Mesh>& meshes)
+{
+	_count = instances.size();
+	const size_t padded = (_count + CullGroup - 1) / CullGroup * CullGroup;
+	for (std::vector<float>* column : { &_minX, &_minY, &_minZ, &_maxX, &_maxY, &_maxZ })
+	{
+		column->resize(padded, 0.0f);
+	}
+	_inside.resize(padded, 1);
+
+	const std::vector<glm::mat4>& transforms = instances.getTransforms();
+	const std::vector<uint32_t>& meshIds = instances.getMeshIndices();
+	AstraThreads.parallelFor(_count, [&](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; i++)
+			{
+				if (!instances.consumeBoundsDirty(i))
+					continue;
+
+				const MeshBounds& bounds = meshes[meshIds[i]].bounds;
+				if (!bounds.valid)
+				{
+					// the corner tested is always at infinity in front of the plane, or gives NaN, and neither is behind it
+					const float inf = std::numeric_limits<float>::infinity();
+					_minX[i] = _minY[i] = _minZ[i] = -inf;
+					_maxX[i] = _maxY[i] = _maxZ[i] = inf;
+					continue;
+				}
+
+				// the box around the transformed box: the center moves, the extents grow by the absolute value of the rotation and scale
+				const glm::mat4& m = transforms[i];
+				const glm::vec3 center = glm::vec3(m * glm::vec4((bounds.min + bounds.max) * 0.5f, 1.0f));
+				const glm::vec3 half = (bounds.max - bounds.min) * 0.5f;
+				const glm::vec3 extent = glm::abs(glm::vec3(m[0])) * half.x + glm::abs(glm::vec3(m[1])) * half.y + glm::abs(glm::vec3(m[2])) * half.z;
+				_minX[i] = center.x - extent.x;
+				_minY[i] = center.y - extent.y;
+				_minZ[i] = center.z - extent.z;
+				_maxX[i] = center.x + extent.x;
+				_maxY[i] = center.y + extent.y;
+				_maxZ[i] = center.z + extent.z;
+			}
+		}, MinBoundsBatch);
+}
+
+void Astra::FrustumCuller::cull(const glm::mat4& viewProj)
+{
+	const FrustumPlanes frustum = extractPlanes(viewProj);
+	const BoxColumns boxes{ { _minX.data(), _minY.data(), _minZ.data() }, { _maxX.data(), _maxY.data(), _maxZ.data() } };
+	const size_t groups = (_count + CullGroup - 1) / CullGroup;
+
+	// whole groups of 8 per batch, every one counts its own culled boxes
+	std::atomic<size_t> culled{ 0 };
+	AstraThreads.parallelFor(groups, [&](size_t beginGroup, size_t endGroup)
+		{
+			const size_t begin = beginGroup * CullGroup;
+			const size_t end = endGroup * CullGroup;
+#ifdef ASTRA_CULL_X86
+			if (_avx2)
+				cullAvx2(frustum, boxes, begin, end, _inside.data());
+			else
+#endif
+				cullScalar(frustum, boxes, begin, end, _inside.data());
+
+			size_t outside = 0;
+			for (size_t i = begin; i < std::min(end, _count); i++)
+			{
+				outside += !_inside[i];
+			}
+			culled += outside;
+		}, MinCullBatch / CullGroup);
+	_culledCount = culled;
+}
+
+bool Astra::FrustumCuller::isInside(size_t index) const
+{
+	// instances added after the last cull() are drawn
+	return index >= _count || _inside[index] != 0;
+}
+
+size_t Astra::FrustumCuller::getCulledCount() const
+{
+	return _culledCount;
+}
+
+size_t Astra::FrustumCuller::size() const
+{
+	return _count;
+}
+
+void Astra::FrustumCuller::clear()
+{
+	for (std::vector<float>* column : { &_minX, &_minY, &_minZ, &_maxX, &_maxY, &_maxZ })
+	{
+		column->clear();
+	}
+	_inside.clear();
+	_count = 0;
+	_culledCount = 0;
+}
@@ -0,0 +1,148 @@
+#include <GeometryBuilder.h>
+#include <Device.h>
+#include <Utils.h>
+#include <nvvk/buffers_vk.hpp>
+#include <algorithm>
+#include <cstring>
+#include <cassert>
+
+Astra::GeometryBuilder::GeometryBuilder(nvvk::ResourceAllocatorDma* alloc, size_t vertexCount, size_t triangleCount)
+	: _alloc(alloc), _vertexCount(vertexCount), _triangleCount(triangleCount)
+{
+	assert(_alloc != nullptr);
+	if (vertexCount == 0 || triangleCount == 0)
+	{
+		Astra::Log("Geometry builder created without vertices or triangles", WARNING);
+	}
+
+	// same usage as the buffers of a loaded mesh, plus the destination of the copies
+	VkBufferUsageFlags flag = VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+	VkBufferUsageFlags rayTracingFlags = flag | (AstraDevice.getRtEnabled() ? (VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT) : 0);
+	_vertexSize = std::max<size_t>(vertexCount, 1) * sizeof(Vertex);
+	_indexSize = std::max<size_t>(triangleCount, 1) * 3 * sizeof(uint32_t);
+	const VkDeviceSize matIndexSize = std::max<size_t>(triangleCount, 1) * sizeof(int32_t);
+	_vertexBuffer = _alloc->createBuffer(_vertexSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | rayTracingFlags);
+	_indexBuffer = _alloc->createBuffer(_indexSize, VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | rayTracingFlags);
+	_matIndexBuffer = _alloc->createBuffer(matIndexSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | rayTracingFlags);
+
+	// not the shared staging of the allocator: any load finalizing it would free this memory while the generator still writes into it
+	_stagingBuffer = _alloc->createBuffer(_vertexSize + _indexSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+	uint8_t* mapped = static_cast<uint8_t*>(_alloc->map(_stagingBuffer));
+	_vertices = reinterpret_cast<Vertex*>(mapped);
+	_indices = reinterpret_cast<uint32_t*>(mapped + _vertexSize);
+}
+
+Astra::GeometryBuilder::~GeometryBuilder()
+{
+	if (_finished)
+		return;
+
+	// nothing was recorded, the buffers can go straight away
+	releaseStaging();
+	_alloc->destroy(_vertexBuffer);
+	_alloc->destroy(_indexBuffer);
+	_alloc->destroy(_matIndexBuffer);
+}
+
+void Astra::GeometryBuilder::releaseStaging()
+{
+	_alloc->unmap(_stagingBuffer);
+	_alloc->destroy(_stagingBuffer);
+	_vertices = nullptr;
+	_indices = nullptr;
+}
+
+Vertex* Astra::GeometryBuilder::getVertices()
+{
+	return _vertices;
+}
+
+uint32_t* Astra::GeometryBuilder::getIndices()
+{
+	return _indices;
+}
+
+size_t Astra::GeometryBuilder::getVertexCount() const
+{
+	return _vertexCount;
+}
+
+size_t Astra::GeometryBuilder::getTriangleCount() const
+{
+	return _triangleCount;
+}
+
+void Astra::GeometryBuilder::writeVertices(size_t first, const Vertex* vertices, size_t count)
+{
+	assert(first + count <= _vertexCount);
+	// the box comes from the source, the staging memory is write-combined and slow to read
+	glm::vec3 lo(FLT_MAX), hi(-FLT_MAX);
+	for (size_t v = 0; v < count; v++)
+	{
+		lo = glm::min(lo, vertices[v].pos);
+		hi = glm::max(hi, vertices[v].pos);
+	}
+	std::memcpy(_vertices + first, vertices, count * sizeof(Vertex));
+	if (count > 0)
+		extendBounds(lo, hi);
+}
+
+void Astra::GeometryBuilder::extendBounds(const glm::vec3& min, const glm::vec3& max)
+{
+	std::lock_guard<std::mutex> lock(_boundsMutex);
+	_boundsMin = glm::min(_boundsMin, min);
+	_boundsMax = glm::max(_boundsMax, max);
+}
+
+void Astra::GeometryBuilder::setBounds(const MeshBounds& bounds)
+{
+	_bounds = bounds;
+}
+
+void Astra::GeometryBuilder::finish(Mesh& mesh, const WaveFrontMaterial& material, MaterialCache& materialCache)
+{
+	assert(!_finished);
+
+	// every triangle uses the only material, the indices go straight to its slot
+	mesh.materials = { material };
+	mesh.materialIds = materialCache.acquire(mesh.materials);
+	nvvk::CommandPool cmdPool(AstraDevice.getVkDevice(), AstraDevice.getGraphicsQueueIndex());
+	VkCommandBuffer cmdBuf = cmdPool.createCommandBuffer();
+	vkCmdFillBuffer(cmdBuf, _matIndexBuffer.buffer, 0, VK_WHOLE_SIZE, mesh.materialIds[0]);
+	const VkBufferCopy vertexCopy{ 0, 0, _vertexSize };
+	const VkBufferCopy indexCopy{ _vertexSize, 0, _indexSize };
+	vkCmdCopyBuffer(cmdBuf, _stagingBuffer.buffer, _vertexBuffer.buffer, 1, &vertexCopy);
+	vkCmdCopyBuffer(cmdBuf, _stagingBuffer.buffer, _indexBuffer.buffer, 1, &indexCopy);
+	cmdPool.submitAndWait(cmdBuf);
+	releaseStaging();
+	_finished = true;
+
+	// the sphere is centered on the box, like the one of computeBounds()
+	if (!_bounds.valid && _boundsMin.x <= _boundsMax.x)
+	{
+		_bounds.min = _boundsMin;
+		_bounds.max = _boundsMax;
+		_bounds.center = (_boundsMin + _boundsMax) * 0.5f;
+		_bounds.radius = glm::length(_boundsMax - _boundsMin) * 0.5f;
+		_bounds.valid = true;
+	}
+
+	mesh.vertexFormat = 0;
+	mesh.setDeviceOnlyData(_vertexCount, _triangleCount * 3);
+	mesh.vertexBuffer = _vertexBuffer;
+	mesh.indexBuffer = _indexBuffer;
+	mesh.matIndexBuffer = _matIndexBuffer;
+	mesh.bounds = _bounds;
+	mesh.submeshBounds = { _bounds };
+
+	mesh.descriptor = ObjDesc{};
+	mesh.descriptor.vertexFormat = 0;
+	mesh.descriptor.vertexStride = static_cast<int>(sizeof(Vertex));
+	mesh.descriptor.posScale = glm::vec3(1.0f);
+	mesh.descriptor.posOffset = glm::vec3(0.0f);
+	mesh.descriptor.vertexAddress = nvvk::getBufferDeviceAddress(AstraDevice.getVkDevice(), _vertexBuffer.buffer);
+	mesh.descriptor.indexAddress = nvvk::getBufferDeviceAddress(AstraDevice.getVkDevice(), _indexBuffer.buffer);
+	mesh.descriptor.materialIndexAddress = nvvk::getBufferDeviceAddress(AstraDevice.getVkDevice(), _matIndexBuffer.buffer);
+	mesh.descriptor.triangleIdAddress = 0;
+}
@@ -0,0 +1,573 @@
+#include <GltfLoader.h>
+#include <Device.h>
+#include <MappedFile.h>
+#include <ThreadPool.h>
+#include <Utils.h>
+// images are decoded by Astra, tinygltf only keeps their bytes
+#define TINYGLTF_IMPLEMENTATION
+#define TINYGLTF_NO_STB_IMAGE
+#define TINYGLTF_NO_STB_IMAGE_WRITE
+#define TINYGLTF_NO_EXTERNAL_IMAGE
+#include <tiny_gltf.h>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <filesystem>
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <cctype>
+
+namespace
+{
+	// below this many vertices a primitive is not split between threads
+	constexpr size_t MinVertexBatch = 4096;
+
+	// strided view of an accessor, data is null if the accessor has no buffer (all zeros)
+	struct AccessorView
+	{
+		const uint8_t* data{ nullptr };
+		size_t stride{ 0 };
+		size_t count{ 0 };
+		int componentType{ TINYGLTF_COMPONENT_TYPE_FLOAT };
+		int components{ 0 };
+		bool normalized{ false };
+	};
+
+	bool keepEncoded(tinygltf::Image* image, const int, std::string*, std::string*, int, int, const unsigned char* bytes, int size, void*)
+	{
+		// decoded later in parallel, and only if the scene does not have it yet
+		image->image.assign(bytes, bytes + size);
+		image->as_is = true;
+		return true;
+	}
+
+	bool getView(const tinygltf::Model& model, int accessorIndex, AccessorView& view, std::string& warning)
+	{
+		view = {};
+		if (accessorIndex < 0 || accessorIndex >= static_cast<int>(model.accessors.size()))
+			return false;
+
+		const tinygltf::Accessor& accessor = model.accessors[accessorIndex];
+		view.count = accessor.count;
+		view.componentType = accessor.componentType;
+		view.components = tinygltf::GetNumComponentsInType(static_cast<uint32_t>(accessor.type));
+		view.normalized = accessor.normalized;
+		if (accessor.sparse.isSparse)
+			warning += "Sparse accessor " + std::to_string(accessorIndex) + " not supported, only its base values are read\n";
+		if (accessor.bufferView < 0)
+			return true;
+
+		const tinygltf::BufferView& bufferView = model.bufferViews[accessor.bufferView];
+		const tinygltf::Buffer& buffer = model.buffers[bufferView.buffer];
+		const int stride = accessor.ByteStride(bufferView);
+		const size_t elementSize = static_cast<size_t>(tinygltf::GetComponentSizeInBytes(static_cast<uint32_t>(accessor.componentType))) * view.components;
+		const size_t offset = bufferView.byteOffset + accessor.byteOffset;
+		if (stride <= 0 || elementSize == 0 || (view.count > 0 && offset + stride * (view.count - 1) + elementSize > buffer.data.size()))
+			return false;
+
+		view.stride = static_cast<size_t>(stride);
+		view.data = buffer.data.data() + offset;
+		return true;
+	}
+
+	float readComponent(const uint8_t* p, int componentType, bool normalized)
+	{
+		switch (componentType)
+		{
+		case TINYGLTF_COMPONENT_TYPE_FLOAT:
+		{
+			float f;
+			std::memcpy(&f, p, sizeof(f));
+			return f;
+		}
+		case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+			return normalized ? *p / 255.0f : *p;
+		case TINYGLTF_COMPONENT_TYPE_BYTE:
+		{
+			const float v = static_cast<float>(static_cast<int8_t>(*p));
+			return normalized ? std::max(v / 127.0f, -1.0f) : v;
+		}
+		case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+		{
+			uint16_t v;
+			std::memcpy(&v, p, sizeof(v));
+			return normalized ? v / 65535.0f : v;
+		}
+		case TINYGLTF_COMPONENT_TYPE_SHORT:
+		{
+			int16_t v;
+			std::memcpy(&v, p, sizeof(v));
+			return normalized ? std::max(v / 32767.0f, -1.0f) : v;
+		}
+		case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:
+		{
+			uint32_t v;
+			std::memcpy(&v, p, sizeof(v));
+			return static_cast<float>(v);
+		}
+		default:
+			return 0.0f;
+		}
+	}
+
+	// reads up to n components of element i, the missing ones are left as they are
+	void readElement(const AccessorView& view, size_t i, float* out, int n)
+	{
+		if (view.data == nullptr || i >= view.count)
+			return;
+		const uint8_t* p = view.data + view.stride * i;
+		const int size = tinygltf::GetComponentSizeInBytes(static_cast<uint32_t>(view.componentType));
+		for (int c = 0; c < std::min(n, view.components); c++)
+		{
+			out[c] = readComponent(p + c * size, view.componentType, view.normalized);
+		}
+	}
+
+	uint32_t readIndex(const AccessorView& view, size_t i)
+	{
+		const uint8_t* p = view.data + view.stride * i;
+		switch (view.componentType)
+		{
+		case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+			return *p;
+		case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+		{
+			uint16_t v;
+			std::memcpy(&v, p, sizeof(v));
+			return v;
+		}
+		default:
+		{
+			uint32_t v;
+			std::memcpy(&v, p, sizeof(v));
+			return v;
+		}
+		}
+	}
+
+	bool isTriangles(const tinygltf::Primitive& primitive)
+	{
+		return primitive.mode == TINYGLTF_MODE_TRIANGLES || primitive.mode == -1;
+	}
+
+	int findAttribute(const tinygltf::Primitive& primitive, const char* name)
+	{
+		auto it = primitive.attributes.find(name);
+		return it != primitive.attributes.end() ? it->second : -1;
+	}
+
+	bool isAligned(const void* p, size_t alignment)
+	{
+		return reinterpret_cast<uintptr_t>(p) % alignment == 0;
+	}
+
+	// the attributes of the only primitive are interleaved exactly like Vertex, so the buffer view can be uploaded as it is
+	const Vertex* matchVertexLayout(const tinygltf::Model& model, const tinygltf::Primitive& primitive, size_t& count)
+	{
+		const char* names[] = { "POSITION", "NORMAL", "COLOR_0", "TEXCOORD_0" };
+		const size_t offsets[] = { offsetof(Vertex, pos), offsetof(Vertex, nrm), offsetof(Vertex, color), offsetof(Vertex, texCoord) };
+		const int types[] = { TINYGLTF_TYPE_VEC3, TINYGLTF_TYPE_VEC3, TINYGLTF_TYPE_VEC3, TINYGLTF_TYPE_VEC2 };
+
+		const uint8_t* base = nullptr;
+		for (int a = 0; a < 4; a++)
+		{
+			const int index = findAttribute(primitive, names[a]);
+			if (index < 0)
+				return nullptr;
+			const tinygltf::Accessor& accessor = model.accessors[index];
+			if (accessor.bufferView < 0 || accessor.sparse.isSparse || accessor.componentType != TINYGLTF_COMPONENT_TYPE_FLOAT || accessor.type != types[a])
+				return nullptr;
+			const tinygltf::BufferView& bufferView = model.bufferViews[accessor.bufferView];
+			if (accessor.ByteStride(bufferView) != static_cast<int>(sizeof(Vertex)))
+				return nullptr;
+
+			const tinygltf::Buffer& buffer = model.buffers[bufferView.buffer];
+			if (bufferView.byteOffset + accessor.byteOffset < offsets[a])
+				return nullptr;
+			const size_t start = bufferView.byteOffset + accessor.byteOffset - offsets[a];
+			if (start + accessor.count * sizeof(Vertex) > buffer.data.size())
+				return nullptr;
+			const uint8_t* attributeBase = buffer.data.data() + start;
+			if (a == 0)
+			{
+				base = attributeBase;
+				count = accessor.count;
+			}
+			else if (attributeBase != base || accessor.count != count)
+				return nullptr;
+		}
+		return isAligned(base, alignof(Vertex)) ? reinterpret_cast<const Vertex*>(base) : nullptr;
+	}
+
+	const uint32_t* matchIndexLayout(const tinygltf::Model& model, const tinygltf::Primitive& primitive, size_t& count)
+	{
+		AccessorView view;
+		std::string ignored;
+		if (!getView(model, primitive.indices, view, ignored) || view.data == nullptr || view.componentType != TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT ||
+			view.stride != sizeof(uint32_t) || model.accessors[primitive.indices].sparse.isSparse || !isAligned(view.data, alignof(uint32_t)))
+			return nullptr;
+		count = view.count;
+		return reinterpret_cast<const uint32_t*>(view.data);
+	}
+
+	WaveFrontMaterial toWaveFront(const tinygltf::Material& material)
+	{
+		const tinygltf::PbrMetallicRoughness& pbr = material.pbrMetallicRoughness;
+		const glm::vec3 base(pbr.baseColorFactor[0], pbr.baseColorFactor[1], pbr.baseColorFactor[2]);
+		// the shaders multiply the diffuse by the texture, and the metallic texture is not read, so a metallic
+		// factor on a textured surface would turn all of it black
+		const bool textured = pbr.baseColorTexture.index >= 0 || pbr.metallicRoughnessTexture.index >= 0;
+		const float metallic = textured ? 0.0f : std::clamp(static_cast<float>(pbr.metallicFactor), 0.0f, 1.0f);
+		const float roughness = std::clamp(static_cast<float>(pbr.roughnessFactor), 0.05f, 1.0f);
+		// glTF factors are already linear
+		WaveFrontMaterial m{};
+		m.diffuse = base * (1.0f - metallic);
+		m.specular = glm::mix(glm::vec3(0.04f), base, metallic);
+		m.emission = glm::vec3(material.emissiveFactor[0], material.emissiveFactor[1], material.emissiveFactor[2]);
+		m.dissolve = static_cast<float>(pbr.baseColorFactor[3]);
+		m.ior = 1.5f;
+		// Blinn-Phong exponent with about the same highlight as the GGX roughness
+		const float alpha = roughness * roughness;
+		m.shininess = std::min(2.0f / (alpha * alpha) - 2.0f, 1000.0f);
+		m.illum = 2;
+		m.textureId = -1;
+		return m;
+	}
+
+	WaveFrontMaterial defaultMaterial()
+	{
+		WaveFrontMaterial m{};
+		m.diffuse = glm::vec3(1.0f);
+		m.illum = 2;
+		m.textureId = -1;
+		return m;
+	}
+
+	std::string imagePath(const tinygltf::Model& model, int imageIndex, const std::string& path, const std::filesystem::path& baseDir)
+	{
+		const tinygltf::Image& image = model.images[imageIndex];
+		if (!image.image.empty() || image.uri.empty())
+			return path + "#image" + std::to_string(imageIndex);
+		std::string uri;
+		if (!tinygltf::URIDecode(image.uri, &uri, nullptr))
+			uri = image.uri;
+		return (baseDir / std::filesystem::u8path(uri)).string();
+	}
+
+	glm::mat4 localTransform(const tinygltf::Node& node)
+	{
+		if (node.matrix.size() == 16)
+		{
+			glm::mat4 m;
+			for (int i = 0; i < 16; i++)
+			{
+				m[i / 4][i % 4] = static_cast<float>(node.matrix[i]);
+			}
+			return m;
+		}
+
+		glm::mat4 m(1.0f);
+		if (node.translation.size() == 3)
+			m = glm::translate(m, glm::vec3(node.translation[0], node.translation[1], node.translation[2]));
+		if (node.rotation.size() == 4)
+			m *= glm::mat4_cast(glm::quat(static_cast<float>(node.rotation[3]), static_cast<float>(node.rotation[0]), static_cast<float>(node.rotation[1]), static_cast<float>(node.rotation[2])));
+		if (node.scale.size() == 3)
+			m = glm::scale(m, glm::vec3(node.scale[0], node.scale[1], node.scale[2]));
+		return m;
+	}
+
+	void addNodes(const tinygltf::Model& model, int nodeIndex, const glm::mat4& parent, int parentNode, std::vector<bool>& visited, Astra::GltfData& data)
+	{
+		// malformed files can have cycles
+		if (nodeIndex < 0 || nodeIndex >= static_cast<int>(model.nodes.size()) || visited[nodeIndex])
+			return;
+		visited[nodeIndex] = true;
+
+		// nodes without a mesh are folded into the transform of their children
+		const tinygltf::Node& node = model.nodes[nodeIndex];
+		glm::mat4 local = parent * localTransform(node);
+		if (node.mesh >= 0 && node.mesh < static_cast<int>(data.meshes.size()))
+		{
+			Astra::GltfNode n;
+			n.mesh = node.mesh;
+			n.parent = parentNode;
+			n.transform = local;
+			n.name = node.name;
+			parentNode = static_cast<int>(data.nodes.size());
+			data.nodes.push_back(n);
+			local = glm::mat4(1.0f);
+		}
+		for (int child : node.children)
+		{
+			addNodes(model, child, local, parentNode, visited, data);
+		}
+	}
+
+	void loadMesh(const tinygltf::Model& model, const tinygltf::Mesh& gltfMesh, const std::string& path, const std::filesystem::path& baseDir,
+		const std::shared_ptr<const void>& source, Astra::Mesh& mesh, std::string& warning)
+	{
+		mesh.name = gltfMesh.name;
+
+		// materials and textures are local to the mesh, the scene table removes the repeated ones
+		std::vector<int> localMaterial(model.materials.size(), -1);
+		int localDefault = -1;
+		std::unordered_map<std::string, int> localTexture;
+		auto getMaterial = [&](int material) -> int
+			{
+				if (material < 0 || material >= static_cast<int>(model.materials.size()))
+				{
+					if (localDefault < 0)
+					{
+						localDefault = static_cast<int>(mesh.materials.size());
+						mesh.materials.push_back(defaultMaterial());
+					}
+					return localDefault;
+				}
+				if (localMaterial[material] >= 0)
+					return localMaterial[material];
+
+				WaveFrontMaterial m = toWaveFront(model.materials[material]);
+				const int texture = model.materials[material].pbrMetallicRoughness.baseColorTexture.index;
+				if (texture >= 0 && texture < static_cast<int>(model.textures.size()))
+				{
+					const int image = model.textures[texture].source;
+					if (image >= 0 && image < static_cast<int>(model.images.size()))
+					{
+						const std::string texturePath = imagePath(model, image, path, baseDir);
+						auto [it, inserted] = localTexture.emplace(texturePath, static_cast<int>(mesh.texturePaths.size()));
+						if (inserted)
+							mesh.texturePaths.push_back(texturePath);
+						m.textureId = it->second;
+					}
+				}
+				localMaterial[material] = static_cast<int>(mesh.materials.size());
+				mesh.materials.push_back(m);
+				return localMaterial[material];
+			};
+
+		std::vector<const tinygltf::Primitive*> primitives;
+		for (const tinygltf::Primitive& primitive : gltfMesh.primitives)
+		{
+			if (!isTriangles(primitive))
+			{
+				warning += "Mesh " + gltfMesh.name + ": only triangle primitives are supported, skipping one with mode " + std::to_string(primitive.mode) + "\n";
+				continue;
+			}
+			if (findAttribute(primitive, "POSITION") < 0)
+				continue;
+			primitives.push_back(&primitive);
+		}
+
+		// the buffer can go to the GPU as it is, only the material of every triangle is generated
+		if (primitives.size() == 1)
+		{
+			size_t vertexCount = 0, indexCount = 0;
+			const Vertex* directVertices = matchVertexLayout(model, *primitives[0], vertexCount);
+			const uint32_t* directIndices = matchIndexLayout(model, *primitives[0], indexCount);
+			// the copy below clamps broken indices, the direct path must not have any
+			if (directVertices != nullptr && directIndices != nullptr &&
+				std::all_of(directIndices, directIndices + indexCount, [vertexCount](uint32_t i) { return i < vertexCount; }))
+			{
+				mesh.materialIndices.assign(indexCount / 3, getMaterial(primitives[0]->material));
+				mesh.setExternalData(source, directVertices, vertexCount, directIndices, indexCount / 3 * 3);
+				return;
+			}
+		}
+
+		size_t totalVertices = 0, totalIndices = 0;
+		for (const tinygltf::Primitive* primitive : primitives)
+		{
+			const size_t vertexCount = model.accessors[findAttribute(*primitive, "POSITION")].count;
+			totalVertices += vertexCount;
+			totalIndices += primitive->indices >= 0 ? model.accessors[primitive->indices].count : vertexCount;
+		}
+		mesh.vertices.reserve(totalVertices);
+		mesh.indices.reserve(totalIndices);
+		mesh.materialIndices.reserve(totalIndices / 3);
+
+		for (const tinygltf::Primitive* primitive : primitives)
+		{
+			// every primitive is appended, one without normals may end up with more vertices than it had
+			const size_t firstVertex = mesh.vertices.size();
+			AccessorView position, normal, color, texCoord, indices;
+			getView(model, findAttribute(*primitive, "POSITION"), position, warning);
+			const bool hasNormals = getView(model, findAttribute(*primitive, "NORMAL"), normal, warning);
+			getView(model, findAttribute(*primitive, "COLOR_0"), color, warning);
+			getView(model, findAttribute(*primitive, "TEXCOORD_0"), texCoord, warning);
+
+			mesh.vertices.resize(firstVertex + position.count);
+			Vertex* out = mesh.vertices.data() + firstVertex;
+			AstraThreads.parallelFor(position.count, [&](size_t begin, size_t end)
+				{
+					for (size_t v = begin; v < end; v++)
+					{
+						// glTF texture coordinates already start at the top left, like Vulkan
+						Vertex vertex{};
+						readElement(position, v, &vertex.pos.x, 3);
+						readElement(normal, v, &vertex.nrm.x, 3);
+						readElement(color, v, &vertex.color.x, 3);
+						readElement(texCoord, v, &vertex.texCoord.x, 2);
+						out[v] = vertex;
+					}
+				}, MinVertexBatch);
+
+			const size_t firstIndex = mesh.indices.size();
+			if (getView(model, primitive->indices, indices, warning) && indices.data != nullptr)
+			{
+				for (size_t i = 0; i < indices.count; i++)
+				{
+					const uint32_t index = readIndex(indices, i);
+					mesh.indices.push_back(static_cast<uint32_t>(firstVertex) + (index < position.count ? index : 0));
+				}
+			}
+			else
+			{
+				for (size_t i = 0; i < position.count; i++)
+				{
+					mesh.indices.push_back(static_cast<uint32_t>(firstVertex + i));
+				}
+			}
+			// incomplete triangles are dropped
+			mesh.indices.resize(firstIndex + (mesh.indices.size() - firstIndex) / 3 * 3);
+			mesh.materialIndices.insert(mesh.materialIndices.end(), (mesh.indices.size() - firstIndex) / 3, getMaterial(primitive->material));
+
+			// glTF asks for flat normals, so the shared vertices are split in one per corner with the normal of its triangle
+			if (!hasNormals)
+			{
+				std::vector<Vertex> corners(mesh.vertices.begin() + firstVertex, mesh.vertices.end());
+				std::vector<uint32_t> cornerIndices(mesh.indices.size() - firstIndex);
+				std::vector<uint32_t> positionIds(corners.size());
+				for (size_t i = 0; i < cornerIndices.size(); i++)
+					cornerIndices[i] = mesh.indices[firstIndex + i] - static_cast<uint32_t>(firstVertex);
+				for (size_t v = 0; v < positionIds.size(); v++)
+					positionIds[v] = static_cast<uint32_t>(v);
+				Astra::computeSmoothNormals(corners, cornerIndices, 0.0f, positionIds.data());
+
+				mesh.vertices.resize(firstVertex);
+				mesh.vertices.insert(mesh.vertices.end(), corners.begin(), corners.end());
+				for (size_t i = 0; i < cornerIndices.size(); i++)
+					mesh.indices[firstIndex + i] = static_cast<uint32_t>(firstVertex) + cornerIndices[i];
+			}
+		}
+
+		if (mesh.materials.empty())
+			getMaterial(-1);
+	}
+}
+
+bool Astra::isGltfFile(const std::string& path)
+{
+	std::string extension = std::filesystem::path(path).extension().string();
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+	return extension == ".gltf" || extension == ".glb";
+}
+
+bool Astra::parseGltf(const std::string& path, GltfData& data)
+{
+	data = {};
+	auto model = std::make_shared<tinygltf::Model>();
+	tinygltf::TinyGLTF loader;
+	loader.SetImageLoader(&keepEncoded, nullptr);
+
+	const std::filesystem::path baseDir = std::filesystem::path(path).parent_path();
+	std::string extension = std::filesystem::path(path).extension().string();
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+	bool ok;
+	if (extension == ".glb")
+	{
+		// the binary chunk is copied once from the mapped file into the model buffer, and from there to the staging memory
+		MappedFile file;
+		if (!file.open(path))
+		{
+			data.error = "Could not open " + path;
+			return false;
+		}
+		ok = loader.LoadBinaryFromMemory(model.get(), &data.error, &data.warning, reinterpret_cast<const unsigned char*>(file.data()),
+			static_cast<unsigned int>(file.size()), baseDir.string());
+	}
+	else
+	{
+		ok = loader.LoadASCIIFromFile(model.get(), &data.error, &data.warning, path);
+	}
+	if (!ok)
+		return false;
+	data.source = model;
+
+	data.meshes.resize(model->meshes.size());
+	for (size_t m = 0; m < model->meshes.size(); m++)
+	{
+		loadMesh(*model, model->meshes[m], path, baseDir, data.source, data.meshes[m], data.warning);
+		if (data.meshes[m].name.empty())
+			data.meshes[m].name = path + "#mesh" + std::to_string(m);
+		data.meshes[m].computeCullingData();
+	}
+
+	for (size_t i = 0; i < model->images.size(); i++)
+	{
+		const tinygltf::Image& image = model->images[i];
+		if (!image.image.empty())
+			data.embeddedImages[path + "#image" + std::to_string(i)] = { image.image.data(), image.image.size() };
+	}
+
+	// every node with a mesh becomes an instance, attached to the closest ancestor that has one too
+	std::vector<bool> visited(model->nodes.size(), false);
+	if (!model->scenes.empty())
+	{
+		const tinygltf::Scene& scene = model->scenes[model->defaultScene >= 0 && model->defaultScene < static_cast<int>(model->scenes.size()) ? model->defaultScene : 0];
+		for (int node : scene.nodes)
+		{
+			addNodes(*model, node, glm::mat4(1.0f), -1, visited, data);
+		}
+	}
+	else
+	{
+		// without scenes every root node is shown
+		std::vector<bool> isChild(model->nodes.size(), false);
+		for (const tinygltf::Node& node : model->nodes)
+		{
+			for (int child : node.children)
+			{
+				if (child >= 0 && child < static_cast<int>(isChild.size()))
+					isChild[child] = true;
+			}
+		}
+		for (size_t n = 0; n < model->nodes.size(); n++)
+		{
+			if (!isChild[n])
+				addNodes(*model, static_cast<int>(n), glm::mat4(1.0f), -1, visited, data);
+		}
+	}
+	return true;
+}
+
+void Astra::decodeGltfTextures(GltfData& data, const TextureCache* cached)
+{
+	// meshes are created one after another, so a shared image only needs to be decoded for the first one that uses it
+	std::unordered_map<std::string, bool> seen;
+	std::vector<std::pair<Mesh*, size_t>> jobs;
+	for (Mesh& mesh : data.meshes)
+	{
+		mesh.decodedTextures.clear();
+		mesh.decodedTextures.resize(mesh.texturePaths.size());
+		for (size_t i = 0; i < mesh.texturePaths.size(); i++)
+		{
+			if (seen.emplace(TextureCache::getCanonicalPath(mesh.texturePaths[i]), true).second && (cached == nullptr || !cached->contains(mesh.texturePaths[i])))
+				jobs.emplace_back(&mesh, i);
+		}
+	}
+
+	const TextureLoadOptions& options = AstraDevice.getTextureLoadOptions();
+	AstraThreads.parallelFor(jobs.size(), [&jobs, &options, &data](size_t begin, size_t end)
+		{
+			for (size_t j = begin; j < end; j++)
+			{
+				Mesh* mesh = jobs[j].first;
+				const size_t i = jobs[j].second;
+				const std::string& path = mesh->texturePaths[i];
+				auto embedded = data.embeddedImages.find(path);
+				mesh->decodedTextures[i] = embedded != data.embeddedImages.end() ?
+					loadTextureData(embedded->second.first, embedded->second.second, path, options) :
+					loadTextureData(path, options);
+			}
+		});
+}
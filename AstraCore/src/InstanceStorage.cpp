@@ -0,0 +1,442 @@
+#include <InstanceStorage.h>
+#include <ThreadPool.h>
+#include <algorithm>
+#include <cassert>
+
+namespace
+{
+	// below this many instances a level of the hierarchy is updated on a single thread
+	constexpr size_t MinTransformBatch = 16 * 1024;
+}
+
+Astra::InstanceStorage::InstanceStorage()
+{
+	// slot 0 is the empty name
+	_names.emplace_back();
+}
+
+uint32_t Astra::InstanceStorage::internName(const std::string& name)
+{
+	if (name.empty())
+		return 0;
+	auto [it, inserted] = _nameLookup.emplace(name, static_cast<uint32_t>(_names.size()));
+	if (inserted)
+		_names.push_back(name);
+	return it->second;
+}
+
+size_t Astra::InstanceStorage::add(uint32_t mesh, const glm::mat4& transform, const std::string& name, uint32_t parent)
+{
+	const size_t index = _transforms.size();
+	if (parent >= index)
+		parent = NoParent;
+	_locals.push_back(transform);
+	// if the parent is stale it will move, and its children with it, in the next updateTransforms()
+	_transforms.push_back(parent == NoParent ? transform : _transforms[parent] * transform);
+	_parents.push_back(parent == NoParent ? InstanceHandle{} : _handles.getHandle(parent));
+	_handles.push();
+	_meshes.push_back(mesh);
+	_lods.push_back(0);
+	_flags.push_back(eInstanceVisible | eInstanceDirty | eInstanceBoundsDirty | eInstanceGpuDirty);
+	_pendingGpu = true;
+	_nameIds.push_back(internName(name));
+	if (parent != NoParent)
+		_parentCount++;
+	_orderDirty = true;
+	_meshVersion++;
+	return index;
+}
+
+size_t Astra::InstanceStorage::add(uint32_t mesh, const glm::mat4* transforms, size_t count)
+{
+	// every column grows once
+	const size_t first = _transforms.size();
+	_locals.insert(_locals.end(), transforms, transforms + count);
+	_transforms.insert(_transforms.end(), transforms, transforms + count);
+	_parents.resize(first + count);
+	_meshes.resize(first + count, mesh);
+	_lods.resize(first + count, 0);
+	_flags.resize(first + count, eInstanceVisible | eInstanceDirty | eInstanceBoundsDirty | eInstanceGpuDirty);
+	_pendingGpu = true;
+	_nameIds.resize(first + count, 0);
+	_handles.reserve(first + count);
+	for (size_t i = 0; i < count; i++)
+	{
+		_handles.push();
+	}
+	_orderDirty = true;
+	_meshVersion++;
+	return first;
+}
+
+void Astra::InstanceStorage::remove(size_t index)
+{
+	assert(index < size());
+	// children find out their parent is gone when the order is rebuilt, parents are handles so moving the last one changes nothing for its own
+	const size_t last = size() - 1;
+	if (!_parents[index].isNull())
+		_parentCount--;
+	_handles.removeAt(static_cast<uint32_t>(index));
+	if (index != last)
+	{
+		_locals[index] = _locals[last];
+		_transforms[index] = _transforms[last];
+		_parents[index] = _parents[last];
+		_meshes[index] = _meshes[last];
+		_lods[index] = _lods[last];
+		// the slot holds a different instance now
+		_flags[index] = _flags[last] | eInstanceDirty | eInstanceBoundsDirty | eInstanceGpuDirty;
+		_pendingGpu = true;
+		_nameIds[index] = _nameIds[last];
+	}
+	_locals.pop_back();
+	_transforms.pop_back();
+	_parents.pop_back();
+	_meshes.pop_back();
+	_lods.pop_back();
+	_flags.pop_back();
+	_nameIds.pop_back();
+	_orderDirty = true;
+	_meshVersion++;
+}
+
+bool Astra::InstanceStorage::remove(InstanceHandle handle)
+{
+	const uint32_t index = _handles.find(handle);
+	if (index == InvalidIndex)
+		return false;
+	remove(index);
+	return true;
+}
+
+void Astra::InstanceStorage::clear()
+{
+	_locals.clear();
+	_transforms.clear();
+	_parents.clear();
+	_meshes.clear();
+	_lods.clear();
+	_flags.clear();
+	_nameIds.clear();
+	_names.resize(1);
+	_nameLookup.clear();
+	_handles.clear();
+	_parentIndices.clear();
+	_order.clear();
+	_levelOffsets.clear();
+	_orderDirty = false;
+	_parentCount = 0;
+	_pendingTransforms = false;
+	_pendingGpu = false;
+	_meshVersion++;
+}
+
+void Astra::InstanceStorage::reserve(size_t count)
+{
+	_locals.reserve(count);
+	_transforms.reserve(count);
+	_parents.reserve(count);
+	_meshes.reserve(count);
+	_lods.reserve(count);
+	_flags.reserve(count);
+	_nameIds.reserve(count);
+	_handles.reserve(count);
+}
+
+size_t Astra::InstanceStorage::size() const
+{
+	return _transforms.size();
+}
+
+bool Astra::InstanceStorage::empty() const
+{
+	return _transforms.empty();
+}
+
+Astra::InstanceHandle Astra::InstanceStorage::getHandle(size_t index) const
+{
+	return _handles.getHandle(static_cast<uint32_t>(index));
+}
+
+uint32_t Astra::InstanceStorage::find(InstanceHandle handle) const
+{
+	return _handles.find(handle);
+}
+
+void Astra::InstanceStorage::replaceMesh(uint32_t from, uint32_t to)
+{
+	for (size_t i = 0; i < _meshes.size(); i++)
+	{
+		if (_meshes[i] == from)
+		{
+			_meshes[i] = to;
+			_flags[i] |= eInstanceBoundsDirty | eInstanceGpuDirty;
+			_pendingGpu = true;
+			_meshVersion++;
+		}
+	}
+}
+
+const glm::mat4& Astra::InstanceStorage::getTransform(size_t index) const
+{
+	return _transforms[index];
+}
+
+const glm::mat4& Astra::InstanceStorage::getLocalTransform(size_t index) const
+{
+	return _locals[index];
+}
+
+void Astra::InstanceStorage::setLocalTransform(size_t index, const glm::mat4& transform)
+{
+	_locals[index] = transform;
+	_flags[index] |= eInstanceLocalDirty;
+	_pendingTransforms = true;
+}
+
+uint32_t Astra::InstanceStorage::getParent(size_t index) const
+{
+	return _parents[index].isNull() ? NoParent : _handles.find(_parents[index]);
+}
+
+bool Astra::InstanceStorage::setParent(size_t index, uint32_t parent, bool keepWorld)
+{
+	if (parent != NoParent)
+	{
+		if (parent >= size())
+			return false;
+		// an instance can not hang from its own subtree
+		for (uint32_t p = parent; p != NoParent; p = getParent(p))
+		{
+			if (p == index)
+				return false;
+		}
+	}
+	const InstanceHandle handle = parent == NoParent ? InstanceHandle{} : _handles.getHandle(parent);
+	if (_parents[index] == handle)
+		return true;
+
+	if (!_parents[index].isNull())
+		_parentCount--;
+	if (parent != NoParent)
+		_parentCount++;
+	_parents[index] = handle;
+	if (keepWorld)
+		_locals[index] = parent == NoParent ? _transforms[index] : glm::inverse(_transforms[parent]) * _transforms[index];
+	_flags[index] |= eInstanceLocalDirty;
+	_pendingTransforms = true;
+	_orderDirty = true;
+	return true;
+}
+
+void Astra::InstanceStorage::rebuildOrder()
+{
+	const size_t count = size();
+	_parentIndices.resize(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		if (_parents[i].isNull())
+		{
+			_parentIndices[i] = NoParent;
+			continue;
+		}
+		_parentIndices[i] = _handles.find(_parents[i]);
+		if (_parentIndices[i] == InvalidIndex)
+		{
+			// the parent was removed, it stays where it was unless it was given a new local transform already
+			if (!(_flags[i] & eInstanceLocalDirty))
+				_locals[i] = _transforms[i];
+			_parents[i] = {};
+			_parentCount--;
+		}
+	}
+
+	// depth of every instance, each chain is only walked until an instance with a known depth
+	std::vector<uint32_t> depths(count, UINT32_MAX);
+	std::vector<uint32_t> chain;
+	uint32_t maxDepth = 0;
+	for (size_t i = 0; i < count; i++)
+	{
+		uint32_t n = static_cast<uint32_t>(i);
+		while (n != NoParent && depths[n] == UINT32_MAX)
+		{
+			chain.push_back(n);
+			n = _parentIndices[n];
+		}
+		uint32_t depth = n == NoParent ? 0 : depths[n] + 1;
+		while (!chain.empty())
+		{
+			depths[chain.back()] = depth++;
+			chain.pop_back();
+		}
+		maxDepth = std::max(maxDepth, depths[i]);
+	}
+
+	// counting sort by depth, parents are always in an earlier level than their children
+	_levelOffsets.assign(maxDepth + 2, 0);
+	for (uint32_t depth : depths)
+	{
+		_levelOffsets[depth + 1]++;
+	}
+	for (size_t l = 1; l < _levelOffsets.size(); l++)
+	{
+		_levelOffsets[l] += _levelOffsets[l - 1];
+	}
+	_order.resize(count);
+	std::vector<size_t> cursor(_levelOffsets.begin(), _levelOffsets.end() - 1);
+	for (size_t i = 0; i < count; i++)
+	{
+		_order[cursor[depths[i]]++] = static_cast<uint32_t>(i);
+	}
+	_orderDirty = false;
+}
+
+void Astra::InstanceStorage::updateTransforms()
+{
+	// nothing moved, static scenes do not touch any matrix
+	if (!_pendingTransforms)
+		return;
+	_pendingTransforms = false;
+	_pendingGpu = true;
+
+	if (_parentCount == 0)
+	{
+		// every instance is a root, its world transform is the local one
+		AstraThreads.parallelFor(size(), [this](size_t begin, size_t end)
+			{
+				for (size_t i = begin; i < end; i++)
+				{
+					if (_flags[i] & eInstanceLocalDirty)
+					{
+						_transforms[i] = _locals[i];
+						_flags[i] = static_cast<uint8_t>((_flags[i] & ~eInstanceLocalDirty) | eInstanceDirty | eInstanceBoundsDirty | eInstanceGpuDirty);
+					}
+				}
+			}, MinTransformBatch);
+		return;
+	}
+
+	if (_orderDirty)
+		rebuildOrder();
+
+	// a level only reads the previous one, so its instances can be split between threads
+	for (size_t l = 0; l + 1 < _levelOffsets.size(); l++)
+	{
+		const size_t first = _levelOffsets[l];
+		AstraThreads.parallelFor(_levelOffsets[l + 1] - first, [this, first](size_t begin, size_t end)
+			{
+				for (size_t k = first + begin; k < first + end; k++)
+				{
+					const uint32_t i = _order[k];
+					const uint32_t parent = _parentIndices[i];
+					const bool moved = (_flags[i] & eInstanceLocalDirty) || (parent != NoParent && (_flags[parent] & eInstanceMoved));
+					if (!moved)
+					{
+						_flags[i] &= ~eInstanceMoved;
+						continue;
+					}
+					_transforms[i] = parent == NoParent ? _locals[i] : _transforms[parent] * _locals[i];
+					_flags[i] = static_cast<uint8_t>((_flags[i] & ~eInstanceLocalDirty) | eInstanceDirty | eInstanceBoundsDirty | eInstanceGpuDirty | eInstanceMoved);
+				}
+			}, MinTransformBatch);
+	}
+}
+
+uint32_t Astra::InstanceStorage::getMeshIndex(size_t index) const
+{
+	return _meshes[index];
+}
+
+uint32_t Astra::InstanceStorage::getLod(size_t index) const
+{
+	return _lods[index];
+}
+
+void Astra::InstanceStorage::setLod(size_t index, uint32_t lod)
+{
+	_lods[index] = lod;
+}
+
+bool Astra::InstanceStorage::getVisible(size_t index) const
+{
+	return (_flags[index] & eInstanceVisible) != 0;
+}
+
+void Astra::InstanceStorage::setVisible(size_t index, bool visible)
+{
+	if (visible == getVisible(index))
+		return;
+	_flags[index] = static_cast<uint8_t>((visible ? _flags[index] | eInstanceVisible : _flags[index] & ~eInstanceVisible) | eInstanceDirty | eInstanceGpuDirty);
+	_pendingGpu = true;
+}
+
+const std::string& Astra::InstanceStorage::getName(size_t index) const
+{
+	return _names[_nameIds[index]];
+}
+
+void Astra::InstanceStorage::setName(size_t index, const std::string& name)
+{
+	_nameIds[index] = internName(name);
+}
+
+bool Astra::InstanceStorage::isDirty(size_t index) const
+{
+	return (_flags[index] & eInstanceDirty) != 0;
+}
+
+void Astra::InstanceStorage::clearDirty()
+{
+	for (uint8_t& flags : _flags)
+	{
+		flags &= ~eInstanceDirty;
+	}
+}
+
+bool Astra::InstanceStorage::consumeBoundsDirty(size_t index)
+{
+	if (!(_flags[index] & eInstanceBoundsDirty))
+		return false;
+	_flags[index] &= ~eInstanceBoundsDirty;
+	return true;
+}
+
+bool Astra::InstanceStorage::consumeGpuDirty(size_t index)
+{
+	if (!(_flags[index] & eInstanceGpuDirty))
+		return false;
+	_flags[index] &= ~eInstanceGpuDirty;
+	return true;
+}
+
+bool Astra::InstanceStorage::consumeGpuPending()
+{
+	const bool pending = _pendingGpu;
+	_pendingGpu = false;
+	return pending;
+}
+
+uint64_t Astra::InstanceStorage::getMeshVersion() const
+{
+	return _meshVersion;
+}
+
+const std::vector<glm::mat4>& Astra::InstanceStorage::getTransforms() const
+{
+	return _transforms;
+}
+
+const std::vector<uint32_t>& Astra::InstanceStorage::getMeshIndices() const
+{
+	return _meshes;
+}
+
+const std::vector<uint32_t>& Astra::InstanceStorage::getLods() const
+{
+	return _lods;
+}
+
+const std::vector<uint8_t>& Astra::InstanceStorage::getFlags() const
+{
+	return _flags;
+}
@@ -0,0 +1,149 @@
+#include <MappedFile.h>
+#include <utility>
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+Astra::MappedFile::MappedFile(const std::string& path)
+{
+	open(path);
+}
+
+Astra::MappedFile::~MappedFile()
+{
+	close();
+}
+
+Astra::MappedFile::MappedFile(MappedFile&& other) noexcept
+{
+	*this = std::move(other);
+}
+
+Astra::MappedFile& Astra::MappedFile::operator=(MappedFile&& other) noexcept
+{
+	if (this != &other)
+	{
+		close();
+		std::swap(_data, other._data);
+		std::swap(_size, other._size);
+		std::swap(_open, other._open);
+#ifdef _WIN32
+		std::swap(_file, other._file);
+		std::swap(_mapping, other._mapping);
+#else
+		std::swap(_fd, other._fd);
+#endif
+	}
+	return *this;
+}
+
+#ifdef _WIN32
+
+bool Astra::MappedFile::open(const std::string& path)
+{
+	close();
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size))
+	{
+		CloseHandle(file);
+		return false;
+	}
+	_file = file;
+	_size = static_cast<size_t>(size.QuadPart);
+	_open = true;
+
+	// empty files cant be mapped, but they are still valid files
+	if (_size == 0)
+		return true;
+
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping == nullptr)
+	{
+		close();
+		return false;
+	}
+	_mapping = mapping;
+	_data = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+	if (_data == nullptr)
+	{
+		close();
+		return false;
+	}
+	return true;
+}
+
+void Astra::MappedFile::close()
+{
+	if (_data)
+		UnmapViewOfFile(_data);
+	if (_mapping)
+		CloseHandle(_mapping);
+	if (_file)
+		CloseHandle(_file);
+	_data = nullptr;
+	_mapping = nullptr;
+	_file = nullptr;
+	_size = 0;
+	_open = false;
+}
+
+#else
+
+bool Astra::MappedFile::open(const std::string& path)
+{
+	close();
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0)
+	{
+		::close(fd);
+		return false;
+	}
+	_fd = fd;
+	_size = static_cast<size_t>(st.st_size);
+	_open = true;
+
+	// empty files cant be mapped, but they are still valid files
+	if (_size == 0)
+		return true;
+
+	void* data = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (data == MAP_FAILED)
+	{
+		close();
+		return false;
+	}
+	// we read the files front to back
+	madvise(data, _size, MADV_SEQUENTIAL);
+	_data = static_cast<const char*>(data);
+	return true;
+}
+
+void Astra::MappedFile::close()
+{
+	if (_data)
+		munmap(const_cast<char*>(_data), _size);
+	if (_fd >= 0)
+		::close(_fd);
+	_data = nullptr;
+	_fd = -1;
+	_size = 0;
+	_open = false;
+}
+
+#endif
@@ -0,0 +1,198 @@
+#include <MaterialCache.h>
+#include <Device.h>
+#include <Utils.h>
+#include <algorithm>
+#include <cstring>
+#include <cassert>
+
+namespace
+{
+	// materials the buffer has room for when it is first created
+	constexpr size_t MinMaterialCapacity = 64;
+
+	// 0 is kept for the freed slots
+	uint64_t hashMaterial(const WaveFrontMaterial& material)
+	{
+		const uint64_t hash = Astra::hashBytes(&material, sizeof(material));
+		return hash == 0 ? 1 : hash;
+	}
+}
+
+void Astra::MaterialCache::init(nvvk::ResourceAllocatorDma* alloc)
+{
+	_alloc = alloc;
+}
+
+void Astra::MaterialCache::destroy()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	if (_buffer.buffer != VK_NULL_HANDLE)
+		_alloc->destroy(_buffer);
+	_capacity = 0;
+	_materials.clear();
+	_refCounts.clear();
+	_slotHashes.clear();
+	_freeSlots.clear();
+	_hashSlots.clear();
+	_dirtyBegin = 0;
+	_dirtyEnd = 0;
+}
+
+void Astra::MaterialCache::createDefault()
+{
+	// same as the one of the models without materials
+	WaveFrontMaterial material{};
+	material.diffuse = glm::vec3(1, 0, 0);
+	material.illum = 2;
+	material.textureId = -1;
+	_materials.push_back(material);
+	_refCounts.push_back(1);
+	_slotHashes.push_back(0);
+	markDirty(0);
+}
+
+void Astra::MaterialCache::markDirty(size_t slot)
+{
+	if (_dirtyBegin == _dirtyEnd)
+	{
+		_dirtyBegin = slot;
+		_dirtyEnd = slot + 1;
+		return;
+	}
+	_dirtyBegin = std::min(_dirtyBegin, slot);
+	_dirtyEnd = std::max(_dirtyEnd, slot + 1);
+}
+
+uint32_t Astra::MaterialCache::addSlot(const WaveFrontMaterial& material, uint64_t hash)
+{
+	uint32_t slot;
+	if (!_freeSlots.empty())
+	{
+		slot = _freeSlots.back();
+		_freeSlots.pop_back();
+		_materials[slot] = material;
+		_refCounts[slot] = 0;
+		_slotHashes[slot] = hash;
+	}
+	else
+	{
+		slot = static_cast<uint32_t>(_materials.size());
+		_materials.push_back(material);
+		_refCounts.push_back(0);
+		_slotHashes.push_back(hash);
+	}
+
+	if (hash != 0)
+		_hashSlots[hash] = slot;
+	markDirty(slot);
+	return slot;
+}
+
+std::vector<uint32_t> Astra::MaterialCache::acquire(const std::vector<WaveFrontMaterial>& materials)
+{
+	std::vector<uint64_t> hashes(materials.size());
+	for (size_t i = 0; i < materials.size(); i++)
+	{
+		hashes[i] = hashMaterial(materials[i]);
+	}
+
+	std::lock_guard<std::mutex> lock(_mutex);
+	if (_materials.empty())
+		createDefault();
+
+	size_t added = 0;
+	std::vector<uint32_t> slots(materials.size(), 0);
+	for (size_t i = 0; i < materials.size(); i++)
+	{
+		auto it = _hashSlots.find(hashes[i]);
+		// a collision only costs a duplicate, the first one keeps the hash
+		if (it != _hashSlots.end() && std::memcmp(&_materials[it->second], &materials[i], sizeof(WaveFrontMaterial)) == 0)
+		{
+			slots[i] = it->second;
+		}
+		else
+		{
+			slots[i] = it != _hashSlots.end() ? addSlot(materials[i], 0) : addSlot(materials[i], hashes[i]);
+			added++;
+		}
+		_refCounts[slots[i]]++;
+	}
+
+	if (!materials.empty())
+	{
+		Astra::Log("Material cache: " + std::to_string(added) + " of " + std::to_string(materials.size()) + " materials added, " +
+			std::to_string(getUniqueCount()) + " unique in the scene");
+	}
+	return slots;
+}
+
+void Astra::MaterialCache::release(const std::vector<uint32_t>& slots)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	for (uint32_t slot : slots)
+	{
+		// the default lives as long as the cache
+		if (slot == 0 || slot >= _refCounts.size() || _refCounts[slot] == 0)
+			continue;
+		if (--_refCounts[slot] > 0)
+			continue;
+
+		auto it = _hashSlots.find(_slotHashes[slot]);
+		if (it != _hashSlots.end() && it->second == slot)
+			_hashSlots.erase(it);
+		// nothing points here anymore, the slot is uploaded again once it is reused
+		_materials[slot] = _materials[0];
+		_slotHashes[slot] = 0;
+		_freeSlots.push_back(slot);
+	}
+}
+
+bool Astra::MaterialCache::reserveBuffer()
+{
+	assert(_alloc != nullptr);
+	std::lock_guard<std::mutex> lock(_mutex);
+	if (_materials.empty())
+		createDefault();
+	if (_materials.size() <= _capacity)
+		return false;
+
+	// doubling, so adding N materials only creates it log(N) times
+	_capacity = std::max(_materials.size(), std::max(_capacity * 2, MinMaterialCapacity));
+	if (_buffer.buffer != VK_NULL_HANDLE)
+	{
+		// frames in flight may still be reading the old one, it goes once they finish
+		nvvk::ResourceAllocatorDma* alloc = _alloc;
+		AstraDevice.retire([alloc, old = _buffer]() mutable { alloc->destroy(old); });
+	}
+	_buffer = _alloc->createBuffer(_capacity * sizeof(WaveFrontMaterial), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+	// the new buffer is empty
+	_dirtyBegin = 0;
+	_dirtyEnd = _materials.size();
+	return true;
+}
+
+std::vector<WaveFrontMaterial> Astra::MaterialCache::consumeUpload(size_t& first)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	// slots past the capacity wait until reserveBuffer() makes room for them
+	const size_t end = std::min(_dirtyEnd, _capacity);
+	if (_buffer.buffer == VK_NULL_HANDLE || _dirtyBegin >= end)
+		return {};
+
+	first = _dirtyBegin;
+	std::vector<WaveFrontMaterial> materials(_materials.begin() + first, _materials.begin() + end);
+	if (end == _dirtyEnd)
+		_dirtyEnd = 0;
+	_dirtyBegin = _dirtyEnd == 0 ? 0 : end;
+	return materials;
+}
+
+const nvvk::Buffer& Astra::MaterialCache::getBuffer() const
+{
+	return _buffer;
+}
+
+size_t Astra::MaterialCache::getUniqueCount() const
+{
+	return _materials.size() - _freeSlots.size();
+}
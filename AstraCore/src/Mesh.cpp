@@ -4,7 +4,21 @@
 #define TINYOBJLOADER_IMPLEMENTATION
 #include <tiny_obj_loader.h>
 #include <Utils.h>
+#include <ObjParser.h>
+#include <MeshProcessing.h>
+#include <MeshCache.h>
+#include <VertexPacking.h>
+#include <ThreadPool.h>
+#include <cstring>
+#include <cstdio>
 #include <filesystem>
+#include <unordered_set>
+
+namespace
+{
+	// below this many triangles the material indices are not split between threads
+	constexpr size_t MinRemapBatch = 64 * 1024;
+}
 
 Astra::MeshInstance::MeshInstance(uint32_t mesh, const glm::mat4& transform, const std::string& name) : Node3D(transform, name), _mesh(mesh)
 {
@@ -16,10 +30,7 @@ Astra::MeshInstance::MeshInstance(uint32_t mesh, const glm::mat4& transform, con
 
 Astra::MeshInstance& Astra::MeshInstance::operator=(const MeshInstance& other)
 {
-	_transform = other._transform;
-	_children = other._children;
-	_name = other._name;
-	_id = other._id;
+	Node3D::operator=(other);
 	_mesh = other._mesh;
 	return *this;
 }
@@ -55,7 +66,7 @@ void Astra::MeshInstance::destroy()
 
 void Astra::MeshInstance::updatePushConstantRaster(PushConstantRaster& pc) const
 {
-	pc.modelMatrix = _transform;
+	pc.modelMatrix = getTransform();
 	pc.objIndex = _mesh;
 }
 
@@ -64,31 +75,90 @@ void Astra::MeshInstance::updatePushConstantRT(PushConstantRay& pc) const
 	// nothing to do
 }
 
-void Astra::Mesh::draw(const CommandList& cmdList) const
+void Astra::Mesh::draw(const CommandList& cmdList, uint32_t lod) const
 {
-	cmdList.drawIndexed(vertexBuffer.buffer, indexBuffer.buffer, indices.size());
+	if (lod == 0 || lod > lods.size())
+	{
+		cmdList.drawIndexed(vertexBuffer.buffer, indexBuffer.buffer, getIndexCount());
+		return;
+	}
+	const MeshLod& level = lods[lod - 1];
+	cmdList.drawIndexed(vertexBuffer.buffer, lodIndexBuffer.buffer, level.indexCount, level.firstIndex);
 }
 
-void Astra::Mesh::create(const Astra::CommandList& cmdList, nvvk::ResourceAllocatorDma* alloc, uint32_t txtOffset)
+void Astra::Mesh::create(const Astra::CommandList& cmdList, nvvk::ResourceAllocatorDma* alloc, TextureCache& textureCache, MaterialCache& materialCache)
 {
 	assert(meshId != -1);
+
+	// shared textures are only uploaded once per scene, textures decoded beforehand
+	// with decodeTextures() are used for the ones the cache does not have yet
+	textureIds = textureCache.acquire(cmdList, texturePaths, decodedTextures);
+	decodedTextures.clear();
+	for (auto& m : materials)
+	{
+		if (m.textureId >= 0 && m.textureId < static_cast<int>(textureIds.size()))
+			m.textureId = static_cast<int>(textureIds[m.textureId]);
+	}
+	// with the textures resolved, materials repeated in other models end up in the same slot
+	materialIds = materialCache.acquire(materials);
+
 	createBuffers(cmdList, alloc);
-	descriptor.txtOffset = txtOffset;
+	// materials already hold the table slot
+	descriptor.txtOffset = 0;
 	descriptor.vertexAddress = nvvk::getBufferDeviceAddress(AstraDevice.getVkDevice(), vertexBuffer.buffer);
 	descriptor.indexAddress = nvvk::getBufferDeviceAddress(AstraDevice.getVkDevice(), indexBuffer.buffer);
-	descriptor.materialAddress = nvvk::getBufferDeviceAddress(AstraDevice.getVkDevice(), matColorBuffer.buffer);
 	descriptor.materialIndexAddress = nvvk::getBufferDeviceAddress(AstraDevice.getVkDevice(), matIndexBuffer.buffer);
-	
-	//TODO / FIXME
-	// Maybe, texture creation should be done in loading from file?
-	// We are creating the buffers in this function but also loading and creating
-	// the textures
-	for (auto path : texturePaths) {
-		textures.push_back(AstraDevice.createTextureImage(cmdList, path, *alloc));
+	descriptor.triangleIdAddress = 0;
+
+	// the levels only change the indices and where the material of every triangle comes from
+	lodDescriptors.clear();
+	if (!lods.empty())
+	{
+		const VkDeviceAddress lodIndexAddress = nvvk::getBufferDeviceAddress(AstraDevice.getVkDevice(), lodIndexBuffer.buffer);
+		const VkDeviceAddress lodTriangleAddress = nvvk::getBufferDeviceAddress(AstraDevice.getVkDevice(), lodTriangleBuffer.buffer);
+		for (const MeshLod& lod : lods)
+		{
+			ObjDesc desc = descriptor;
+			desc.indexAddress = lodIndexAddress + lod.firstIndex * sizeof(uint32_t);
+			desc.triangleIdAddress = lodTriangleAddress + lod.firstIndex / 3 * sizeof(uint32_t);
+			lodDescriptors.push_back(desc);
+		}
 	}
-	if (texturePaths.empty()) {
-		textures.push_back(AstraDevice.createTextureImage(cmdList, "", *alloc, true));
+}
+
+void Astra::Mesh::decodeTextures(const TextureCache* cached)
+{
+	decodeTextures({ this }, cached);
+}
+
+void Astra::Mesh::decodeTextures(const std::vector<Mesh*>& meshes, const TextureCache* cached)
+{
+	// every texture of every mesh is a job, so a mesh with many textures does not hold back the rest.
+	// Meshes are created in order, so a texture shared across the batch is only decoded for the first one that uses it,
+	// the rest find it in the TextureCache
+	std::unordered_set<std::string> seen;
+	std::vector<std::pair<Mesh*, size_t>> jobs;
+	for (Mesh* mesh : meshes)
+	{
+		mesh->decodedTextures.clear();
+		mesh->decodedTextures.resize(mesh->texturePaths.size());
+		for (size_t i = 0; i < mesh->texturePaths.size(); i++)
+		{
+			if (seen.insert(TextureCache::getCanonicalPath(mesh->texturePaths[i])).second && (cached == nullptr || !cached->contains(mesh->texturePaths[i])))
+				jobs.emplace_back(mesh, i);
+		}
 	}
+
+	const TextureLoadOptions& options = AstraDevice.getTextureLoadOptions();
+	AstraThreads.parallelFor(jobs.size(), [&jobs, &options](size_t begin, size_t end)
+		{
+			for (size_t j = begin; j < end; j++)
+			{
+				Mesh* mesh = jobs[j].first;
+				const size_t i = jobs[j].second;
+				mesh->decodedTextures[i] = loadTextureData(mesh->texturePaths[i], options);
+			}
+		});
 }
 
 void Astra::Mesh::createBuffers(const Astra::CommandList& cmdList, nvvk::ResourceAllocatorDma* alloc)
@@ -96,20 +166,75 @@ void Astra::Mesh::createBuffers(const Astra::CommandList& cmdList, nvvk::Resourc
 	const auto& cmdBuf = cmdList.getCommandBuffer();
 	VkBufferUsageFlags flag = VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
 	VkBufferUsageFlags rayTracingFlags = flag | (AstraDevice.getRtEnabled() ? (VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT) : 0);
-	vertexBuffer = alloc->createBuffer(cmdBuf, vertices, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | rayTracingFlags);
-	indexBuffer = alloc->createBuffer(cmdBuf, indices, VK_BUFFER_USAGE_INDEX_BUFFER_BIT | rayTracingFlags);
-	matColorBuffer = alloc->createBuffer(cmdBuf, materials, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | rayTracingFlags);
-	matIndexBuffer = alloc->createBuffer(cmdBuf, materialIndices, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | rayTracingFlags);
+	// the data may live in a mapped cache file, it goes from there to the staging buffer
+	descriptor.vertexFormat = static_cast<int>(vertexFormat);
+	descriptor.vertexStride = static_cast<int>(getVertexStride(vertexFormat));
+	descriptor.posScale = glm::vec3(1.0f);
+	descriptor.posOffset = glm::vec3(0.0f);
+	if (vertexFormat & eVertexPacked)
+	{
+		const std::vector<uint32_t> packed = packVertices(getVertexData(), getVertexCount(), vertexFormat, descriptor.posScale, descriptor.posOffset);
+		vertexBuffer = alloc->createBuffer(cmdBuf, packed, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | rayTracingFlags);
+		if ((vertexFormat & eVertexQuantized) && AstraDevice.getRtEnabled())
+		{
+			// the BLAS is built from the snorm positions, this puts them back in object space
+			VkTransformMatrixKHR dequant{};
+			for (int r = 0; r < 3; r++)
+			{
+				dequant.matrix[r][r] = descriptor.posScale[r];
+				dequant.matrix[r][3] = descriptor.posOffset[r];
+			}
+			dequantBuffer = alloc->createBuffer(cmdBuf, sizeof(dequant), &dequant, flag | VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR);
+		}
+	}
+	else
+	{
+		vertexBuffer = alloc->createBuffer(cmdBuf, getVertexCount() * sizeof(Vertex), getVertexData(), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | rayTracingFlags);
+	}
+	indexBuffer = alloc->createBuffer(cmdBuf, getIndexCount() * sizeof(uint32_t), getIndexData(), VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | rayTracingFlags);
+	// the shaders index the scene material table straight away
+	const int32_t* materialIndexData = getMaterialIndexData();
+	std::vector<int32_t> materialSlots(getMaterialIndexCount());
+	AstraThreads.parallelFor(materialSlots.size(), [&](size_t begin, size_t end)
+		{
+			for (size_t t = begin; t < end; t++)
+			{
+				const int32_t mi = materialIndexData[t];
+				materialSlots[t] = static_cast<int32_t>(mi >= 0 && mi < static_cast<int32_t>(materialIds.size()) ? materialIds[mi] : 0);
+			}
+		}, MinRemapBatch);
+	matIndexBuffer = alloc->createBuffer(cmdBuf, materialSlots, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | rayTracingFlags);
+
+	// loaded models bring them from the worker or the cache, the rest are computed here
+	if (!bounds.valid)
+		computeCullingData();
+	meshletCount = static_cast<uint32_t>(meshlets.size());
+	if (!meshlets.empty())
+		meshletBuffer = alloc->createBuffer(cmdBuf, meshlets, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | flag);
+
+	if (!lods.empty())
+	{
+		lodIndexBuffer = alloc->createBuffer(cmdBuf, getLodIndexCount() * sizeof(uint32_t), getLodIndexData(), VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | rayTracingFlags);
+		lodTriangleBuffer = alloc->createBuffer(cmdBuf, getLodIndexCount() / 3 * sizeof(uint32_t), getLodTriangleData(), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | flag);
+	}
+}
+
+void Astra::Mesh::computeCullingData()
+{
+	// for culling, levels of detail and picking
+	meshlets = buildMeshlets(getVertexData(), getVertexCount(), getIndexData(), getIndexCount());
+	bounds = Astra::computeBounds(getVertexData(), getVertexCount());
+	submeshBounds = Astra::computeSubmeshBounds(getVertexData(), getIndexData(), getIndexCount(), getMaterialIndexData(), getMaterialIndexCount(), materials.size());
 }
 
-void Astra::Mesh::loadFromFile(const std::string& path)
+bool Astra::Mesh::loadObjTinyobj(const std::string& path, std::vector<uint32_t>& positionIds)
 {
 	tinyobj::ObjReader reader;
 	reader.ParseFromFile(path);
 	if (!reader.Valid())
 	{
 		Astra::Log("Error reading obj file: " + path + ", error: " + reader.Error(), ERR);
-		assert(reader.Valid());
+		return false;
 	}
 
 	if (!reader.Warning().empty())
@@ -120,7 +245,8 @@ void Astra::Mesh::loadFromFile(const std::string& path)
 	// Collecting the material in the scene
 	for (const auto& material : reader.GetMaterials())
 	{
-		WaveFrontMaterial m;
+		WaveFrontMaterial m{};
+		m.textureId = -1;
 		m.ambient = glm::vec3(material.ambient[0], material.ambient[1], material.ambient[2]);
 		m.diffuse = glm::vec3(material.diffuse[0], material.diffuse[1], material.diffuse[2]);
 		m.specular = glm::vec3(material.specular[0], material.specular[1], material.specular[2]);
@@ -176,9 +302,164 @@ void Astra::Mesh::loadFromFile(const std::string& path)
 
 			vertices.push_back(vertex);
 			indices.push_back(static_cast<int>(indices.size()));
+			if (attrib.normals.empty())
+				positionIds.push_back(static_cast<uint32_t>(index.vertex_index));
 		}
 	}
 
+	return !attrib.normals.empty();
+}
+
+bool Astra::Mesh::loadObjParallel(const std::string& path, std::vector<uint32_t>& positionIds)
+{
+	ObjData data;
+	if (!parseObj(path, data))
+	{
+		Astra::Log("Error reading obj file: " + path + ", error: " + data.error, ERR);
+		return false;
+	}
+
+	if (!data.warning.empty())
+	{
+		Astra::Log("Error reading obj file: " + path + ", error: " + data.warning, WARNING);
+	}
+
+	vertices = std::move(data.vertices);
+	indices = std::move(data.indices);
+	materialIndices = std::move(data.materialIndices);
+	materials = std::move(data.materials);
+	texturePaths = std::move(data.texturePaths);
+	positionIds = std::move(data.positionIds);
+	return data.hasNormals;
+}
+
+const Vertex* Astra::Mesh::getVertexData() const
+{
+	return _externalVertices || _deviceOnly ? _externalVertices : vertices.data();
+}
+
+size_t Astra::Mesh::getVertexCount() const
+{
+	return _externalVertices || _deviceOnly ? _externalVertexCount : vertices.size();
+}
+
+const uint32_t* Astra::Mesh::getIndexData() const
+{
+	return _externalIndices || _deviceOnly ? _externalIndices : indices.data();
+}
+
+size_t Astra::Mesh::getIndexCount() const
+{
+	return _externalIndices || _deviceOnly ? _externalIndexCount : indices.size();
+}
+
+const int32_t* Astra::Mesh::getMaterialIndexData() const
+{
+	return _externalMaterialIndices || _deviceOnly ? _externalMaterialIndices : materialIndices.data();
+}
+
+size_t Astra::Mesh::getMaterialIndexCount() const
+{
+	return _externalMaterialIndices || _deviceOnly ? _externalMaterialIndexCount : materialIndices.size();
+}
+
+const uint32_t* Astra::Mesh::getLodIndexData() const
+{
+	return _externalLodIndices ? _externalLodIndices : lodIndices.data();
+}
+
+const uint32_t* Astra::Mesh::getLodTriangleData() const
+{
+	return _externalLodIndices ? _externalLodTriangles : lodTriangles.data();
+}
+
+size_t Astra::Mesh::getLodIndexCount() const
+{
+	return _externalLodIndices ? _externalLodIndexCount : lodIndices.size();
+}
+
+void Astra::Mesh::setExternalData(std::shared_ptr<const void> owner, const Vertex* vertexData, size_t vertexCount, const uint32_t* indexData, size_t indexCount,
+	const int32_t* materialIndexData, size_t materialIndexCount)
+{
+	_externalOwner = std::move(owner);
+	_externalVertices = vertexData;
+	_externalVertexCount = vertexData ? vertexCount : 0;
+	_externalIndices = indexData;
+	_externalIndexCount = indexData ? indexCount : 0;
+	_externalMaterialIndices = materialIndexData;
+	_externalMaterialIndexCount = materialIndexData ? materialIndexCount : 0;
+}
+
+void Astra::Mesh::setDeviceOnlyData(size_t vertexCount, size_t indexCount)
+{
+	// the counts stay, the pointers say there is nothing to read
+	setExternalData(nullptr, nullptr, 0, nullptr, 0);
+	_deviceOnly = true;
+	_externalVertexCount = vertexCount;
+	_externalIndexCount = indexCount;
+	_externalMaterialIndexCount = indexCount / 3;
+	vertices.clear();
+	indices.clear();
+	materialIndices.clear();
+}
+
+void Astra::Mesh::setExternalLodData(const uint32_t* indexData, const uint32_t* triangleData, size_t indexCount)
+{
+	_externalLodIndices = indexData && triangleData ? indexData : nullptr;
+	_externalLodTriangles = _externalLodIndices ? triangleData : nullptr;
+	_externalLodIndexCount = _externalLodIndices ? indexCount : 0;
+}
+
+bool Astra::Mesh::loadFromFile(const std::string& path, const MeshLoadOptions& options)
+{
+	// only changes the upload, the cache always keeps plain vertices
+	vertexFormat = options.vertexFormat;
+
+	// everything that changes the result goes in the key, so changing options invalidates the cache
+	struct
+	{
+		uint32_t flags;
+		float weldEpsilon;
+		float creaseAngle;
+		uint32_t lodCount;
+		float lodReduction;
+	} keyOptions{ (options.parallelParser ? 1u : 0u) | (options.weldVertices ? 2u : 0u) | (options.linearizeColors ? 4u : 0u) | (options.optimizeMesh ? 8u : 0u),
+		options.weldEpsilon, options.creaseAngle, std::min(options.lodCount, 0xFFu), options.lodReduction };
+	const uint64_t optionsKey = Astra::hashBytes(&keyOptions, sizeof(keyOptions));
+
+	std::string cachePath;
+	if (options.useCache)
+	{
+		cachePath = getMeshCachePath(path, options.cacheDirectory);
+		MeshCacheData cached;
+		if (readMeshCache(cachePath, path, optionsKey, cached))
+		{
+			setExternalData(std::move(cached.file), cached.vertices, cached.vertexCount, cached.indices, cached.indexCount,
+				cached.materialIndices, cached.materialIndexCount);
+			setExternalLodData(cached.lodIndices, cached.lodTriangles, cached.lodIndexCount);
+			lods = std::move(cached.lods);
+			materials = std::move(cached.materials);
+			texturePaths = std::move(cached.texturePaths);
+			meshlets = std::move(cached.meshlets);
+			bounds = cached.bounds;
+			submeshBounds = std::move(cached.submeshBounds);
+			return true;
+		}
+	}
+
+	std::vector<uint32_t> positionIds;
+	const bool hasNormals = options.parallelParser ? loadObjParallel(path, positionIds) : loadObjTinyobj(path, positionIds);
+	if (vertices.empty() || indices.empty())
+	{
+		// unreadable or without triangles, the caller sees no vertices and nothing is cached
+		vertices.clear();
+		indices.clear();
+		materialIndices.clear();
+		materials.clear();
+		texturePaths.clear();
+		return false;
+	}
+
 	// Fixing material indices
 	for (auto& mi : materialIndices)
 	{
@@ -187,20 +468,20 @@ void Astra::Mesh::loadFromFile(const std::string& path)
 	}
 
 	// Compute normal when no normal were provided.
-	if (attrib.normals.empty())
+	if (!hasNormals)
+	{
+		Astra::computeSmoothNormals(vertices, indices, options.creaseAngle, positionIds.size() == vertices.size() ? positionIds.data() : nullptr);
+	}
+
+	// welding goes after the normals are computed, corners across a crease must stay apart
+	if (options.weldVertices)
 	{
-		for (size_t i = 0; i < indices.size(); i += 3)
+		const size_t before = vertices.size();
+		Astra::weldVertices(vertices, indices, options.weldEpsilon);
+		if (before > 0)
 		{
-			Vertex& v0 = vertices[indices[i + 0]];
-			Vertex& v1 = vertices[indices[i + 1]];
-			Vertex& v2 = vertices[indices[i + 2]];
-
-			glm::vec3 n = glm::normalize(glm::cross((v1.pos - v0.pos), (v2.pos - v0.pos)));
-			v0.nrm = n;
-			v1.nrm = n;
-			v2.nrm = n;
+			Astra::Log("Welded " + path + ": " + std::to_string(before) + " -> " + std::to_string(vertices.size()) + " vertices (" + std::to_string(100 * vertices.size() / before) + "%)");
 		}
-
 	}
 	// If there were none, add a default
 	if (materials.empty())
@@ -214,6 +495,26 @@ void Astra::Mesh::loadFromFile(const std::string& path)
 		materialIndices.push_back(0);
 	}
 
+	// after welding, the optimizations need shared vertices to be worth anything
+	if (options.optimizeMesh)
+	{
+		const MeshOptimizationStats stats = Astra::optimizeMesh(vertices, indices, materialIndices);
+		char acmr[64];
+		snprintf(acmr, sizeof(acmr), "%.3f -> %.3f", stats.acmrBefore, stats.acmrAfter);
+		Astra::Log("Optimized " + path + ": ACMR " + acmr);
+	}
+
+	// on the final order, so the levels keep it as far as possible
+	if (options.lodCount > 0)
+	{
+		lods = Astra::buildLodChain(vertices.data(), vertices.size(), indices.data(), indices.size(), std::min(options.lodCount, 0xFFu), options.lodReduction,
+			lodIndices, lodTriangles);
+		std::string counts = std::to_string(indices.size() / 3);
+		for (const MeshLod& lod : lods)
+			counts += " -> " + std::to_string(lod.indexCount / 3);
+		Astra::Log("Simplified " + path + ": " + counts + " triangles");
+	}
+
 	// process texture paths
 	// if they are relative, add the base path
 	std::filesystem::path meshPath(path);
@@ -224,6 +525,45 @@ void Astra::Mesh::loadFromFile(const std::string& path)
 			texturePathStr = (meshPath / txtPath).string(); // the "/" operator appends paths 
 		}
 	}
+
+	// color space to linear
+	if (options.linearizeColors)
+	{
+		for (auto& m : materials)
+		{
+			m.ambient = glm::pow(m.ambient, glm::vec3(2.2f));
+			m.diffuse = glm::pow(m.diffuse, glm::vec3(2.2f));
+			m.specular = glm::pow(m.specular, glm::vec3(2.2f));
+		}
+	}
+
+	// on the worker, so create() only has to upload them
+	computeCullingData();
+
+	if (options.useCache)
+	{
+		MeshCacheData data;
+		data.vertices = vertices.data();
+		data.vertexCount = vertices.size();
+		data.indices = indices.data();
+		data.indexCount = indices.size();
+		data.materialIndices = materialIndices.data();
+		data.materialIndexCount = materialIndices.size();
+		data.lodIndices = lodIndices.data();
+		data.lodTriangles = lodTriangles.data();
+		data.lodIndexCount = lodIndices.size();
+		data.lods = lods;
+		data.materials = materials;
+		data.texturePaths = texturePaths;
+		data.meshlets = meshlets;
+		data.bounds = bounds;
+		data.submeshBounds = submeshBounds;
+		if (!writeMeshCache(cachePath, path, optionsKey, data))
+		{
+			Astra::Log("Could not write mesh cache: " + cachePath, WARNING);
+		}
+	}
+	return true;
 }
 
 void Astra::Mesh::fromGeoMat(const Astra::Geometry& geom, const WaveFrontMaterial &material)
@@ -0,0 +1,429 @@
+#include <MeshCache.h>
+#include <Utils.h>
+#include <filesystem>
+#include <fstream>
+#include <algorithm>
+#include <functional>
+#include <thread>
+#include <cstring>
+#include <cstdio>
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace
+{
+	constexpr char MeshCacheMagic[8] = { 'A', 'S', 'T', 'R', 'M', 'E', 'S', 'H' };
+	constexpr uint64_t SectionAlignment = 16;
+	// size of a dependency that did not exist when the cache was written
+	constexpr uint64_t MissingDependency = ~0ull;
+
+	struct MeshCacheHeader
+	{
+		char magic[8];
+		uint32_t version;
+		// catch layout changes of the shared structs
+		uint32_t vertexStride;
+		uint32_t materialStride;
+		uint32_t meshletStride;
+		uint32_t boundsStride;
+		uint32_t padding;
+		uint64_t optionsKey;
+		uint64_t sourceSize;
+		int64_t sourceTime;
+		uint64_t sourceHash;
+		uint64_t vertexCount;
+		uint64_t vertexOffset;
+		uint64_t indexCount;
+		uint64_t indexOffset;
+		uint64_t materialCount;
+		uint64_t materialOffset;
+		uint64_t materialIndexCount;
+		uint64_t materialIndexOffset;
+		uint64_t lodIndexCount;
+		uint64_t lodIndexOffset;
+		uint64_t lodTriangleOffset;
+		uint64_t lodCount;
+		uint64_t lodOffset;
+		uint64_t meshletCount;
+		uint64_t meshletOffset;
+		// the bounds of the whole mesh go first, then the ones of every material
+		uint64_t boundsCount;
+		uint64_t boundsOffset;
+		uint64_t textureCount;
+		uint64_t textureOffset;
+		uint64_t dependencyCount;
+		uint64_t dependencyOffset;
+		uint64_t fileSize;
+	};
+
+	// every file the mtllib lines name, followed by its path
+	struct MeshCacheDependency
+	{
+		uint64_t size;
+		int64_t time;
+		uint64_t hash;
+		uint32_t pathLength;
+		uint32_t padding;
+	};
+
+	uint64_t align(uint64_t v)
+	{
+		return (v + SectionAlignment - 1) & ~(SectionAlignment - 1);
+	}
+
+	bool getSourceInfo(const std::string& sourcePath, uint64_t& size, int64_t& time)
+	{
+		std::error_code ec;
+		size = std::filesystem::file_size(sourcePath, ec);
+		if (ec)
+			return false;
+		time = static_cast<int64_t>(std::filesystem::last_write_time(sourcePath, ec).time_since_epoch().count());
+		return !ec;
+	}
+
+	bool isBlank(char c)
+	{
+		return c == ' ' || c == '\t' || c == '\r';
+	}
+
+	// every file named by the mtllib lines, relative ones next to the obj like both parsers look for them
+	void findMaterialLibraries(const std::string& sourcePath, const char* data, size_t size, std::vector<std::string>& libraries)
+	{
+		const std::filesystem::path baseDir = std::filesystem::path(sourcePath).parent_path();
+		const char* p = data;
+		const char* end = data + size;
+		while (p < end)
+		{
+			const char* lineEnd = static_cast<const char*>(std::memchr(p, '\n', end - p));
+			if (lineEnd == nullptr)
+				lineEnd = end;
+			while (p < lineEnd && isBlank(*p))
+				p++;
+			if (lineEnd - p > 6 && std::memcmp(p, "mtllib", 6) == 0 && isBlank(p[6]))
+			{
+				for (p += 6; p < lineEnd;)
+				{
+					while (p < lineEnd && isBlank(*p))
+						p++;
+					const char* nameEnd = p;
+					while (nameEnd < lineEnd && !isBlank(*nameEnd))
+						nameEnd++;
+					if (nameEnd > p)
+					{
+						std::filesystem::path library(std::string(p, nameEnd));
+						if (library.is_relative())
+							library = baseDir / library;
+						const std::string path = library.string();
+						if (std::find(libraries.begin(), libraries.end(), path) == libraries.end())
+							libraries.push_back(path);
+					}
+					p = nameEnd;
+				}
+			}
+			p = lineEnd < end ? lineEnd + 1 : end;
+		}
+	}
+
+	bool hashSource(const std::string& sourcePath, uint64_t& hash, std::vector<std::string>* libraries = nullptr)
+	{
+		Astra::MappedFile source;
+		if (!source.open(sourcePath))
+			return false;
+		hash = Astra::hashBytes(source.data(), source.size());
+		if (libraries != nullptr)
+			findMaterialLibraries(sourcePath, source.data(), source.size(), *libraries);
+		return true;
+	}
+
+	MeshCacheDependency getDependency(const std::string& path)
+	{
+		MeshCacheDependency dependency{};
+		dependency.pathLength = static_cast<uint32_t>(path.size());
+		if (!getSourceInfo(path, dependency.size, dependency.time) || !hashSource(path, dependency.hash))
+		{
+			// if it shows up later the materials change, so its absence is recorded too
+			dependency.size = MissingDependency;
+			dependency.time = 0;
+			dependency.hash = 0;
+		}
+		return dependency;
+	}
+
+	// same checks as the obj: size, then the content only if the time changed
+	bool dependencyMatches(const std::string& path, const MeshCacheDependency& dependency)
+	{
+		uint64_t size;
+		int64_t time;
+		if (!getSourceInfo(path, size, time))
+			return dependency.size == MissingDependency;
+		if (size != dependency.size)
+			return false;
+		if (time == dependency.time)
+			return true;
+		uint64_t hash;
+		return hashSource(path, hash) && hash == dependency.hash;
+	}
+
+	// unique for every writer, so loads of the same model from several threads or processes do not write the same file
+	std::string getTempPath(const std::string& cachePath)
+	{
+#ifdef _WIN32
+		const unsigned long long processId = static_cast<unsigned long long>(_getpid());
+#else
+		const unsigned long long processId = static_cast<unsigned long long>(getpid());
+#endif
+		const unsigned long long threadId = static_cast<unsigned long long>(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+		char suffix[64];
+		snprintf(suffix, sizeof(suffix), ".%llu.%016llx.tmp", processId, threadId);
+		return cachePath + suffix;
+	}
+
+	bool validSection(const MeshCacheHeader& header, uint64_t offset, uint64_t count, uint64_t stride)
+	{
+		return offset % SectionAlignment == 0 && offset <= header.fileSize && count <= (header.fileSize - offset) / stride;
+	}
+}
+
+std::string Astra::getMeshCachePath(const std::string& sourcePath, const std::string& cacheDirectory)
+{
+	if (cacheDirectory.empty())
+		return sourcePath + ".astramesh";
+
+	// files with the same name in different folders must not share the cache
+	std::error_code ec;
+	std::string absolute = std::filesystem::absolute(sourcePath, ec).string();
+	if (ec)
+		absolute = sourcePath;
+	char hash[17];
+	snprintf(hash, sizeof(hash), "%016llx", static_cast<unsigned long long>(Astra::hashBytes(absolute.data(), absolute.size())));
+	const std::string name = std::filesystem::path(sourcePath).filename().string() + "." + hash + ".astramesh";
+	return (std::filesystem::path(cacheDirectory) / name).string();
+}
+
+bool Astra::readMeshCache(const std::string& cachePath, const std::string& sourcePath, uint64_t optionsKey, MeshCacheData& data)
+{
+	uint64_t sourceSize;
+	int64_t sourceTime;
+	if (!getSourceInfo(sourcePath, sourceSize, sourceTime))
+		return false;
+
+	auto file = std::make_shared<MappedFile>();
+	if (!file->open(cachePath) || file->size() < sizeof(MeshCacheHeader))
+		return false;
+
+	MeshCacheHeader header;
+	std::memcpy(&header, file->data(), sizeof(header));
+	if (std::memcmp(header.magic, MeshCacheMagic, sizeof(MeshCacheMagic)) != 0 || header.version != MeshCacheVersion ||
+		header.vertexStride != sizeof(Vertex) || header.materialStride != sizeof(WaveFrontMaterial) ||
+		header.meshletStride != sizeof(Meshlet) || header.boundsStride != sizeof(MeshBounds) ||
+		header.optionsKey != optionsKey || header.fileSize != file->size() || header.sourceSize != sourceSize)
+		return false;
+
+	// a touched or copied file gets a new time, only then the content has to be checked
+	if (header.sourceTime != sourceTime)
+	{
+		uint64_t sourceHash;
+		if (!hashSource(sourcePath, sourceHash) || sourceHash != header.sourceHash)
+			return false;
+	}
+
+	if (!validSection(header, header.vertexOffset, header.vertexCount, sizeof(Vertex)) ||
+		!validSection(header, header.indexOffset, header.indexCount, sizeof(uint32_t)) ||
+		!validSection(header, header.materialOffset, header.materialCount, sizeof(WaveFrontMaterial)) ||
+		!validSection(header, header.materialIndexOffset, header.materialIndexCount, sizeof(int32_t)) ||
+		!validSection(header, header.lodIndexOffset, header.lodIndexCount, sizeof(uint32_t)) ||
+		!validSection(header, header.lodTriangleOffset, header.lodIndexCount / 3, sizeof(uint32_t)) ||
+		!validSection(header, header.lodOffset, header.lodCount, sizeof(MeshLod)) ||
+		!validSection(header, header.meshletOffset, header.meshletCount, sizeof(Meshlet)) ||
+		!validSection(header, header.boundsOffset, header.boundsCount, sizeof(MeshBounds)) || header.boundsCount == 0 ||
+		header.textureOffset > header.dependencyOffset || header.dependencyOffset % SectionAlignment != 0 || header.dependencyOffset > header.fileSize)
+		return false;
+
+	const char* base = file->data();
+
+	// the materials come from the mtl files, they must not have changed either
+	const char* dependency = base + header.dependencyOffset;
+	const char* dependencyEnd = base + header.fileSize;
+	for (uint64_t i = 0; i < header.dependencyCount; i++)
+	{
+		MeshCacheDependency info;
+		if (static_cast<size_t>(dependencyEnd - dependency) < sizeof(info))
+			return false;
+		std::memcpy(&info, dependency, sizeof(info));
+		dependency += sizeof(info);
+		if (static_cast<size_t>(dependencyEnd - dependency) < info.pathLength)
+			return false;
+		if (!dependencyMatches(std::string(dependency, info.pathLength), info))
+			return false;
+		dependency += info.pathLength;
+	}
+
+	data.vertices = reinterpret_cast<const Vertex*>(base + header.vertexOffset);
+	data.vertexCount = header.vertexCount;
+	data.indices = reinterpret_cast<const uint32_t*>(base + header.indexOffset);
+	data.indexCount = header.indexCount;
+	data.materialIndices = reinterpret_cast<const int32_t*>(base + header.materialIndexOffset);
+	data.materialIndexCount = header.materialIndexCount;
+	data.lodIndices = reinterpret_cast<const uint32_t*>(base + header.lodIndexOffset);
+	data.lodTriangles = reinterpret_cast<const uint32_t*>(base + header.lodTriangleOffset);
+	data.lodIndexCount = header.lodIndexCount;
+
+	const auto* lods = reinterpret_cast<const MeshLod*>(base + header.lodOffset);
+	data.lods.assign(lods, lods + header.lodCount);
+	for (const MeshLod& lod : data.lods)
+	{
+		if (lod.firstIndex > data.lodIndexCount || lod.indexCount > data.lodIndexCount - lod.firstIndex)
+			return false;
+	}
+
+	const auto* materials = reinterpret_cast<const WaveFrontMaterial*>(base + header.materialOffset);
+	data.materials.assign(materials, materials + header.materialCount);
+
+	const auto* meshlets = reinterpret_cast<const Meshlet*>(base + header.meshletOffset);
+	data.meshlets.assign(meshlets, meshlets + header.meshletCount);
+	const auto* bounds = reinterpret_cast<const MeshBounds*>(base + header.boundsOffset);
+	data.bounds = bounds[0];
+	data.submeshBounds.assign(bounds + 1, bounds + header.boundsCount);
+
+	data.texturePaths.clear();
+	const char* p = base + header.textureOffset;
+	const char* end = base + header.dependencyOffset;
+	for (uint64_t i = 0; i < header.textureCount; i++)
+	{
+		uint32_t length;
+		if (static_cast<size_t>(end - p) < sizeof(length))
+			return false;
+		std::memcpy(&length, p, sizeof(length));
+		p += sizeof(length);
+		if (static_cast<size_t>(end - p) < length)
+			return false;
+		data.texturePaths.emplace_back(p, length);
+		p += length;
+	}
+
+	data.file = std::move(file);
+	return true;
+}
+
+bool Astra::writeMeshCache(const std::string& cachePath, const std::string& sourcePath, uint64_t optionsKey, const MeshCacheData& data)
+{
+	MeshCacheHeader header{};
+	std::memcpy(header.magic, MeshCacheMagic, sizeof(MeshCacheMagic));
+	header.version = MeshCacheVersion;
+	header.vertexStride = sizeof(Vertex);
+	header.materialStride = sizeof(WaveFrontMaterial);
+	header.meshletStride = sizeof(Meshlet);
+	header.boundsStride = sizeof(MeshBounds);
+	header.optionsKey = optionsKey;
+	std::vector<std::string> libraries;
+	if (!getSourceInfo(sourcePath, header.sourceSize, header.sourceTime) || !hashSource(sourcePath, header.sourceHash, &libraries))
+		return false;
+	std::vector<MeshCacheDependency> dependencies;
+	for (const auto& library : libraries)
+		dependencies.push_back(getDependency(library));
+
+	header.vertexCount = data.vertexCount;
+	header.indexCount = data.indexCount;
+	header.materialCount = data.materials.size();
+	header.materialIndexCount = data.materialIndexCount;
+	header.lodIndexCount = data.lodIndexCount;
+	header.lodCount = data.lods.size();
+	header.meshletCount = data.meshlets.size();
+	header.boundsCount = 1 + data.submeshBounds.size();
+	header.textureCount = data.texturePaths.size();
+	header.dependencyCount = dependencies.size();
+
+	header.vertexOffset = align(sizeof(MeshCacheHeader));
+	header.indexOffset = align(header.vertexOffset + header.vertexCount * sizeof(Vertex));
+	header.materialOffset = align(header.indexOffset + header.indexCount * sizeof(uint32_t));
+	header.materialIndexOffset = align(header.materialOffset + header.materialCount * sizeof(WaveFrontMaterial));
+	header.lodIndexOffset = align(header.materialIndexOffset + header.materialIndexCount * sizeof(int32_t));
+	header.lodTriangleOffset = align(header.lodIndexOffset + header.lodIndexCount * sizeof(uint32_t));
+	header.lodOffset = align(header.lodTriangleOffset + header.lodIndexCount / 3 * sizeof(uint32_t));
+	header.meshletOffset = align(header.lodOffset + header.lodCount * sizeof(MeshLod));
+	header.boundsOffset = align(header.meshletOffset + header.meshletCount * sizeof(Meshlet));
+	header.textureOffset = align(header.boundsOffset + header.boundsCount * sizeof(MeshBounds));
+	header.dependencyOffset = header.textureOffset;
+	for (const auto& path : data.texturePaths)
+		header.dependencyOffset += sizeof(uint32_t) + path.size();
+	header.dependencyOffset = align(header.dependencyOffset);
+	header.fileSize = header.dependencyOffset;
+	for (const auto& path : libraries)
+		header.fileSize += sizeof(MeshCacheDependency) + path.size();
+
+	std::error_code ec;
+	const std::filesystem::path target(cachePath);
+	if (target.has_parent_path())
+		std::filesystem::create_directories(target.parent_path(), ec);
+
+	// written aside and renamed, so a crash never leaves a broken cache behind
+	const std::string tmpPath = getTempPath(cachePath);
+	{
+		std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+		if (!out)
+			return false;
+
+		uint64_t written = 0;
+		auto write = [&](const void* bytes, uint64_t size)
+		{
+			out.write(static_cast<const char*>(bytes), static_cast<std::streamsize>(size));
+			written += size;
+		};
+		auto pad = [&](uint64_t offset)
+		{
+			static const char zeros[SectionAlignment] = {};
+			write(zeros, offset - written);
+		};
+
+		write(&header, sizeof(header));
+		pad(header.vertexOffset);
+		write(data.vertices, header.vertexCount * sizeof(Vertex));
+		pad(header.indexOffset);
+		write(data.indices, header.indexCount * sizeof(uint32_t));
+		pad(header.materialOffset);
+		write(data.materials.data(), header.materialCount * sizeof(WaveFrontMaterial));
+		pad(header.materialIndexOffset);
+		write(data.materialIndices, header.materialIndexCount * sizeof(int32_t));
+		pad(header.lodIndexOffset);
+		write(data.lodIndices, header.lodIndexCount * sizeof(uint32_t));
+		pad(header.lodTriangleOffset);
+		write(data.lodTriangles, header.lodIndexCount / 3 * sizeof(uint32_t));
+		pad(header.lodOffset);
+		write(data.lods.data(), header.lodCount * sizeof(MeshLod));
+		pad(header.meshletOffset);
+		write(data.meshlets.data(), header.meshletCount * sizeof(Meshlet));
+		pad(header.boundsOffset);
+		write(&data.bounds, sizeof(MeshBounds));
+		write(data.submeshBounds.data(), data.submeshBounds.size() * sizeof(MeshBounds));
+		pad(header.textureOffset);
+		for (const auto& path : data.texturePaths)
+		{
+			const uint32_t length = static_cast<uint32_t>(path.size());
+			write(&length, sizeof(length));
+			write(path.data(), length);
+		}
+		pad(header.dependencyOffset);
+		for (size_t i = 0; i < libraries.size(); i++)
+		{
+			write(&dependencies[i], sizeof(MeshCacheDependency));
+			write(libraries[i].data(), libraries[i].size());
+		}
+		if (!out)
+		{
+			out.close();
+			std::filesystem::remove(tmpPath, ec);
+			return false;
+		}
+	}
+
+	std::filesystem::rename(tmpPath, cachePath, ec);
+	if (ec)
+	{
+		std::filesystem::remove(tmpPath, ec);
+		return false;
+	}
+	return true;
+}
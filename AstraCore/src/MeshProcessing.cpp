@@ -0,0 +1,1389 @@
+#include <MeshProcessing.h>
+#include <ThreadPool.h>
+#include <glm/gtc/constants.hpp>
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+#include <cfloat>
+#include <limits>
+#include <mutex>
+#include <atomic>
+#include <unordered_map>
+
+namespace
+{
+	constexpr size_t NbComponents = sizeof(Vertex) / sizeof(float);
+	static_assert(sizeof(Vertex) == NbComponents * sizeof(float), "Vertex must only contain floats");
+
+	constexpr uint32_t EmptySlot = UINT32_MAX;
+	// below this many vertices splitting the work is not worth it
+	constexpr size_t MinWeldBatch = 16 * 1024;
+
+	struct WeldKey
+	{
+		int64_t q[NbComponents];
+
+		bool operator==(const WeldKey& other) const
+		{
+			return std::memcmp(q, other.q, sizeof(q)) == 0;
+		}
+	};
+
+	WeldKey quantize(const Vertex& vertex, double invEpsilon)
+	{
+		float components[NbComponents];
+		std::memcpy(components, &vertex, sizeof(Vertex));
+
+		WeldKey key;
+		for (size_t i = 0; i < NbComponents; i++)
+		{
+			if (invEpsilon > 0.0)
+			{
+				key.q[i] = std::llround(static_cast<double>(components[i]) * invEpsilon);
+			}
+			else
+			{
+				// exact comparison, but 0 and -0 are the same vertex
+				const float value = components[i] == 0.0f ? 0.0f : components[i];
+				uint32_t bits;
+				std::memcpy(&bits, &value, sizeof(bits));
+				key.q[i] = bits;
+			}
+		}
+		return key;
+	}
+
+	uint64_t hashKey(const WeldKey& key)
+	{
+		uint64_t h = 0x9E3779B97F4A7C15ull;
+		for (size_t i = 0; i < NbComponents; i++)
+		{
+			h ^= static_cast<uint64_t>(key.q[i]) + 0x9E3779B97F4A7C15ull + (h << 6) + (h >> 2);
+		}
+		// final mix so the low and high bits are both usable
+		h ^= h >> 33;
+		h *= 0xFF51AFD7ED558CCDull;
+		h ^= h >> 33;
+		return h;
+	}
+
+	size_t nextPowerOfTwo(size_t v)
+	{
+		size_t p = 1;
+		while (p < v)
+			p <<= 1;
+		return p;
+	}
+
+	// remap[i] is the first vertex equal to i, which is always <= i. Vertices are only compared when their hashes match
+	template <typename Equal>
+	void findFirstEqual(const std::vector<uint64_t>& hashes, const Equal& equal, std::vector<uint32_t>& remap)
+	{
+		const size_t count = hashes.size();
+		auto& pool = AstraThreads;
+
+		// vertices are split by hash so every partition is searched on its own
+		const size_t nbPartitions = std::max<size_t>(1, std::min<size_t>(pool.getThreadCount() * 2, count / MinWeldBatch));
+		std::vector<std::vector<size_t>> blockCounts(nbPartitions, std::vector<size_t>(nbPartitions, 0));
+		const size_t blockSize = (count + nbPartitions - 1) / nbPartitions;
+		pool.parallelFor(nbPartitions, [&](size_t begin, size_t end)
+			{
+				for (size_t b = begin; b < end; b++)
+				{
+					const size_t last = std::min(count, (b + 1) * blockSize);
+					for (size_t i = b * blockSize; i < last; i++)
+						blockCounts[b][hashes[i] % nbPartitions]++;
+				}
+			});
+
+		// partition major offsets, so each partition keeps its vertices in index order
+		std::vector<size_t> partitionBegin(nbPartitions + 1, 0);
+		std::vector<std::vector<size_t>> blockOffsets(nbPartitions, std::vector<size_t>(nbPartitions, 0));
+		size_t offset = 0;
+		for (size_t p = 0; p < nbPartitions; p++)
+		{
+			partitionBegin[p] = offset;
+			for (size_t b = 0; b < nbPartitions; b++)
+			{
+				blockOffsets[b][p] = offset;
+				offset += blockCounts[b][p];
+			}
+		}
+		partitionBegin[nbPartitions] = offset;
+
+		std::vector<uint32_t> order(count);
+		pool.parallelFor(nbPartitions, [&](size_t begin, size_t end)
+			{
+				for (size_t b = begin; b < end; b++)
+				{
+					std::vector<size_t>& cursor = blockOffsets[b];
+					const size_t last = std::min(count, (b + 1) * blockSize);
+					for (size_t i = b * blockSize; i < last; i++)
+						order[cursor[hashes[i] % nbPartitions]++] = static_cast<uint32_t>(i);
+				}
+			});
+
+		remap.resize(count);
+		pool.parallelFor(nbPartitions, [&](size_t begin, size_t end)
+			{
+				for (size_t p = begin; p < end; p++)
+				{
+					const size_t first = partitionBegin[p];
+					const size_t n = partitionBegin[p + 1] - first;
+					const size_t mask = nextPowerOfTwo(std::max<size_t>(2 * n, 16)) - 1;
+					std::vector<uint32_t> table(mask + 1, EmptySlot);
+
+					for (size_t k = first; k < first + n; k++)
+					{
+						const uint32_t i = order[k];
+						size_t slot = (hashes[i] >> 20) & mask;
+						remap[i] = i;
+						while (table[slot] != EmptySlot)
+						{
+							const uint32_t j = table[slot];
+							if (hashes[j] == hashes[i] && equal(j, i))
+							{
+								remap[i] = j;
+								break;
+							}
+							slot = (slot + 1) & mask;
+						}
+						if (remap[i] == i)
+							table[slot] = i;
+					}
+				}
+			});
+	}
+}
+
+size_t Astra::weldVertices(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, float epsilon)
+{
+	const size_t count = vertices.size();
+	if (count == 0)
+		return 0;
+
+	const double invEpsilon = epsilon > 0.0f ? 1.0 / static_cast<double>(epsilon) : 0.0;
+	auto& pool = AstraThreads;
+
+	std::vector<uint64_t> hashes(count);
+	pool.parallelFor(count, [&](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; i++)
+				hashes[i] = hashKey(quantize(vertices[i], invEpsilon));
+		}, MinWeldBatch);
+
+	// remap[i] is the first vertex equal to i
+	std::vector<uint32_t> remap;
+	findFirstEqual(hashes, [&](uint32_t a, uint32_t b) { return quantize(vertices[a], invEpsilon) == quantize(vertices[b], invEpsilon); }, remap);
+
+	// compaction, unique vertices keep their relative order
+	const size_t nbBlocks = std::max<size_t>(1, std::min<size_t>(pool.getThreadCount() * 2, count / MinWeldBatch));
+	const size_t compactBlock = (count + nbBlocks - 1) / nbBlocks;
+	std::vector<size_t> uniqueBefore(nbBlocks + 1, 0);
+	pool.parallelFor(nbBlocks, [&](size_t begin, size_t end)
+		{
+			for (size_t b = begin; b < end; b++)
+			{
+				const size_t last = std::min(count, (b + 1) * compactBlock);
+				size_t unique = 0;
+				for (size_t i = b * compactBlock; i < last; i++)
+					unique += remap[i] == i;
+				uniqueBefore[b + 1] = unique;
+			}
+		});
+	for (size_t b = 0; b < nbBlocks; b++)
+		uniqueBefore[b + 1] += uniqueBefore[b];
+	const size_t nbUnique = uniqueBefore[nbBlocks];
+
+	std::vector<uint32_t> newIndex(count);
+	std::vector<Vertex> welded(nbUnique);
+	pool.parallelFor(nbBlocks, [&](size_t begin, size_t end)
+		{
+			for (size_t b = begin; b < end; b++)
+			{
+				size_t next = uniqueBefore[b];
+				const size_t last = std::min(count, (b + 1) * compactBlock);
+				for (size_t i = b * compactBlock; i < last; i++)
+				{
+					if (remap[i] == i)
+					{
+						newIndex[i] = static_cast<uint32_t>(next);
+						welded[next] = vertices[i];
+						next++;
+					}
+				}
+			}
+		});
+
+	// duplicates always point to a unique vertex, whose index is already final
+	pool.parallelFor(count, [&](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; i++)
+			{
+				if (remap[i] != i)
+					newIndex[i] = newIndex[remap[i]];
+			}
+		}, MinWeldBatch);
+
+	pool.parallelFor(indices.size(), [&](size_t begin, size_t end)
+		{
+			for (size_t k = begin; k < end; k++)
+				indices[k] = newIndex[indices[k]];
+		}, MinWeldBatch);
+
+	vertices = std::move(welded);
+	return nbUnique;
+}
+
+namespace
+{
+	// Forsyth's scoring, with the constants of the original article
+	constexpr uint32_t ForsythCacheSize = 32;
+	constexpr float LastTriangleScore = 0.75f;
+	constexpr float CacheDecayPower = 1.5f;
+	constexpr float ValenceBoostScale = 2.0f;
+	constexpr float ValenceBoostPower = 0.5f;
+
+	// cache size the ACMR is measured with, the usual post-transform cache of current GPUs
+	constexpr uint32_t FifoCacheSize = 16;
+
+	float vertexScore(int cachePos, uint32_t remaining)
+	{
+		// vertices without triangles left must never be chosen
+		if (remaining == 0)
+			return -1.0f;
+
+		float score = 0.0f;
+		if (cachePos >= 0)
+		{
+			// the last triangle is scored the same no matter its order, so it is not used again right away
+			if (cachePos < 3)
+			{
+				score = LastTriangleScore;
+			}
+			else
+			{
+				const float scaler = 1.0f / (ForsythCacheSize - 3);
+				score = std::pow(1.0f - (cachePos - 3) * scaler, CacheDecayPower);
+			}
+		}
+		// vertices with few triangles left are preferred, to finish them and avoid isolated triangles
+		score += ValenceBoostScale * std::pow(static_cast<float>(remaining), -ValenceBoostPower);
+		return score;
+	}
+
+	// misses of every triangle with a FIFO cache
+	std::vector<uint32_t> simulateFifo(const uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize)
+	{
+		// a vertex is in the cache while less than cacheSize misses have happened since it was loaded
+		std::vector<uint32_t> loadedAt(vertexCount, 0);
+		std::vector<uint32_t> misses(indexCount / 3, 0);
+		uint32_t time = cacheSize + 1;
+		for (size_t t = 0; t < indexCount / 3; t++)
+		{
+			for (int k = 0; k < 3; k++)
+			{
+				const uint32_t v = indices[t * 3 + k];
+				if (time - loadedAt[v] > cacheSize)
+				{
+					loadedAt[v] = time++;
+					misses[t]++;
+				}
+			}
+		}
+		return misses;
+	}
+}
+
+float Astra::computeAcmr(const uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize)
+{
+	const size_t triCount = indexCount / 3;
+	if (triCount == 0)
+		return 0.0f;
+	const std::vector<uint32_t> misses = simulateFifo(indices, indexCount, vertexCount, cacheSize);
+	size_t total = 0;
+	for (uint32_t m : misses)
+		total += m;
+	return static_cast<float>(total) / static_cast<float>(triCount);
+}
+
+void Astra::optimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount)
+{
+	const size_t triCount = indexCount / 3;
+	if (triCount == 0)
+		return;
+
+	// triangles of every vertex, the ones already emitted are moved past remaining[v]
+	std::vector<uint32_t> remaining(vertexCount, 0);
+	for (size_t i = 0; i < triCount * 3; i++)
+		remaining[indices[i]]++;
+	std::vector<uint32_t> adjOffset(vertexCount + 1, 0);
+	for (size_t v = 0; v < vertexCount; v++)
+		adjOffset[v + 1] = adjOffset[v] + remaining[v];
+	std::vector<uint32_t> adjacency(triCount * 3);
+	{
+		std::vector<uint32_t> fill(adjOffset.begin(), adjOffset.end() - 1);
+		for (size_t i = 0; i < triCount * 3; i++)
+			adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+	}
+
+	std::vector<int> cachePos(vertexCount, -1);
+	std::vector<float> score(vertexCount);
+	for (size_t v = 0; v < vertexCount; v++)
+		score[v] = vertexScore(-1, remaining[v]);
+
+	std::vector<float> triScore(triCount);
+	std::vector<bool> emitted(triCount, false);
+	uint32_t best = 0;
+	for (size_t t = 0; t < triCount; t++)
+	{
+		triScore[t] = score[indices[t * 3]] + score[indices[t * 3 + 1]] + score[indices[t * 3 + 2]];
+		if (triScore[t] > triScore[best])
+			best = static_cast<uint32_t>(t);
+	}
+
+	std::vector<uint32_t> result(triCount * 3);
+	// the three new vertices go in front, so the cache can grow by three before trimming it
+	std::vector<uint32_t> cache, newCache;
+	cache.reserve(ForsythCacheSize + 3);
+	newCache.reserve(ForsythCacheSize + 3);
+	size_t scanCursor = 0;
+
+	for (size_t out = 0; out < triCount; out++)
+	{
+		if (best == UINT32_MAX)
+		{
+			// nothing in the cache is connected to what is left, continue with any triangle
+			while (emitted[scanCursor])
+				scanCursor++;
+			best = static_cast<uint32_t>(scanCursor);
+		}
+
+		const uint32_t* tri = indices + best * 3;
+		emitted[best] = true;
+		newCache.clear();
+		for (int k = 0; k < 3; k++)
+		{
+			const uint32_t v = tri[k];
+			result[out * 3 + k] = v;
+
+			// the triangle is swapped with the last one still pending
+			uint32_t* adj = adjacency.data() + adjOffset[v];
+			for (uint32_t a = 0; a < remaining[v]; a++)
+			{
+				if (adj[a] == best)
+				{
+					std::swap(adj[a], adj[remaining[v] - 1]);
+					remaining[v]--;
+					break;
+				}
+			}
+			if (std::find(newCache.begin(), newCache.end(), v) == newCache.end())
+				newCache.push_back(v);
+		}
+		for (uint32_t v : cache)
+		{
+			if (std::find(newCache.begin(), newCache.end(), v) == newCache.end())
+				newCache.push_back(v);
+		}
+
+		// evicted vertices are updated too, they lost their cache score
+		best = UINT32_MAX;
+		float bestScore = -1.0f;
+		for (size_t c = 0; c < newCache.size(); c++)
+		{
+			const uint32_t v = newCache[c];
+			cachePos[v] = c < ForsythCacheSize ? static_cast<int>(c) : -1;
+			const float newScore = vertexScore(cachePos[v], remaining[v]);
+			const float delta = newScore - score[v];
+			score[v] = newScore;
+			const uint32_t* adj = adjacency.data() + adjOffset[v];
+			for (uint32_t a = 0; a < remaining[v]; a++)
+			{
+				const uint32_t t = adj[a];
+				triScore[t] += delta;
+				if (triScore[t] > bestScore)
+				{
+					bestScore = triScore[t];
+					best = t;
+				}
+			}
+		}
+		if (newCache.size() > ForsythCacheSize)
+			newCache.resize(ForsythCacheSize);
+		std::swap(cache, newCache);
+	}
+
+	std::memcpy(indices, result.data(), result.size() * sizeof(uint32_t));
+}
+
+void Astra::optimizeOverdraw(uint32_t* indices, size_t indexCount, const Vertex* vertices, size_t vertexCount, float threshold)
+{
+	const size_t triCount = indexCount / 3;
+	if (triCount < 2)
+		return;
+
+	// a cluster starts wherever the cache is flushed, so moving it around does not cost any extra misses
+	const std::vector<uint32_t> misses = simulateFifo(indices, indexCount, vertexCount, FifoCacheSize);
+	std::vector<size_t> hardBounds;
+	size_t totalMisses = 0;
+	for (size_t t = 0; t < triCount; t++)
+	{
+		if (t == 0 || misses[t] == 3)
+			hardBounds.push_back(t);
+		totalMisses += misses[t];
+	}
+	hardBounds.push_back(triCount);
+
+	// clusters are split further while they do well enough drawn on their own, starting with an empty cache
+	const float maxAcmr = threshold * static_cast<float>(totalMisses) / static_cast<float>(triCount);
+	std::vector<size_t> bounds;
+	std::vector<uint32_t> loadedAt(vertexCount, 0);
+	uint32_t time = FifoCacheSize + 1;
+	for (size_t h = 0; h + 1 < hardBounds.size(); h++)
+	{
+		size_t start = hardBounds[h];
+		size_t clusterMisses = 0;
+		bounds.push_back(start);
+		for (size_t t = start; t < hardBounds[h + 1]; t++)
+		{
+			for (int k = 0; k < 3; k++)
+			{
+				const uint32_t v = indices[t * 3 + k];
+				if (time - loadedAt[v] > FifoCacheSize)
+				{
+					loadedAt[v] = time++;
+					clusterMisses++;
+				}
+			}
+			if (t + 1 < hardBounds[h + 1] && clusterMisses <= maxAcmr * (t + 1 - start))
+			{
+				start = t + 1;
+				clusterMisses = 0;
+				bounds.push_back(start);
+				// moving the clock past the cache size empties it
+				time += FifoCacheSize + 1;
+			}
+		}
+		time += FifoCacheSize + 1;
+	}
+	bounds.push_back(triCount);
+	const size_t clusterCount = bounds.size() - 1;
+
+	// clusters facing away from the center are drawn first, they usually hide the rest
+	std::vector<glm::vec3> centroids(clusterCount, glm::vec3(0.0f));
+	std::vector<glm::vec3> normals(clusterCount, glm::vec3(0.0f));
+	std::vector<float> areas(clusterCount, 0.0f);
+	glm::vec3 meshCentroid(0.0f);
+	float meshArea = 0.0f;
+	for (size_t c = 0; c < clusterCount; c++)
+	{
+		for (size_t t = bounds[c]; t < bounds[c + 1]; t++)
+		{
+			const glm::vec3& p0 = vertices[indices[t * 3]].pos;
+			const glm::vec3& p1 = vertices[indices[t * 3 + 1]].pos;
+			const glm::vec3& p2 = vertices[indices[t * 3 + 2]].pos;
+			const glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+			const float area = glm::length(n);
+			centroids[c] += (p0 + p1 + p2) * (area / 3.0f);
+			normals[c] += n;
+			areas[c] += area;
+		}
+		meshCentroid += centroids[c];
+		meshArea += areas[c];
+		if (areas[c] > 0.0f)
+			centroids[c] /= areas[c];
+	}
+	if (meshArea > 0.0f)
+		meshCentroid /= meshArea;
+
+	std::vector<float> keys(clusterCount, 0.0f);
+	std::vector<size_t> order(clusterCount);
+	for (size_t c = 0; c < clusterCount; c++)
+	{
+		order[c] = c;
+		const float length = glm::length(normals[c]);
+		if (length > 0.0f)
+			keys[c] = glm::dot(centroids[c] - meshCentroid, normals[c] / length);
+	}
+	std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return keys[a] > keys[b]; });
+
+	std::vector<uint32_t> result;
+	result.reserve(triCount * 3);
+	for (size_t c : order)
+		result.insert(result.end(), indices + bounds[c] * 3, indices + bounds[c + 1] * 3);
+	std::memcpy(indices, result.data(), result.size() * sizeof(uint32_t));
+}
+
+size_t Astra::optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+{
+	std::vector<uint32_t> newIndex(vertices.size(), EmptySlot);
+	std::vector<Vertex> ordered;
+	ordered.reserve(vertices.size());
+	for (uint32_t& index : indices)
+	{
+		if (newIndex[index] == EmptySlot)
+		{
+			newIndex[index] = static_cast<uint32_t>(ordered.size());
+			ordered.push_back(vertices[index]);
+		}
+		index = newIndex[index];
+	}
+	vertices = std::move(ordered);
+	return vertices.size();
+}
+
+Astra::MeshOptimizationStats Astra::optimizeMesh(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, std::vector<int32_t>& materialIndices)
+{
+	MeshOptimizationStats stats;
+	const size_t triCount = indices.size() / 3;
+	if (triCount == 0)
+		return stats;
+	stats.acmrBefore = computeAcmr(indices.data(), triCount * 3, vertices.size(), FifoCacheSize);
+
+	// every material is drawn on its own, so triangles are only reordered inside their material.
+	// Triangles without material index use the first one, and extra indices are kept at the end
+	auto materialOf = [&](size_t t) { return t < materialIndices.size() ? materialIndices[t] : 0; };
+	std::vector<uint32_t> order(triCount);
+	for (size_t t = 0; t < triCount; t++)
+		order[t] = static_cast<uint32_t>(t);
+	std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return materialOf(a) < materialOf(b); });
+
+	std::vector<uint32_t> sorted(triCount * 3);
+	std::vector<int32_t> sortedMaterials(std::max(triCount, materialIndices.size()));
+	std::vector<size_t> groups;
+	for (size_t t = 0; t < triCount; t++)
+	{
+		std::memcpy(&sorted[t * 3], &indices[order[t] * 3], 3 * sizeof(uint32_t));
+		sortedMaterials[t] = materialOf(order[t]);
+		if (t == 0 || sortedMaterials[t] != sortedMaterials[t - 1])
+			groups.push_back(t);
+	}
+	groups.push_back(triCount);
+	std::copy(materialIndices.begin() + std::min(triCount, materialIndices.size()), materialIndices.end(), sortedMaterials.begin() + triCount);
+
+	AstraThreads.parallelFor(groups.size() - 1, [&](size_t begin, size_t end)
+		{
+			for (size_t g = begin; g < end; g++)
+			{
+				uint32_t* groupIndices = sorted.data() + groups[g] * 3;
+				const size_t groupIndexCount = (groups[g + 1] - groups[g]) * 3;
+
+				// compact local vertex ids keep the work proportional to the group
+				std::unordered_map<uint32_t, uint32_t> toLocal;
+				std::vector<uint32_t> toGlobal;
+				std::vector<Vertex> localVertices;
+				std::vector<uint32_t> local(groupIndexCount);
+				for (size_t i = 0; i < groupIndexCount; i++)
+				{
+					auto it = toLocal.emplace(groupIndices[i], static_cast<uint32_t>(toGlobal.size()));
+					if (it.second)
+					{
+						toGlobal.push_back(groupIndices[i]);
+						localVertices.push_back(vertices[groupIndices[i]]);
+					}
+					local[i] = it.first->second;
+				}
+
+				optimizeVertexCache(local.data(), groupIndexCount, toGlobal.size());
+				optimizeOverdraw(local.data(), groupIndexCount, localVertices.data(), localVertices.size());
+
+				for (size_t i = 0; i < groupIndexCount; i++)
+					groupIndices[i] = toGlobal[local[i]];
+			}
+		}, 1);
+
+	indices = std::move(sorted);
+	materialIndices = std::move(sortedMaterials);
+	optimizeVertexFetch(vertices, indices);
+	stats.acmrAfter = computeAcmr(indices.data(), indices.size(), vertices.size(), FifoCacheSize);
+	return stats;
+}
+
+namespace
+{
+	constexpr size_t MinMeshletBatch = 256;
+	// below this the triangles face too many directions for the cone to cull anything
+	constexpr float MinConeDot = 0.1f;
+
+	void computeMeshletBounds(Meshlet& meshlet, const Vertex* vertices, const uint32_t* indices)
+	{
+		const uint32_t* tris = indices + static_cast<size_t>(meshlet.firstTriangle) * 3;
+		glm::vec3 lo(FLT_MAX), hi(-FLT_MAX);
+		for (uint32_t i = 0; i < meshlet.triangleCount * 3; i++)
+		{
+			lo = glm::min(lo, vertices[tris[i]].pos);
+			hi = glm::max(hi, vertices[tris[i]].pos);
+		}
+		meshlet.center = (lo + hi) * 0.5f;
+		float radius2 = 0.0f;
+		for (uint32_t i = 0; i < meshlet.triangleCount * 3; i++)
+		{
+			const glm::vec3 d = vertices[tris[i]].pos - meshlet.center;
+			radius2 = std::max(radius2, glm::dot(d, d));
+		}
+		meshlet.radius = std::sqrt(radius2);
+
+		// a cutoff of 1 never culls
+		meshlet.coneApex = meshlet.center;
+		meshlet.coneAxis = glm::vec3(0.0f, 0.0f, 1.0f);
+		meshlet.coneCutoff = 1.0f;
+
+		glm::vec3 normals[MESHLET_MAX_TRIANGLES];
+		glm::vec3 axis(0.0f);
+		for (uint32_t t = 0; t < meshlet.triangleCount; t++)
+		{
+			const glm::vec3& p0 = vertices[tris[t * 3]].pos;
+			const glm::vec3 n = glm::cross(vertices[tris[t * 3 + 1]].pos - p0, vertices[tris[t * 3 + 2]].pos - p0);
+			const float length = glm::length(n);
+			normals[t] = length > 0.0f ? n / length : glm::vec3(0.0f);
+			axis += normals[t];
+		}
+		const float axisLength = glm::length(axis);
+		if (axisLength == 0.0f)
+			return;
+		axis /= axisLength;
+
+		float minDot = 1.0f;
+		for (uint32_t t = 0; t < meshlet.triangleCount; t++)
+		{
+			if (normals[t] != glm::vec3(0.0f))
+				minDot = std::min(minDot, glm::dot(normals[t], axis));
+		}
+		if (minDot <= MinConeDot)
+			return;
+
+		// the apex goes back along the axis until every triangle plane is in front of it
+		float maxT = 0.0f;
+		for (uint32_t t = 0; t < meshlet.triangleCount; t++)
+		{
+			if (normals[t] == glm::vec3(0.0f))
+				continue;
+			const glm::vec3& p0 = vertices[tris[t * 3]].pos;
+			maxT = std::max(maxT, glm::dot(meshlet.center - p0, normals[t]) / glm::dot(normals[t], axis));
+		}
+		meshlet.coneApex = meshlet.center - axis * maxT;
+		meshlet.coneAxis = axis;
+		meshlet.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+	}
+}
+
+std::vector<Meshlet> Astra::buildMeshlets(const Vertex* vertices, size_t vertexCount, const uint32_t* indices, size_t indexCount)
+{
+	std::vector<Meshlet> meshlets;
+	const size_t triCount = indexCount / 3;
+	if (triCount == 0)
+		return meshlets;
+
+	// the triangles are already sorted for the vertex cache, so taking them in order keeps the meshlets compact
+	std::vector<uint32_t> lastMeshlet(vertexCount, EmptySlot);
+	auto newVertices = [&](size_t t, uint32_t meshlet)
+		{
+			const uint32_t* tri = indices + t * 3;
+			uint32_t count = 0;
+			for (int k = 0; k < 3; k++)
+			{
+				const bool repeated = (k > 0 && tri[k] == tri[0]) || (k > 1 && tri[k] == tri[1]);
+				if (lastMeshlet[tri[k]] != meshlet && !repeated)
+					count++;
+			}
+			return count;
+		};
+
+	Meshlet current{};
+	for (size_t t = 0; t < triCount; t++)
+	{
+		uint32_t id = static_cast<uint32_t>(meshlets.size());
+		uint32_t added = newVertices(t, id);
+		if (current.triangleCount == MESHLET_MAX_TRIANGLES || current.vertexCount + added > MESHLET_MAX_VERTICES)
+		{
+			meshlets.push_back(current);
+			current = {};
+			current.firstTriangle = static_cast<uint32_t>(t);
+			id++;
+			added = newVertices(t, id);
+		}
+		for (int k = 0; k < 3; k++)
+			lastMeshlet[indices[t * 3 + k]] = id;
+		current.vertexCount += added;
+		current.triangleCount++;
+	}
+	meshlets.push_back(current);
+
+	AstraThreads.parallelFor(meshlets.size(), [&](size_t begin, size_t end)
+		{
+			for (size_t m = begin; m < end; m++)
+				computeMeshletBounds(meshlets[m], vertices, indices);
+		}, MinMeshletBatch);
+	return meshlets;
+}
+
+namespace
+{
+	constexpr size_t MinCollapseBatch = 16 * 1024;
+	// borders are kept in place with planes this many times stronger than the surface
+	constexpr double BorderWeight = 10.0;
+	constexpr int MaxSimplifyPasses = 64;
+	// a level that keeps more than this fraction of the previous one is not worth it
+	constexpr float MinLodReduction = 0.9f;
+
+	struct Quadric
+	{
+		double a00{ 0 }, a01{ 0 }, a02{ 0 }, a03{ 0 }, a11{ 0 }, a12{ 0 }, a13{ 0 }, a22{ 0 }, a23{ 0 }, a33{ 0 };
+		double weight{ 0 };
+
+		void addPlane(const glm::dvec3& n, double d, double w)
+		{
+			a00 += w * n.x * n.x;
+			a01 += w * n.x * n.y;
+			a02 += w * n.x * n.z;
+			a03 += w * n.x * d;
+			a11 += w * n.y * n.y;
+			a12 += w * n.y * n.z;
+			a13 += w * n.y * d;
+			a22 += w * n.z * n.z;
+			a23 += w * n.z * d;
+			a33 += w * d * d;
+			weight += w;
+		}
+
+		void add(const Quadric& q)
+		{
+			a00 += q.a00;
+			a01 += q.a01;
+			a02 += q.a02;
+			a03 += q.a03;
+			a11 += q.a11;
+			a12 += q.a12;
+			a13 += q.a13;
+			a22 += q.a22;
+			a23 += q.a23;
+			a33 += q.a33;
+			weight += q.weight;
+		}
+
+		// weighted sum of squared distances to the planes
+		double evaluate(const glm::dvec3& p) const
+		{
+			return a00 * p.x * p.x + 2.0 * (a01 * p.x * p.y + a02 * p.x * p.z + a03 * p.x) +
+				a11 * p.y * p.y + 2.0 * (a12 * p.y * p.z + a13 * p.y) +
+				a22 * p.z * p.z + 2.0 * a23 * p.z + a33;
+		}
+	};
+
+	struct Collapse
+	{
+		uint32_t from;
+		uint32_t to;
+		double cost;
+	};
+
+	struct PositionKey
+	{
+		uint32_t bits[3];
+
+		bool operator==(const PositionKey& other) const
+		{
+			return bits[0] == other.bits[0] && bits[1] == other.bits[1] && bits[2] == other.bits[2];
+		}
+	};
+
+	struct PositionHash
+	{
+		size_t operator()(const PositionKey& key) const
+		{
+			uint64_t h = (static_cast<uint64_t>(key.bits[0]) * 0x9E3779B97F4A7C15ull) ^ (static_cast<uint64_t>(key.bits[1]) * 0xC2B2AE3D27D4EB4Full) ^ key.bits[2];
+			h ^= h >> 33;
+			h *= 0xFF51AFD7ED558CCDull;
+			h ^= h >> 33;
+			return static_cast<size_t>(h);
+		}
+	};
+
+	PositionKey positionKey(const glm::vec3& p)
+	{
+		PositionKey key;
+		for (int c = 0; c < 3; c++)
+		{
+			const float value = p[c] == 0.0f ? 0.0f : p[c];
+			std::memcpy(&key.bits[c], &value, sizeof(float));
+		}
+		return key;
+	}
+}
+
+float Astra::simplifyMesh(const Vertex* vertices, size_t vertexCount, const uint32_t* indices, size_t indexCount, size_t targetIndexCount,
+	std::vector<uint32_t>& outIndices, std::vector<uint32_t>& outTriangles)
+{
+	outIndices.clear();
+	outTriangles.clear();
+	const size_t triCount = indexCount / 3;
+	const size_t targetTris = targetIndexCount / 3;
+
+	// the collapses work on positions, seams are separate vertices in the same place
+	std::vector<uint32_t> canonical(vertexCount);
+	{
+		std::unordered_map<PositionKey, uint32_t, PositionHash> first;
+		first.reserve(vertexCount);
+		for (size_t v = 0; v < vertexCount; v++)
+			canonical[v] = first.emplace(positionKey(vertices[v].pos), static_cast<uint32_t>(v)).first->second;
+	}
+	auto position = [&](uint32_t v) { return glm::dvec3(vertices[v].pos); };
+
+	std::vector<uint32_t> tris;
+	std::vector<uint32_t> origins;
+	tris.reserve(triCount * 3);
+	origins.reserve(triCount);
+	for (size_t t = 0; t < triCount; t++)
+	{
+		const uint32_t a = canonical[indices[t * 3]], b = canonical[indices[t * 3 + 1]], c = canonical[indices[t * 3 + 2]];
+		if (a == b || b == c || a == c)
+			continue;
+		tris.insert(tris.end(), { a, b, c });
+		origins.push_back(static_cast<uint32_t>(t));
+	}
+
+	// plane quadrics weighted by area, plus perpendicular planes on the borders so they keep their shape
+	std::vector<Quadric> quadrics(vertexCount);
+	std::vector<std::pair<uint64_t, uint32_t>> edges;
+	edges.reserve(tris.size());
+	for (size_t t = 0; t < tris.size() / 3; t++)
+	{
+		const glm::dvec3 p0 = position(tris[t * 3]), p1 = position(tris[t * 3 + 1]), p2 = position(tris[t * 3 + 2]);
+		glm::dvec3 n = glm::cross(p1 - p0, p2 - p0);
+		const double length = glm::length(n);
+		if (length == 0.0)
+			continue;
+		n /= length;
+		for (int k = 0; k < 3; k++)
+		{
+			quadrics[tris[t * 3 + k]].addPlane(n, -glm::dot(n, p0), length * 0.5);
+			const uint32_t a = tris[t * 3 + k], b = tris[t * 3 + (k + 1) % 3];
+			edges.emplace_back((static_cast<uint64_t>(std::min(a, b)) << 32) | std::max(a, b), static_cast<uint32_t>(t * 3 + k));
+		}
+	}
+	std::sort(edges.begin(), edges.end());
+	for (size_t e = 0; e < edges.size(); e++)
+	{
+		const bool shared = (e > 0 && edges[e - 1].first == edges[e].first) || (e + 1 < edges.size() && edges[e + 1].first == edges[e].first);
+		if (shared)
+			continue;
+		const size_t t = edges[e].second / 3;
+		const uint32_t k = edges[e].second % 3;
+		const uint32_t a = tris[t * 3 + k], b = tris[t * 3 + (k + 1) % 3];
+		const glm::dvec3 p0 = position(tris[t * 3]), p1 = position(tris[t * 3 + 1]), p2 = position(tris[t * 3 + 2]);
+		const glm::dvec3 edge = position(b) - position(a);
+		const glm::dvec3 border = glm::cross(edge, glm::cross(p1 - p0, p2 - p0));
+		const double length = glm::length(border);
+		if (length == 0.0)
+			continue;
+		const glm::dvec3 n = border / length;
+		const double weight = BorderWeight * glm::dot(edge, edge);
+		quadrics[a].addPlane(n, -glm::dot(n, position(a)), weight);
+		quadrics[b].addPlane(n, -glm::dot(n, position(a)), weight);
+	}
+
+	std::vector<uint32_t> collapsedTo(vertexCount);
+	for (size_t v = 0; v < vertexCount; v++)
+		collapsedTo[v] = static_cast<uint32_t>(v);
+	std::vector<uint32_t> lockedPass(vertexCount, 0);
+	double maxCost = 0.0;
+
+	for (int pass = 1; pass <= MaxSimplifyPasses && tris.size() / 3 > targetTris; pass++)
+	{
+		const size_t liveTris = tris.size() / 3;
+
+		std::vector<uint64_t> keys;
+		keys.reserve(tris.size());
+		for (size_t t = 0; t < liveTris; t++)
+		{
+			for (int k = 0; k < 3; k++)
+			{
+				const uint32_t a = tris[t * 3 + k], b = tris[t * 3 + (k + 1) % 3];
+				keys.push_back((static_cast<uint64_t>(std::min(a, b)) << 32) | std::max(a, b));
+			}
+		}
+		std::sort(keys.begin(), keys.end());
+		keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+		// every edge goes in the cheaper direction, the merged quadric measured at the vertex that stays
+		std::vector<Collapse> collapses(keys.size());
+		AstraThreads.parallelFor(keys.size(), [&](size_t begin, size_t end)
+			{
+				for (size_t e = begin; e < end; e++)
+				{
+					const uint32_t a = static_cast<uint32_t>(keys[e] >> 32), b = static_cast<uint32_t>(keys[e] & 0xFFFFFFFFu);
+					Quadric q = quadrics[a];
+					q.add(quadrics[b]);
+					const double weight = std::max(q.weight, 1e-30);
+					const double toB = std::max(q.evaluate(position(b)), 0.0) / weight;
+					const double toA = std::max(q.evaluate(position(a)), 0.0) / weight;
+					collapses[e] = toB <= toA ? Collapse{ a, b, toB } : Collapse{ b, a, toA };
+				}
+			}, MinCollapseBatch);
+		std::sort(collapses.begin(), collapses.end(), [](const Collapse& x, const Collapse& y) { return x.cost < y.cost; });
+
+		// triangles around every vertex, to check the collapses do not flip any of them
+		std::vector<uint32_t> adjOffset(vertexCount + 1, 0);
+		for (uint32_t v : tris)
+			adjOffset[v + 1]++;
+		for (size_t v = 0; v < vertexCount; v++)
+			adjOffset[v + 1] += adjOffset[v];
+		std::vector<uint32_t> adjacency(tris.size());
+		{
+			std::vector<uint32_t> fill(adjOffset.begin(), adjOffset.end() - 1);
+			for (size_t i = 0; i < tris.size(); i++)
+				adjacency[fill[tris[i]]++] = static_cast<uint32_t>(i / 3);
+		}
+
+		// collapses in the same pass never touch the same triangle, so they can all be checked against the current mesh
+		size_t removed = 0;
+		size_t applied = 0;
+		for (const Collapse& c : collapses)
+		{
+			if (liveTris - removed <= targetTris)
+				break;
+			if (lockedPass[c.from] == static_cast<uint32_t>(pass) || lockedPass[c.to] == static_cast<uint32_t>(pass))
+				continue;
+
+			bool flips = false;
+			size_t lost = 0;
+			for (uint32_t a = adjOffset[c.from]; a < adjOffset[c.from + 1] && !flips; a++)
+			{
+				const uint32_t* tri = &tris[adjacency[a] * 3];
+				if (tri[0] == c.to || tri[1] == c.to || tri[2] == c.to)
+				{
+					lost++;
+					continue;
+				}
+				glm::dvec3 p[3] = { position(tri[0]), position(tri[1]), position(tri[2]) };
+				const glm::dvec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+				for (int k = 0; k < 3; k++)
+				{
+					if (tri[k] == c.from)
+						p[k] = position(c.to);
+				}
+				const glm::dvec3 after = glm::cross(p[1] - p[0], p[2] - p[0]);
+				flips = glm::dot(before, after) <= 0.0;
+			}
+			if (flips)
+				continue;
+
+			for (uint32_t a = adjOffset[c.from]; a < adjOffset[c.from + 1]; a++)
+			{
+				const uint32_t* tri = &tris[adjacency[a] * 3];
+				for (int k = 0; k < 3; k++)
+					lockedPass[tri[k]] = static_cast<uint32_t>(pass);
+			}
+			collapsedTo[c.from] = c.to;
+			quadrics[c.to].add(quadrics[c.from]);
+			maxCost = std::max(maxCost, c.cost);
+			removed += lost;
+			applied++;
+		}
+		if (applied == 0)
+			break;
+
+		// the targets are locked, so one step is enough
+		size_t out = 0;
+		for (size_t t = 0; t < liveTris; t++)
+		{
+			const uint32_t a = collapsedTo[tris[t * 3]], b = collapsedTo[tris[t * 3 + 1]], c = collapsedTo[tris[t * 3 + 2]];
+			if (a == b || b == c || a == c)
+				continue;
+			tris[out * 3] = a;
+			tris[out * 3 + 1] = b;
+			tris[out * 3 + 2] = c;
+			origins[out] = origins[t];
+			out++;
+		}
+		tris.resize(out * 3);
+		origins.resize(out);
+	}
+
+	// back to real vertices: a corner keeps its vertex if it did not move,
+	// otherwise it takes the vertex at the new position with the closest normal
+	std::vector<uint32_t> groupOffset(vertexCount + 1, 0);
+	for (size_t v = 0; v < vertexCount; v++)
+		groupOffset[canonical[v] + 1]++;
+	for (size_t v = 0; v < vertexCount; v++)
+		groupOffset[v + 1] += groupOffset[v];
+	std::vector<uint32_t> groups(vertexCount);
+	{
+		std::vector<uint32_t> fill(groupOffset.begin(), groupOffset.end() - 1);
+		for (size_t v = 0; v < vertexCount; v++)
+			groups[fill[canonical[v]]++] = static_cast<uint32_t>(v);
+	}
+
+	outIndices.resize(tris.size());
+	outTriangles = origins;
+	for (size_t t = 0; t < origins.size(); t++)
+	{
+		for (int k = 0; k < 3; k++)
+		{
+			const uint32_t original = indices[origins[t] * 3 + k];
+			const uint32_t target = tris[t * 3 + k];
+			if (canonical[original] == target)
+			{
+				outIndices[t * 3 + k] = original;
+				continue;
+			}
+			uint32_t best = target;
+			float bestDot = -FLT_MAX;
+			for (uint32_t g = groupOffset[target]; g < groupOffset[target + 1]; g++)
+			{
+				const float d = glm::dot(vertices[groups[g]].nrm, vertices[original].nrm);
+				if (d > bestDot)
+				{
+					bestDot = d;
+					best = groups[g];
+				}
+			}
+			outIndices[t * 3 + k] = best;
+		}
+	}
+	return static_cast<float>(std::sqrt(maxCost));
+}
+
+std::vector<Astra::MeshLod> Astra::buildLodChain(const Vertex* vertices, size_t vertexCount, const uint32_t* indices, size_t indexCount, uint32_t lodCount, float reduction,
+	std::vector<uint32_t>& lodIndices, std::vector<uint32_t>& lodTriangles)
+{
+	std::vector<MeshLod> lods;
+	lodIndices.clear();
+	lodTriangles.clear();
+
+	std::vector<uint32_t> source(indices, indices + indexCount);
+	std::vector<uint32_t> sourceTriangles(indexCount / 3);
+	for (size_t t = 0; t < sourceTriangles.size(); t++)
+		sourceTriangles[t] = static_cast<uint32_t>(t);
+	float error = 0.0f;
+
+	for (uint32_t l = 0; l < lodCount; l++)
+	{
+		const size_t target = static_cast<size_t>(source.size() / 3 * reduction) * 3;
+		std::vector<uint32_t> simplified, triangles;
+		// the levels are built one from another, so the errors add up
+		error += simplifyMesh(vertices, vertexCount, source.data(), source.size(), target, simplified, triangles);
+		if (simplified.empty() || simplified.size() > source.size() * MinLodReduction)
+			break;
+
+		for (uint32_t& t : triangles)
+			t = sourceTriangles[t];
+
+		MeshLod lod;
+		lod.firstIndex = static_cast<uint32_t>(lodIndices.size());
+		lod.indexCount = static_cast<uint32_t>(simplified.size());
+		lod.error = error;
+		lods.push_back(lod);
+		lodIndices.insert(lodIndices.end(), simplified.begin(), simplified.end());
+		lodTriangles.insert(lodTriangles.end(), triangles.begin(), triangles.end());
+
+		source = std::move(simplified);
+		sourceTriangles = std::move(triangles);
+	}
+	return lods;
+}
+
+namespace
+{
+	// below this many triangles or vertices the work is not split between threads
+	constexpr size_t MinGeometryBatch = 16 * 1024;
+
+	// Abramowitz and Stegun 4.4.45, within 7e-5 radians, plenty for weights
+	float fastAcos(float x)
+	{
+		const float a = std::abs(x);
+		const float r = std::sqrt(1.0f - a) * (1.5707288f + a * (-0.2121144f + a * (0.0742610f - 0.0187293f * a)));
+		return x >= 0.0f ? r : glm::pi<float>() - r;
+	}
+
+	// angle of the triangle at every corner
+	glm::vec3 cornerAngles(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2)
+	{
+		auto angle = [](const glm::vec3& a, const glm::vec3& b)
+		{
+			const float l2 = glm::dot(a, a) * glm::dot(b, b);
+			if (l2 == 0.0f)
+				return 0.0f;
+			return fastAcos(glm::clamp(glm::dot(a, b) / std::sqrt(l2), -1.0f, 1.0f));
+		};
+		return glm::vec3(angle(p1 - p0, p2 - p0), angle(p2 - p1, p0 - p1), angle(p0 - p2, p1 - p2));
+	}
+
+	// sphere around the box center, from the positions of [begin, end) given by at()
+	template <typename Position>
+	float maxDistance2(const glm::vec3& center, size_t begin, size_t end, const Position& at)
+	{
+		float r2 = 0.0f;
+		for (size_t i = begin; i < end; i++)
+		{
+			const glm::vec3 d = at(i) - center;
+			r2 = std::max(r2, glm::dot(d, d));
+		}
+		return r2;
+	}
+}
+
+void Astra::computeSmoothNormals(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, float creaseAngle, const uint32_t* positionIds)
+{
+	const size_t cornerCount = indices.size() / 3 * 3;
+	const size_t triCount = cornerCount / 3;
+	auto& pool = AstraThreads;
+
+	// corners sharing a vertex may get different normals, the loaders already give one vertex per corner
+	std::atomic<bool> perCorner{ vertices.size() == cornerCount };
+	if (perCorner)
+	{
+		pool.parallelFor(cornerCount, [&](size_t begin, size_t end)
+			{
+				for (size_t c = begin; c < end && perCorner; c++)
+				{
+					if (indices[c] != c)
+						perCorner = false;
+				}
+			}, MinGeometryBatch);
+	}
+	std::vector<Vertex> expanded;
+	if (!perCorner)
+	{
+		expanded.resize(cornerCount);
+		pool.parallelFor(cornerCount, [&](size_t begin, size_t end)
+			{
+				for (size_t c = begin; c < end; c++)
+					expanded[c] = vertices[indices[c]];
+			}, MinGeometryBatch);
+	}
+	Vertex* corners = perCorner ? vertices.data() : expanded.data();
+
+	// normal and angle weights of every triangle
+	std::vector<glm::vec3> faceNormals(triCount);
+	std::vector<glm::vec3> angles(triCount);
+	pool.parallelFor(triCount, [&](size_t begin, size_t end)
+		{
+			for (size_t t = begin; t < end; t++)
+			{
+				const glm::vec3& p0 = corners[t * 3].pos;
+				const glm::vec3& p1 = corners[t * 3 + 1].pos;
+				const glm::vec3& p2 = corners[t * 3 + 2].pos;
+				const glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+				const float length = glm::length(n);
+				faceNormals[t] = length > 0.0f ? n / length : glm::vec3(0.0f);
+				angles[t] = cornerAngles(p0, p1, p2);
+			}
+		}, MinGeometryBatch);
+
+	// corners in the same place share a group: the id given by the loader or the first corner with that position
+	std::vector<uint32_t> group(cornerCount);
+	size_t groupCount = 0;
+	if (positionIds != nullptr)
+	{
+		std::mutex maxMutex;
+		pool.parallelFor(cornerCount, [&](size_t begin, size_t end)
+			{
+				uint32_t maxId = 0;
+				for (size_t c = begin; c < end; c++)
+				{
+					group[c] = positionIds[perCorner ? c : indices[c]];
+					maxId = std::max(maxId, group[c]);
+				}
+				std::lock_guard<std::mutex> lock(maxMutex);
+				groupCount = std::max<size_t>(groupCount, static_cast<size_t>(maxId) + 1);
+			}, MinGeometryBatch);
+	}
+	else
+	{
+		std::vector<uint64_t> hashes(cornerCount);
+		pool.parallelFor(cornerCount, [&](size_t begin, size_t end)
+			{
+				for (size_t c = begin; c < end; c++)
+					hashes[c] = PositionHash()(positionKey(corners[c].pos));
+			}, MinGeometryBatch);
+		findFirstEqual(hashes, [&](uint32_t a, uint32_t b) { return positionKey(corners[a].pos) == positionKey(corners[b].pos); }, group);
+		groupCount = cornerCount;
+	}
+
+	// corners of every group, filled in parallel and sorted so the sums do not depend on the threads
+	std::vector<std::atomic<uint32_t>> groupSize(groupCount);
+	pool.parallelFor(groupCount, [&](size_t begin, size_t end)
+		{
+			for (size_t g = begin; g < end; g++)
+				groupSize[g].store(0, std::memory_order_relaxed);
+		}, MinGeometryBatch);
+	pool.parallelFor(cornerCount, [&](size_t begin, size_t end)
+		{
+			for (size_t c = begin; c < end; c++)
+				groupSize[group[c]].fetch_add(1, std::memory_order_relaxed);
+		}, MinGeometryBatch);
+	std::vector<uint32_t> groupOffset(groupCount + 1, 0);
+	for (size_t g = 0; g < groupCount; g++)
+	{
+		groupOffset[g + 1] = groupOffset[g] + groupSize[g].load(std::memory_order_relaxed);
+		groupSize[g].store(groupOffset[g], std::memory_order_relaxed);
+	}
+	std::vector<uint32_t> members(cornerCount);
+	pool.parallelFor(cornerCount, [&](size_t begin, size_t end)
+		{
+			for (size_t c = begin; c < end; c++)
+				members[groupSize[group[c]].fetch_add(1, std::memory_order_relaxed)] = static_cast<uint32_t>(c);
+		}, MinGeometryBatch);
+	pool.parallelFor(groupCount, [&](size_t begin, size_t end)
+		{
+			for (size_t g = begin; g < end; g++)
+				std::sort(members.begin() + groupOffset[g], members.begin() + groupOffset[g + 1]);
+		}, MinGeometryBatch);
+
+	// the faces of every group are clustered once: each one joins the first cluster whose first face is within the crease angle,
+	// and every corner takes the angle weighted sum of its cluster. Degenerate faces have no direction and take the first cluster
+	const float minCos = std::cos(glm::radians(creaseAngle));
+	constexpr uint32_t NoCluster = std::numeric_limits<uint32_t>::max();
+	pool.parallelFor(groupCount, [&](size_t begin, size_t end)
+		{
+			std::vector<glm::vec3> axes; // first face of every cluster
+			std::vector<glm::vec3> sums;
+			std::vector<uint32_t> cluster;
+			for (size_t g = begin; g < end; g++)
+			{
+				const uint32_t first = groupOffset[g];
+				const uint32_t last = groupOffset[g + 1];
+				axes.clear();
+				sums.clear();
+				cluster.resize(last - first);
+				for (uint32_t m = first; m < last; m++)
+				{
+					const uint32_t c = members[m];
+					const glm::vec3& face = faceNormals[c / 3];
+					if (face == glm::vec3(0.0f))
+					{
+						cluster[m - first] = NoCluster;
+						continue;
+					}
+					uint32_t k = 0;
+					while (k < axes.size() && glm::dot(axes[k], face) < minCos)
+						k++;
+					if (k == axes.size())
+					{
+						axes.push_back(face);
+						sums.push_back(glm::vec3(0.0f));
+					}
+					sums[k] += face * angles[c / 3][c % 3];
+					cluster[m - first] = k;
+				}
+				for (uint32_t m = first; m < last; m++)
+				{
+					const uint32_t c = members[m];
+					const uint32_t k = cluster[m - first] != NoCluster ? cluster[m - first] : 0;
+					const glm::vec3 n = k < sums.size() ? sums[k] : glm::vec3(0.0f);
+					const float length = glm::length(n);
+					corners[c].nrm = length > 0.0f ? n / length : faceNormals[c / 3];
+				}
+			}
+		}, MinGeometryBatch);
+
+	if (!perCorner)
+	{
+		vertices = std::move(expanded);
+		indices.resize(cornerCount);
+		for (size_t c = 0; c < cornerCount; c++)
+			indices[c] = static_cast<uint32_t>(c);
+	}
+}
+
+Astra::MeshBounds Astra::computeBounds(const Vertex* vertices, size_t vertexCount)
+{
+	MeshBounds bounds;
+	if (vertexCount == 0)
+		return bounds;
+
+	glm::vec3 lo(FLT_MAX), hi(-FLT_MAX);
+	std::mutex boundsMutex;
+	AstraThreads.parallelFor(vertexCount, [&](size_t begin, size_t end)
+		{
+			glm::vec3 l(FLT_MAX), h(-FLT_MAX);
+			for (size_t v = begin; v < end; v++)
+			{
+				l = glm::min(l, vertices[v].pos);
+				h = glm::max(h, vertices[v].pos);
+			}
+			std::lock_guard<std::mutex> lock(boundsMutex);
+			lo = glm::min(lo, l);
+			hi = glm::max(hi, h);
+		}, MinGeometryBatch);
+	bounds.min = lo;
+	bounds.max = hi;
+	bounds.center = (lo + hi) * 0.5f;
+	bounds.valid = true;
+
+	float radius2 = 0.0f;
+	AstraThreads.parallelFor(vertexCount, [&](size_t begin, size_t end)
+		{
+			const float r2 = maxDistance2(bounds.center, begin, end, [vertices](size_t v) { return vertices[v].pos; });
+			std::lock_guard<std::mutex> lock(boundsMutex);
+			radius2 = std::max(radius2, r2);
+		}, MinGeometryBatch);
+	bounds.radius = std::sqrt(radius2);
+	return bounds;
+}
+
+std::vector<Astra::MeshBounds> Astra::computeSubmeshBounds(const Vertex* vertices, const uint32_t* indices, size_t indexCount, const int32_t* materialIndices,
+	size_t materialIndexCount, size_t materialCount)
+{
+	std::vector<MeshBounds> bounds(materialCount);
+	const size_t triCount = indexCount / 3;
+	if (materialCount == 0 || triCount == 0)
+		return bounds;
+
+	auto materialOf = [&](size_t t)
+	{
+		const int32_t m = t < materialIndexCount ? materialIndices[t] : 0;
+		return m >= 0 && static_cast<size_t>(m) < materialCount ? static_cast<size_t>(m) : 0;
+	};
+
+	// every batch keeps its own boxes and merges them at the end
+	std::vector<glm::vec3> lo(materialCount, glm::vec3(FLT_MAX)), hi(materialCount, glm::vec3(-FLT_MAX));
+	std::mutex boundsMutex;
+	AstraThreads.parallelFor(triCount, [&](size_t begin, size_t end)
+		{
+			std::vector<glm::vec3> l(materialCount, glm::vec3(FLT_MAX)), h(materialCount, glm::vec3(-FLT_MAX));
+			for (size_t t = begin; t < end; t++)
+			{
+				const size_t m = materialOf(t);
+				for (int k = 0; k < 3; k++)
+				{
+					l[m] = glm::min(l[m], vertices[indices[t * 3 + k]].pos);
+					h[m] = glm::max(h[m], vertices[indices[t * 3 + k]].pos);
+				}
+			}
+			std::lock_guard<std::mutex> lock(boundsMutex);
+			for (size_t m = 0; m < materialCount; m++)
+			{
+				lo[m] = glm::min(lo[m], l[m]);
+				hi[m] = glm::max(hi[m], h[m]);
+			}
+		}, MinGeometryBatch);
+	for (size_t m = 0; m < materialCount; m++)
+	{
+		bounds[m].valid = lo[m].x <= hi[m].x;
+		if (!bounds[m].valid)
+			continue;
+		bounds[m].min = lo[m];
+		bounds[m].max = hi[m];
+		bounds[m].center = (lo[m] + hi[m]) * 0.5f;
+	}
+
+	std::vector<float> radius2(materialCount, 0.0f);
+	AstraThreads.parallelFor(triCount, [&](size_t begin, size_t end)
+		{
+			std::vector<float> r2(materialCount, 0.0f);
+			for (size_t t = begin; t < end; t++)
+			{
+				const size_t m = materialOf(t);
+				r2[m] = std::max(r2[m], maxDistance2(bounds[m].center, t * 3, t * 3 + 3, [indices, vertices](size_t i) { return vertices[indices[i]].pos; }));
+			}
+			std::lock_guard<std::mutex> lock(boundsMutex);
+			for (size_t m = 0; m < materialCount; m++)
+				radius2[m] = std::max(radius2[m], r2[m]);
+		}, MinGeometryBatch);
+	for (size_t m = 0; m < materialCount; m++)
+		bounds[m].radius = std::sqrt(radius2[m]);
+	return bounds;
+}
@@ -0,0 +1,163 @@
+#include <MipGenerator.h>
+#include <ThreadPool.h>
+#include <Utils.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define ASTRA_MIPS_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#define ASTRA_TARGET_AVX2
+#else
+#define ASTRA_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace
+{
+	constexpr size_t EncodeTableSize = 16384;
+	// below this many rows a level is not split between threads
+	constexpr size_t MinRowBatch = 16;
+
+	struct SrgbTables
+	{
+		float toLinear[256];
+		uint8_t toSrgb[EncodeTableSize];
+
+		SrgbTables()
+		{
+			for (int i = 0; i < 256; i++)
+			{
+				const float c = i / 255.0f;
+				toLinear[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+			}
+			for (size_t i = 0; i < EncodeTableSize; i++)
+			{
+				const float l = static_cast<float>(i) / (EncodeTableSize - 1);
+				const float c = l <= 0.0031308f ? l * 12.92f : 1.055f * std::pow(l, 1.0f / 2.4f) - 0.055f;
+				toSrgb[i] = static_cast<uint8_t>(std::lround(std::clamp(c, 0.0f, 1.0f) * 255.0f));
+			}
+		}
+	};
+
+	const SrgbTables& getTables()
+	{
+		static const SrgbTables tables;
+		return tables;
+	}
+
+	// averages dst pixels [begin, end) of one row, rows and columns past the border are clamped
+	void downsampleRowScalar(const float* row0, const float* row1, uint32_t srcWidth, float* dst, uint32_t begin, uint32_t end)
+	{
+		for (uint32_t x = begin; x < end; x++)
+		{
+			const uint32_t x0 = std::min(2 * x, srcWidth - 1);
+			const uint32_t x1 = std::min(2 * x + 1, srcWidth - 1);
+			for (uint32_t c = 0; c < 4; c++)
+			{
+				// same order of additions as the AVX2 path, so both give the same bits
+				dst[x * 4 + c] = ((row0[x0 * 4 + c] + row1[x0 * 4 + c]) + (row0[x1 * 4 + c] + row1[x1 * 4 + c])) * 0.25f;
+			}
+		}
+	}
+
+#ifdef ASTRA_MIPS_X86
+	// two dst pixels per iteration, as long as their four source pixels are inside the row
+	ASTRA_TARGET_AVX2 uint32_t downsampleRowAvx2(const float* row0, const float* row1, uint32_t srcWidth, uint32_t dstWidth, float* dst)
+	{
+		const __m256 quarter = _mm256_set1_ps(0.25f);
+		uint32_t x = 0;
+		for (; x + 1 < dstWidth && 2 * x + 3 < srcWidth; x += 2)
+		{
+			const __m256 a = _mm256_add_ps(_mm256_loadu_ps(row0 + x * 8), _mm256_loadu_ps(row1 + x * 8));
+			const __m256 b = _mm256_add_ps(_mm256_loadu_ps(row0 + x * 8 + 8), _mm256_loadu_ps(row1 + x * 8 + 8));
+			// a = p0 p1, b = p2 p3 -> (p0 + p1, p2 + p3)
+			const __m256 even = _mm256_permute2f128_ps(a, b, 0x20);
+			const __m256 odd = _mm256_permute2f128_ps(a, b, 0x31);
+			_mm256_storeu_ps(dst + x * 4, _mm256_mul_ps(_mm256_add_ps(even, odd), quarter));
+		}
+		return x;
+	}
+#endif
+
+	void downsample(const std::vector<float>& src, uint32_t srcWidth, uint32_t srcHeight, std::vector<float>& dst, uint32_t dstWidth, uint32_t dstHeight, bool avx2)
+	{
+		dst.resize(static_cast<size_t>(dstWidth) * dstHeight * 4);
+		AstraThreads.parallelFor(dstHeight, [&](size_t begin, size_t end)
+			{
+				for (size_t y = begin; y < end; y++)
+				{
+					const float* row0 = src.data() + std::min<size_t>(2 * y, srcHeight - 1) * srcWidth * 4;
+					const float* row1 = src.data() + std::min<size_t>(2 * y + 1, srcHeight - 1) * srcWidth * 4;
+					float* out = dst.data() + y * dstWidth * 4;
+					uint32_t done = 0;
+#ifdef ASTRA_MIPS_X86
+					if (avx2)
+						done = downsampleRowAvx2(row0, row1, srcWidth, dstWidth, out);
+#endif
+					downsampleRowScalar(row0, row1, srcWidth, out, done, dstWidth);
+				}
+			}, MinRowBatch);
+	}
+
+	void encode(const std::vector<float>& linear, uint8_t* dst)
+	{
+		const SrgbTables& tables = getTables();
+		AstraThreads.parallelFor(linear.size() / 4, [&](size_t begin, size_t end)
+			{
+				for (size_t p = begin; p < end; p++)
+				{
+					for (size_t c = 0; c < 3; c++)
+					{
+						const float l = std::clamp(linear[p * 4 + c], 0.0f, 1.0f);
+						dst[p * 4 + c] = tables.toSrgb[static_cast<size_t>(l * (EncodeTableSize - 1) + 0.5f)];
+					}
+					dst[p * 4 + 3] = static_cast<uint8_t>(std::clamp(linear[p * 4 + 3], 0.0f, 1.0f) * 255.0f + 0.5f);
+				}
+			}, MinRowBatch * 256);
+	}
+}
+
+void Astra::generateMipChain(TextureData& data)
+{
+	if (data.isCompressed() || data.width == 0 || data.height == 0)
+		return;
+
+	const uint32_t levelCount = static_cast<uint32_t>(std::floor(std::log2(std::max(data.width, data.height)))) + 1;
+	std::vector<size_t> offsets;
+	size_t total = 0;
+	for (uint32_t level = 0; level < levelCount; level++)
+	{
+		offsets.push_back(total);
+		total += getTextureLevelSize(TextureFormat::RGBA8, data.getLevelWidth(level), data.getLevelHeight(level));
+	}
+	data.pixels.resize(total);
+	data.levelOffsets = std::move(offsets);
+	if (levelCount == 1)
+		return;
+
+	const SrgbTables& tables = getTables();
+	std::vector<float> current(getTextureLevelSize(TextureFormat::RGBA8, data.width, data.height));
+	const uint8_t* base = data.pixels.data();
+	AstraThreads.parallelFor(current.size() / 4, [&](size_t begin, size_t end)
+		{
+			for (size_t p = begin; p < end; p++)
+			{
+				current[p * 4] = tables.toLinear[base[p * 4]];
+				current[p * 4 + 1] = tables.toLinear[base[p * 4 + 1]];
+				current[p * 4 + 2] = tables.toLinear[base[p * 4 + 2]];
+				current[p * 4 + 3] = base[p * 4 + 3] / 255.0f;
+			}
+		}, MinRowBatch * 256);
+
+	const bool avx2 = Astra::hasAvx2();
+	std::vector<float> next;
+	for (uint32_t level = 1; level < levelCount; level++)
+	{
+		downsample(current, data.getLevelWidth(level - 1), data.getLevelHeight(level - 1), next, data.getLevelWidth(level), data.getLevelHeight(level), avx2);
+		encode(next, data.pixels.data() + data.levelOffsets[level]);
+		std::swap(current, next);
+	}
+}
@@ -0,0 +1,33 @@
+#include <ModelLoad.h>
+
+Astra::ModelLoad::ModelLoad(const std::string& path, const glm::mat4& transform, const std::function<void(int)>& onLoaded)
+	: _path(path), _transform(transform), _onLoaded(onLoaded)
+{
+	_future = _promise.get_future().share();
+}
+
+const std::string& Astra::ModelLoad::getPath() const
+{
+	return _path;
+}
+
+float Astra::ModelLoad::getProgress() const
+{
+	return _progress.load();
+}
+
+Astra::ModelLoadStatus Astra::ModelLoad::getStatus() const
+{
+	return _status.load();
+}
+
+std::shared_future<int> Astra::ModelLoad::getFuture() const
+{
+	return _future;
+}
+
+bool Astra::ModelLoad::isFinished() const
+{
+	const ModelLoadStatus status = _status.load();
+	return status == ModelLoadStatus::Done || status == ModelLoadStatus::Failed;
+}
@@ -5,15 +5,17 @@
 
 using namespace Astra;
 
-uint32_t Node3D::NodeCount = 0;
+std::atomic<uint32_t> Node3D::NodeCount{ 0 };
 
 Node3D::Node3D(const glm::mat4& transform_mat, const std::string& name) : _transform(transform_mat), _name(name)
 {
 	_id = NodeCount++;
+	// the identity is already split, anything else is decomposed when first needed
+	_trsDirty = transform_mat != glm::mat4(1.0f);
 
 	if (name.empty())
 	{
-		_name = std::string("Node3D - ") + std::to_string(Node3D::NodeCount);
+		_name = std::string("Node3D - ") + std::to_string(_id + 1);
 	}
 }
 
@@ -43,97 +45,119 @@ void Astra::Node3D::removeChild(const Node3D& child)
 		_children.erase(eraser);
 }
 
+void Astra::Node3D::composeMatrix() const
+{
+	// T * R * S without building the three matrices
+	const glm::mat3 rotation = glm::mat3_cast(_rotation);
+	_transform = glm::mat4(glm::vec4(rotation[0] * _scale.x, 0.0f), glm::vec4(rotation[1] * _scale.y, 0.0f), glm::vec4(rotation[2] * _scale.z, 0.0f), glm::vec4(_position, 1.0f));
+	_matrixDirty = false;
+}
+
+void Astra::Node3D::decomposeMatrix() const
+{
+	glm::vec3 skew;
+	glm::vec4 perspective;
+	glm::decompose(_transform, _scale, _rotation, _position, skew, perspective);
+	_trsDirty = false;
+}
+
 void Node3D::rotate(const glm::vec3& axis, const float& angle)
 {
-	_transform = glm::rotate(_transform, angle, axis);
+	// in local space, like post-multiplying the matrix
+	if (_trsDirty)
+		decomposeMatrix();
+	_rotation = glm::normalize(_rotation * glm::angleAxis(angle, glm::normalize(axis)));
+	_matrixDirty = true;
 }
 
 void Node3D::scale(const glm::vec3& scaling)
 {
-	_transform = glm::scale(_transform, scaling);
+	if (_trsDirty)
+		decomposeMatrix();
+	_scale *= scaling;
+	_matrixDirty = true;
 }
 
 void Node3D::translate(const glm::vec3& position)
 {
-	_transform = glm::translate(_transform, position);
+	if (_trsDirty)
+		decomposeMatrix();
+	_position += _rotation * (_scale * position);
+	_matrixDirty = true;
 }
 
 glm::vec3 Astra::Node3D::getPosition() const
 {
-	glm::vec3 scale;
-	glm::quat rotation;
-	glm::vec3 translation;
-	glm::vec3 skew;
-	glm::vec4 perspective;
-
-	glm::decompose(_transform, scale, rotation, translation, skew, perspective);
-
-	return translation;
+	if (_trsDirty)
+		decomposeMatrix();
+	return _position;
 }
 
 glm::vec3 Astra::Node3D::getRotation() const
 {
-	glm::vec3 scale;
-	glm::quat rotation;
-	glm::vec3 translation;
-	glm::vec3 skew;
-	glm::vec4 perspective;
-
-	glm::decompose(_transform, scale, rotation, translation, skew, perspective);
-
-	return glm::eulerAngles(rotation);
+	if (_trsDirty)
+		decomposeMatrix();
+	return glm::eulerAngles(_rotation);
 }
 
 glm::vec3 Astra::Node3D::getScale() const
 {
-	glm::vec3 scale;
-	glm::quat rotation;
-	glm::vec3 translation;
-	glm::vec3 skew;
-	glm::vec4 perspective;
-
-	glm::decompose(_transform, scale, rotation, translation, skew, perspective);
-
-	return scale;
+	if (_trsDirty)
+		decomposeMatrix();
+	return _scale;
 }
 
-glm::vec3 Astra::Node3D::getPosition()
+const glm::quat& Astra::Node3D::getOrientation() const
 {
-	glm::vec3 scale;
-	glm::quat rotation;
-	glm::vec3 translation;
-	glm::vec3 skew;
-	glm::vec4 perspective;
-
-	glm::decompose(_transform, scale, rotation, translation, skew, perspective);
-
-	return translation;
+	if (_trsDirty)
+		decomposeMatrix();
+	return _rotation;
 }
 
-glm::vec3 Astra::Node3D::getRotation()
+glm::mat4& Astra::Node3D::getTransformRef()
 {
-	glm::vec3 scale;
-	glm::quat rotation;
-	glm::vec3 translation;
-	glm::vec3 skew;
-	glm::vec4 perspective;
+	if (_matrixDirty)
+		composeMatrix();
+	_trsDirty = true;
+	return _transform;
+}
 
-	glm::decompose(_transform, scale, rotation, translation, skew, perspective);
+const glm::mat4& Astra::Node3D::getTransform() const
+{
+	if (_matrixDirty)
+		composeMatrix();
+	return _transform;
+}
 
-	return glm::eulerAngles(rotation);
+void Astra::Node3D::setPosition(const glm::vec3& position)
+{
+	if (_trsDirty)
+		decomposeMatrix();
+	_position = position;
+	_matrixDirty = true;
 }
 
-glm::vec3 Astra::Node3D::getScale()
+void Astra::Node3D::setOrientation(const glm::quat& rotation)
 {
-	glm::vec3 scale;
-	glm::quat rotation;
-	glm::vec3 translation;
-	glm::vec3 skew;
-	glm::vec4 perspective;
+	if (_trsDirty)
+		decomposeMatrix();
+	_rotation = rotation;
+	_matrixDirty = true;
+}
 
-	glm::decompose(_transform, scale, rotation, translation, skew, perspective);
+void Astra::Node3D::setScale(const glm::vec3& scale)
+{
+	if (_trsDirty)
+		decomposeMatrix();
+	_scale = scale;
+	_matrixDirty = true;
+}
 
-	return scale;
+void Astra::Node3D::setTransform(const glm::mat4& transform)
+{
+	_transform = transform;
+	_matrixDirty = false;
+	_trsDirty = true;
 }
 
 std::string& Astra::Node3D::getNameRef()
@@ -0,0 +1,802 @@
+#include <ObjParser.h>
+#include <MappedFile.h>
+#include <ThreadPool.h>
+#include <unordered_map>
+#include <algorithm>
+#include <filesystem>
+#include <cstring>
+#include <cmath>
+#include <climits>
+
+namespace
+{
+	// below this size a chunk is not worth a task
+	constexpr size_t MinChunkSize = 256 * 1024;
+	constexpr int32_t MissingIndex = INT32_MIN;
+	// faces before the first usemtl of a chunk take the material of the previous chunks
+	constexpr int32_t InheritMaterial = -2;
+
+	struct Corner
+	{
+		int32_t v;
+		int32_t vt;
+		int32_t vn;
+	};
+
+	struct ObjChunk
+	{
+		const char* begin{ nullptr };
+		const char* end{ nullptr };
+
+		std::vector<float> positions;
+		std::vector<float> colors;
+		std::vector<float> normals;
+		std::vector<float> texcoords;
+		bool hasColors{ false };
+
+		std::vector<Corner> corners;
+		std::vector<uint32_t> faceSizes;
+		// index in usedMaterials or InheritMaterial
+		std::vector<int32_t> faceMaterials;
+		std::vector<std::string> usedMaterials;
+		int32_t currentMaterial{ InheritMaterial };
+		// corners[i / 3] component i % 3 was a negative index, relative to the end of this chunk
+		std::vector<size_t> relativeFixups;
+		std::vector<std::string> mtllibs;
+
+		size_t nbTriangles{ 0 };
+		size_t nbDegenerated{ 0 };
+		std::string error;
+	};
+
+	inline bool isSpace(char c)
+	{
+		return c == ' ' || c == '\t' || c == '\r';
+	}
+
+	inline bool isDigit(char c)
+	{
+		return c >= '0' && c <= '9';
+	}
+
+	inline void skipSpaces(const char*& p, const char* end)
+	{
+		while (p < end && isSpace(*p))
+			p++;
+	}
+
+	inline bool startsWith(const char* p, const char* end, const char* keyword, size_t len)
+	{
+		return static_cast<size_t>(end - p) > len && std::memcmp(p, keyword, len) == 0 && isSpace(p[len]);
+	}
+
+	inline double pow10(int e)
+	{
+		static const double table[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+			1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+		if (e >= 0 && e <= 22)
+			return table[e];
+		return std::pow(10.0, e);
+	}
+
+	// strtof is locale dependent and way too slow for this, so we parse the usual obj notation by hand
+	bool parseFloat(const char*& p, const char* end, float& out)
+	{
+		skipSpaces(p, end);
+		const char* s = p;
+		bool negative = false;
+		if (s < end && (*s == '-' || *s == '+'))
+		{
+			negative = *s == '-';
+			s++;
+		}
+
+		uint64_t mantissa = 0;
+		int exponent = 0;
+		int significant = 0;
+		bool anyDigit = false;
+		while (s < end && isDigit(*s))
+		{
+			anyDigit = true;
+			if (significant < 19)
+			{
+				mantissa = mantissa * 10 + (*s - '0');
+				if (mantissa != 0)
+					significant++;
+			}
+			else
+			{
+				exponent++;
+			}
+			s++;
+		}
+		if (s < end && *s == '.')
+		{
+			s++;
+			while (s < end && isDigit(*s))
+			{
+				anyDigit = true;
+				if (significant < 19)
+				{
+					mantissa = mantissa * 10 + (*s - '0');
+					if (mantissa != 0)
+						significant++;
+					exponent--;
+				}
+				s++;
+			}
+		}
+		if (!anyDigit)
+			return false;
+
+		if (s < end && (*s == 'e' || *s == 'E'))
+		{
+			const char* e = s + 1;
+			bool negativeExp = false;
+			if (e < end && (*e == '-' || *e == '+'))
+			{
+				negativeExp = *e == '-';
+				e++;
+			}
+			if (e < end && isDigit(*e))
+			{
+				int value = 0;
+				while (e < end && isDigit(*e))
+				{
+					if (value < 10000)
+						value = value * 10 + (*e - '0');
+					e++;
+				}
+				exponent += negativeExp ? -value : value;
+				s = e;
+			}
+		}
+
+		double value = static_cast<double>(mantissa);
+		if (exponent < 0)
+			value /= pow10(-exponent);
+		else if (exponent > 0)
+			value *= pow10(exponent);
+		out = static_cast<float>(negative ? -value : value);
+		p = s;
+		return true;
+	}
+
+	bool parseInt(const char*& p, const char* end, int64_t& out)
+	{
+		const char* s = p;
+		bool negative = false;
+		if (s < end && (*s == '-' || *s == '+'))
+		{
+			negative = *s == '-';
+			s++;
+		}
+		if (s >= end || !isDigit(*s))
+			return false;
+		int64_t value = 0;
+		while (s < end && isDigit(*s))
+		{
+			if (value < INT32_MAX)
+				value = value * 10 + (*s - '0');
+			s++;
+		}
+		out = negative ? -value : value;
+		p = s;
+		return true;
+	}
+
+	// rest of the line without surrounding whitespace
+	std::string restOfLine(const char* p, const char* end)
+	{
+		skipSpaces(p, end);
+		while (end > p && isSpace(end[-1]))
+			end--;
+		return std::string(p, end);
+	}
+
+	// obj indices are 1 based, negative ones are relative to the last element read
+	bool resolveIndex(int64_t raw, size_t localCount, int32_t& out, bool& relative)
+	{
+		if (raw > 0)
+		{
+			out = static_cast<int32_t>(raw - 1);
+			relative = false;
+			return true;
+		}
+		if (raw < 0)
+		{
+			out = static_cast<int32_t>(static_cast<int64_t>(localCount) + raw);
+			relative = true;
+			return true;
+		}
+		return false;
+	}
+
+	void parseFace(ObjChunk& chunk, const char* p, const char* end)
+	{
+		const size_t firstCorner = chunk.corners.size();
+		while (true)
+		{
+			skipSpaces(p, end);
+			if (p >= end)
+				break;
+
+			Corner corner{ MissingIndex, MissingIndex, MissingIndex };
+			int64_t raw;
+			bool relative;
+			if (!parseInt(p, end, raw) || !resolveIndex(raw, chunk.positions.size() / 3, corner.v, relative))
+			{
+				chunk.error = "invalid face index";
+				chunk.corners.resize(firstCorner);
+				return;
+			}
+			const size_t cornerIndex = chunk.corners.size();
+			if (relative)
+				chunk.relativeFixups.push_back(cornerIndex * 3 + 0);
+
+			if (p < end && *p == '/')
+			{
+				p++;
+				if (parseInt(p, end, raw))
+				{
+					if (!resolveIndex(raw, chunk.texcoords.size() / 2, corner.vt, relative))
+					{
+						chunk.error = "invalid texcoord index";
+						chunk.corners.resize(firstCorner);
+						return;
+					}
+					if (relative)
+						chunk.relativeFixups.push_back(cornerIndex * 3 + 1);
+				}
+				if (p < end && *p == '/')
+				{
+					p++;
+					if (parseInt(p, end, raw))
+					{
+						if (!resolveIndex(raw, chunk.normals.size() / 3, corner.vn, relative))
+						{
+							chunk.error = "invalid normal index";
+							chunk.corners.resize(firstCorner);
+							return;
+						}
+						if (relative)
+							chunk.relativeFixups.push_back(cornerIndex * 3 + 2);
+					}
+				}
+			}
+			chunk.corners.push_back(corner);
+
+			// anything else glued to the index is garbage
+			while (p < end && !isSpace(*p))
+				p++;
+		}
+
+		const size_t nbCorners = chunk.corners.size() - firstCorner;
+		if (nbCorners < 3)
+		{
+			// drop its fixups too, they point past the end now
+			while (!chunk.relativeFixups.empty() && chunk.relativeFixups.back() >= firstCorner * 3)
+				chunk.relativeFixups.pop_back();
+			chunk.corners.resize(firstCorner);
+			chunk.nbDegenerated++;
+			return;
+		}
+		chunk.faceSizes.push_back(static_cast<uint32_t>(nbCorners));
+		chunk.faceMaterials.push_back(chunk.currentMaterial);
+		chunk.nbTriangles += nbCorners - 2;
+	}
+
+	void parseVertex(ObjChunk& chunk, const char* p, const char* end)
+	{
+		float v[6] = { 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f };
+		int n = 0;
+		while (n < 6 && parseFloat(p, end, v[n]))
+			n++;
+		chunk.positions.insert(chunk.positions.end(), v, v + 3);
+
+		if (n == 6 && !chunk.hasColors)
+		{
+			// colors appeared after some vertices without them, those keep the default white
+			chunk.hasColors = true;
+			chunk.colors.assign(chunk.positions.size() - 3, 1.0f);
+		}
+		if (chunk.hasColors)
+			chunk.colors.insert(chunk.colors.end(), v + 3, v + 6);
+	}
+
+	void parseLine(ObjChunk& chunk, const char* p, const char* end)
+	{
+		skipSpaces(p, end);
+		if (p >= end)
+			return;
+
+		switch (*p)
+		{
+		case 'v':
+			if (end - p > 1 && isSpace(p[1]))
+			{
+				parseVertex(chunk, p + 2, end);
+			}
+			else if (startsWith(p, end, "vn", 2))
+			{
+				float n[3] = { 0.0f, 0.0f, 0.0f };
+				p += 3;
+				for (int i = 0; i < 3 && parseFloat(p, end, n[i]); i++)
+					;
+				chunk.normals.insert(chunk.normals.end(), n, n + 3);
+			}
+			else if (startsWith(p, end, "vt", 2))
+			{
+				float t[2] = { 0.0f, 0.0f };
+				p += 3;
+				for (int i = 0; i < 2 && parseFloat(p, end, t[i]); i++)
+					;
+				chunk.texcoords.insert(chunk.texcoords.end(), t, t + 2);
+			}
+			break;
+		case 'f':
+			if (end - p > 1 && isSpace(p[1]))
+				parseFace(chunk, p + 2, end);
+			break;
+		case 'u':
+			if (startsWith(p, end, "usemtl", 6))
+			{
+				chunk.usedMaterials.push_back(restOfLine(p + 7, end));
+				chunk.currentMaterial = static_cast<int32_t>(chunk.usedMaterials.size()) - 1;
+			}
+			break;
+		case 'm':
+			if (startsWith(p, end, "mtllib", 6))
+				chunk.mtllibs.push_back(restOfLine(p + 7, end));
+			break;
+		default:
+			// comments, groups, objects, smoothing groups, lines and points are not used
+			break;
+		}
+	}
+
+	void parseChunk(ObjChunk& chunk)
+	{
+		const char* p = chunk.begin;
+		while (p < chunk.end && chunk.error.empty())
+		{
+			const char* lineEnd = static_cast<const char*>(std::memchr(p, '\n', chunk.end - p));
+			if (!lineEnd)
+				lineEnd = chunk.end;
+			parseLine(chunk, p, lineEnd);
+			p = lineEnd + 1;
+		}
+	}
+
+	WaveFrontMaterial defaultMaterial()
+	{
+		WaveFrontMaterial m{};
+		m.shininess = 1.0f;
+		m.ior = 1.0f;
+		m.dissolve = 1.0f;
+		m.illum = 0;
+		m.textureId = -1;
+		return m;
+	}
+
+	glm::vec3 parseVec3(const char* p, const char* end)
+	{
+		float v[3] = { 0.0f, 0.0f, 0.0f };
+		for (int n = 0; n < 3 && parseFloat(p, end, v[n]); n++)
+			;
+		return glm::vec3(v[0], v[1], v[2]);
+	}
+
+	float parseScalar(const char* p, const char* end, float fallback)
+	{
+		float v;
+		return parseFloat(p, end, v) ? v : fallback;
+	}
+
+	// texture statements can have options before the file name, eg: map_Kd -s 1 1 1 -clamp on texture.png
+	std::string parseTextureName(const char* p, const char* end)
+	{
+		static const std::unordered_map<std::string, int> optionArgs = {
+			{ "-blendu", 1 }, { "-blendv", 1 }, { "-boost", 1 }, { "-mm", 2 }, { "-o", 3 }, { "-s", 3 },
+			{ "-t", 3 }, { "-texres", 1 }, { "-clamp", 1 }, { "-bm", 1 }, { "-imfchan", 1 }, { "-type", 1 },
+			{ "-colorspace", 1 }
+		};
+
+		while (true)
+		{
+			skipSpaces(p, end);
+			const char* tokenEnd = p;
+			while (tokenEnd < end && !isSpace(*tokenEnd))
+				tokenEnd++;
+			auto it = optionArgs.find(std::string(p, tokenEnd));
+			if (it == optionArgs.end())
+				break;
+
+			p = tokenEnd;
+			// -o, -s and -t take between one and three numbers
+			const bool variable = it->second == 3;
+			for (int i = 0; i < it->second; i++)
+			{
+				const char* arg = p;
+				float dummy;
+				if (variable && i > 0 && !parseFloat(arg, end, dummy))
+					break;
+				skipSpaces(p, end);
+				while (p < end && !isSpace(*p))
+					p++;
+			}
+		}
+		return restOfLine(p, end);
+	}
+
+	bool parseMtl(const std::string& path, std::vector<WaveFrontMaterial>& materials, std::vector<std::string>& texturePaths,
+		std::unordered_map<std::string, int32_t>& materialMap, std::string& warning)
+	{
+		Astra::MappedFile file;
+		if (!file.open(path))
+			return false;
+
+		WaveFrontMaterial material = defaultMaterial();
+		std::string name;
+		std::string texture;
+		bool hasD = false;
+
+		auto flush = [&]()
+		{
+			if (name.empty())
+				return;
+			if (!texture.empty())
+			{
+				texturePaths.push_back(texture);
+				material.textureId = static_cast<int>(texturePaths.size()) - 1;
+			}
+			// the first definition wins, like in tinyobj
+			materialMap.emplace(name, static_cast<int32_t>(materials.size()));
+			materials.push_back(material);
+		};
+
+		const char* p = file.data();
+		const char* fileEnd = p + file.size();
+		while (p < fileEnd)
+		{
+			const char* end = static_cast<const char*>(std::memchr(p, '\n', fileEnd - p));
+			if (!end)
+				end = fileEnd;
+			const char* line = p;
+			p = end + 1;
+
+			skipSpaces(line, end);
+			if (line >= end || *line == '#')
+				continue;
+
+			const char* keyEnd = line;
+			while (keyEnd < end && !isSpace(*keyEnd))
+				keyEnd++;
+			const std::string key(line, keyEnd);
+			const char* args = keyEnd;
+
+			if (key == "newmtl")
+			{
+				flush();
+				material = defaultMaterial();
+				texture.clear();
+				hasD = false;
+				name = restOfLine(args, end);
+			}
+			else if (key == "Ka")
+				material.ambient = parseVec3(args, end);
+			else if (key == "Kd")
+				material.diffuse = parseVec3(args, end);
+			else if (key == "Ks")
+				material.specular = parseVec3(args, end);
+			else if (key == "Ke")
+				material.emission = parseVec3(args, end);
+			else if (key == "Kt" || key == "Tf")
+				material.transmittance = parseVec3(args, end);
+			else if (key == "Ni")
+				material.ior = parseScalar(args, end, 1.0f);
+			else if (key == "Ns")
+				material.shininess = parseScalar(args, end, 1.0f);
+			else if (key == "illum")
+				material.illum = static_cast<int>(parseScalar(args, end, 0.0f));
+			else if (key == "d")
+			{
+				material.dissolve = parseScalar(args, end, 1.0f);
+				hasD = true;
+			}
+			else if (key == "Tr")
+			{
+				// d wins over Tr, which is not part of the spec
+				if (hasD)
+					warning += "Both d and Tr defined for material " + name + ", using d\n";
+				else
+					material.dissolve = 1.0f - parseScalar(args, end, 0.0f);
+			}
+			else if (key == "map_Kd")
+				texture = parseTextureName(args, end);
+		}
+		flush();
+		return true;
+	}
+
+	// mtllib can list several files, the first one that can be read is used
+	void loadMtllib(const std::string& line, const std::filesystem::path& baseDir, std::vector<WaveFrontMaterial>& materials,
+		std::vector<std::string>& texturePaths, std::unordered_map<std::string, int32_t>& materialMap, std::string& warning)
+	{
+		const char* p = line.data();
+		const char* end = p + line.size();
+		while (true)
+		{
+			skipSpaces(p, end);
+			if (p >= end)
+				break;
+			const char* nameEnd = p;
+			while (nameEnd < end && !isSpace(*nameEnd))
+				nameEnd++;
+			std::filesystem::path mtlPath(std::string(p, nameEnd));
+			if (mtlPath.is_relative())
+				mtlPath = baseDir / mtlPath;
+			if (parseMtl(mtlPath.string(), materials, texturePaths, materialMap, warning))
+				return;
+			p = nameEnd;
+		}
+		warning += "Could not load any material file from: " + line + "\n";
+	}
+
+	std::vector<ObjChunk> splitChunks(const char* data, size_t size)
+	{
+		const size_t maxChunks = static_cast<size_t>(AstraThreads.getThreadCount()) * 4;
+		const size_t nbChunks = std::max<size_t>(1, std::min(maxChunks, size / MinChunkSize));
+		const size_t chunkSize = size / nbChunks;
+
+		std::vector<ObjChunk> chunks;
+		chunks.reserve(nbChunks);
+		const char* begin = data;
+		const char* fileEnd = data + size;
+		for (size_t i = 0; i < nbChunks && begin < fileEnd; i++)
+		{
+			const char* end = (i + 1 == nbChunks) ? fileEnd : std::max(begin, data + (i + 1) * chunkSize);
+			// chunks always end after a newline so no line is split in two
+			if (end < fileEnd)
+			{
+				const char* nl = static_cast<const char*>(std::memchr(end, '\n', fileEnd - end));
+				end = nl ? nl + 1 : fileEnd;
+			}
+			ObjChunk chunk;
+			chunk.begin = begin;
+			chunk.end = end;
+			chunks.push_back(std::move(chunk));
+			begin = end;
+		}
+		return chunks;
+	}
+}
+
+bool Astra::parseObj(const std::string& path, ObjData& data)
+{
+	data = ObjData{};
+	MappedFile file;
+	if (!file.open(path))
+	{
+		data.error = "Could not open file: " + path;
+		return false;
+	}
+
+	std::vector<ObjChunk> chunks = splitChunks(file.data(), file.size());
+	const size_t nbChunks = chunks.size();
+
+	AstraThreads.parallelFor(nbChunks, [&chunks](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; i++)
+				parseChunk(chunks[i]);
+		});
+
+	for (const auto& chunk : chunks)
+	{
+		if (!chunk.error.empty())
+		{
+			data.error = chunk.error;
+			return false;
+		}
+	}
+
+	// offsets of every chunk in the global arrays
+	std::vector<size_t> posBase(nbChunks + 1, 0), nrmBase(nbChunks + 1, 0), texBase(nbChunks + 1, 0), triBase(nbChunks + 1, 0);
+	bool anyColors = false;
+	size_t nbDegenerated = 0;
+	for (size_t i = 0; i < nbChunks; i++)
+	{
+		posBase[i + 1] = posBase[i] + chunks[i].positions.size() / 3;
+		nrmBase[i + 1] = nrmBase[i] + chunks[i].normals.size() / 3;
+		texBase[i + 1] = texBase[i] + chunks[i].texcoords.size() / 2;
+		triBase[i + 1] = triBase[i] + chunks[i].nbTriangles;
+		anyColors |= chunks[i].hasColors;
+		nbDegenerated += chunks[i].nbDegenerated;
+	}
+	if (nbDegenerated > 0)
+		data.warning += std::to_string(nbDegenerated) + " faces with less than 3 vertices were ignored\n";
+
+	// materials, in file order
+	std::unordered_map<std::string, int32_t> materialMap;
+	const std::filesystem::path baseDir = std::filesystem::path(path).parent_path();
+	for (const auto& chunk : chunks)
+	{
+		for (const auto& lib : chunk.mtllibs)
+			loadMtllib(lib, baseDir, data.materials, data.texturePaths, materialMap, data.warning);
+	}
+
+	// chunk material slots to global ids
+	std::vector<std::vector<int32_t>> slotMaterial(nbChunks);
+	std::vector<int32_t> inheritedMaterial(nbChunks, -1);
+	int32_t current = -1;
+	std::unordered_map<std::string, bool> missingMaterials;
+	for (size_t i = 0; i < nbChunks; i++)
+	{
+		inheritedMaterial[i] = current;
+		for (const auto& name : chunks[i].usedMaterials)
+		{
+			auto it = materialMap.find(name);
+			if (it == materialMap.end())
+			{
+				if (missingMaterials.emplace(name, true).second)
+					data.warning += "Material " + name + " not found\n";
+				slotMaterial[i].push_back(-1);
+			}
+			else
+			{
+				slotMaterial[i].push_back(it->second);
+			}
+		}
+		if (chunks[i].currentMaterial != InheritMaterial)
+			current = slotMaterial[i][chunks[i].currentMaterial];
+	}
+
+	const size_t nbPositions = posBase[nbChunks];
+	const size_t nbNormals = nrmBase[nbChunks];
+	const size_t nbTexcoords = texBase[nbChunks];
+	const size_t nbTriangles = triBase[nbChunks];
+
+	std::vector<float> positions(nbPositions * 3), normals(nbNormals * 3), texcoords(nbTexcoords * 2);
+	std::vector<float> colors(anyColors ? nbPositions * 3 : 0);
+	data.vertices.resize(nbTriangles * 3);
+	data.indices.resize(nbTriangles * 3);
+	data.materialIndices.resize(nbTriangles);
+	data.hasNormals = nbNormals > 0;
+	if (!data.hasNormals)
+		data.positionIds.resize(nbTriangles * 3);
+
+	// gather attributes and turn relative indices into absolute ones
+	std::vector<std::string> errors(nbChunks);
+	AstraThreads.parallelFor(nbChunks, [&](size_t begin, size_t end)
+		{
+			for (size_t c = begin; c < end; c++)
+			{
+				ObjChunk& chunk = chunks[c];
+				std::copy(chunk.positions.begin(), chunk.positions.end(), positions.begin() + posBase[c] * 3);
+				std::copy(chunk.normals.begin(), chunk.normals.end(), normals.begin() + nrmBase[c] * 3);
+				std::copy(chunk.texcoords.begin(), chunk.texcoords.end(), texcoords.begin() + texBase[c] * 2);
+				if (chunk.hasColors)
+					std::copy(chunk.colors.begin(), chunk.colors.end(), colors.begin() + posBase[c] * 3);
+				else if (anyColors)
+					std::fill(colors.begin() + posBase[c] * 3, colors.begin() + posBase[c + 1] * 3, 1.0f);
+
+				for (size_t fixup : chunk.relativeFixups)
+				{
+					Corner& corner = chunk.corners[fixup / 3];
+					switch (fixup % 3)
+					{
+					case 0: corner.v += static_cast<int32_t>(posBase[c]); break;
+					case 1: corner.vt += static_cast<int32_t>(texBase[c]); break;
+					default: corner.vn += static_cast<int32_t>(nrmBase[c]); break;
+					}
+				}
+				// non relative indices are already global
+				for (Corner& corner : chunk.corners)
+				{
+					const bool validV = corner.v >= 0 && static_cast<size_t>(corner.v) < nbPositions;
+					const bool validVt = corner.vt == MissingIndex || (corner.vt >= 0 && static_cast<size_t>(corner.vt) < nbTexcoords);
+					const bool validVn = corner.vn == MissingIndex || (corner.vn >= 0 && static_cast<size_t>(corner.vn) < nbNormals);
+					if (!validV || !validVt || !validVn)
+					{
+						errors[c] = "face index out of range";
+						break;
+					}
+				}
+			}
+		});
+
+	for (const auto& e : errors)
+	{
+		if (!e.empty())
+		{
+			data.error = e;
+			return false;
+		}
+	}
+
+	// triangulate and emit one vertex per corner
+	AstraThreads.parallelFor(nbChunks, [&](size_t begin, size_t end)
+		{
+			for (size_t c = begin; c < end; c++)
+			{
+				const ObjChunk& chunk = chunks[c];
+				size_t tri = triBase[c];
+				size_t firstCorner = 0;
+
+				auto emit = [&](const Corner& corner, size_t slot)
+				{
+					Vertex& vertex = data.vertices[slot];
+					const float* vp = &positions[3 * static_cast<size_t>(corner.v)];
+					vertex.pos = { vp[0], vp[1], vp[2] };
+					vertex.nrm = glm::vec3(0.0f);
+					if (corner.vn != MissingIndex)
+					{
+						const float* np = &normals[3 * static_cast<size_t>(corner.vn)];
+						vertex.nrm = { np[0], np[1], np[2] };
+					}
+					vertex.texCoord = glm::vec2(0.0f);
+					if (corner.vt != MissingIndex)
+					{
+						const float* tp = &texcoords[2 * static_cast<size_t>(corner.vt)];
+						vertex.texCoord = { tp[0], 1.0f - tp[1] };
+					}
+					vertex.color = glm::vec3(1.0f);
+					if (anyColors)
+					{
+						const float* cp = &colors[3 * static_cast<size_t>(corner.v)];
+						vertex.color = { cp[0], cp[1], cp[2] };
+					}
+					data.indices[slot] = static_cast<uint32_t>(slot);
+					if (!data.hasNormals)
+						data.positionIds[slot] = static_cast<uint32_t>(corner.v);
+				};
+				auto triangle = [&](const Corner& a, const Corner& b, const Corner& d, int32_t material)
+				{
+					emit(a, 3 * tri + 0);
+					emit(b, 3 * tri + 1);
+					emit(d, 3 * tri + 2);
+					data.materialIndices[tri] = material;
+					tri++;
+				};
+
+				for (size_t f = 0; f < chunk.faceSizes.size(); f++)
+				{
+					const uint32_t n = chunk.faceSizes[f];
+					const Corner* face = &chunk.corners[firstCorner];
+					firstCorner += n;
+					const int32_t slot = chunk.faceMaterials[f];
+					const int32_t material = slot == InheritMaterial ? inheritedMaterial[c] : slotMaterial[c][slot];
+
+					if (n == 4)
+					{
+						// split along the shortest diagonal, same as tinyobj
+						auto position = [&](const Corner& corner)
+						{
+							const float* vp = &positions[3 * static_cast<size_t>(corner.v)];
+							return glm::vec3(vp[0], vp[1], vp[2]);
+						};
+						const glm::vec3 d02 = position(face[2]) - position(face[0]);
+						const glm::vec3 d13 = position(face[3]) - position(face[1]);
+						if (glm::dot(d02, d02) < glm::dot(d13, d13))
+						{
+							triangle(face[0], face[1], face[2], material);
+							triangle(face[0], face[2], face[3], material);
+						}
+						else
+						{
+							triangle(face[0], face[1], face[3], material);
+							triangle(face[1], face[2], face[3], material);
+						}
+					}
+					else
+					{
+						// polygons are expected to be convex
+						for (uint32_t k = 1; k + 1 < n; k++)
+							triangle(face[0], face[k], face[k + 1], material);
+					}
+				}
+			}
+		});
+
+	return true;
+}
@@ -38,6 +38,69 @@ VkPipelineLayout Astra::Pipeline::getLayout() const
 	return _layout;
 }
 
+void Astra::ComputePipeline::bind(const CommandList &cmdList, const std::vector<VkDescriptorSet> &descsets)
+{
+	cmdList.bindPipeline(Astra::PipelineBindPoints::Compute, _pipeline);
+	if (!descsets.empty())
+		cmdList.bindDescriptorSets(Astra::PipelineBindPoints::Compute, _layout, descsets);
+}
+
+void Astra::MeshletCullPipeline::create(VkDevice vkdev, const std::vector<VkDescriptorSetLayout> &descsetsLayouts)
+{
+	VkPushConstantRange pushConstantRanges = {VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PushConstantCull)};
+
+	VkPipelineLayoutCreateInfo createInfo{VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO};
+	createInfo.setLayoutCount = static_cast<uint32_t>(descsetsLayouts.size());
+	createInfo.pSetLayouts = descsetsLayouts.data();
+	createInfo.pushConstantRangeCount = 1;
+	createInfo.pPushConstantRanges = &pushConstantRanges;
+	if (vkCreatePipelineLayout(vkdev, &createInfo, nullptr, &_layout) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Error creating pipeline layout");
+	}
+
+	VkComputePipelineCreateInfo pipelineInfo{VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO};
+	pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+	pipelineInfo.stage.module = AstraDevice.createShaderModule(nvh::loadFile("spv/AstraCore/meshlet_cull.comp.spv", true, defaultSearchPaths, true));
+	pipelineInfo.stage.pName = "main";
+	pipelineInfo.layout = _layout;
+	const VkResult result = vkCreateComputePipelines(vkdev, {}, 1, &pipelineInfo, nullptr, &_pipeline);
+	vkDestroyShaderModule(vkdev, pipelineInfo.stage.module, nullptr);
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Error creating pipelines");
+	}
+}
+
+void Astra::GpuCullPipeline::create(VkDevice vkdev, const std::vector<VkDescriptorSetLayout> &descsetsLayouts)
+{
+	VkPushConstantRange pushConstantRanges = {VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PushConstantGpuCull)};
+
+	VkPipelineLayoutCreateInfo createInfo{VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO};
+	createInfo.setLayoutCount = static_cast<uint32_t>(descsetsLayouts.size());
+	createInfo.pSetLayouts = descsetsLayouts.data();
+	createInfo.pushConstantRangeCount = 1;
+	createInfo.pPushConstantRanges = &pushConstantRanges;
+	if (vkCreatePipelineLayout(vkdev, &createInfo, nullptr, &_layout) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Error creating pipeline layout");
+	}
+
+	VkComputePipelineCreateInfo pipelineInfo{VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO};
+	pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+	pipelineInfo.stage.module = AstraDevice.createShaderModule(nvh::loadFile("spv/AstraCore/gpu_cull.comp.spv", true, defaultSearchPaths, true));
+	pipelineInfo.stage.pName = "main";
+	pipelineInfo.layout = _layout;
+	const VkResult result = vkCreateComputePipelines(vkdev, {}, 1, &pipelineInfo, nullptr, &_pipeline);
+	vkDestroyShaderModule(vkdev, pipelineInfo.stage.module, nullptr);
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Error creating pipelines");
+	}
+}
+
 void Astra::RayTracingPipeline::create(VkDevice vkdev, const std::vector<VkDescriptorSetLayout> &descsets, nvvk::ResourceAllocatorDma &alloc)
 {
 	auto rtProperties = AstraDevice.getRtProperties();
@@ -263,13 +326,7 @@ void Astra::OffscreenRaster::create(VkDevice vkdev, const std::vector<VkDescript
 	gpb.depthStencilState.depthTestEnable = true;
 	gpb.addShader(nvh::loadFile("spv/AstraCore/vert_shader.vert.spv", true, defaultSearchPaths, true), VK_SHADER_STAGE_VERTEX_BIT);
 	gpb.addShader(nvh::loadFile("spv/AstraCore/frag_shader.frag.spv", true, defaultSearchPaths, true), VK_SHADER_STAGE_FRAGMENT_BIT);
-	gpb.addBindingDescription({0, sizeof(Vertex)});
-	gpb.addAttributeDescriptions({
-		{0, 0, VK_FORMAT_R32G32B32_SFLOAT, static_cast<uint32_t>(offsetof(Vertex, pos))},
-		{1, 0, VK_FORMAT_R32G32B32_SFLOAT, static_cast<uint32_t>(offsetof(Vertex, nrm))},
-		{2, 0, VK_FORMAT_R32G32B32_SFLOAT, static_cast<uint32_t>(offsetof(Vertex, color))},
-		{3, 0, VK_FORMAT_R32G32_SFLOAT, static_cast<uint32_t>(offsetof(Vertex, texCoord))},
-	});
+	// no vertex input, the vertex shader reads each mesh in its own format (see vertex.glsl)
 
 	_pipeline = gpb.createPipeline();
 }
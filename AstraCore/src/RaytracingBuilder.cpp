@@ -0,0 +1,34 @@
+#include <RaytracingBuilder.h>
+#include <Device.h>
+
+size_t Astra::RaytracingBuilder::getBlasCount() const
+{
+	return m_blas.size();
+}
+
+void Astra::RaytracingBuilder::destroyBlasFrom(size_t first)
+{
+	for (size_t i = first; i < m_blas.size(); i++)
+	{
+		m_alloc->destroy(m_blas[i]);
+	}
+	if (first < m_blas.size())
+		m_blas.resize(first);
+}
+
+void Astra::RaytracingBuilder::destroyTlas()
+{
+	if (m_alloc != nullptr && m_tlas.accel != VK_NULL_HANDLE)
+		m_alloc->destroy(m_tlas);
+	m_tlas = {};
+}
+
+void Astra::RaytracingBuilder::retireTlas()
+{
+	if (m_alloc != nullptr && m_tlas.accel != VK_NULL_HANDLE)
+	{
+		nvvk::ResourceAllocator* alloc = m_alloc;
+		AstraDevice.retire([alloc, tlas = m_tlas]() mutable { alloc->destroy(tlas); });
+	}
+	m_tlas = {};
+}
@@ -140,6 +140,8 @@ void Astra::Renderer::createSwapchain(const VkSurfaceKHR& surface, uint32_t widt
 		fenceCreateInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
 		vkCreateFence(device, &fenceCreateInfo, nullptr, &fence);
 	}
+	// resources replaced while rendering are destroyed once these fences are waited
+	AstraDevice.initFrames(_swapchain.getImageCount());
 
 	/*
 	 * We use the CommandList type in the class attribute
@@ -427,6 +429,9 @@ void Astra::Renderer::resize(int w, int h, nvvk::ResourceAllocatorDma& alloc)
 
 void Astra::Renderer::prepareFrame()
 {
+	// frame boundary, models loaded in the background are added here
+	_app->updateAsyncLoads();
+
 	int w, h;
 	glfwGetFramebufferSize(AstraDevice.getWindow(), &w, &h);
 
@@ -445,6 +450,10 @@ void Astra::Renderer::prepareFrame()
 	// use fence to wait for cmdbuff execution
 	uint32_t imageIndex = _swapchain.getActiveImageIndex();
 	vkWaitForFences(AstraDevice.getVkDevice(), 1, &_fences[imageIndex], VK_TRUE, UINT64_MAX);
+	AstraDevice.frameCompleted(imageIndex);
+
+	// the GPU is done with this frame's descriptor sets, they can be written now
+	_app->updateFrameDescriptors(imageIndex);
 }
 
 Astra::CommandList Astra::Renderer::beginFrame()
@@ -514,6 +523,7 @@ void Astra::Renderer::endFrame(const CommandList& cmdList)
 
 	// Submit to the graphics queue passing a wait fence
 	vkQueueSubmit(AstraDevice.getQueue(), 1, &submitInfo, _fences[imageIndex]);
+	AstraDevice.frameSubmitted(imageIndex);
 
 	// Presenting frame
 	_swapchain.present(AstraDevice.getQueue());
@@ -558,6 +568,8 @@ void Astra::Renderer::init(App* app, nvvk::ResourceAllocatorDma& alloc)
 	createPostDescriptorSet();
 	createPostPipeline();
 	updatePostDescriptorSet();
+	_cullPipeline.create(AstraDevice.getVkDevice());
+	_gpuCullPipeline.create(AstraDevice.getVkDevice());
 }
 
 void Astra::Renderer::linkApp(App* app)
@@ -568,6 +580,9 @@ void Astra::Renderer::linkApp(App* app)
 void Astra::Renderer::destroy(nvvk::ResourceAllocator* alloc)
 {
 	const auto& device = AstraDevice.getVkDevice();
+	// the app already waited for the GPU
+	AstraDevice.flushRetired();
+	AstraDevice.initFrames(0);
 	alloc->destroy(_offscreenColor);
 	alloc->destroy(_offscreenDepth);
 	vkDestroyImageView(device, _depthView, nullptr);
@@ -587,16 +602,25 @@ void Astra::Renderer::destroy(nvvk::ResourceAllocator* alloc)
 		_commandLists[i].free();
 	}
 	_swapchain.deinit();
+	_cullPipeline.destroy(alloc);
+	_gpuCullPipeline.destroy(alloc);
 }
 
 void Astra::Renderer::render(const Astra::CommandList& cmdList, Scene* scene, Pipeline* pipeline, const std::vector<VkDescriptorSet>& descSets, Astra::GuiController* gui)
 {
+	// descriptions of the models added since the last frame
+	scene->updateObjDescBuffer(cmdList);
 	if (pipeline->doesRayTracing())
 	{
 		renderRaytrace(cmdList, (SceneRT*)scene, (RayTracingPipeline*)pipeline, descSets);
 	}
 	else
 	{
+		// compute work has to go outside the render pass
+		if (scene->getGpuDriven())
+			scene->cullGpuDriven(cmdList, &_gpuCullPipeline);
+		else
+			scene->cull(cmdList, &_cullPipeline);
 		renderRaster(cmdList, scene, (RasterPipeline*)pipeline, descSets);
 	}
 	// post render: ui and texture
@@ -630,6 +654,10 @@ const nvvk::Texture& Astra::Renderer::getOffscreenColor() const
 {
 	return _offscreenColor;
 }
+uint32_t Astra::Renderer::getFrameCount() const
+{
+	return _swapchain.getImageCount();
+}
 VkRenderPass Astra::Renderer::getOffscreenRenderPass() const
 {
 	return _offscreenRenderPass;
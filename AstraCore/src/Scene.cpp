@@ -3,28 +3,232 @@
 #include <Device.h>
 #include <nvvk/buffers_vk.hpp>
 #include <Utils.h>
+#include <ThreadPool.h>
+#include <GltfLoader.h>
 #include <fstream>
+#include <chrono>
+#include <deque>
+#include <stdexcept>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+	// the same one the GPU-driven culling uses
+	constexpr float LodHysteresis = static_cast<float>(LOD_HYSTERESIS);
+	// below this many instances the levels of detail are picked on a single thread
+	constexpr size_t MinLodBatch = 16 * 1024;
+	// descriptions the buffer has room for when it is first created
+	constexpr size_t MinObjDescCapacity = 64;
+	// staging memory the uploads of loadModels() fill before they are submitted
+	constexpr VkDeviceSize MaxUploadBatchSize = 256ull * 1024 * 1024;
+	// vkCmdUpdateBuffer takes up to 64KB at a time
+	constexpr VkDeviceSize MaxUpdateSize = 65536;
+	// instances the GPU-driven buffers have room for when they are first created
+	constexpr size_t MinGpuInstanceCapacity = 1024;
+	// indices the merged buffer of the GPU-driven raster has room for when it is first created, 4MB
+	constexpr size_t MinGpuIndexCapacity = 1 << 20;
+	// block of the models whose indices are not in the merged buffer yet
+	constexpr VkDeviceSize NoIndexBlock = std::numeric_limits<VkDeviceSize>::max();
+	// draw commands of the meshlet culling, 20MB; the instances past them are drawn whole
+	constexpr size_t MaxMeshletDraws = 1 << 20;
+	// workgroups of the meshlet culling, the minimum maxComputeWorkGroupCount
+	constexpr size_t MaxCullChunks = 65535;
+	// first draw of the instances the meshlet culling leaves out
+	constexpr uint32_t NotCulled = std::numeric_limits<uint32_t>::max();
+
+	// makes room for @p count elements, doubling the capacity. The old buffer is retired, frames in flight may still be using it. Returns whether it was created again
+	bool reserveBuffer(nvvk::ResourceAllocatorDma* alloc, nvvk::Buffer& buffer, size_t& capacity, size_t count, VkDeviceSize elementSize, VkBufferUsageFlags usage,
+		size_t minCapacity = 1)
+	{
+		if (count <= capacity && buffer.buffer != VK_NULL_HANDLE)
+			return false;
+		if (buffer.buffer != VK_NULL_HANDLE)
+			AstraDevice.retire([alloc, old = buffer]() mutable { alloc->destroy(old); });
+		capacity = std::max(count, std::max(capacity * 2, minCapacity));
+		buffer = alloc->createBuffer(capacity * elementSize, usage);
+		return true;
+	}
+
+	// levels of detail of @p mesh the GPU-driven raster draws, the ones with a description
+	uint32_t getGpuLodCount(const Astra::Mesh& mesh)
+	{
+		return static_cast<uint32_t>(std::min(mesh.lods.size(), mesh.lodDescriptors.size()));
+	}
+
+	// indices of @p mesh in the merged buffer, its own followed by those of its levels of detail
+	VkDeviceSize getGpuIndexCount(const Astra::Mesh& mesh)
+	{
+		return mesh.getIndexCount() + (getGpuLodCount(mesh) > 0 ? mesh.getLodIndexCount() : 0);
+	}
+
+	// uploads @p size bytes inside the command list, without staging, in as many updates as needed
+	void updateBufferChunks(const Astra::CommandList& cmdList, const nvvk::Buffer& buffer, VkDeviceSize offset, VkDeviceSize size, const void* data)
+	{
+		const uint8_t* bytes = static_cast<const uint8_t*>(data);
+		for (VkDeviceSize done = 0; done < size; done += MaxUpdateSize)
+		{
+			cmdList.updateBuffer(buffer, static_cast<uint32_t>(offset + done), std::min(MaxUpdateSize, size - done), bytes + done);
+		}
+	}
+
+	// records uploads in one command buffer until the staging memory reaches MaxUploadBatchSize, then submits it with a fence
+	// and starts another one, so loading many models takes a few submissions instead of one per model
+	class UploadBatch
+	{
+	private:
+		nvvk::ResourceAllocatorDma* _alloc;
+		nvvk::CommandPool _cmdPool;
+		VkCommandBuffer _cmdBuf{ VK_NULL_HANDLE };
+		std::deque<std::pair<VkCommandBuffer, VkFence>> _inFlight;
+		size_t _submissions{ 0 };
+
+		VkDeviceSize getStagingUsed() const
+		{
+			VkDeviceSize allocated = 0;
+			VkDeviceSize used = 0;
+			_alloc->getStaging()->getUtilization(allocated, used);
+			return used;
+		}
+
+		void submit()
+		{
+			VkFenceCreateInfo fenceInfo{ VK_STRUCTURE_TYPE_FENCE_CREATE_INFO };
+			VkFence fence;
+			vkCreateFence(AstraDevice.getVkDevice(), &fenceInfo, nullptr, &fence);
+			// the staging memory of this batch is released once the fence is signaled
+			_alloc->finalizeStaging(fence);
+			_cmdPool.submit(1, &_cmdBuf, fence);
+			_inFlight.emplace_back(_cmdBuf, fence);
+			_cmdBuf = VK_NULL_HANDLE;
+			_submissions++;
+		}
+
+		void waitOldest()
+		{
+			auto [cmdBuf, fence] = _inFlight.front();
+			_inFlight.pop_front();
+			vkWaitForFences(AstraDevice.getVkDevice(), 1, &fence, VK_TRUE, UINT64_MAX);
+			_alloc->releaseStaging();
+			vkDestroyFence(AstraDevice.getVkDevice(), fence, nullptr);
+			_cmdPool.destroy(cmdBuf);
+		}
+
+	public:
+		UploadBatch(nvvk::ResourceAllocatorDma* alloc) : _alloc(alloc), _cmdPool(AstraDevice.getVkDevice(), AstraDevice.getGraphicsQueueIndex())
+		{
+		}
+
+		Astra::CommandList getCommandList()
+		{
+			if (_cmdBuf == VK_NULL_HANDLE)
+				_cmdBuf = _cmdPool.createCommandBuffer();
+			return Astra::CommandList(_cmdBuf);
+		}
+
+		// after every upload. While the staging memory is over the cap, older batches are waited for so it can be reused
+		void flushIfFull()
+		{
+			if (_cmdBuf == VK_NULL_HANDLE || getStagingUsed() < MaxUploadBatchSize)
+				return;
+			submit();
+			while (_inFlight.size() > 1 && getStagingUsed() >= MaxUploadBatchSize)
+			{
+				waitOldest();
+			}
+		}
+
+		// submits what is left and waits for everything
+		size_t finish()
+		{
+			if (_cmdBuf != VK_NULL_HANDLE)
+				submit();
+			while (!_inFlight.empty())
+			{
+				waitOldest();
+			}
+			return _submissions;
+		}
+	};
+}
 
 void Astra::Scene::createObjDescBuffer()
 {
-	if (_objDescBuffer.buffer != VK_NULL_HANDLE)
+	// only the new models are laid out, every one followed by its levels of detail, so the slots already taken never move
+	for (; _objDescMeshCount < _objModels.size(); _objDescMeshCount++)
+	{
+		Mesh& mesh = _objModels[_objDescMeshCount];
+		mesh.descIndex = static_cast<uint32_t>(_objDescs.size());
+		mesh.lodDescIndex = mesh.descIndex + 1;
+		_gpuGeometryDirty = true;
+		_objDescs.push_back(mesh.descriptor);
+		_objDescs.insert(_objDescs.end(), mesh.lodDescriptors.begin(), mesh.lodDescriptors.end());
+	}
+
+	if (_objDescs.size() > _objDescCapacity)
 	{
-		_alloc->destroy(_objDescBuffer);
+		// doubling, so loading N models only creates it log(N) times
+		_objDescCapacity = std::max(_objDescs.size(), std::max(_objDescCapacity * 2, MinObjDescCapacity));
+		if (_objDescBuffer.buffer != VK_NULL_HANDLE)
+		{
+			// frames in flight may still be reading the old one, it goes once they finish
+			nvvk::ResourceAllocatorDma* alloc = _alloc;
+			AstraDevice.retire([alloc, old = _objDescBuffer]() mutable { alloc->destroy(old); });
+		}
+		_objDescBuffer = _alloc->createBuffer(_objDescCapacity * sizeof(ObjDesc), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+		// the new buffer is empty, updateObjDescBuffer() uploads every description
+		_objDescUploaded = 0;
+		_descriptorsChanged = true;
 	}
+	// the material table grows the same way, its new materials are uploaded along with the descriptions
+	if (_materialCache.reserveBuffer())
+		_descriptorsChanged = true;
+}
 
-	nvvk::CommandPool cmdGen(AstraDevice.getVkDevice(), AstraDevice.getGraphicsQueueIndex());
+void Astra::Scene::rebuildObjDescs()
+{
+	// the capacity stays, the new layout is uploaded by updateObjDescBuffer()
+	_objDescs.clear();
+	_objDescMeshCount = 0;
+	_objDescUploaded = 0;
+	createObjDescBuffer();
+}
 
-	auto cmdBuf = cmdGen.createCommandBuffer();
-	std::vector<ObjDesc> objDescs;
-	for (auto& mesh : _objModels)
+void Astra::Scene::updateObjDescBuffer(const CommandList& cmdList)
+{
+	const bool newDescs = _objDescUploaded < _objDescs.size() && _objDescBuffer.buffer != VK_NULL_HANDLE;
+	size_t firstMaterial = 0;
+	const std::vector<WaveFrontMaterial> materials = _materialCache.consumeUpload(firstMaterial);
+	if (!newDescs && materials.empty())
+		return;
+
+	// previous frames may still be reading the descriptions and the materials
+	VkMemoryBarrier beforeBarrier{ VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+	beforeBarrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	beforeBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	cmdList.pipelineBarrier(VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, { beforeBarrier }, {}, {});
+
+	if (newDescs)
 	{
-		objDescs.push_back(mesh.descriptor);
+		updateBufferChunks(cmdList, _objDescBuffer, _objDescUploaded * sizeof(ObjDesc), (_objDescs.size() - _objDescUploaded) * sizeof(ObjDesc), _objDescs.data() + _objDescUploaded);
+		_objDescUploaded = _objDescs.size();
 	}
-	if (!objDescs.empty())
-		_objDescBuffer = _alloc->createBuffer(cmdBuf, objDescs, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+	if (!materials.empty())
+		updateBufferChunks(cmdList, _materialCache.getBuffer(), firstMaterial * sizeof(WaveFrontMaterial), materials.size() * sizeof(WaveFrontMaterial), materials.data());
 
-	cmdGen.submitAndWait(cmdBuf);
-	_alloc->finalizeAndReleaseStaging();
+	VkMemoryBarrier afterBarrier{ VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+	afterBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	afterBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	cmdList.pipelineBarrier(VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, { afterBarrier }, {}, {});
+}
+
+bool Astra::Scene::consumeDescriptorsChanged()
+{
+	const bool changed = _descriptorsChanged;
+	_descriptorsChanged = false;
+	return changed;
 }
 
 void Astra::Scene::createCameraUBO()
@@ -47,107 +251,438 @@ void Astra::Scene::updateLightsUBO(const CommandList& cmdList)
 	AstraDevice.updateUBO<LightsUniform>(_lightsUniform, _lightsUBO, cmdList);
 }
 
-void Astra::Scene::loadModel(const std::string& filename, const glm::mat4& transform)
+void Astra::Scene::loadModel(const std::string& filename, const glm::mat4& transform, uint32_t vertexFormat)
 {
 	// we cant load models until we have access to the resource allocator
 	// if we have it, just create it
 	// if we dont, postpone the operation to the init stage
-	if (_alloc != nullptr)
+	if (isGltfFile(filename))
+	{
+		loadGltf(filename, transform, vertexFormat);
+	}
+	else if (_alloc != nullptr)
 	{
-		// find the offset for this model
-		auto txtOffset = static_cast<uint32_t>(getTextures().size());
 		// allocating cmdbuffers
 		nvvk::CommandPool cmdBufGet(AstraDevice.getVkDevice(), AstraDevice.getGraphicsQueueIndex());
 		VkCommandBuffer cmdBuf = cmdBufGet.createCommandBuffer();
 		Astra::CommandList cmdList(cmdBuf);
 
 		Astra::Mesh mesh;
-		mesh.loadFromFile(filename);
+		Astra::MeshLoadOptions options;
+		options.linearizeColors = true;
+		options.vertexFormat = vertexFormat;
+		if (!mesh.loadFromFile(filename, options))
+		{
+			Astra::Log("Could not load model: " + filename, ERR);
+			return;
+		}
 		mesh.meshId = getModels().size();
 
-		// color space to linear
-		for (auto& m : mesh.materials)
+		// creates the buffers and descriptors neeeded, textures go to the scene table
+		mesh.create(cmdList, _alloc, _textureCache, _materialCache);
+
+		cmdBufGet.submitAndWait(cmdBuf);
+		_alloc->finalizeAndReleaseStaging();
+
+		addLoadedModel(std::move(mesh), filename, transform);
+
+		// creates the descriptor buffer
+		createObjDescBuffer();
+	}
+	else
+	{
+		_lazymodels.push_back({ filename, transform, vertexFormat });
+	}
+}
+
+void Astra::Scene::loadGltf(const std::string& filename, const glm::mat4& transform, uint32_t vertexFormat)
+{
+	if (_alloc == nullptr)
+	{
+		_lazymodels.push_back({ filename, transform, vertexFormat });
+		return;
+	}
+
+	GltfData data;
+	if (!parseGltf(filename, data))
+	{
+		Astra::Log("Error reading gltf file: " + filename + ", error: " + data.error, ERR);
+		return;
+	}
+	if (!data.warning.empty())
+	{
+		Astra::Log("Error reading gltf file: " + filename + ", error: " + data.warning, WARNING);
+	}
+
+	// every image is decoded at once, then the whole file goes in one command buffer
+	decodeGltfTextures(data, &_textureCache);
+
+	nvvk::CommandPool cmdBufGet(AstraDevice.getVkDevice(), AstraDevice.getGraphicsQueueIndex());
+	VkCommandBuffer cmdBuf = cmdBufGet.createCommandBuffer();
+	Astra::CommandList cmdList(cmdBuf);
+
+	const int firstMesh = static_cast<int>(_objModels.size());
+	for (Mesh& mesh : data.meshes)
+	{
+		mesh.meshId = static_cast<int>(_objModels.size());
+		mesh.vertexFormat = vertexFormat;
+		mesh.create(cmdList, _alloc, _textureCache, _materialCache);
+		addModel(mesh);
+	}
+
+	cmdBufGet.submitAndWait(cmdBuf);
+	_alloc->finalizeAndReleaseStaging();
+
+	addGltfNodes(data, firstMesh, transform);
+	Astra::Log("Loaded " + filename + ": " + std::to_string(data.meshes.size()) + " meshes, " + std::to_string(data.nodes.size()) + " instances");
+
+	// creates the descriptor buffer
+	createObjDescBuffer();
+}
+
+void Astra::Scene::addGltfNodes(const GltfData& data, int firstMesh, const glm::mat4& transform)
+{
+	// repeated nodes share their mesh
+	// the nodes keep their hierarchy, only the roots take the load transform
+	const size_t firstInstance = _instances.size();
+	_instances.reserve(firstInstance + data.nodes.size());
+	for (const GltfNode& node : data.nodes)
+	{
+		if (node.parent < 0)
+			_instances.add(firstMesh + node.mesh, transform * node.transform, node.name);
+		else
+			_instances.add(firstMesh + node.mesh, node.transform, node.name, static_cast<uint32_t>(firstInstance + node.parent));
+	}
+}
+
+void Astra::Scene::loadModels(const std::vector<ModelFile>& models)
+{
+	if (_alloc == nullptr)
+	{
+		_lazymodels.insert(_lazymodels.end(), models.begin(), models.end());
+		return;
+	}
+	if (models.empty())
+		return;
+
+	// every file is parsed on its own, the parsers split their work further between the threads left
+	std::vector<Mesh> meshes(models.size());
+	std::vector<std::unique_ptr<GltfData>> gltfs(models.size());
+	std::vector<uint8_t> parsed(models.size(), 0);
+	AstraThreads.parallelFor(models.size(), [&](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; i++)
+			{
+				if (isGltfFile(models[i].path))
+				{
+					gltfs[i] = std::make_unique<GltfData>();
+					parsed[i] = parseGltf(models[i].path, *gltfs[i]);
+					continue;
+				}
+				Astra::MeshLoadOptions options;
+				options.linearizeColors = true;
+				options.vertexFormat = models[i].vertexFormat;
+				meshes[i].loadFromFile(models[i].path, options);
+				parsed[i] = meshes[i].getVertexCount() > 0;
+			}
+		});
+
+	// the textures of every obj are decoded together, the glTF ones may be embedded so they go file by file
+	std::vector<Mesh*> objMeshes;
+	for (size_t i = 0; i < models.size(); i++)
+	{
+		if (parsed[i] && !gltfs[i])
+			objMeshes.push_back(&meshes[i]);
+	}
+	Mesh::decodeTextures(objMeshes, &_textureCache);
+	for (size_t i = 0; i < models.size(); i++)
+	{
+		if (parsed[i] && gltfs[i])
+			decodeGltfTextures(*gltfs[i], &_textureCache);
+	}
+
+	UploadBatch batch(_alloc);
+	size_t loaded = 0;
+	for (size_t i = 0; i < models.size(); i++)
+	{
+		const ModelFile& model = models[i];
+		if (!parsed[i])
+		{
+			Astra::Log("Could not load model: " + model.path + (gltfs[i] ? ", error: " + gltfs[i]->error : ""), ERR);
+			continue;
+		}
+		loaded++;
+
+		if (gltfs[i])
 		{
-			m.ambient = glm::pow(m.ambient, glm::vec3(2.2f));
-			m.diffuse = glm::pow(m.diffuse, glm::vec3(2.2f));
-			m.specular = glm::pow(m.specular, glm::vec3(2.2f));
+			GltfData& data = *gltfs[i];
+			if (!data.warning.empty())
+				Astra::Log("Error reading gltf file: " + model.path + ", error: " + data.warning, WARNING);
+			const int firstMesh = static_cast<int>(_objModels.size());
+			for (Mesh& mesh : data.meshes)
+			{
+				mesh.meshId = static_cast<int>(_objModels.size());
+				mesh.vertexFormat = model.vertexFormat;
+				mesh.create(batch.getCommandList(), _alloc, _textureCache, _materialCache);
+				addModel(std::move(mesh));
+				batch.flushIfFull();
+			}
+			addGltfNodes(data, firstMesh, model.transform);
+			// the parsed data is not needed anymore
+			gltfs[i].reset();
+			continue;
 		}
 
-		// creates the buffers and descriptors neeeded
-		mesh.create(cmdList, _alloc, txtOffset);
+		Mesh& mesh = meshes[i];
+		mesh.meshId = static_cast<int>(_objModels.size());
+		mesh.create(batch.getCommandList(), _alloc, _textureCache, _materialCache);
+		addLoadedModel(std::move(mesh), model.path, model.transform);
+		mesh = Mesh();
+		batch.flushIfFull();
+	}
+
+	const size_t submissions = batch.finish();
+	Astra::Log("Loaded " + std::to_string(loaded) + " of " + std::to_string(models.size()) + " models in " + std::to_string(submissions) + " submissions");
+
+	// the descriptions of all of them at once
+	createObjDescBuffer();
+}
+
+void Astra::Scene::addLoadedModel(Mesh&& mesh, const std::string& filename, const glm::mat4& transform)
+{
+	// adds the model to the scene, its data is not copied
+	const int meshId = mesh.meshId;
+	addModel(std::move(mesh));
+
+	// creates an instance of the model
+	Astra::MeshInstance instance(meshId, transform);
+	instance.setName(instance.getName() + " :: " + filename.substr(filename.size() - std::min(10, (int)filename.size() / 2 - 4), filename.size()));
+	addInstance(instance);
+}
+
+std::shared_ptr<Astra::ModelLoad> Astra::Scene::loadModelAsync(const std::string& filename, const glm::mat4& transform, const std::function<void(int)>& onLoaded,
+	uint32_t vertexFormat)
+{
+	auto load = std::make_shared<ModelLoad>(filename, transform, onLoaded);
+
+	// parsing and decoding dont need the device, they can start before init
+	// textures the scene already has are not decoded again, destroy() waits for this job so the cache outlives it
+	const TextureCache* textureCache = &_textureCache;
+	load->_cpuWork = AstraThreads.submit([load, textureCache, vertexFormat]()
+		{
+			load->_progress = 0.05f;
+			// a glTF has several meshes, it goes through loadGltf(); the empty mesh fails the load
+			if (isGltfFile(load->_path))
+				return;
+			Astra::MeshLoadOptions options;
+			options.linearizeColors = true;
+			options.vertexFormat = vertexFormat;
+			load->_mesh.loadFromFile(load->_path, options);
+			load->_progress = 0.5f;
+			if (load->_mesh.getVertexCount() > 0)
+			{
+				load->_mesh.decodeTextures(textureCache);
+			}
+			load->_progress = 0.9f;
+		});
+
+	_pendingLoads.push_back(load);
+	return load;
+}
 
-		// Adds mesh textures to the scene texture buffer
+bool Astra::Scene::updateAsyncLoads()
+{
+	// uploads need the allocator
+	if (_alloc == nullptr || _pendingLoads.empty())
+		return false;
 
-		for (const auto &p : mesh.textures)
+	bool ready = false;
+	for (auto& load : _pendingLoads)
+	{
+		if (load->_status == ModelLoadStatus::Loading && load->_cpuWork.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
 		{
-			getTextures().push_back(p);
+			try
+			{
+				load->_cpuWork.get();
+			}
+			catch (...)
+			{
+				// an exception on the worker is one more way of failing, it goes to the future
+				load->_error = std::current_exception();
+				load->_mesh = Mesh();
+			}
+			if (load->_mesh.getVertexCount() == 0)
+			{
+				// published as a failure in publishAsyncLoads
+				load->_status = ModelLoadStatus::Failed;
+				ready = true;
+				continue;
+			}
+
+			if (_loadCmdPool.getCommandPool() == VK_NULL_HANDLE)
+				_loadCmdPool.init(AstraDevice.getVkDevice(), AstraDevice.getGraphicsQueueIndex());
+
+			load->_cmdBuf = _loadCmdPool.createCommandBuffer();
+			Astra::CommandList cmdList(load->_cmdBuf);
+			// final id is set when the model is published, the textures are already in the scene table
+			// but not bound until the descriptors are rewritten
+			load->_mesh.meshId = static_cast<int>(_objModels.size());
+			load->_mesh.create(cmdList, _alloc, _textureCache, _materialCache);
+
+			VkFenceCreateInfo fenceInfo{ VK_STRUCTURE_TYPE_FENCE_CREATE_INFO };
+			vkCreateFence(AstraDevice.getVkDevice(), &fenceInfo, nullptr, &load->_fence);
+			// the staging memory is released once this fence is signaled
+			_alloc->finalizeStaging(load->_fence);
+			_loadCmdPool.submit(1, &load->_cmdBuf, load->_fence);
+
+			load->_status = ModelLoadStatus::Uploading;
+			load->_progress = 0.95f;
 		}
 
-		cmdBufGet.submitAndWait(cmdBuf);
-		_alloc->finalizeAndReleaseStaging();
+		if (load->_status == ModelLoadStatus::Uploading && vkGetFenceStatus(AstraDevice.getVkDevice(), load->_fence) == VK_SUCCESS)
+		{
+			ready = true;
+		}
+	}
 
-		// adds the model to the scene
-		addModel(mesh);
+	// frees the staging buffers of finished uploads
+	_alloc->releaseStaging();
+	return ready;
+}
 
-		// creates an instance of the model
-		Astra::MeshInstance instance(mesh.meshId, transform);
-		instance.setName(instance.getName() + " :: " + filename.substr(filename.size() - std::min(10, (int)filename.size() / 2 - 4), filename.size()));
-		addInstance(instance);
+void Astra::Scene::publishAsyncLoads()
+{
+	std::vector<std::shared_ptr<ModelLoad>> finished;
+	std::vector<std::shared_ptr<ModelLoad>> pending;
+	for (auto& load : _pendingLoads)
+	{
+		const bool uploaded = load->_status == ModelLoadStatus::Uploading && vkGetFenceStatus(AstraDevice.getVkDevice(), load->_fence) == VK_SUCCESS;
+		if (uploaded || load->_status == ModelLoadStatus::Failed)
+			finished.push_back(load);
+		else
+			pending.push_back(load);
+	}
+	_pendingLoads = std::move(pending);
 
-		// creates the descriptor buffer
-		createObjDescBuffer();
+	bool added = false;
+	for (auto& load : finished)
+	{
+		if (load->_status == ModelLoadStatus::Failed)
+		{
+			std::string reason;
+			try
+			{
+				if (load->_error)
+					std::rethrow_exception(load->_error);
+			}
+			catch (const std::exception& e)
+			{
+				reason = std::string(", error: ") + e.what();
+			}
+			catch (...)
+			{
+			}
+			Astra::Log("Could not load model: " + load->_path + reason, ERR);
+			load->_promise.set_exception(load->_error ? load->_error : std::make_exception_ptr(std::runtime_error("Could not load model: " + load->_path)));
+			continue;
+		}
+
+		vkDestroyFence(AstraDevice.getVkDevice(), load->_fence, nullptr);
+		_loadCmdPool.destroy(load->_cmdBuf);
+		load->_fence = VK_NULL_HANDLE;
+		load->_cmdBuf = VK_NULL_HANDLE;
+
+		const int meshId = static_cast<int>(_objModels.size());
+		load->_mesh.meshId = meshId;
+		// the scene owns the mesh now, the load does not keep a copy of it
+		addLoadedModel(std::move(load->_mesh), load->_path, load->_transform);
+		load->_mesh = Mesh();
+		added = true;
+
+		load->_status = ModelLoadStatus::Done;
+		load->_progress = 1.0f;
+		load->_promise.set_value(meshId);
 	}
-	else
+
+	if (added)
+		createObjDescBuffer();
+
+	// callbacks go last, so they see the scene already updated
+	for (auto& load : finished)
 	{
-		_lazymodels.push_back(std::make_pair(filename, transform));
+		if (load->_onLoaded)
+			load->_onLoaded(load->_status == ModelLoadStatus::Done ? load->_future.get() : -1);
 	}
 }
 
+bool Astra::Scene::hasPendingLoads() const
+{
+	return !_pendingLoads.empty();
+}
+
 void Astra::Scene::init(nvvk::ResourceAllocator* alloc)
 {
 	if (_lazymodels.empty() && _objModels.empty())
 		throw std::runtime_error("Cant create an empty scene. Please add a mesh to it to start!");
 
 	_alloc = (nvvk::ResourceAllocatorDma*)alloc;
-	for (auto& p : _lazymodels)
-	{
-		loadModel(p.first, p.second);
-	}
+	_textureCache.init(_alloc);
+	_materialCache.init(_alloc);
+	// everything added before init is loaded as a single batch
+	const std::vector<ModelFile> lazyModels = std::move(_lazymodels);
 	_lazymodels.clear();
+	loadModels(lazyModels);
 	createCameraUBO();
 	createLightsUBO();
 }
 
 void Astra::Scene::destroy()
 {
+	// loads in flight own resources too
+	for (auto& load : _pendingLoads)
+	{
+		if (load->_cpuWork.valid())
+			load->_cpuWork.wait();
+		if (load->_fence != VK_NULL_HANDLE)
+		{
+			vkWaitForFences(AstraDevice.getVkDevice(), 1, &load->_fence, VK_TRUE, UINT64_MAX);
+			vkDestroyFence(AstraDevice.getVkDevice(), load->_fence, nullptr);
+			_loadCmdPool.destroy(load->_cmdBuf);
+
+			Mesh& m = load->_mesh;
+			destroyModelBuffers(m);
+			_textureCache.release(m.textureIds);
+			_materialCache.release(m.materialIds);
+		}
+	}
+	_pendingLoads.clear();
+	_loadCmdPool.deinit();
 
 	_alloc->destroy(_objDescBuffer);
+	_objDescs.clear();
+	_objDescCapacity = 0;
+	_objDescMeshCount = 0;
+	_objDescUploaded = 0;
+	destroyCullingBuffers();
+	destroyGpuDrivenBuffers();
 
 	for (auto& m : _objModels)
 	{
-		_alloc->destroy(m.vertexBuffer);
-		_alloc->destroy(m.indexBuffer);
-		_alloc->destroy(m.matColorBuffer);
-		_alloc->destroy(m.matIndexBuffer);
+		destroyModelBuffers(m);
 	}
 
-	for (auto& t : _textures)
-	{
-		_alloc->destroy(t);
-	}
+	_textureCache.destroy();
+	_materialCache.destroy();
 
-	for (auto& m : _instances)
-	{
-		m.destroy();
-	}
+	_instances.clear();
+	_instanceNodes.clear();
+	_frustumCuller.clear();
 
 	_alloc->destroy(_cameraUBO);
 	_alloc->destroy(_lightsUBO);
 }
 
 void Astra::Scene::addShape(Astra::Mesh& mesh) {
-	// find the offset for this model
-	auto txtOffset = static_cast<uint32_t>(getTextures().size());
 	// allocating cmdbuffers
 	nvvk::CommandPool cmdBufGet(AstraDevice.getVkDevice(), AstraDevice.getGraphicsQueueIndex());
 	VkCommandBuffer cmdBuf = cmdBufGet.createCommandBuffer();
@@ -155,15 +690,8 @@ void Astra::Scene::addShape(Astra::Mesh& mesh) {
 
 	mesh.meshId = getModels().size();
 
-	// creates the buffers and descriptors neeeded
-	mesh.create(cmdList, _alloc, txtOffset);
-
-	// Adds mesh textures to the scene texture buffer
-
-	for (const auto& p : mesh.textures)
-	{
-		getTextures().push_back(p);
-	}
+	// creates the buffers and descriptors neeeded, textures go to the scene table
+	mesh.create(cmdList, _alloc, _textureCache, _materialCache);
 
 	cmdBufGet.submitAndWait(cmdBuf);
 	_alloc->finalizeAndReleaseStaging();
@@ -180,54 +708,162 @@ void Astra::Scene::addShape(Astra::Mesh& mesh) {
 	createObjDescBuffer();
 }
 
+std::unique_ptr<Astra::GeometryBuilder> Astra::Scene::beginShape(size_t vertexCount, size_t triangleCount)
+{
+	return std::make_unique<GeometryBuilder>(_alloc, vertexCount, triangleCount);
+}
+
+int Astra::Scene::addShape(GeometryBuilder& builder, const WaveFrontMaterial& material)
+{
+	// the buffers are already filled, the mesh only takes them
+	Astra::Mesh mesh;
+	mesh.meshId = static_cast<int>(_objModels.size());
+	builder.finish(mesh, material, _materialCache);
+	addModel(mesh);
+
+	createObjDescBuffer();
+	return mesh.meshId;
+}
+
 void Astra::Scene::addModel(Astra::Mesh& model)
 {
 	_objModels.push_back(model);
+	_meshHandles.push();
+}
+
+void Astra::Scene::addModel(Astra::Mesh&& model)
+{
+	_objModels.push_back(std::move(model));
+	_meshHandles.push();
+}
+
+void Astra::Scene::destroyModelBuffers(Mesh& mesh)
+{
+	_alloc->destroy(mesh.vertexBuffer);
+	_alloc->destroy(mesh.indexBuffer);
+	_alloc->destroy(mesh.matIndexBuffer);
+	_alloc->destroy(mesh.dequantBuffer);
+	_alloc->destroy(mesh.meshletBuffer);
+	_alloc->destroy(mesh.lodIndexBuffer);
+	_alloc->destroy(mesh.lodTriangleBuffer);
+}
+
+void Astra::Scene::removeModel(MeshHandle handle)
+{
+	const uint32_t index = _meshHandles.find(handle);
+	if (index == HandleTable<Mesh>::InvalidIndex)
+		return;
+
+	// its instances go first, from the back so the ones moved into the gaps were already checked
+	for (size_t i = _instances.size(); i-- > 0;)
+	{
+		if (_instances.getMeshIndex(i) == index)
+			_instances.remove(i);
+	}
+
+	// previous frames may still be drawing it
+	AstraDevice.waitIdle();
+	Mesh& mesh = _objModels[index];
+	destroyModelBuffers(mesh);
+	_textureCache.release(mesh.textureIds);
+	_materialCache.release(mesh.materialIds);
+	releaseGpuGeometry(index);
+
+	// the last model fills the gap, the mesh id is its position
+	const uint32_t last = static_cast<uint32_t>(_objModels.size() - 1);
+	if (index != last)
+	{
+		_objModels[index] = std::move(_objModels[last]);
+		_objModels[index].meshId = static_cast<int>(index);
+		_instances.replaceMesh(last, index);
+	}
+	_objModels.pop_back();
+	_meshHandles.removeAt(index);
+
+	rebuildObjDescs();
+}
+
+Astra::MeshHandle Astra::Scene::getModelHandle(size_t index) const
+{
+	return _meshHandles.getHandle(static_cast<uint32_t>(index));
 }
 
-void Astra::Scene::addInstance(const MeshInstance& instance)
+int Astra::Scene::findModel(MeshHandle handle) const
 {
-	_instances.push_back(instance);
+	const uint32_t index = _meshHandles.find(handle);
+	return index == HandleTable<Mesh>::InvalidIndex ? -1 : static_cast<int>(index);
 }
 
-void Astra::Scene::removeInstance(const MeshInstance& n)
+Astra::InstanceHandle Astra::Scene::addInstance(const MeshInstance& instance)
 {
-	auto eraser = _instances.begin();
-	bool found = false;
-	for (auto it = _instances.begin(); it != _instances.end() && !found; ++it)
+	const size_t index = _instances.add(instance.getMeshIndex(), instance.getTransform(), instance.getName());
+	_instances.setVisible(index, instance.getVisible());
+	return _instances.getHandle(index);
+}
+
+Astra::InstanceHandle Astra::Scene::addInstance(MeshInstance* instance)
+{
+	const InstanceHandle handle = addInstance(*instance);
+	_instanceNodes.emplace_back(instance, handle);
+	return handle;
+}
+
+size_t Astra::Scene::addInstances(uint32_t meshIndex, const glm::mat4* transforms, size_t count, InstanceHandle* handles)
+{
+	const size_t first = _instances.add(meshIndex, transforms, count);
+	if (handles != nullptr)
 	{
-		if ((*it) == n)
+		for (size_t i = 0; i < count; i++)
 		{
-			eraser = it;
-			found = true;
+			handles[i] = _instances.getHandle(first + i);
 		}
 	}
-	if (found)
-		_instances.erase(eraser);
+	return first;
 }
 
-void Astra::Scene::addLight(Light* l)
+size_t Astra::Scene::addInstances(uint32_t meshIndex, const std::vector<glm::mat4>& transforms, std::vector<InstanceHandle>* handles)
 {
-	if (_lights.size() < MAX_LIGHTS)
-		_lights.push_back(l);
-	else
+	if (handles != nullptr)
+		handles->resize(transforms.size());
+	return addInstances(meshIndex, transforms.data(), transforms.size(), handles != nullptr ? handles->data() : nullptr);
+}
+
+void Astra::Scene::removeInstance(InstanceHandle handle)
+{
+	_instances.remove(handle);
+}
+
+Astra::LightHandle Astra::Scene::addLight(Light* l)
+{
+	if (_lights.size() >= MAX_LIGHTS)
+	{
 		Astra::Log("The maximum number of lights is " + std::to_string(MAX_LIGHTS) + "!", WARNING);
+		return {};
+	}
+	_lights.push_back(l);
+	return _lightHandles.push();
+}
+
+void Astra::Scene::removeLight(LightHandle handle)
+{
+	const uint32_t index = _lightHandles.find(handle);
+	if (index == HandleTable<Light>::InvalidIndex)
+		return;
+	_lights[index] = _lights.back();
+	_lights.pop_back();
+	_lightHandles.removeAt(index);
 }
 
 void Astra::Scene::removeLight(Light* l)
 {
-	auto eraser = _lights.begin();
-	bool found = false;
-	for (auto it = _lights.begin(); it != _lights.end() && !found; ++it)
+	for (size_t i = 0; i < _lights.size(); i++)
 	{
-		if (*(*it) == *l)
+		if (*_lights[i] == *l)
 		{
-			eraser = it;
-			found = true;
+			removeLight(_lightHandles.getHandle(static_cast<uint32_t>(i)));
+			return;
 		}
 	}
-	if (found)
-		_lights.erase(eraser);
 }
 
 void Astra::Scene::setCamera(CameraController* c)
@@ -251,32 +887,644 @@ void Astra::Scene::update(const CommandList& cmdList, float delta)
 	_camera->update(delta);
 	updateCameraUBO(cmdList);
 
-	// updating instances
-	for (auto& i : _instances)
+	// only the instances added by pointer have behaviour, what it changes goes to the storage
+	for (size_t i = 0; i < _instanceNodes.size();)
+	{
+		const uint32_t index = _instances.find(_instanceNodes[i].second);
+		if (index == InstanceStorage::InvalidIndex)
+		{
+			// removed by hand or along with its model
+			_instanceNodes[i] = _instanceNodes.back();
+			_instanceNodes.pop_back();
+			continue;
+		}
+		MeshInstance* instance = _instanceNodes[i].first;
+		if (instance->update(delta))
+		{
+			_instances.setLocalTransform(index, instance->getTransform());
+			_instances.setVisible(index, instance->getVisible());
+		}
+		i++;
+	}
+
+	// then only the moved subtrees and their level of detail change
+	_instances.updateTransforms();
+	// the GPU-driven raster picks them in its culling, ray tracing still needs them here
+	if (!_gpuDriven || isRt())
+		updateLods();
+}
+
+void Astra::Scene::updateLods()
+{
+	const float height = static_cast<float>(_camera->getWindowHeight());
+	if (_lodThreshold <= 0.0f || height <= 0.0f)
 	{
-		i.update(delta);
+		for (size_t i = 0; i < _instances.size(); i++)
+			_instances.setLod(i, 0);
+		return;
 	}
+
+	// pixels covered by one unit of object space at distance 1
+	const float pixelsPerUnit = height * 0.5f / std::tan(glm::radians(_camera->getFov()) * 0.5f);
+	const glm::vec3 eye = _camera->getEye();
+	const std::vector<glm::mat4>& transforms = _instances.getTransforms();
+	const std::vector<uint32_t>& meshes = _instances.getMeshIndices();
+	// every instance only writes its own level
+	AstraThreads.parallelFor(_instances.size(), [&](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; i++)
+			{
+				const Mesh& mesh = _objModels[meshes[i]];
+				const uint32_t lodCount = static_cast<uint32_t>(mesh.lods.size());
+				if (lodCount == 0)
+				{
+					_instances.setLod(i, 0);
+					continue;
+				}
+
+				const glm::mat4& transform = transforms[i];
+				const float scale = std::max(glm::length(glm::vec3(transform[0])), std::max(glm::length(glm::vec3(transform[1])), glm::length(glm::vec3(transform[2]))));
+				const glm::vec3 center = glm::vec3(transform * glm::vec4(mesh.bounds.center, 1.0f));
+				// from the closest point of the bounds, inside them the full mesh is drawn
+				const float distance = glm::length(center - eye) - mesh.bounds.radius * scale;
+				if (distance <= 0.0f)
+				{
+					_instances.setLod(i, 0);
+					continue;
+				}
+				auto projectedError = [&](uint32_t lod)
+				{
+					return lod == 0 ? 0.0f : mesh.lods[lod - 1].error * scale * pixelsPerUnit / distance;
+				};
+
+				uint32_t lod = std::min(_instances.getLod(i), lodCount);
+				while (lod > 0 && projectedError(lod) > _lodThreshold * LodHysteresis)
+					lod--;
+				while (lod < lodCount && projectedError(lod + 1) <= _lodThreshold / LodHysteresis)
+					lod++;
+				_instances.setLod(i, lod);
+			}
+		}, MinLodBatch);
+}
+
+uint32_t Astra::Scene::getObjDescIndex(size_t instance) const
+{
+	const uint32_t meshIndex = _instances.getMeshIndex(instance);
+	const uint32_t lod = _instances.getLod(instance);
+	const Mesh& mesh = _objModels[meshIndex];
+	if (lod == 0 || lod > mesh.lodDescriptors.size())
+		return mesh.descIndex;
+	return mesh.lodDescIndex + lod - 1;
 }
 
 void Astra::Scene::draw(RenderContext<PushConstantRaster>& renderContext)
 {
 	renderContext.pushConstant.nLights = _lights.size();
-	for (auto& inst : _instances)
+	if (_gpuDriven && _gpuDrawBuffer.buffer != VK_NULL_HANDLE && _gpuIndexBuffer.buffer != VK_NULL_HANDLE)
+	{
+		// the vertex shader takes the transform and the description of every draw from the buffers of cullGpuDriven()
+		const VkDevice device = AstraDevice.getVkDevice();
+		renderContext.pushConstant.instanceAddress = nvvk::getBufferDeviceAddress(device, _gpuInstanceBuffer.buffer);
+		renderContext.pushConstant.stateAddress = nvvk::getBufferDeviceAddress(device, _gpuStateBuffer.buffer);
+		renderContext.pushConstants();
+		renderContext.cmdList.drawIndexedIndirectCount(_gpuIndexBuffer.buffer, _gpuDrawBuffer.buffer, sizeof(uint32_t), _gpuDrawBuffer.buffer, 0, static_cast<uint32_t>(_instances.size()));
+		return;
+	}
+	renderContext.pushConstant.instanceAddress = 0;
+	renderContext.pushConstant.stateAddress = 0;
+	const std::vector<glm::mat4>& transforms = _instances.getTransforms();
+	const std::vector<uint32_t>& meshes = _instances.getMeshIndices();
+	const std::vector<uint32_t>& lods = _instances.getLods();
+	const std::vector<uint8_t>& flags = _instances.getFlags();
+	if (_frustumCulling)
+	{
+		// only the instances that moved get a new box
+		_frustumCuller.updateBounds(_instances, _objModels);
+		_frustumCuller.cull(_camera->getProjectionMatrix() * _camera->getViewMatrix());
+	}
+	for (size_t i = 0; i < _instances.size(); i++)
 	{
-		// skip invisibles
-		if (inst.getVisible())
+		// skip invisibles and the ones out of the camera
+		if ((flags[i] & eInstanceVisible) && (!_frustumCulling || _frustumCuller.isInside(i)))
 		{
 			// get model (with buffers) and update transform matrix
-			auto& model = _objModels[inst.getMeshIndex()];
-			inst.updatePushConstantRaster(renderContext.pushConstant);
+			auto& model = _objModels[meshes[i]];
+			renderContext.pushConstant.modelMatrix = transforms[i];
+			// simplified levels find their materials through their own description
+			renderContext.pushConstant.objIndex = getObjDescIndex(i);
+
+			if (isCulled(i) && lods[i] == 0)
+			{
+				// a draw per visible meshlet from the index buffer of the mesh, with the count written by cull()
+				renderContext.pushConstants();
+				renderContext.cmdList.drawIndexedIndirectCount(model.indexBuffer.buffer, _cullDrawBuffer.buffer, _cullFirstDraw[i] * sizeof(VkDrawIndexedIndirectCommand),
+					_cullCountBuffer.buffer, i * sizeof(uint32_t), model.meshletCount);
+			}
+			else
+			{
+				// send pc to gpu
+				renderContext.pushConstants();
+
+				// draw call
+				model.draw(renderContext.cmdList, lods[i]);
+			}
+		}
+	}
+}
+
+void Astra::Scene::updateCullingBuffers(const CommandList& cmdList)
+{
+	_cullMeshVersion = _instances.getMeshVersion();
+	_cullFirstDraw.assign(_instances.size(), NotCulled);
+
+	// every workgroup takes up to MESHLET_CULL_GROUP_SIZE meshlets of a single instance
+	const VkDevice device = AstraDevice.getVkDevice();
+	std::vector<CullChunk> chunks;
+	size_t drawCount = 0;
+	for (size_t i = 0; i < _instances.size(); i++)
+	{
+		const Mesh& mesh = _objModels[_instances.getMeshIndex(i)];
+		if (mesh.meshletCount == 0)
+			continue;
+		const size_t chunkCount = (mesh.meshletCount + MESHLET_CULL_GROUP_SIZE - 1) / MESHLET_CULL_GROUP_SIZE;
+		// past the budget the instances are drawn whole
+		if (drawCount + mesh.meshletCount > MaxMeshletDraws || chunks.size() + chunkCount > MaxCullChunks)
+			continue;
+
+		_cullFirstDraw[i] = static_cast<uint32_t>(drawCount);
+		const VkDeviceAddress meshletAddress = nvvk::getBufferDeviceAddress(device, mesh.meshletBuffer.buffer);
+		for (uint32_t first = 0; first < mesh.meshletCount; first += MESHLET_CULL_GROUP_SIZE)
+		{
+			chunks.push_back({ meshletAddress, static_cast<uint32_t>(i), first, mesh.meshletCount, static_cast<uint32_t>(drawCount) });
+		}
+		drawCount += mesh.meshletCount;
+	}
+	_cullChunkCount = static_cast<uint32_t>(chunks.size());
+	if (chunks.empty())
+		return;
+
+	const VkBufferUsageFlags flags = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+	reserveBuffer(_alloc, _cullChunkBuffer, _cullChunkCapacity, chunks.size(), sizeof(CullChunk), flags);
+	reserveBuffer(_alloc, _cullDrawBuffer, _cullDrawCapacity, drawCount, sizeof(VkDrawIndexedIndirectCommand), flags | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT);
+	reserveBuffer(_alloc, _cullCountBuffer, _cullCountCapacity, _instances.size(), sizeof(uint32_t), flags | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT);
+	updateBufferChunks(cmdList, _cullChunkBuffer, 0, chunks.size() * sizeof(CullChunk), chunks.data());
+}
+
+void Astra::Scene::destroyCullingBuffers()
+{
+	_alloc->destroy(_cullChunkBuffer);
+	_alloc->destroy(_cullDrawBuffer);
+	_alloc->destroy(_cullCountBuffer);
+	_cullChunkCapacity = 0;
+	_cullDrawCapacity = 0;
+	_cullCountCapacity = 0;
+	_cullChunkCount = 0;
+	_cullFirstDraw.clear();
+	// laid out again in the next cull()
+	_cullMeshVersion = _instances.getMeshVersion() - 1;
+}
+
+bool Astra::Scene::isCulled(size_t instance) const
+{
+	return _meshletCulling != 0 && _cullChunkCount > 0 && _cullMeshVersion == _instances.getMeshVersion() && instance < _cullFirstDraw.size() &&
+		   _cullFirstDraw[instance] != NotCulled;
+}
+
+void Astra::Scene::cull(const CommandList& cmdList, ComputePipeline* pipeline)
+{
+	if (_meshletCulling == 0 || _instances.empty())
+		return;
+
+	// the previous frame has to finish culling and drawing before the buffers are written again
+	VkMemoryBarrier beforeBarrier{ VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+	beforeBarrier.srcAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+	beforeBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	cmdList.pipelineBarrier(VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, { beforeBarrier }, {}, {});
+
+	// the transforms come from the same instance buffer as the GPU-driven raster, only the changed ones are uploaded
+	updateGpuInstances(cmdList);
+	// the layout only follows the meshes of the instances, moving them does not change it
+	if (_cullMeshVersion != _instances.getMeshVersion())
+		updateCullingBuffers(cmdList);
+	if (_cullChunkCount == 0)
+		return;
+
+	// every count starts at 0 and the shader adds the visible meshlets
+	cmdList.fillBuffer(_cullCountBuffer, 0, 0, _instances.size() * sizeof(uint32_t));
+	VkMemoryBarrier clearBarrier{ VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+	clearBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	clearBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	cmdList.pipelineBarrier(VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, { clearBarrier }, {}, {});
+
+	const VkDevice device = AstraDevice.getVkDevice();
+	PushConstantCull pc{};
+	pc.viewProj = _camera->getProjectionMatrix() * _camera->getViewMatrix();
+	pc.cameraPos = _camera->getEye();
+	pc.flags = _meshletCulling;
+	pc.chunkAddress = nvvk::getBufferDeviceAddress(device, _cullChunkBuffer.buffer);
+	pc.instanceAddress = nvvk::getBufferDeviceAddress(device, _gpuInstanceBuffer.buffer);
+	pc.drawAddress = nvvk::getBufferDeviceAddress(device, _cullDrawBuffer.buffer);
+	pc.countAddress = nvvk::getBufferDeviceAddress(device, _cullCountBuffer.buffer);
+
+	// every instance at once, one workgroup per chunk of meshlets
+	pipeline->bind(cmdList, {});
+	pipeline->pushConstants(cmdList, VK_SHADER_STAGE_COMPUTE_BIT, sizeof(PushConstantCull), &pc);
+	cmdList.dispatch(_cullChunkCount);
+
+	VkMemoryBarrier afterBarrier{ VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+	afterBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	afterBarrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+	cmdList.pipelineBarrier(VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, 0, { afterBarrier }, {}, {});
+}
+
+void Astra::Scene::updateGpuGeometry(const CommandList& cmdList)
+{
+	_gpuGeometryDirty = false;
+	// only the models without a block get one, the others keep theirs
+	_gpuMeshBlocks.resize(_objModels.size(), { NoIndexBlock, 0 });
+	std::vector<size_t> placed;
+	for (size_t m = 0; m < _objModels.size(); m++)
+	{
+		if (_gpuMeshBlocks[m].first != NoIndexBlock)
+			continue;
+		const VkDeviceSize count = getGpuIndexCount(_objModels[m]);
+		_gpuMeshBlocks[m] = { count > 0 ? allocateGpuIndices(cmdList, count) : 0, count };
+		placed.push_back(m);
+	}
+	if (_gpuIndexBuffer.buffer == VK_NULL_HANDLE)
+		return;
+
+	// copied on the GPU once the buffer has its final size, the indices never go back through the CPU
+	for (size_t m : placed)
+	{
+		const Mesh& mesh = _objModels[m];
+		const VkDeviceSize first = _gpuMeshBlocks[m].first;
+		if (mesh.getIndexCount() > 0)
+			cmdList.copyBuffer(mesh.indexBuffer, _gpuIndexBuffer, 0, first * sizeof(uint32_t), mesh.getIndexCount() * sizeof(uint32_t));
+		if (getGpuLodCount(mesh) > 0 && mesh.getLodIndexCount() > 0)
+			cmdList.copyBuffer(mesh.lodIndexBuffer, _gpuIndexBuffer, 0, (first + mesh.getIndexCount()) * sizeof(uint32_t), mesh.getLodIndexCount() * sizeof(uint32_t));
+	}
+
+	// the tables are small and the descriptions may have been laid out again, they are written whole
+	std::vector<GpuMesh> meshes(_objModels.size());
+	std::vector<GpuDrawRange> ranges(_objDescs.size());
+	for (size_t m = 0; m < _objModels.size(); m++)
+	{
+		const Mesh& mesh = _objModels[m];
+		const uint32_t lodCount = getGpuLodCount(mesh);
+		// meshes without bounds are never culled and always drawn whole
+		meshes[m].center = mesh.bounds.center;
+		meshes[m].radius = mesh.bounds.valid ? mesh.bounds.radius : std::numeric_limits<float>::infinity();
+		meshes[m].descIndex = mesh.descIndex;
+		meshes[m].lodCount = lodCount;
+
+		// the levels of detail of a model follow its indices, the same as its descriptions
+		const VkDeviceSize first = _gpuMeshBlocks[m].first;
+		ranges[mesh.descIndex] = { static_cast<uint32_t>(first), static_cast<uint32_t>(mesh.getIndexCount()), 0.0f };
+		const VkDeviceSize lodFirst = first + mesh.getIndexCount();
+		for (uint32_t l = 0; l < lodCount; l++)
+		{
+			const MeshLod& level = mesh.lods[l];
+			ranges[mesh.descIndex + 1 + l] = { static_cast<uint32_t>(lodFirst + level.firstIndex), level.indexCount, level.error };
+		}
+	}
+
+	const VkBufferUsageFlags flags = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+	reserveBuffer(_alloc, _gpuMeshBuffer, _gpuMeshCapacity, meshes.size(), sizeof(GpuMesh), flags);
+	reserveBuffer(_alloc, _gpuRangeBuffer, _gpuRangeCapacity, ranges.size(), sizeof(GpuDrawRange), flags);
+	updateBufferChunks(cmdList, _gpuMeshBuffer, 0, meshes.size() * sizeof(GpuMesh), meshes.data());
+	updateBufferChunks(cmdList, _gpuRangeBuffer, 0, ranges.size() * sizeof(GpuDrawRange), ranges.data());
+}
+
+VkDeviceSize Astra::Scene::allocateGpuIndices(const CommandList& cmdList, VkDeviceSize count)
+{
+	std::vector<IndexBlock>& freeBlocks = *_gpuFreeBlocks;
+	auto takeFree = [&freeBlocks, count](VkDeviceSize& first) {
+		for (IndexBlock& block : freeBlocks)
+		{
+			if (block.count < count)
+				continue;
+			first = block.first;
+			block.first += count;
+			block.count -= count;
+			if (block.count == 0)
+			{
+				block = freeBlocks.back();
+				freeBlocks.pop_back();
+			}
+			return true;
+		}
+		return false;
+	};
+
+	VkDeviceSize first = 0;
+	if (takeFree(first))
+		return first;
+
+	// neighbouring blocks may fit it once merged
+	std::sort(freeBlocks.begin(), freeBlocks.end(), [](const IndexBlock& a, const IndexBlock& b) { return a.first < b.first; });
+	size_t kept = 0;
+	for (size_t i = 0; i < freeBlocks.size(); i++)
+	{
+		if (kept > 0 && freeBlocks[kept - 1].first + freeBlocks[kept - 1].count == freeBlocks[i].first)
+			freeBlocks[kept - 1].count += freeBlocks[i].count;
+		else
+			freeBlocks[kept++] = freeBlocks[i];
+	}
+	freeBlocks.resize(kept);
+	// a free block at the end goes back to the unused space
+	if (!freeBlocks.empty() && freeBlocks.back().first + freeBlocks.back().count == _gpuIndexEnd)
+	{
+		_gpuIndexEnd = freeBlocks.back().first;
+		freeBlocks.pop_back();
+	}
+	if (takeFree(first))
+		return first;
+
+	if (_gpuIndexEnd + count > _gpuIndexCapacity)
+	{
+		// doubling, so adding models one by one only creates it log(N) times
+		const size_t capacity = std::max(static_cast<size_t>(_gpuIndexEnd + count), std::max(_gpuIndexCapacity * 2, MinGpuIndexCapacity));
+		nvvk::Buffer buffer = _alloc->createBuffer(capacity * sizeof(uint32_t),
+			VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
+		if (_gpuIndexBuffer.buffer != VK_NULL_HANDLE)
+		{
+			if (_gpuIndexEnd > 0)
+			{
+				// the blocks keep their place, the copies that filled them have to land before they are read
+				VkMemoryBarrier barrier{ VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+				barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+				barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+				cmdList.pipelineBarrier(VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, { barrier }, {}, {});
+				cmdList.copyBuffer(_gpuIndexBuffer, buffer, 0, 0, _gpuIndexEnd * sizeof(uint32_t));
+			}
+			// frames in flight may still be drawing with the old one, it goes once they finish
+			nvvk::ResourceAllocatorDma* alloc = _alloc;
+			AstraDevice.retire([alloc, old = _gpuIndexBuffer]() mutable { alloc->destroy(old); });
+		}
+		_gpuIndexBuffer = buffer;
+		_gpuIndexCapacity = capacity;
+	}
+	first = _gpuIndexEnd;
+	_gpuIndexEnd += count;
+	return first;
+}
+
+void Astra::Scene::releaseGpuGeometry(uint32_t index)
+{
+	_gpuGeometryDirty = true;
+	// neither it nor the models after it have a block yet
+	if (index >= _gpuMeshBlocks.size())
+		return;
+
+	const IndexBlock block = _gpuMeshBlocks[index];
+	if (block.first != NoIndexBlock && block.count > 0)
+	{
+		// the frames in flight may still draw from it; if the buffers are destroyed before they finish, the block is dropped with them
+		std::weak_ptr<std::vector<IndexBlock>> freeBlocks = _gpuFreeBlocks;
+		AstraDevice.retire([freeBlocks, block]() {
+			if (std::shared_ptr<std::vector<IndexBlock>> blocks = freeBlocks.lock())
+				blocks->push_back(block);
+		});
+	}
+
+	// the same swap removeModel() does with the models
+	const size_t last = _objModels.size() - 1;
+	_gpuMeshBlocks[index] = last < _gpuMeshBlocks.size() ? _gpuMeshBlocks[last] : IndexBlock{ NoIndexBlock, 0 };
+	if (_gpuMeshBlocks.size() > last)
+		_gpuMeshBlocks.resize(last);
+}
+
+void Astra::Scene::updateGpuInstances(const CommandList& cmdList)
+{
+	const size_t count = _instances.size();
+	bool all = false;
+	if (count > _gpuInstanceCapacity)
+	{
+		// doubling, so adding instances one by one only creates them log(N) times
+		const size_t capacity = std::max(count, std::max(_gpuInstanceCapacity * 2, MinGpuInstanceCapacity));
+		if (_gpuInstanceBuffer.buffer != VK_NULL_HANDLE)
+		{
+			// frames in flight may still be drawing with them, they go once those finish
+			nvvk::ResourceAllocatorDma* alloc = _alloc;
+			AstraDevice.retire([alloc, instances = _gpuInstanceBuffer, states = _gpuStateBuffer, draws = _gpuDrawBuffer]() mutable {
+				alloc->destroy(instances);
+				alloc->destroy(states);
+				alloc->destroy(draws);
+			});
+		}
+		const VkBufferUsageFlags flags = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+		_gpuInstanceBuffer = _alloc->createBuffer(capacity * sizeof(GpuInstance), flags);
+		_gpuStateBuffer = _alloc->createBuffer(capacity * sizeof(GpuInstanceState), flags);
+		_gpuDrawBuffer = _alloc->createBuffer(sizeof(uint32_t) + capacity * sizeof(VkDrawIndexedIndirectCommand), flags | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT);
+		// every instance starts with its full mesh
+		cmdList.fillBuffer(_gpuStateBuffer, 0);
+		_gpuInstanceCapacity = capacity;
+		all = true;
+	}
+	_gpuInstances.resize(count);
+	// static frames do not walk the instances
+	if (!_instances.consumeGpuPending() && !all)
+		return;
+
+	const std::vector<glm::mat4>& transforms = _instances.getTransforms();
+	const std::vector<uint32_t>& meshes = _instances.getMeshIndices();
+	const std::vector<uint8_t>& flags = _instances.getFlags();
+	// every run of changed instances becomes a region, packed one after another in the staging buffer
+	std::vector<VkBufferCopy> runs;
+	VkDeviceSize runBytes = 0;
+	size_t runStart = count;
+	for (size_t i = 0; i <= count; i++)
+	{
+		const bool dirty = i < count && (_instances.consumeGpuDirty(i) || all);
+		if (dirty)
+		{
+			_gpuInstances[i].transform = transforms[i];
+			_gpuInstances[i].mesh = meshes[i];
+			_gpuInstances[i].visible = (flags[i] & eInstanceVisible) ? 1u : 0u;
+			if (runStart == count)
+				runStart = i;
+		}
+		else if (runStart != count)
+		{
+			const VkDeviceSize size = (i - runStart) * sizeof(GpuInstance);
+			runs.push_back({ runBytes, runStart * sizeof(GpuInstance), size });
+			runBytes += size;
+			runStart = count;
+		}
+	}
+	if (runs.empty())
+		return;
 
-			// send pc to gpu
-			renderContext.pushConstants();
+	const uint8_t* data = reinterpret_cast<const uint8_t*>(_gpuInstances.data());
+	const uint32_t frameCount = AstraDevice.getFrameCount();
+	if (runBytes <= MaxUpdateSize || frameCount == 0)
+	{
+		// a few instances go inside the command buffer, without staging
+		for (const VkBufferCopy& run : runs)
+			updateBufferChunks(cmdList, _gpuInstanceBuffer, run.dstOffset, run.size, data + run.dstOffset);
+		return;
+	}
 
-			// draw call
-			model.draw(renderContext.cmdList);
+	// the rest go through the staging buffer of this frame, what it held was already copied when the frame fence signalled
+	if (_gpuStaging.size() < frameCount)
+		_gpuStaging.resize(frameCount);
+	FrameStaging& staging = _gpuStaging[AstraDevice.getFrameIndex()];
+	if (runBytes > staging.size)
+	{
+		if (staging.buffer.buffer != VK_NULL_HANDLE)
+		{
+			nvvk::ResourceAllocatorDma* alloc = _alloc;
+			AstraDevice.retire([alloc, old = staging.buffer]() mutable {
+				alloc->unmap(old);
+				alloc->destroy(old);
+			});
 		}
+		staging.size = std::max(runBytes, staging.size * 2);
+		staging.buffer = _alloc->createBuffer(staging.size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+		staging.data = _alloc->map(staging.buffer);
+	}
+	uint8_t* mapped = static_cast<uint8_t*>(staging.data);
+	for (const VkBufferCopy& run : runs)
+	{
+		std::memcpy(mapped + run.srcOffset, data + run.dstOffset, run.size);
+	}
+	vkCmdCopyBuffer(cmdList.getCommandBuffer(), staging.buffer.buffer, _gpuInstanceBuffer.buffer, static_cast<uint32_t>(runs.size()), runs.data());
+}
+
+void Astra::Scene::destroyGpuDrivenBuffers()
+{
+	_alloc->destroy(_gpuIndexBuffer);
+	_alloc->destroy(_gpuMeshBuffer);
+	_alloc->destroy(_gpuRangeBuffer);
+	_alloc->destroy(_gpuInstanceBuffer);
+	_alloc->destroy(_gpuStateBuffer);
+	_alloc->destroy(_gpuDrawBuffer);
+	for (FrameStaging& staging : _gpuStaging)
+	{
+		if (staging.buffer.buffer == VK_NULL_HANDLE)
+			continue;
+		_alloc->unmap(staging.buffer);
+		_alloc->destroy(staging.buffer);
+	}
+	_gpuStaging.clear();
+	_gpuInstances.clear();
+	_gpuInstanceCapacity = 0;
+	_gpuIndexCapacity = 0;
+	_gpuIndexEnd = 0;
+	_gpuMeshBlocks.clear();
+	// blocks still retired point into the destroyed buffer, they are dropped
+	_gpuFreeBlocks = std::make_shared<std::vector<IndexBlock>>();
+	_gpuMeshCapacity = 0;
+	_gpuRangeCapacity = 0;
+	_gpuGeometryDirty = true;
+}
+
+void Astra::Scene::cullGpuDriven(const CommandList& cmdList, ComputePipeline* pipeline)
+{
+	if (_instances.empty() || _objModels.empty())
+		return;
+
+	// the previous frame has to finish drawing before the buffers are written again
+	VkMemoryBarrier beforeBarrier{ VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+	beforeBarrier.srcAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+	beforeBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	cmdList.pipelineBarrier(VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, { beforeBarrier }, {}, {});
+
+	if (_gpuGeometryDirty)
+		updateGpuGeometry(cmdList);
+	if (_gpuIndexBuffer.buffer == VK_NULL_HANDLE)
+		return;
+	updateGpuInstances(cmdList);
+
+	// the count starts at 0 and the shader adds the visible instances
+	cmdList.fillBuffer(_gpuDrawBuffer, 0, 0, sizeof(uint32_t));
+	VkMemoryBarrier uploadBarrier{ VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+	uploadBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	uploadBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_INDEX_READ_BIT;
+	cmdList.pipelineBarrier(VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT, 0,
+		{ uploadBarrier }, {}, {});
+
+	const VkDevice device = AstraDevice.getVkDevice();
+	const float height = static_cast<float>(_camera->getWindowHeight());
+	PushConstantGpuCull pc{};
+	pc.viewProj = _camera->getProjectionMatrix() * _camera->getViewMatrix();
+	pc.cameraPos = _camera->getEye();
+	pc.instanceCount = static_cast<uint32_t>(_instances.size());
+	pc.instanceAddress = nvvk::getBufferDeviceAddress(device, _gpuInstanceBuffer.buffer);
+	pc.meshAddress = nvvk::getBufferDeviceAddress(device, _gpuMeshBuffer.buffer);
+	pc.rangeAddress = nvvk::getBufferDeviceAddress(device, _gpuRangeBuffer.buffer);
+	pc.stateAddress = nvvk::getBufferDeviceAddress(device, _gpuStateBuffer.buffer);
+	pc.drawAddress = nvvk::getBufferDeviceAddress(device, _gpuDrawBuffer.buffer);
+	// same scale as updateLods()
+	pc.pixelsPerUnit = height * 0.5f / std::tan(glm::radians(_camera->getFov()) * 0.5f);
+	pc.lodThreshold = height > 0.0f ? _lodThreshold : 0.0f;
+
+	pipeline->bind(cmdList, {});
+	pipeline->pushConstants(cmdList, VK_SHADER_STAGE_COMPUTE_BIT, sizeof(PushConstantGpuCull), &pc);
+	cmdList.dispatch((pc.instanceCount + GPU_CULL_GROUP_SIZE - 1) / GPU_CULL_GROUP_SIZE);
+
+	VkMemoryBarrier afterBarrier{ VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+	afterBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	afterBarrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+	cmdList.pipelineBarrier(VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT, 0, { afterBarrier }, {}, {});
+}
+
+void Astra::Scene::setMeshletCulling(uint32_t flags)
+{
+	if (flags != 0 && !AstraDevice.getGpuDrivenSupported())
+	{
+		Astra::Log("The device does not support indirect count draws, the meshlet culling stays disabled", WARNING);
+		return;
+	}
+	_meshletCulling = flags;
+}
+
+uint32_t Astra::Scene::getMeshletCulling() const
+{
+	return _meshletCulling;
+}
+
+void Astra::Scene::setLodThreshold(float pixels)
+{
+	_lodThreshold = pixels;
+}
+
+float Astra::Scene::getLodThreshold() const
+{
+	return _lodThreshold;
+}
+
+void Astra::Scene::setFrustumCulling(bool enabled)
+{
+	_frustumCulling = enabled;
+}
+
+bool Astra::Scene::getFrustumCulling() const
+{
+	return _frustumCulling;
+}
+
+size_t Astra::Scene::getFrustumCulledCount() const
+{
+	return _frustumCulling && !_gpuDriven ? _frustumCuller.getCulledCount() : 0;
+}
+
+void Astra::Scene::setGpuDriven(bool enabled)
+{
+	if (enabled && !AstraDevice.getGpuDrivenSupported())
+	{
+		Astra::Log("The device does not support indirect count draws, the GPU-driven raster stays disabled", WARNING);
+		return;
 	}
+	_gpuDriven = enabled;
+}
+
+bool Astra::Scene::getGpuDriven() const
+{
+	return _gpuDriven;
 }
 
 void Astra::SceneRT::draw(RenderContext<PushConstantRay>& renderContext)
@@ -295,7 +1543,7 @@ Astra::CameraController* Astra::Scene::getCamera() const
 	return _camera;
 }
 
-std::vector<Astra::MeshInstance>& Astra::Scene::getInstances()
+Astra::InstanceStorage& Astra::Scene::getInstances()
 {
 	return _instances;
 }
@@ -305,9 +1553,19 @@ std::vector<Astra::Mesh>& Astra::Scene::getModels()
 	return _objModels;
 }
 
-std::vector<nvvk::Texture>& Astra::Scene::getTextures()
+const std::vector<nvvk::Texture>& Astra::Scene::getTextures() const
+{
+	return _textureCache.getTextures();
+}
+
+Astra::TextureCache& Astra::Scene::getTextureCache()
+{
+	return _textureCache;
+}
+
+const nvvk::Buffer& Astra::Scene::getMaterialBuff() const
 {
-	return _textures;
+	return _materialCache.getBuffer();
 }
 
 nvvk::Buffer& Astra::Scene::getObjDescBuff()
@@ -357,18 +1615,33 @@ void Astra::SceneRT::init(nvvk::ResourceAllocator* alloc)
 void Astra::SceneRT::update(const CommandList& cmdList, float delta)
 {
 	Astra::Scene::update(cmdList, delta);
-	std::vector<int> asupdates;
-	for (int i = 0; i < _instances.size(); i++)
+
+	// every changed instance is patched, then the TLAS is refitted once
+	bool changed = false;
+	const size_t count = std::min(_instances.size(), _asInstances.size());
+	for (size_t i = 0; i < count; i++)
+	{
+		// far instances are traced against the BLAS of their level of detail
+		if (_instances.isDirty(i) || _asInstances[i].instanceCustomIndex != getObjDescIndex(i))
+		{
+			_asInstances[i] = toRayInstance(i);
+			changed = true;
+		}
+	}
+	// the TLAS keeps its size until reset(), removed instances are hidden and new ones wait for it
+	for (size_t i = count; i < _asInstances.size(); i++)
 	{
-		if (_instances[i].update(delta))
+		if (_asInstances[i].mask != 0)
 		{
-			asupdates.push_back(i);
+			_asInstances[i].mask = 0;
+			changed = true;
 		}
 	}
+	_instances.clearDirty();
 
-	for (int i : asupdates)
+	if (changed)
 	{
-		updateTopLevelAS(i);
+		_rtBuilder.buildTlas(_asInstances, VK_BUILD_ACCELERATION_STRUCTURE_ALLOW_UPDATE_BIT_KHR | VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_TRACE_BIT_KHR, true);
 	}
 }
 
@@ -382,52 +1655,110 @@ void Astra::SceneRT::createBottomLevelAS()
 	std::vector<nvvk::RaytracingBuilderKHR::BlasInput> allBlas;
 	allBlas.reserve(_objModels.size());
 
+	// same order as the descriptions, so the BLAS of every mesh and level is at its description slot
 	for (const auto& obj : _objModels)
 	{
 		auto blas = AstraDevice.objectToVkGeometry(obj);
 
 		allBlas.emplace_back(blas);
+		for (uint32_t lod = 1; lod <= obj.lods.size(); lod++)
+		{
+			allBlas.emplace_back(AstraDevice.objectToVkGeometry(obj, lod));
+		}
 	}
+	_blasModelCount = _objModels.size();
 
 	_rtBuilder.buildBlas(allBlas, VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_TRACE_BIT_KHR);
 }
 
-void Astra::SceneRT::createTopLevelAS()
+void Astra::SceneRT::appendBottomLevelAS()
 {
-	if (getTLAS() != VK_NULL_HANDLE)
+	std::vector<nvvk::RaytracingBuilderKHR::BlasInput> newBlas;
+	for (size_t m = _blasModelCount; m < _objModels.size(); m++)
 	{
-		_rtBuilder.destroy();
-		_asInstances.clear();
+		const Mesh& obj = _objModels[m];
+		newBlas.emplace_back(AstraDevice.objectToVkGeometry(obj));
+		for (uint32_t lod = 1; lod <= obj.lods.size(); lod++)
+		{
+			newBlas.emplace_back(AstraDevice.objectToVkGeometry(obj, lod));
+		}
 	}
+	_blasModelCount = _objModels.size();
+	// buildBlas() appends, the descriptions of the new models start where the existing BLAS end
+	if (!newBlas.empty())
+		_rtBuilder.buildBlas(newBlas, VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_TRACE_BIT_KHR);
+}
+
+void Astra::SceneRT::publishAsyncLoads()
+{
+	const size_t modelCount = _objModels.size();
+	Scene::publishAsyncLoads();
+	if (_objModels.size() == modelCount || getTLAS() == VK_NULL_HANDLE)
+		return;
+	appendBottomLevelAS();
+	// the TLAS grows with the new instances, an update can not change its size
+	createTopLevelAS();
+}
+
+void Astra::SceneRT::removeModel(MeshHandle handle)
+{
+	const int index = findModel(handle);
+	if (index < 0)
+		return;
+	// the descriptions from the removed model on are laid out again, the BLAS before it keep their slots
+	const uint32_t firstSlot = _objModels[index].descIndex;
+	const bool built = static_cast<size_t>(index) < _blasModelCount;
+	Scene::removeModel(handle);
+	if (!built || getTLAS() == VK_NULL_HANDLE)
+		return;
+
+	// Scene::removeModel() already waited for the GPU
+	_rtBuilder.destroyBlasFrom(firstSlot);
+	_blasModelCount = static_cast<size_t>(index);
+	appendBottomLevelAS();
+	// the instances of the moved model point at other BLAS and there are fewer of them
+	createTopLevelAS();
+}
+
+void Astra::SceneRT::createTopLevelAS()
+{
+	// the BLAS stay, only the TLAS is built again, the old one goes once the frames tracing it finish
+	_rtBuilder.retireTlas();
+	_asInstances.clear();
 	_asInstances.reserve(_instances.size());
-	for (const Astra::MeshInstance& inst : _instances)
+	for (size_t i = 0; i < _instances.size(); i++)
 	{
-		VkAccelerationStructureInstanceKHR rayInst{};
-		rayInst.transform = nvvk::toTransformMatrixKHR(inst.getTransform());
-		rayInst.instanceCustomIndex = inst.getMeshIndex(); // gl_InstanceCustomIndexEXT
-		rayInst.accelerationStructureReference = _rtBuilder.getBlasDeviceAddress(inst.getMeshIndex());
-		rayInst.flags = VK_GEOMETRY_INSTANCE_TRIANGLE_FRONT_COUNTERCLOCKWISE_BIT_KHR;
-		rayInst.mask = inst.getVisible() ? 0xFF : 0x00;		// only be hit if raymask & instance.mask != 0
-		rayInst.instanceShaderBindingTableRecordOffset = 0; // the same hit group for all objects
-
-		_asInstances.emplace_back(rayInst);
+		_asInstances.emplace_back(toRayInstance(i));
 	}
+	_instances.clearDirty();
 	_rtBuilder.buildTlas(_asInstances, VK_BUILD_ACCELERATION_STRUCTURE_ALLOW_UPDATE_BIT_KHR | VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_TRACE_BIT_KHR);
 }
 
 void Astra::SceneRT::updateTopLevelAS(int instance_id)
 {
-	const auto& inst = _instances[instance_id];
+	_asInstances[instance_id] = toRayInstance(instance_id);
+
+	_rtBuilder.buildTlas(_asInstances, VK_BUILD_ACCELERATION_STRUCTURE_ALLOW_UPDATE_BIT_KHR | VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_TRACE_BIT_KHR, true);
+}
+
+bool Astra::SceneRT::hasBlas(size_t instance) const
+{
+	// descriptions are only appended, so the ones of the models the BLAS were built for are still at their slots
+	return _instances.getMeshIndex(instance) < _blasModelCount;
+}
+
+VkAccelerationStructureInstanceKHR Astra::SceneRT::toRayInstance(size_t instance)
+{
+	const uint32_t object = getObjDescIndex(instance);
+	const bool traced = hasBlas(instance);
 	VkAccelerationStructureInstanceKHR rayInst{};
-	rayInst.transform = nvvk::toTransformMatrixKHR(inst.getTransform());
-	rayInst.instanceCustomIndex = inst.getMeshIndex(); // gl_InstanceCustomIndexEXT
-	rayInst.accelerationStructureReference = _rtBuilder.getBlasDeviceAddress(inst.getMeshIndex());
+	rayInst.transform = nvvk::toTransformMatrixKHR(_instances.getTransform(instance));
+	rayInst.instanceCustomIndex = object; // gl_InstanceCustomIndexEXT
+	rayInst.accelerationStructureReference = _rtBuilder.getBlasDeviceAddress(traced ? object : 0);
 	rayInst.flags = VK_GEOMETRY_INSTANCE_TRIANGLE_FRONT_COUNTERCLOCKWISE_BIT_KHR;
-	rayInst.mask = inst.getVisible() ? 0xFF : 0x00;		// only be hit if raymask & instance.mask != 0
+	rayInst.mask = traced && _instances.getVisible(instance) ? 0xFF : 0x00; // only be hit if raymask & instance.mask != 0
 	rayInst.instanceShaderBindingTableRecordOffset = 0; // the same hit group for all objects
-	_asInstances[instance_id] = rayInst;
-
-	_rtBuilder.buildTlas(_asInstances, VK_BUILD_ACCELERATION_STRUCTURE_ALLOW_UPDATE_BIT_KHR | VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_TRACE_BIT_KHR, true);
+	return rayInst;
 }
 
 void Astra::SceneRT::rebuildAS()
@@ -0,0 +1,134 @@
+#include <Texture.h>
+#include <TextureCompression.h>
+#include <MipGenerator.h>
+#include <Utils.h>
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+#include <filesystem>
+#include <algorithm>
+#include <cstring>
+#include <cctype>
+
+namespace
+{
+	bool isKtx2(const std::string& path)
+	{
+		std::string extension = std::filesystem::path(path).extension().string();
+		std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+		return extension == ".ktx2";
+	}
+
+	// the compressed file is only valid if it was written after the image
+	bool upToDate(const std::string& compressedPath, const std::string& sourcePath)
+	{
+		std::error_code ec;
+		const auto compressedTime = std::filesystem::last_write_time(compressedPath, ec);
+		if (ec)
+			return false;
+		const auto sourceTime = std::filesystem::last_write_time(sourcePath, ec);
+		return !ec && compressedTime >= sourceTime;
+	}
+
+	Astra::TextureData missingTexture(const std::string& path)
+	{
+		Astra::Log("Could not load texture: " + path, Astra::WARNING);
+		Astra::TextureData data;
+		data.width = data.height = 1;
+		data.pixels = { 255u, 0u, 255u, 255u };
+		return data;
+	}
+
+	Astra::TextureData supported(Astra::TextureData data, const Astra::TextureLoadOptions& options)
+	{
+		if (data.isCompressed() && !options.compressedSupported)
+			data = Astra::decompressTexture(data);
+		if (!data.isCompressed() && data.levelOffsets.size() <= 1)
+			Astra::generateMipChain(data);
+		return data;
+	}
+
+	// takes the stb pixels and frees them
+	Astra::TextureData process(stbi_uc* pixels, int width, int height, bool compress)
+	{
+		Astra::TextureData data;
+		data.width = static_cast<uint32_t>(width);
+		data.height = static_cast<uint32_t>(height);
+		data.pixels.resize(static_cast<size_t>(width) * height * 4);
+		std::memcpy(data.pixels.data(), pixels, data.pixels.size());
+		stbi_image_free(pixels);
+
+		if (compress)
+			return Astra::compressTexture(data, Astra::chooseCompressedFormat(data));
+		Astra::generateMipChain(data);
+		return data;
+	}
+}
+
+uint32_t Astra::TextureData::getLevelCount() const
+{
+	return std::max<uint32_t>(1, static_cast<uint32_t>(levelOffsets.size()));
+}
+
+uint32_t Astra::TextureData::getLevelWidth(uint32_t level) const
+{
+	return std::max(1u, width >> level);
+}
+
+uint32_t Astra::TextureData::getLevelHeight(uint32_t level) const
+{
+	return std::max(1u, height >> level);
+}
+
+const uint8_t* Astra::TextureData::getLevelData(uint32_t level) const
+{
+	return pixels.data() + (levelOffsets.empty() ? 0 : levelOffsets[level]);
+}
+
+size_t Astra::TextureData::getLevelSize(uint32_t level) const
+{
+	return getTextureLevelSize(format, getLevelWidth(level), getLevelHeight(level));
+}
+
+bool Astra::TextureData::isCompressed() const
+{
+	return format != TextureFormat::RGBA8;
+}
+
+Astra::TextureData Astra::loadTextureData(const std::string& path, const TextureLoadOptions& options)
+{
+	TextureData data;
+	if (isKtx2(path))
+	{
+		if (!readKtx2(path, data))
+			return missingTexture(path);
+		return supported(std::move(data), options);
+	}
+
+	const bool compress = options.compress && options.compressedSupported;
+	const std::string cachePath = options.useCache ? getTextureCachePath(path, options.cacheDirectory) : "";
+	// a cache made with other options is rebuilt
+	if (options.useCache && upToDate(cachePath, path) && readKtx2(cachePath, data) && data.isCompressed() == compress && !data.levelOffsets.empty())
+		return data;
+
+	int texWidth, texHeight, texChannels;
+	stbi_uc* pixels = stbi_load(path.c_str(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
+
+	// Handle failure
+	if (!pixels)
+		return missingTexture(path);
+
+	data = process(pixels, texWidth, texHeight, compress);
+
+	if (options.useCache && !writeKtx2(cachePath, data))
+		Astra::Log("Could not write texture cache: " + cachePath, WARNING);
+	return data;
+}
+
+Astra::TextureData Astra::loadTextureData(const uint8_t* bytes, size_t size, const std::string& name, const TextureLoadOptions& options)
+{
+	int texWidth, texHeight, texChannels;
+	stbi_uc* pixels = stbi_load_from_memory(bytes, static_cast<int>(size), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
+	if (!pixels)
+		return missingTexture(name);
+	return process(pixels, texWidth, texHeight, options.compress && options.compressedSupported);
+}
@@ -0,0 +1,229 @@
+#include <TextureCache.h>
+#include <Device.h>
+#include <MappedFile.h>
+#include <ThreadPool.h>
+#include <Utils.h>
+#include <filesystem>
+#include <cassert>
+
+namespace
+{
+	// 0 means the file could not be read, those are only matched by path
+	uint64_t hashFile(const std::string& path)
+	{
+		Astra::MappedFile file;
+		if (!file.open(path))
+			return 0;
+		const uint64_t hash = Astra::hashBytes(file.data(), file.size());
+		return hash == 0 ? 1 : hash;
+	}
+}
+
+void Astra::TextureCache::init(nvvk::ResourceAllocatorDma* alloc)
+{
+	_alloc = alloc;
+}
+
+void Astra::TextureCache::destroy()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	for (size_t i = 0; i < _textures.size(); i++)
+	{
+		// freed slots only hold a copy of the dummy
+		if (i == 0 || _refCounts[i] > 0)
+			_alloc->destroy(_textures[i]);
+	}
+	_textures.clear();
+	_refCounts.clear();
+	_slotHashes.clear();
+	_freeSlots.clear();
+	_pathSlots.clear();
+	_hashSlots.clear();
+}
+
+void Astra::TextureCache::createDummy(const CommandList& cmdList)
+{
+	_textures.push_back(AstraDevice.createTextureImage(cmdList, "", *_alloc, true));
+	_refCounts.push_back(1);
+	_slotHashes.push_back(0);
+}
+
+uint32_t Astra::TextureCache::addSlot(const nvvk::Texture& texture, uint64_t hash)
+{
+	uint32_t slot;
+	if (!_freeSlots.empty())
+	{
+		slot = _freeSlots.back();
+		_freeSlots.pop_back();
+		_textures[slot] = texture;
+		_refCounts[slot] = 0;
+		_slotHashes[slot] = hash;
+	}
+	else
+	{
+		slot = static_cast<uint32_t>(_textures.size());
+		_textures.push_back(texture);
+		_refCounts.push_back(0);
+		_slotHashes.push_back(hash);
+	}
+
+	if (hash != 0)
+		_hashSlots[hash] = slot;
+	return slot;
+}
+
+std::vector<uint32_t> Astra::TextureCache::acquire(const CommandList& cmdList, const std::vector<std::string>& paths, const std::vector<TextureData>& decoded)
+{
+	assert(_alloc != nullptr);
+	std::vector<std::string> canonical(paths.size());
+	for (size_t i = 0; i < paths.size(); i++)
+	{
+		canonical[i] = getCanonicalPath(paths[i]);
+	}
+
+	std::unique_lock<std::mutex> lock(_mutex);
+	if (_textures.empty())
+		createDummy(cmdList);
+
+	// first lookup by path, the cheap one
+	std::vector<uint32_t> slots(paths.size(), 0);
+	std::vector<size_t> misses;
+	std::unordered_map<std::string, size_t> missByPath;
+	std::vector<size_t> firstMiss(paths.size(), SIZE_MAX);
+	for (size_t i = 0; i < paths.size(); i++)
+	{
+		auto it = _pathSlots.find(canonical[i]);
+		if (it != _pathSlots.end())
+		{
+			slots[i] = it->second;
+			continue;
+		}
+		auto [miss, inserted] = missByPath.emplace(canonical[i], i);
+		if (inserted)
+			misses.push_back(i);
+		firstMiss[i] = miss->second;
+	}
+	lock.unlock();
+
+	// the same image can be copied under another name, so the unknown paths are checked by content
+	std::vector<uint64_t> hashes(paths.size(), 0);
+	std::vector<TextureData> images(paths.size());
+	AstraThreads.parallelFor(misses.size(), [&](size_t begin, size_t end)
+		{
+			for (size_t m = begin; m < end; m++)
+			{
+				hashes[misses[m]] = hashFile(paths[misses[m]]);
+			}
+		});
+
+	lock.lock();
+	std::vector<size_t> uploads;
+	std::unordered_map<uint64_t, size_t> uploadByHash;
+	for (size_t i : misses)
+	{
+		auto it = hashes[i] != 0 ? _hashSlots.find(hashes[i]) : _hashSlots.end();
+		if (it != _hashSlots.end())
+		{
+			slots[i] = it->second;
+			continue;
+		}
+		auto upload = hashes[i] != 0 ? uploadByHash.find(hashes[i]) : uploadByHash.end();
+		if (upload != uploadByHash.end())
+		{
+			// two new names for the same image in this batch
+			firstMiss[i] = upload->second;
+			continue;
+		}
+		if (hashes[i] != 0)
+			uploadByHash.emplace(hashes[i], i);
+		uploads.push_back(i);
+	}
+	lock.unlock();
+
+	AstraThreads.parallelFor(uploads.size(), [&](size_t begin, size_t end)
+		{
+			for (size_t u = begin; u < end; u++)
+			{
+				const size_t i = uploads[u];
+				if (i >= decoded.size() || decoded[i].width == 0)
+					images[i] = loadTextureData(paths[i], AstraDevice.getTextureLoadOptions());
+			}
+		});
+
+	lock.lock();
+	for (size_t i : uploads)
+	{
+		const TextureData& image = i < decoded.size() && decoded[i].width != 0 ? decoded[i] : images[i];
+		slots[i] = addSlot(AstraDevice.createTextureImage(cmdList, image, *_alloc), hashes[i]);
+	}
+
+	for (size_t i = 0; i < paths.size(); i++)
+	{
+		if (firstMiss[i] != SIZE_MAX)
+			slots[i] = slots[firstMiss[i]];
+		_refCounts[slots[i]]++;
+	}
+	// new names of known images are remembered too, so next time the file is not read
+	for (size_t i : misses)
+	{
+		_pathSlots[canonical[i]] = slots[i];
+	}
+
+	if (!paths.empty())
+	{
+		Astra::Log("Texture cache: " + std::to_string(uploads.size()) + " of " + std::to_string(paths.size()) + " textures uploaded, " +
+			std::to_string(getUniqueCount()) + " unique in the scene");
+	}
+	return slots;
+}
+
+void Astra::TextureCache::release(const std::vector<uint32_t>& slots)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	for (uint32_t slot : slots)
+	{
+		// the dummy lives as long as the cache
+		if (slot == 0 || slot >= _refCounts.size() || _refCounts[slot] == 0)
+			continue;
+		if (--_refCounts[slot] > 0)
+			continue;
+
+		// every path that resolved to this slot goes with it
+		for (auto it = _pathSlots.begin(); it != _pathSlots.end();)
+		{
+			it = it->second == slot ? _pathSlots.erase(it) : std::next(it);
+		}
+		if (_slotHashes[slot] != 0)
+			_hashSlots.erase(_slotHashes[slot]);
+
+		_alloc->destroy(_textures[slot]);
+		// the descriptor array still needs something valid there
+		_textures[slot] = _textures[0];
+		_slotHashes[slot] = 0;
+		_freeSlots.push_back(slot);
+	}
+}
+
+std::string Astra::TextureCache::getCanonicalPath(const std::string& path)
+{
+	std::error_code ec;
+	const std::filesystem::path canonical = std::filesystem::weakly_canonical(path, ec);
+	return ec ? path : canonical.generic_string();
+}
+
+bool Astra::TextureCache::contains(const std::string& path) const
+{
+	const std::string canonical = getCanonicalPath(path);
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _pathSlots.find(canonical) != _pathSlots.end();
+}
+
+const std::vector<nvvk::Texture>& Astra::TextureCache::getTextures() const
+{
+	return _textures;
+}
+
+size_t Astra::TextureCache::getUniqueCount() const
+{
+	return _textures.size() - _freeSlots.size();
+}
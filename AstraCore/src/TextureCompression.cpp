@@ -0,0 +1,466 @@
+#include <TextureCompression.h>
+#include <MipGenerator.h>
+#include <MappedFile.h>
+#include <ThreadPool.h>
+#include <Utils.h>
+#include <cstring>
+#define STB_DXT_IMPLEMENTATION
+#include <stb_dxt.h>
+#include <filesystem>
+#include <fstream>
+#include <algorithm>
+#include <cstdio>
+
+namespace
+{
+	constexpr uint8_t Ktx2Identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+	// VkFormat values, this file does not need the vulkan headers for them
+	constexpr uint32_t VkFormatR8G8B8A8Srgb = 43;
+	constexpr uint32_t VkFormatBC1RgbSrgb = 132;
+	constexpr uint32_t VkFormatBC3Srgb = 138;
+	constexpr uint32_t VkFormatBC5Unorm = 141;
+
+	struct Ktx2Header
+	{
+		uint8_t identifier[12];
+		uint32_t vkFormat;
+		uint32_t typeSize;
+		uint32_t pixelWidth;
+		uint32_t pixelHeight;
+		uint32_t pixelDepth;
+		uint32_t layerCount;
+		uint32_t faceCount;
+		uint32_t levelCount;
+		uint32_t supercompressionScheme;
+		uint32_t dfdByteOffset;
+		uint32_t dfdByteLength;
+		uint32_t kvdByteOffset;
+		uint32_t kvdByteLength;
+		uint64_t sgdByteOffset;
+		uint64_t sgdByteLength;
+	};
+	static_assert(sizeof(Ktx2Header) == 80, "KTX2 header must be packed");
+
+	struct Ktx2Level
+	{
+		uint64_t byteOffset;
+		uint64_t byteLength;
+		uint64_t uncompressedByteLength;
+	};
+
+	// one channel of the basic data format descriptor
+	struct DfdSample
+	{
+		uint16_t bitOffset;
+		uint8_t bitLength;
+		uint8_t channel;
+		uint32_t upper;
+	};
+
+	uint32_t toVkFormat(Astra::TextureFormat format)
+	{
+		switch (format)
+		{
+		case Astra::TextureFormat::BC1: return VkFormatBC1RgbSrgb;
+		case Astra::TextureFormat::BC3: return VkFormatBC3Srgb;
+		case Astra::TextureFormat::BC5: return VkFormatBC5Unorm;
+		default: return VkFormatR8G8B8A8Srgb;
+		}
+	}
+
+	bool fromVkFormat(uint32_t vkFormat, Astra::TextureFormat& format)
+	{
+		switch (vkFormat)
+		{
+		case VkFormatR8G8B8A8Srgb: format = Astra::TextureFormat::RGBA8; return true;
+		case VkFormatBC1RgbSrgb: format = Astra::TextureFormat::BC1; return true;
+		case VkFormatBC3Srgb: format = Astra::TextureFormat::BC3; return true;
+		case VkFormatBC5Unorm: format = Astra::TextureFormat::BC5; return true;
+		default: return false;
+		}
+	}
+
+	std::vector<uint32_t> buildDfd(Astra::TextureFormat format)
+	{
+		// KHR_DF_MODEL_*, bytes per block and the samples of each block
+		uint32_t model;
+		uint32_t blockBytes;
+		bool srgb = true;
+		std::vector<DfdSample> samples;
+		switch (format)
+		{
+		case Astra::TextureFormat::BC1:
+			model = 128;
+			blockBytes = 8;
+			samples = { { 0, 63, 0, UINT32_MAX } };
+			break;
+		case Astra::TextureFormat::BC3:
+			model = 130;
+			blockBytes = 16;
+			samples = { { 0, 63, 15 | 0x10, UINT32_MAX }, { 64, 63, 0, UINT32_MAX } };
+			break;
+		case Astra::TextureFormat::BC5:
+			model = 132;
+			blockBytes = 16;
+			srgb = false;
+			samples = { { 0, 63, 0, UINT32_MAX }, { 64, 63, 1, UINT32_MAX } };
+			break;
+		default:
+			model = 1;
+			blockBytes = 4;
+			samples = { { 0, 7, 0, 255 }, { 8, 7, 1, 255 }, { 16, 7, 2, 255 }, { 24, 7, 15 | 0x10, 255 } };
+			break;
+		}
+		const bool blocks = format != Astra::TextureFormat::RGBA8;
+
+		const uint32_t blockSize = 24 + 16 * static_cast<uint32_t>(samples.size());
+		std::vector<uint32_t> dfd;
+		dfd.push_back(4 + blockSize);
+		dfd.push_back(0);						  // vendor and descriptor type
+		dfd.push_back(2 | (blockSize << 16)); // version 1.3
+		// model, BT709 primaries, transfer function, straight alpha
+		dfd.push_back(model | (1u << 8) | ((srgb ? 2u : 1u) << 16));
+		dfd.push_back(blocks ? 0x00000303u : 0u); // block dimensions minus one
+		dfd.push_back(blockBytes);
+		dfd.push_back(0);
+		for (const auto& s : samples)
+		{
+			dfd.push_back(s.bitOffset | (static_cast<uint32_t>(s.bitLength) << 16) | (static_cast<uint32_t>(s.channel) << 24));
+			dfd.push_back(0); // sample position
+			dfd.push_back(0);
+			dfd.push_back(s.upper);
+		}
+		return dfd;
+	}
+
+	void encodeLevel(const uint8_t* rgba, uint32_t width, uint32_t height, Astra::TextureFormat format, uint8_t* dst)
+	{
+		const uint32_t blocksX = (width + 3) / 4;
+		const uint32_t blocksY = (height + 3) / 4;
+		const size_t blockBytes = format == Astra::TextureFormat::BC1 ? 8 : 16;
+
+		AstraThreads.parallelFor(blocksY, [&](size_t begin, size_t end)
+			{
+				uint8_t block[16 * 4];
+				uint8_t rg[16 * 2];
+				for (size_t by = begin; by < end; by++)
+				{
+					for (uint32_t bx = 0; bx < blocksX; bx++)
+					{
+						// blocks past the border repeat the edge pixels
+						for (uint32_t p = 0; p < 16; p++)
+						{
+							const size_t x = std::min<size_t>(bx * 4 + p % 4, width - 1);
+							const size_t y = std::min<size_t>(by * 4 + p / 4, height - 1);
+							std::memcpy(block + p * 4, rgba + (y * width + x) * 4, 4);
+							rg[p * 2] = block[p * 4];
+							rg[p * 2 + 1] = block[p * 4 + 1];
+						}
+
+						uint8_t* out = dst + (by * blocksX + bx) * blockBytes;
+						if (format == Astra::TextureFormat::BC5)
+							stb_compress_bc5_block(out, rg);
+						else
+							stb_compress_dxt_block(out, block, format == Astra::TextureFormat::BC3, STB_DXT_HIGHQUAL);
+					}
+				}
+			}, 4);
+	}
+
+	void decodeColorBlock(const uint8_t* src, bool threeColorMode, uint8_t* rgba)
+	{
+		const uint16_t c0 = static_cast<uint16_t>(src[0] | (src[1] << 8));
+		const uint16_t c1 = static_cast<uint16_t>(src[2] | (src[3] << 8));
+		auto expand = [](uint16_t c, int* out)
+		{
+			out[0] = ((c >> 11) & 31) * 255 / 31;
+			out[1] = ((c >> 5) & 63) * 255 / 63;
+			out[2] = (c & 31) * 255 / 31;
+		};
+		int palette[4][3];
+		expand(c0, palette[0]);
+		expand(c1, palette[1]);
+		for (int c = 0; c < 3; c++)
+		{
+			if (!threeColorMode || c0 > c1)
+			{
+				palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+				palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+			}
+			else
+			{
+				palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+				palette[3][c] = 0;
+			}
+		}
+		const uint32_t indices = static_cast<uint32_t>(src[4] | (src[5] << 8) | (src[6] << 16)) | (static_cast<uint32_t>(src[7]) << 24);
+		for (int p = 0; p < 16; p++)
+		{
+			const int* color = palette[(indices >> (2 * p)) & 3];
+			rgba[p * 4] = static_cast<uint8_t>(color[0]);
+			rgba[p * 4 + 1] = static_cast<uint8_t>(color[1]);
+			rgba[p * 4 + 2] = static_cast<uint8_t>(color[2]);
+		}
+	}
+
+	// BC3 alpha and BC5 channels, written every 4 bytes starting at out
+	void decodeChannelBlock(const uint8_t* src, uint8_t* out)
+	{
+		int values[8];
+		values[0] = src[0];
+		values[1] = src[1];
+		if (values[0] > values[1])
+		{
+			for (int i = 1; i < 7; i++)
+				values[i + 1] = ((7 - i) * values[0] + i * values[1]) / 7;
+		}
+		else
+		{
+			for (int i = 1; i < 5; i++)
+				values[i + 1] = ((5 - i) * values[0] + i * values[1]) / 5;
+			values[6] = 0;
+			values[7] = 255;
+		}
+		uint64_t indices = 0;
+		for (int i = 0; i < 6; i++)
+			indices |= static_cast<uint64_t>(src[2 + i]) << (8 * i);
+		for (int p = 0; p < 16; p++)
+			out[p * 4] = static_cast<uint8_t>(values[(indices >> (3 * p)) & 7]);
+	}
+}
+
+size_t Astra::getTextureLevelSize(TextureFormat format, uint32_t width, uint32_t height)
+{
+	const size_t blocks = static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4);
+	switch (format)
+	{
+	case TextureFormat::BC1: return blocks * 8;
+	case TextureFormat::BC3:
+	case TextureFormat::BC5: return blocks * 16;
+	default: return static_cast<size_t>(width) * height * 4;
+	}
+}
+
+Astra::TextureFormat Astra::chooseCompressedFormat(const TextureData& rgba)
+{
+	for (size_t i = 3; i < rgba.pixels.size(); i += 4)
+	{
+		if (rgba.pixels[i] != 255)
+			return TextureFormat::BC3;
+	}
+	return TextureFormat::BC1;
+}
+
+Astra::TextureData Astra::compressTexture(const TextureData& rgba, TextureFormat format)
+{
+	// the mipmaps are filtered before compressing, never from compressed data
+	TextureData mips;
+	mips.width = rgba.width;
+	mips.height = rgba.height;
+	mips.pixels.assign(rgba.pixels.begin(), rgba.pixels.begin() + getTextureLevelSize(TextureFormat::RGBA8, rgba.width, rgba.height));
+	generateMipChain(mips);
+
+	TextureData result;
+	result.width = rgba.width;
+	result.height = rgba.height;
+	result.format = format;
+	size_t total = 0;
+	for (uint32_t level = 0; level < mips.getLevelCount(); level++)
+	{
+		result.levelOffsets.push_back(total);
+		total += result.getLevelSize(level);
+	}
+	result.pixels.resize(total);
+
+	for (uint32_t level = 0; level < mips.getLevelCount(); level++)
+	{
+		encodeLevel(mips.getLevelData(level), mips.getLevelWidth(level), mips.getLevelHeight(level), format, result.pixels.data() + result.levelOffsets[level]);
+	}
+	return result;
+}
+
+Astra::TextureData Astra::decompressTexture(const TextureData& compressed)
+{
+	if (!compressed.isCompressed())
+		return compressed;
+
+	TextureData result;
+	result.width = compressed.width;
+	result.height = compressed.height;
+	result.pixels.resize(getTextureLevelSize(TextureFormat::RGBA8, result.width, result.height));
+
+	const uint32_t blocksX = (compressed.width + 3) / 4;
+	const uint32_t blocksY = (compressed.height + 3) / 4;
+	const size_t blockBytes = compressed.format == TextureFormat::BC1 ? 8 : 16;
+	const uint8_t* src = compressed.getLevelData(0);
+
+	AstraThreads.parallelFor(blocksY, [&](size_t begin, size_t end)
+		{
+			uint8_t block[16 * 4];
+			for (size_t by = begin; by < end; by++)
+			{
+				for (uint32_t bx = 0; bx < blocksX; bx++)
+				{
+					const uint8_t* in = src + (by * blocksX + bx) * blockBytes;
+					std::memset(block, 255, sizeof(block));
+					switch (compressed.format)
+					{
+					case TextureFormat::BC1:
+						decodeColorBlock(in, true, block);
+						break;
+					case TextureFormat::BC3:
+						decodeChannelBlock(in, block + 3);
+						decodeColorBlock(in + 8, false, block);
+						break;
+					default:
+						decodeChannelBlock(in, block);
+						decodeChannelBlock(in + 8, block + 1);
+						for (int p = 0; p < 16; p++)
+							block[p * 4 + 2] = 0;
+						break;
+					}
+
+					for (uint32_t p = 0; p < 16; p++)
+					{
+						const size_t x = bx * 4 + p % 4;
+						const size_t y = by * 4 + p / 4;
+						if (x < result.width && y < result.height)
+							std::memcpy(result.pixels.data() + (y * result.width + x) * 4, block + p * 4, 4);
+					}
+				}
+			}
+		}, 4);
+	return result;
+}
+
+std::string Astra::getTextureCachePath(const std::string& sourcePath, const std::string& cacheDirectory)
+{
+	if (cacheDirectory.empty())
+		return sourcePath + ".ktx2";
+
+	// images with the same name in different folders must not share the file
+	std::error_code ec;
+	std::string absolute = std::filesystem::absolute(sourcePath, ec).string();
+	if (ec)
+		absolute = sourcePath;
+	char hash[17];
+	snprintf(hash, sizeof(hash), "%016llx", static_cast<unsigned long long>(Astra::hashBytes(absolute.data(), absolute.size())));
+	const std::string name = std::filesystem::path(sourcePath).filename().string() + "." + hash + ".ktx2";
+	return (std::filesystem::path(cacheDirectory) / name).string();
+}
+
+bool Astra::writeKtx2(const std::string& path, const TextureData& data)
+{
+	const uint32_t levelCount = data.getLevelCount();
+	const std::vector<uint32_t> dfd = buildDfd(data.format);
+	const uint64_t alignment = data.format == TextureFormat::BC1 ? 8 : (data.isCompressed() ? 16 : 4);
+
+	Ktx2Header header{};
+	std::memcpy(header.identifier, Ktx2Identifier, sizeof(Ktx2Identifier));
+	header.vkFormat = toVkFormat(data.format);
+	header.typeSize = 1;
+	header.pixelWidth = data.width;
+	header.pixelHeight = data.height;
+	header.faceCount = 1;
+	header.levelCount = levelCount;
+	header.dfdByteOffset = static_cast<uint32_t>(sizeof(Ktx2Header) + levelCount * sizeof(Ktx2Level));
+	header.dfdByteLength = static_cast<uint32_t>(dfd.size() * sizeof(uint32_t));
+
+	// the spec stores the smallest level first
+	std::vector<Ktx2Level> levels(levelCount);
+	uint64_t offset = header.dfdByteOffset + header.dfdByteLength;
+	for (uint32_t level = levelCount; level-- > 0;)
+	{
+		offset = (offset + alignment - 1) / alignment * alignment;
+		levels[level].byteOffset = offset;
+		levels[level].byteLength = data.getLevelSize(level);
+		levels[level].uncompressedByteLength = levels[level].byteLength;
+		offset += levels[level].byteLength;
+	}
+
+	std::error_code ec;
+	const std::filesystem::path target(path);
+	if (target.has_parent_path())
+		std::filesystem::create_directories(target.parent_path(), ec);
+
+	// written aside and renamed, so a crash never leaves a broken file behind
+	const std::string tmpPath = path + ".tmp";
+	{
+		std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+		if (!out)
+			return false;
+		out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		out.write(reinterpret_cast<const char*>(levels.data()), levels.size() * sizeof(Ktx2Level));
+		out.write(reinterpret_cast<const char*>(dfd.data()), dfd.size() * sizeof(uint32_t));
+		uint64_t written = header.dfdByteOffset + header.dfdByteLength;
+		for (uint32_t level = levelCount; level-- > 0;)
+		{
+			static const char zeros[16] = {};
+			out.write(zeros, static_cast<std::streamsize>(levels[level].byteOffset - written));
+			out.write(reinterpret_cast<const char*>(data.getLevelData(level)), static_cast<std::streamsize>(levels[level].byteLength));
+			written = levels[level].byteOffset + levels[level].byteLength;
+		}
+		if (!out)
+		{
+			out.close();
+			std::filesystem::remove(tmpPath, ec);
+			return false;
+		}
+	}
+
+	std::filesystem::rename(tmpPath, path, ec);
+	if (ec)
+	{
+		std::filesystem::remove(tmpPath, ec);
+		return false;
+	}
+	return true;
+}
+
+bool Astra::readKtx2(const std::string& path, TextureData& data)
+{
+	MappedFile file;
+	if (!file.open(path) || file.size() < sizeof(Ktx2Header))
+		return false;
+
+	Ktx2Header header;
+	std::memcpy(&header, file.data(), sizeof(header));
+	TextureFormat format;
+	if (std::memcmp(header.identifier, Ktx2Identifier, sizeof(Ktx2Identifier)) != 0 || !fromVkFormat(header.vkFormat, format) ||
+		header.supercompressionScheme != 0 || header.pixelDepth > 1 || header.layerCount > 1 || header.faceCount != 1 ||
+		header.pixelWidth == 0 || header.pixelHeight == 0)
+		return false;
+
+	// 0 levels means the mipmaps have to be generated
+	const uint32_t levelCount = std::max(1u, header.levelCount);
+	if (levelCount > 32 || file.size() < sizeof(Ktx2Header) + levelCount * sizeof(Ktx2Level))
+		return false;
+
+	TextureData result;
+	result.width = header.pixelWidth;
+	result.height = header.pixelHeight;
+	result.format = format;
+	std::vector<Ktx2Level> levels(levelCount);
+	std::memcpy(levels.data(), file.data() + sizeof(Ktx2Header), levels.size() * sizeof(Ktx2Level));
+
+	size_t total = 0;
+	for (uint32_t level = 0; level < levelCount; level++)
+	{
+		const size_t size = getTextureLevelSize(format, result.getLevelWidth(level), result.getLevelHeight(level));
+		if (levels[level].byteLength != size || levels[level].byteOffset > file.size() || size > file.size() - levels[level].byteOffset)
+			return false;
+		if (header.levelCount > 0)
+			result.levelOffsets.push_back(total);
+		total += size;
+	}
+
+	result.pixels.resize(total);
+	for (uint32_t level = 0; level < levelCount; level++)
+	{
+		std::memcpy(result.pixels.data() + (result.levelOffsets.empty() ? 0 : result.levelOffsets[level]), file.data() + levels[level].byteOffset, levels[level].byteLength);
+	}
+
+	data = std::move(result);
+	return true;
+}
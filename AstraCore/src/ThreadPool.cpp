@@ -0,0 +1,132 @@
+#include <ThreadPool.h>
+#include <atomic>
+#include <algorithm>
+#include <exception>
+
+Astra::ThreadPool::ThreadPool()
+{
+	// the thread calling parallelFor works too, so we leave one core for it
+	unsigned int hwThreads = std::thread::hardware_concurrency();
+	unsigned int nbWorkers = std::max(1u, hwThreads > 1 ? hwThreads - 1 : 1u);
+	_workers.reserve(nbWorkers);
+	for (unsigned int i = 0; i < nbWorkers; i++)
+	{
+		_workers.emplace_back(&ThreadPool::workerLoop, this);
+	}
+}
+
+Astra::ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stop = true;
+	}
+	_cv.notify_all();
+	for (auto& w : _workers)
+	{
+		w.join();
+	}
+}
+
+void Astra::ThreadPool::workerLoop()
+{
+	while (true)
+	{
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_cv.wait(lock, [this]() { return _stop || !_tasks.empty(); });
+			if (_stop && _tasks.empty())
+				return;
+			task = std::move(_tasks.front());
+			_tasks.pop_front();
+		}
+		task();
+	}
+}
+
+void Astra::ThreadPool::enqueue(std::function<void()> task)
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_tasks.push_back(std::move(task));
+	}
+	_cv.notify_one();
+}
+
+uint32_t Astra::ThreadPool::getThreadCount() const
+{
+	return static_cast<uint32_t>(_workers.size()) + 1;
+}
+
+void Astra::ThreadPool::parallelFor(size_t count, const std::function<void(size_t, size_t)>& fn, size_t minBatch)
+{
+	if (count == 0)
+		return;
+
+	// a few batches per thread, they are handed out on demand so uneven work still balances
+	minBatch = std::max<size_t>(minBatch, 1);
+	size_t nbBatches = std::min<size_t>(getThreadCount() * 4, (count + minBatch - 1) / minBatch);
+	if (nbBatches <= 1)
+	{
+		fn(0, count);
+		return;
+	}
+
+	// shared between the helpers, they may outlive this call if they start after every batch was taken
+	struct Batches
+	{
+		std::atomic<size_t> next{ 0 };
+		std::atomic<size_t> done{ 0 };
+		size_t count;
+		size_t batchSize;
+		size_t nbBatches;
+		std::mutex mutex;
+		std::condition_variable cv;
+		std::exception_ptr error;
+	};
+	auto batches = std::make_shared<Batches>();
+	batches->count = count;
+	batches->nbBatches = nbBatches;
+	batches->batchSize = (count + nbBatches - 1) / nbBatches;
+
+	// fn is only touched while a batch is running, and we dont return until every batch is done
+	const auto* func = &fn;
+	auto work = [batches, func]()
+	{
+		size_t b;
+		while ((b = batches->next.fetch_add(1)) < batches->nbBatches)
+		{
+			size_t begin = b * batches->batchSize;
+			size_t end = std::min(begin + batches->batchSize, batches->count);
+			try
+			{
+				if (begin < end)
+					(*func)(begin, end);
+			}
+			catch (...)
+			{
+				std::lock_guard<std::mutex> lock(batches->mutex);
+				if (!batches->error)
+					batches->error = std::current_exception();
+			}
+			if (batches->done.fetch_add(1) + 1 == batches->nbBatches)
+			{
+				std::lock_guard<std::mutex> lock(batches->mutex);
+				batches->cv.notify_all();
+			}
+		}
+	};
+
+	const size_t nbHelpers = std::min<size_t>(nbBatches, getThreadCount()) - 1;
+	for (size_t i = 0; i < nbHelpers; i++)
+	{
+		enqueue(work);
+	}
+	work();
+
+	std::unique_lock<std::mutex> lock(batches->mutex);
+	batches->cv.wait(lock, [&batches]() { return batches->done.load() == batches->nbBatches; });
+	if (batches->error)
+		std::rethrow_exception(batches->error);
+}
@@ -1,6 +1,12 @@
 #include <Utils.h>
 #include <fstream>
 #include <iostream>
+#include <cstring>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#include <immintrin.h>
+#endif
 
 std::vector<char> Astra::readShaderSource(const std::string &filename)
 {
@@ -18,6 +24,45 @@ std::vector<char> Astra::readShaderSource(const std::string &filename)
 	return buffer;
 }
 
+uint64_t Astra::hashBytes(const void *data, size_t size)
+{
+	const char *bytes = static_cast<const char *>(data);
+	uint64_t h = 0xCBF29CE484222325ull ^ size;
+	size_t i = 0;
+	for (; i + 8 <= size; i += 8)
+	{
+		uint64_t word;
+		std::memcpy(&word, bytes + i, 8);
+		h = (h ^ word) * 0x100000001B3ull;
+		h ^= h >> 29;
+	}
+	for (; i < size; i++)
+	{
+		h = (h ^ static_cast<uint8_t>(bytes[i])) * 0x100000001B3ull;
+	}
+	return h;
+}
+
+bool Astra::hasAvx2()
+{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7)
+		return false;
+	__cpuid(info, 1);
+	// the OS must save the ymm registers
+	if ((info[2] & (1 << 27)) == 0 || (_xgetbv(0) & 6) != 6)
+		return false;
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#elif defined(__x86_64__) || defined(__i386__)
+	return __builtin_cpu_supports("avx2");
+#else
+	return false;
+#endif
+}
+
 void Astra::Log(const std::string &s, LOG_LEVELS level)
 {
 	if (level == LOG_LEVELS::INFO)
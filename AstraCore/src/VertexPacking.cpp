@@ -0,0 +1,160 @@
+#include <VertexPacking.h>
+#include <ThreadPool.h>
+#include <glm/gtc/packing.hpp>
+#include <algorithm>
+#include <mutex>
+#include <cmath>
+#include <cstring>
+#include <cfloat>
+
+namespace
+{
+	// below this many vertices a mesh is not split between threads
+	constexpr size_t MinPackBatch = 16 * 1024;
+
+	glm::vec2 octEncode(const glm::vec3& n)
+	{
+		const float sum = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+		if (sum == 0.0f)
+			return glm::vec2(0.0f);
+		glm::vec2 p = glm::vec2(n.x, n.y) / sum;
+		if (n.z < 0.0f)
+		{
+			// the lower half is folded over the diagonals
+			const glm::vec2 sign(p.x >= 0.0f ? 1.0f : -1.0f, p.y >= 0.0f ? 1.0f : -1.0f);
+			p = (glm::vec2(1.0f) - glm::abs(glm::vec2(p.y, p.x))) * sign;
+		}
+		return p;
+	}
+
+	glm::vec3 octDecode(const glm::vec2& f)
+	{
+		glm::vec3 n(f.x, f.y, 1.0f - std::abs(f.x) - std::abs(f.y));
+		const float t = std::max(-n.z, 0.0f);
+		n.x += n.x >= 0.0f ? -t : t;
+		n.y += n.y >= 0.0f ? -t : t;
+		return glm::normalize(n);
+	}
+
+	uint32_t floatBits(float f)
+	{
+		uint32_t bits;
+		std::memcpy(&bits, &f, sizeof(bits));
+		return bits;
+	}
+
+	float bitsFloat(uint32_t bits)
+	{
+		float f;
+		std::memcpy(&f, &bits, sizeof(f));
+		return f;
+	}
+}
+
+uint32_t Astra::getVertexStride(uint32_t vertexFormat)
+{
+	if ((vertexFormat & eVertexPacked) == 0)
+		return sizeof(Vertex);
+	// position, normal and texture coordinates, then the color
+	uint32_t words = (vertexFormat & eVertexQuantized) ? 2 : 3;
+	words += 2;
+	if (vertexFormat & eVertexColor)
+		words++;
+	return words * sizeof(uint32_t);
+}
+
+std::vector<uint32_t> Astra::packVertices(const Vertex* vertices, size_t count, uint32_t vertexFormat, glm::vec3& posScale, glm::vec3& posOffset)
+{
+	posScale = glm::vec3(1.0f);
+	posOffset = glm::vec3(0.0f);
+	if ((vertexFormat & eVertexPacked) == 0)
+	{
+		std::vector<uint32_t> plain(count * sizeof(Vertex) / sizeof(uint32_t));
+		std::memcpy(plain.data(), vertices, count * sizeof(Vertex));
+		return plain;
+	}
+
+	const bool quantized = (vertexFormat & eVertexQuantized) != 0;
+	if (quantized && count > 0)
+	{
+		glm::vec3 lo(FLT_MAX), hi(-FLT_MAX);
+		std::mutex boundsMutex;
+		AstraThreads.parallelFor(count, [&](size_t begin, size_t end)
+			{
+				glm::vec3 l(FLT_MAX), h(-FLT_MAX);
+				for (size_t v = begin; v < end; v++)
+				{
+					l = glm::min(l, vertices[v].pos);
+					h = glm::max(h, vertices[v].pos);
+				}
+				std::lock_guard<std::mutex> lock(boundsMutex);
+				lo = glm::min(lo, l);
+				hi = glm::max(hi, h);
+			}, MinPackBatch);
+		posOffset = (lo + hi) * 0.5f;
+		posScale = (hi - lo) * 0.5f;
+		// flat axes keep a valid scale
+		for (int c = 0; c < 3; c++)
+		{
+			if (posScale[c] <= 0.0f)
+				posScale[c] = 1.0f;
+		}
+	}
+
+	const uint32_t words = getVertexStride(vertexFormat) / sizeof(uint32_t);
+	std::vector<uint32_t> packed(count * words);
+	const glm::vec3 invScale = 1.0f / posScale;
+	AstraThreads.parallelFor(count, [&](size_t begin, size_t end)
+		{
+			for (size_t v = begin; v < end; v++)
+			{
+				const Vertex& vertex = vertices[v];
+				uint32_t* out = packed.data() + v * words;
+				if (quantized)
+				{
+					const glm::vec3 q = glm::clamp((vertex.pos - posOffset) * invScale, -1.0f, 1.0f);
+					*out++ = glm::packSnorm2x16(glm::vec2(q.x, q.y));
+					*out++ = glm::packSnorm2x16(glm::vec2(q.z, 0.0f));
+				}
+				else
+				{
+					*out++ = floatBits(vertex.pos.x);
+					*out++ = floatBits(vertex.pos.y);
+					*out++ = floatBits(vertex.pos.z);
+				}
+				*out++ = glm::packSnorm2x16(octEncode(vertex.nrm));
+				*out++ = glm::packHalf2x16(vertex.texCoord);
+				if (vertexFormat & eVertexColor)
+					*out++ = glm::packUnorm4x8(glm::vec4(glm::clamp(vertex.color, 0.0f, 1.0f), 1.0f));
+			}
+		}, MinPackBatch);
+	return packed;
+}
+
+Vertex Astra::unpackVertex(const uint32_t* packed, uint32_t vertexFormat, const glm::vec3& posScale, const glm::vec3& posOffset)
+{
+	Vertex vertex{};
+	if ((vertexFormat & eVertexPacked) == 0)
+	{
+		std::memcpy(&vertex, packed, sizeof(Vertex));
+		return vertex;
+	}
+
+	if (vertexFormat & eVertexQuantized)
+	{
+		const glm::vec2 xy = glm::unpackSnorm2x16(packed[0]);
+		const glm::vec2 zw = glm::unpackSnorm2x16(packed[1]);
+		vertex.pos = glm::vec3(xy, zw.x) * posScale + posOffset;
+		packed += 2;
+	}
+	else
+	{
+		vertex.pos = glm::vec3(bitsFloat(packed[0]), bitsFloat(packed[1]), bitsFloat(packed[2]));
+		packed += 3;
+	}
+	vertex.nrm = octDecode(glm::unpackSnorm2x16(packed[0]));
+	vertex.texCoord = glm::unpackHalf2x16(packed[1]);
+	if (vertexFormat & eVertexColor)
+		vertex.color = glm::vec3(glm::unpackUnorm4x8(packed[2]));
+	return vertex;
+}